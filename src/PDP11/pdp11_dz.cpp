@@ -687,9 +687,12 @@ t_stat r;
 extern int32 sim_switches;
 
 dz_mctl = dz_auto = 0;                                  /* modem ctl off */
+dz_desc.wakeup = uptr;                                  /* poll on input */
 r = tmxr_attach (&dz_desc, uptr, cptr);                 /* attach mux */
-if (r != SCPE_OK)                                       /* error? */
+if (r != SCPE_OK) {                                     /* error? */
+    dz_desc.wakeup = NULL;
     return r;
+    }
 if (sim_switches & SWMASK ('M')) {                      /* modem control? */
     dz_mctl = 1;
     smp_printf ("Modem control activated\n");
@@ -709,7 +712,10 @@ return SCPE_OK;
 
 t_stat dz_detach (UNIT *uptr)
 {
-return tmxr_detach (&dz_desc, uptr);
+t_stat r = tmxr_detach (&dz_desc, uptr);                /* detach mux */
+
+dz_desc.wakeup = NULL;                                  /* no more wakeups */
+return r;
 }
 
 /* SET LINES processor */
@@ -49,19 +49,68 @@
 #include "pdp11_defs.h"
 #endif
 
+/* Output to an attached file is normally buffered: a character written to
+   LPBUF is stored in a host-side buffer and DONE is set again at once, so the
+   guest can drive the printer at full speed without an event per character.
+   Full buffers are handed to a writer (IOP) thread when asynchronous I/O is
+   enabled, or written in one call on the VCPU thread otherwise; partial
+   buffers are written out when the flush timer expires or the simulator
+   stops.  While the writer still owns the other buffer, the printer stays
+   not-ready until it is done.  SET LPT PACED restores per-character service
+   with the original timing.
+*/
+
+#define UNIT_V_PACE     (UNIT_V_UF + 0)                 /* per-char timing */
+#define UNIT_PACE       (1u << UNIT_V_PACE)
+#define lpt_ctx         up8                             /* writer context */
+
 #define LPTCSR_IMP      (CSR_ERR + CSR_DONE + CSR_IE)   /* implemented */
 #define LPTCSR_RW       (CSR_IE)                        /* read/write */
 
+#define LPT_BUFSIZ      8192                            /* host buffer size */
+
 int32 lpt_csr = 0;                                      /* control/status */
 int32 lpt_stopioe = 0;                                  /* stop on error */
+int32 lpt_fwait = 100000;                               /* flush timer */
+uint8 lpt_xbuf[2][LPT_BUFSIZ];                          /* host buffers */
+int32 lpt_fill = 0;                                     /* buffer being filled */
+int32 lpt_ocnt = 0;                                     /* chars in it */
+t_bool lpt_stall = FALSE;                               /* waiting for writer */
 AUTO_INIT_DEVLOCK(lp_lock);
 
+/* Writer context, exists while attached */
+
+class lpt_context : public aio_context
+{
+public:
+    lpt_context(UNIT* uptr) : aio_context(uptr)
+    {
+        io_pend = FALSE;
+        wbuf = NULL;
+        wcnt = 0;
+    }
+    t_bool has_request() { return io_pend; }
+    void perform_request();
+    void perform_flush() { fflush (uptr->fileref); }
+    void perform_io();
+
+public:
+    volatile t_bool     io_pend;                        /* buffer queued */
+    uint8*              wbuf;                           /* buffer to write */
+    int32               wcnt;                           /* its length */
+};
+
 t_stat lpt_rd (int32 *data, int32 PA, int32 access);
 t_stat lpt_wr (int32 data, int32 PA, int32 access);
 t_stat lpt_svc (RUN_SVC_DECL, UNIT *uptr);
 t_stat lpt_reset (DEVICE *dptr);
 t_stat lpt_attach (UNIT *uptr, char *ptr);
 t_stat lpt_detach (UNIT *uptr);
+t_bool lpt_fast (UNIT *uptr);
+t_bool lpt_submit (UNIT *uptr);
+void lpt_io_complete (UNIT *uptr);
+void lpt_io_flush (UNIT *uptr);
+void lpt_reset_aio (DEVICE *dptr);
 
 /* LPT data structures
 
@@ -87,6 +136,8 @@ REG lpt_reg[] = {
     { FLDATA_GBL (IE, lpt_csr, CSR_V_IE) },
     { DRDATA_GBL (POS, lpt_unit.pos, T_ADDR_W), PV_LEFT },
     { DRDATA_GBL (TIME, lpt_unit.wait, 24), PV_LEFT },
+    { DRDATA_GBL (FTIME, lpt_fwait, 24), PV_LEFT },
+    { DRDATA_GBL (OCNT, lpt_ocnt, 16), PV_LEFT + REG_RO },
     { FLDATA_GBL (STOP_IOE, lpt_stopioe, 0) },
     { GRDATA_GBL (DEVADDR, lpt_dib.ba, DEV_RDX, 32, 0), REG_HRO },
     { GRDATA_GBL (DEVVEC, lpt_dib.vec, DEV_RDX, 16, 0), REG_HRO },
@@ -94,6 +145,8 @@ REG lpt_reg[] = {
     };
 
 MTAB lpt_mod[] = {
+    { UNIT_PACE, 0, "buffered", "BUFFERED", NULL },
+    { UNIT_PACE, UNIT_PACE, "paced", "PACED", NULL },
     { MTAB_XTD|MTAB_VDV, 004, "ADDRESS", "ADDRESS",
       &set_addr, &show_addr, NULL },
     { MTAB_XTD|MTAB_VDV, 0, "VECTOR", "VECTOR",
@@ -113,7 +166,7 @@ DEVICE lpt_dev = {
 
    lpt_rd       I/O page read
    lpt_wr       I/O page write
-   lpt_svc      process event (printer ready)
+   lpt_svc      process event (printer ready, flush timer)
    lpt_reset    process reset
    lpt_attach   process attach
    lpt_detach   process detach
@@ -145,6 +198,19 @@ t_stat lpt_wr (int32 data, int32 PA, int32 access)
             lpt_unit.buf = data & 0177;
         lpt_csr = lpt_csr & ~CSR_DONE;
         CLR_INT (LPT);
+        if (lpt_fast (&lpt_unit)) {                         /* buffered output? */
+            lpt_xbuf[lpt_fill][lpt_ocnt++] = (uint8) (lpt_unit.buf & 0177);
+            if (lpt_ocnt >= LPT_BUFSIZ && !lpt_submit (&lpt_unit)) {
+                lpt_stall = TRUE;                           /* writer busy */
+                return SCPE_OK;                             /* stay not ready */
+                }
+            lpt_csr = lpt_csr | CSR_DONE;                   /* ready again */
+            if (lpt_csr & CSR_IE)
+                SET_INT (LPT);
+            if (lpt_ocnt && !sim_is_active (&lpt_unit))     /* arm flush timer */
+                sim_activate (&lpt_unit, lpt_fwait);
+            return SCPE_OK;
+            }
         if ((lpt_unit.buf == 015) || (lpt_unit.buf == 014) ||
             (lpt_unit.buf == 012)) sim_activate (&lpt_unit, lpt_unit.wait);
         else sim_activate (&lpt_unit, 0);
@@ -156,6 +222,21 @@ t_stat lpt_svc (RUN_SVC_DECL, UNIT *uptr)
 {
     AUTO_LOCK(lp_lock);
     RUN_SVC_CHECK_CANCELLED(uptr);
+    if (lpt_fast (uptr)) {                                  /* buffered output */
+        if (lpt_ocnt == 0 || lpt_submit (uptr)) {
+            if (lpt_stall) {                                /* was not ready? */
+                lpt_stall = FALSE;
+                lpt_csr = lpt_csr | CSR_DONE;
+                if (lpt_csr & CSR_IE)
+                    SET_INT (LPT);
+                }
+            }
+        else if (!lpt_stall)                                /* writer busy, */
+            sim_activate (uptr, lpt_fwait);                 /* retry later */
+        if (lpt_csr & CSR_ERR)
+            return IORETURN (lpt_stopioe, SCPE_IOERR);
+        return SCPE_OK;
+        }
     lpt_csr = lpt_csr | CSR_ERR | CSR_DONE;
     if (lpt_csr & CSR_IE)
         SET_INT (LPT);
@@ -172,10 +253,149 @@ t_stat lpt_svc (RUN_SVC_DECL, UNIT *uptr)
     return SCPE_OK;
 }
 
+/* Buffered output is used when attached and not paced */
+
+t_bool lpt_fast (UNIT *uptr)
+{
+    return (uptr->flags & (UNIT_ATT + UNIT_PACE)) == UNIT_ATT &&
+           uptr->lpt_ctx != NULL;
+}
+
+/* Hand the fill buffer to the writer.  Returns FALSE if the writer still owns
+   the other buffer.  Unit position is advanced here rather than by querying
+   the file, it is exact once the writer is flushed.
+*/
+
+t_bool lpt_submit (UNIT *uptr)
+{
+    lpt_context* ctx = (lpt_context*) uptr->lpt_ctx;
+
+    if (ctx->io_pend)                                       /* writer busy? */
+        return FALSE;
+    if (ctx->io_status != SCPE_OK) {                        /* prior write failed? */
+        lpt_csr = lpt_csr | CSR_ERR;
+        ctx->io_status = SCPE_OK;
+        }
+    ctx->wbuf = lpt_xbuf[lpt_fill];
+    ctx->wcnt = lpt_ocnt;
+    uptr->pos = uptr->pos + lpt_ocnt;
+    lpt_fill = lpt_fill ^ 1;
+    lpt_ocnt = 0;
+    if (ctx->asynch_io) {                                   /* queue to writer */
+        ctx->io_pend = TRUE;
+        smp_wmb();
+        ctx->io_event_signal();
+        }
+    else {                                                  /* write it now */
+        ctx->perform_io();
+        if (ctx->io_status != SCPE_OK) {
+            lpt_csr = lpt_csr | CSR_ERR;
+            ctx->io_status = SCPE_OK;
+            }
+        }
+    return TRUE;
+}
+
+/* Write one buffer, on IOP thread or synchronously on VCPU thread */
+
+void lpt_context::perform_io()
+{
+    fxwrite (wbuf, 1, wcnt, uptr->fileref);
+    if (ferror (uptr->fileref)) {
+        smp_perror ("LPT I/O error");
+        clearerr (uptr->fileref);
+        io_status = SCPE_IOERR;
+        }
+}
+
+void lpt_context::perform_request()
+{
+    perform_io();
+    io_pend = FALSE;
+    sim_async_post_io_event(uptr);
+}
+
+SMP_THREAD_ROUTINE_DECL lpt_io_thread (void* arg)
+{
+    UNIT* volatile uptr = (UNIT*) arg;
+    lpt_context* ctx = (lpt_context*) uptr->lpt_ctx;
+
+    sim_try
+    {
+        smp_thread_init();
+
+        run_scope_context* rscx = new run_scope_context(NULL, SIM_THREAD_TYPE_IOP, ctx->io_thread);
+        rscx->set_current();
+
+        smp_set_thread_priority(SIMH_THREAD_PRIORITY_IOP);
+        smp_set_thread_name("IOP_LPT");
+
+        ctx->thread_loop();
+    }
+    sim_catch (sim_exception_SimError, exc)
+    {
+        fprintf(smp_stderr, "\nFatal error in %s simulator, unexpected exception while executing LPT IOP thread\n", sim_name);
+        fprintf(smp_stderr, "Exception cause: %s\n", exc->get_message());
+        fprintf(smp_stderr, "Terminating the simulator abnormally...\n");
+        exit(1);
+    }
+    sim_end_try
+
+    SMP_THREAD_ROUTINE_END;
+}
+
+/* Buffer written - invoked by primary VCPU holding unit lock */
+
+void lpt_io_complete (UNIT *uptr)
+{
+    if (uptr->lpt_ctx && lpt_stall)                         /* printer waiting? */
+        sim_activate (uptr, 0);
+}
+
+/* Write out everything buffered - console thread with VCPUs paused,
+   or VCPU thread holding lp_lock
+*/
+
+void lpt_io_flush (UNIT *uptr)
+{
+    lpt_context* ctx = (lpt_context*) uptr->lpt_ctx;
+
+    if (ctx == NULL)
+        return;
+    ctx->flush();                                           /* writer idle */
+    if (lpt_ocnt) {
+        lpt_submit (uptr);
+        ctx->flush();
+        }
+    if (!ctx->asynch_io)
+        fflush (uptr->fileref);
+}
+
+/* Drain buffered output and drop writer completion events, as in rl_reset_aio */
+
+void lpt_reset_aio (DEVICE *dptr)
+{
+    RUN_SCOPE_RSCX;
+    lpt_context* ctx = (lpt_context*) lpt_unit.lpt_ctx;
+
+    if (ctx == NULL)
+        return;
+    if (ctx->asynch_io && rscx->thread_type == SIM_THREAD_TYPE_CPU && !cpu_unit->is_primary_cpu())
+        panic("LPT device reset attempted by a secondary CPU");
+    lpt_io_flush (&lpt_unit);
+    if (ctx->asynch_io) {
+        if (rscx->thread_type == SIM_THREAD_TYPE_CONSOLE)
+            sim_async_process_io_events_for_console();
+        else sim_async_process_io_events(RUN_PASS, NULL, TRUE);
+        }
+}
+
 t_stat lpt_reset (DEVICE *dptr)
 {
     AUTO_LOCK(lp_lock);
     sim_bind_devunits_lock(&lpt_dev, lp_lock);
+    lpt_reset_aio (&lpt_dev);                               /* write out buffer */
+    lpt_stall = FALSE;
     lpt_unit.buf = 0;
     lpt_csr = CSR_DONE;
     if ((lpt_unit.flags & UNIT_ATT) == 0)
@@ -191,13 +411,47 @@ t_stat lpt_attach (UNIT *uptr, char *cptr)
 
     lpt_csr = lpt_csr & ~CSR_ERR;
     reason = attach_unit (uptr, cptr);
-    if ((lpt_unit.flags & UNIT_ATT) == 0)
+    if ((lpt_unit.flags & UNIT_ATT) == 0) {
         lpt_csr = lpt_csr | CSR_ERR;
+        return reason;
+        }
+    lpt_context* ctx = new lpt_context (uptr);              /* writer context */
+    ctx->dptr = &lpt_dev;
+    uptr->lpt_ctx = ctx;
+    lpt_fill = lpt_ocnt = 0;
+    lpt_stall = FALSE;
+    if (sim_asynch_enabled) {                               /* writer thread? */
+        uptr->a_check_completion = lpt_io_complete;
+        ctx->asynch_init (lpt_io_thread, (void*) uptr);
+        ctx->asynch_io = TRUE;
+        }
+    uptr->io_flush = lpt_io_flush;
     return reason;
 }
 
 t_stat lpt_detach (UNIT *uptr)
 {
+    lpt_context* ctx = (lpt_context*) uptr->lpt_ctx;
+    t_bool async;
+
+    if (ctx) {
+        async = ctx->asynch_io;
+        lpt_io_flush (uptr);                                /* write out buffer */
+        ctx->asynch_uninit();                               /* stop writer */
+        uptr->lpt_ctx = NULL;
+        delete ctx;
+        if (async)                                          /* drop its events */
+            sim_async_process_io_events_for_console();
+        }
+    uptr->io_flush = NULL;
+    uptr->a_check_completion = NULL;
+    if (lpt_stall) {                                        /* guest was waiting */
+        lpt_stall = FALSE;
+        sim_cancel (uptr);
+        lpt_csr = lpt_csr | CSR_DONE;
+        if (lpt_csr & CSR_IE)
+            SET_INT (LPT);
+        }
     lpt_csr = lpt_csr | CSR_ERR;
     return detach_unit (uptr);
 }
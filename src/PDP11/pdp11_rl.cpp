@@ -70,6 +70,17 @@
    - PDP-11 Unibus 22b systems - the RL11 behaves as an 18b Unibus
      peripheral and must go through the I/O map
    - VAX Q22 systems - the RL11 must go through the I/O map
+
+   If asynchronous I/O is enabled when a drive is attached, host file
+   transfers for the drive are performed by an IOP thread, so the VCPU
+   executing the service routine is not stalled by the host disk.  Data
+   transfer commands are then serviced in two phases: the top phase checks
+   the command, fetches write data from memory and queues the host transfer;
+   on completion the unit is posted to the AIO queue and rescheduled, and the
+   bottom phase stores read data, updates the registers and sets done.  The
+   drive reads as not ready until the bottom phase completes, just as while
+   the unit is scheduled, so the command sequence seen by the guest is the
+   same as with synchronous I/O.
 */
 
 #if defined (VM_PDP10)                                  /* PDP10 version */
@@ -111,6 +122,11 @@ extern uint32 cpu_opt;
 
 #define TRK             u3                              /* current track */
 #define STAT            u4                              /* status */
+#define IOSTATE         u5                              /* async transfer state */
+#define  RL_IOIDLE      0                               /* no transfer */
+#define  RL_IOPEND      1                               /* queued to IOP thread */
+#define  RL_IODONE      2                               /* completed, bottom phase next */
+#define rl_ctx          up8                             /* async I/O context */
 
 /* RLDS, NI = not implemented, * = kept in STAT, ^ = kept in TRK */
 
@@ -201,8 +217,32 @@ int32 rlmp = 0, rlmp1 = 0, rlmp2 = 0;                   /* mp register queue */
 int32 rl_swait = 10;                                    /* seek wait */
 int32 rl_rwait = 10;                                    /* rotate wait */
 int32 rl_stopioe = 1;                                   /* stop on error */
+int32 rl_xwc = 0;                                       /* wc of transfer in progress */
 AUTO_INIT_DEVLOCK(rl_lock);                             /* device structures lock */
 
+/* Host file transfer context, one per attached drive */
+
+class rl_context : public aio_context
+{
+public:
+    rl_context(UNIT* uptr) : aio_context(uptr)
+    {
+        io_op = RLOP_DONE;
+    }
+    t_bool has_request() { return io_op != RLOP_DONE; }
+    void perform_request();
+    void perform_flush() { fflush (uptr->fileref); }
+    void perform_io();
+
+public:
+    enum { RLOP_DONE = 0, RLOP_READ, RLOP_WRITE };
+    volatile int        io_op;                          /* queued operation */
+    int                 op;                             /* operation */
+    t_addr              pos;                            /* file position */
+    int32               wc;                             /* words to transfer */
+    int32               xwc;                            /* words transferred */
+};
+
 t_stat rl_rd (int32 *data, int32 PA, int32 access);
 t_stat rl_wr (int32 data, int32 PA, int32 access);
 t_stat rl_svc (RUN_SVC_DECL, UNIT *uptr);
@@ -210,6 +250,12 @@ t_stat rl_reset (DEVICE *dptr);
 void rl_set_done (int32 error);
 t_stat rl_boot (int32 unitno, DEVICE *dptr);
 t_stat rl_attach (UNIT *uptr, char *cptr);
+t_stat rl_detach (UNIT *uptr);
+void rl_reset_aio (DEVICE *dptr);
+t_stat rl_xfer_end (RUN_DECL, UNIT *uptr);
+void rl_io_complete (UNIT *uptr);
+void rl_io_flush (UNIT *uptr);
+t_bool rl_busy (UNIT *uptr);
 t_stat rl_set_size (UNIT *uptr, int32 val, char *cptr, void *desc);
 t_stat rl_set_bad (UNIT *uptr, int32 val, char *cptr, void *desc);
 
@@ -280,7 +326,7 @@ DEVICE rl_dev = {
     "RL", rl_unit, rl_reg, rl_mod,
     RL_NUMDR, DEV_RDX, 24, 1, DEV_RDX, 16,
     NULL, NULL, &rl_reset,
-    &rl_boot, &rl_attach, NULL,
+    &rl_boot, &rl_attach, &rl_detach,
     &rl_dib, DEV_DISABLE | DEV_UBUS | DEV_QBUS
     };
 
@@ -305,7 +351,7 @@ switch ((PA >> 1) & 07) {                               /* decode PA<2:1> */
         if (rlcs & RLCS_ALLERR)
             rlcs = rlcs | RLCS_ERR;
         uptr = rl_dev.units[GET_DRIVE (rlcs)];
-        if (sim_is_active (uptr))
+        if (rl_busy (uptr))
             rlcs = rlcs & ~RLCS_DRDY;
         else rlcs = rlcs | RLCS_DRDY;                   /* see if ready */
         *data = rlcs;
@@ -348,7 +394,7 @@ switch ((PA >> 1) & 07) {                               /* decode PA<2:1> */
         if (rlcs & RLCS_ALLERR)
             rlcs = rlcs | RLCS_ERR;
         uptr = rl_dev.units[GET_DRIVE (data)];          /* get new drive */
-        if (sim_is_active (uptr))
+        if (rl_busy (uptr))
             rlcs = rlcs & ~RLCS_DRDY;
         else rlcs = rlcs | RLCS_DRDY;                   /* see if ready */
 
@@ -432,17 +478,26 @@ return SCPE_OK;
    Else complete data transfer command
 
    The unit control block contains the function and cylinder for
-   the current command.
+   the current command.  A data transfer is started here (top phase)
+   and finished by rl_xfer_end (bottom phase), either right away for
+   synchronous I/O or when the unit is rescheduled by rl_io_complete.
 */
 
 t_stat rl_svc (RUN_SVC_DECL, UNIT *uptr)
 {
 AUTO_LOCK(rl_lock);
 RUN_SVC_CHECK_CANCELLED(uptr);
-int32 err, wc, maxwc, t;
+rl_context* ctx = (rl_context*) uptr->rl_ctx;
+int32 wc, maxwc, t;
 int32 i, func, da, awc;
 uint32 ma;
-uint16 comp;
+
+if (uptr->IOSTATE == RL_IOPEND)                         /* host xfer pending? */
+    return SCPE_OK;                                     /* wait for completion */
+if (uptr->IOSTATE == RL_IODONE) {                       /* host xfer done? */
+    uptr->IOSTATE = RL_IOIDLE;
+    return rl_xfer_end (RUN_PASS, uptr);                /* bottom phase */
+    }
 
 func = GET_FUNC (rlcs);                                 /* get function */
 if (func == RLCS_GSTA) {                                /* get status */
@@ -497,12 +552,56 @@ wc = 0200000 - rlmp;                                    /* get true wc */
 maxwc = (RL_NUMSC - GET_SECT (rlda)) * RL_NUMWD;        /* max transfer */
 if (wc > maxwc)                                         /* track overrun? */
     wc = maxwc;
-err = fseek (uptr->fileref, da * sizeof (int16), SEEK_SET);
 
-if ((func >= RLCS_READ) && (err == 0)) {                /* read (no hdr)? */
-    i = (int32) fxread (rlxb, sizeof (int16), wc, uptr->fileref);
-    err = ferror (uptr->fileref);
-    for ( ; i < wc; i++)                                /* fill buffer */
+ctx->op = rl_context::RLOP_READ;                        /* read (no hdr), wchk */
+ctx->pos = da * sizeof (int16);
+ctx->wc = wc;
+ctx->xwc = 0;
+ctx->io_status = SCPE_OK;
+if (func == RLCS_WRITE) {                               /* write? */
+    if (t = Map_ReadW (RUN_PASS, ma, wc << 1, rlxb)) {            /* fetch buffer */
+        rlcs = rlcs | RLCS_ERR | RLCS_NXM;              /* nxm */
+        wc = wc - t;                                    /* adj xfer lnt */
+        }
+    awc = (wc + (RL_NUMWD - 1)) & ~(RL_NUMWD - 1);      /* clr to */
+    for (i = wc; i < awc; i++)                          /* end of blk */
+        rlxb[i] = 0;
+    ctx->op = rl_context::RLOP_WRITE;
+    ctx->wc = awc;
+    }
+rl_xwc = wc;                                            /* save for bottom phase */
+
+if (ctx->wc == 0)                                       /* no xfer? */
+    return rl_xfer_end (RUN_PASS, uptr);
+if (ctx->asynch_io) {                                   /* queue to IOP thread */
+    uptr->IOSTATE = RL_IOPEND;
+    ctx->io_reset_count = uptr->device->a_reset_count;
+    smp_wmb();
+    ctx->io_op = ctx->op;
+    ctx->io_event_signal();
+    return SCPE_OK;                                     /* done for now until completion */
+    }
+ctx->perform_io();                                      /* synchronous */
+return rl_xfer_end (RUN_PASS, uptr);
+}
+
+/* Complete data transfer command, after host file transfer */
+
+t_stat rl_xfer_end (RUN_DECL, UNIT *uptr)
+{
+rl_context* ctx = (rl_context*) uptr->rl_ctx;
+int32 err, wc, t;
+int32 i, func, awc;
+uint32 ma;
+uint16 comp;
+
+func = GET_FUNC (rlcs);                                 /* get function */
+ma = (rlbae << 16) | rlba;                              /* get mem addr */
+wc = rl_xwc;                                            /* get xfer wc */
+err = (ctx->io_status != SCPE_OK);
+
+if (func >= RLCS_READ) {                                /* read (no hdr)? */
+    for (i = ctx->xwc; i < wc; i++)                     /* fill buffer */
         rlxb[i] = 0;
     if (t = Map_WriteW (RUN_PASS, ma, wc << 1, rlxb)) {           /* store buffer */
         rlcs = rlcs | RLCS_ERR | RLCS_NXM;              /* nxm */
@@ -510,27 +609,11 @@ if ((func >= RLCS_READ) && (err == 0)) {                /* read (no hdr)? */
         }
     }                                                   /* end read */
 
-if ((func == RLCS_WRITE) && (err == 0)) {               /* write? */
-    if (t = Map_ReadW (RUN_PASS, ma, wc << 1, rlxb)) {            /* fetch buffer */
-        rlcs = rlcs | RLCS_ERR | RLCS_NXM;              /* nxm */
-        wc = wc - t;                                    /* adj xfer lnt */
-        }
-    if (wc) {                                           /* any xfer? */
-        awc = (wc + (RL_NUMWD - 1)) & ~(RL_NUMWD - 1);  /* clr to */
-        for (i = wc; i < awc; i++)                      /* end of blk */
-            rlxb[i] = 0;
-        fxwrite (rlxb, sizeof (int16), awc, uptr->fileref);
-        err = ferror (uptr->fileref);
-        }
-    }                                                   /* end write */
-
 if ((func == RLCS_WCHK) && (err == 0)) {                /* write check? */
-    i = (int32) fxread (rlxb, sizeof (int16), wc, uptr->fileref);
-    err = ferror (uptr->fileref);
-    for ( ; i < wc; i++)                                /* fill buffer */
+    for (i = ctx->xwc; i < wc; i++)                     /* fill buffer */
         rlxb[i] = 0;
     awc = wc;                                           /* save wc */
-    for (wc = 0; (err == 0) && (wc < awc); wc++)  {     /* loop thru buf */
+    for (wc = 0; wc < awc; wc++)  {                     /* loop thru buf */
         if (Map_ReadW (RUN_PASS, ma + (wc << 1), 2, &comp)) {     /* mem wd */
             rlcs = rlcs | RLCS_ERR | RLCS_NXM;          /* nxm */
             break;
@@ -550,12 +633,97 @@ rlcs = (rlcs & ~RLCS_MEX) | ((rlbae & RLCS_M_MEX) << RLCS_V_MEX);
 rlda = rlda + ((wc + (RL_NUMWD - 1)) / RL_NUMWD);
 rl_set_done (0);
 
+if (err != 0)                                           /* error? */
+    return SCPE_IOERR;                                  /* reported by perform_io */
+return SCPE_OK;
+}
+
+/* Drive is not ready while scheduled or while its host transfer is in progress */
+
+t_bool rl_busy (UNIT *uptr)
+{
+return sim_is_active (uptr) || (uptr->IOSTATE != RL_IOIDLE);
+}
+
+/* Perform host file transfer, on IOP thread or synchronously on VCPU thread */
+
+void rl_context::perform_io()
+{
+int32 err;
+
+err = fseek (uptr->fileref, pos, SEEK_SET);
+if (err == 0) {
+    if (op == RLOP_WRITE) {
+        fxwrite (rlxb, sizeof (int16), wc, uptr->fileref);
+        xwc = wc;
+        }
+    else xwc = (int32) fxread (rlxb, sizeof (int16), wc, uptr->fileref);
+    err = ferror (uptr->fileref);
+    }
 if (err != 0) {                                         /* error? */
     smp_perror ("RL I/O error");
     clearerr (uptr->fileref);
-    return SCPE_IOERR;
     }
-return SCPE_OK;
+io_status = err? SCPE_IOERR: SCPE_OK;
+}
+
+void rl_context::perform_request()
+{
+perform_io();
+io_op = RLOP_DONE;
+sim_async_post_io_event(uptr);
+}
+
+SMP_THREAD_ROUTINE_DECL rl_io_thread (void* arg)
+{
+UNIT* volatile uptr = (UNIT*) arg;
+rl_context* ctx = (rl_context*) uptr->rl_ctx;
+char tname[16];
+
+sim_try
+{
+    smp_thread_init();
+
+    run_scope_context* rscx = new run_scope_context(NULL, SIM_THREAD_TYPE_IOP, ctx->io_thread);
+    rscx->set_current();
+
+    smp_set_thread_priority(SIMH_THREAD_PRIORITY_IOP);
+    sprintf(tname, "IOP_%s%d", uptr->device->name, sim_unit_index(uptr));
+    smp_set_thread_name(tname);
+
+    ctx->thread_loop();
+}
+sim_catch (sim_exception_SimError, exc)
+{
+    fprintf(smp_stderr, "\nFatal error in %s simulator, unexpected exception while executing RL IOP thread\n", sim_name);
+    fprintf(smp_stderr, "Exception cause: %s\n", exc->get_message());
+    fprintf(smp_stderr, "Terminating the simulator abnormally...\n");
+    exit(1);
+}
+sim_end_try
+
+SMP_THREAD_ROUTINE_END;
+}
+
+/* Host transfer completed - invoked by primary VCPU holding unit lock */
+
+void rl_io_complete (UNIT *uptr)
+{
+rl_context* ctx = (rl_context*) uptr->rl_ctx;
+
+if (ctx == NULL || uptr->IOSTATE != RL_IOPEND ||        /* detached or reset? */
+    ctx->io_reset_count != uptr->device->a_reset_count)
+    return;
+uptr->IOSTATE = RL_IODONE;
+sim_activate (uptr, 0);                                 /* run bottom phase */
+}
+
+void rl_io_flush (UNIT *uptr)
+{
+rl_context* ctx = (rl_context*) uptr->rl_ctx;
+
+if (ctx)
+    ctx->flush();
 }
 
 /* Set done and possibly errors */
@@ -569,6 +737,38 @@ else CLR_INT (RL);
 return;
 }
 
+/* Wait for host transfers in progress and drop their completion events.
+
+   Caller is either console thread or VCPU thread holding rl_lock.  As with
+   sim_disk_reset, AIO events are handled by the primary VCPU only, so reset
+   with asynchronous transfers outstanding is not supported on a secondary.
+*/
+
+void rl_reset_aio (DEVICE *dptr)
+{
+RUN_SCOPE_RSCX;
+t_bool any_async = FALSE;
+rl_context* ctx;
+uint32 k;
+
+for (k = 0; k < dptr->numunits; k++) {
+    ctx = (rl_context*) dptr->units[k]->rl_ctx;
+    if (ctx && ctx->asynch_io)
+        any_async = TRUE;
+    }
+if (any_async && rscx->thread_type == SIM_THREAD_TYPE_CPU && !cpu_unit->is_primary_cpu())
+    panic("RL controller device reset attempted by a secondary CPU");
+
+dptr->a_reset_count++;
+for (k = 0; k < dptr->numunits; k++)
+    rl_io_flush (dptr->units[k]);
+if (any_async) {
+    if (rscx->thread_type == SIM_THREAD_TYPE_CONSOLE)
+        sim_async_process_io_events_for_console();
+    else sim_async_process_io_events(RUN_PASS, NULL, TRUE);
+    }
+}
+
 /* Device reset
 
    Note that the RL11 does NOT recalibrate its drives on RESET
@@ -584,10 +784,12 @@ UNIT *uptr;
 rlcs = CSR_DONE;
 rlda = rlba = rlbae = rlmp = rlmp1 = rlmp2 = 0;
 CLR_INT (RL);
+rl_reset_aio (&rl_dev);                                 /* drain host xfers */
 for (i = 0; i < RL_NUMDR; i++) {
     uptr = rl_dev.units[i];
     sim_cancel (uptr);
     uptr->STAT = 0;
+    uptr->IOSTATE = RL_IOIDLE;
     }
 if (rlxb == NULL)
     rlxb = (uint16 *) calloc (RL_MAXFR, sizeof (uint16));
@@ -607,6 +809,16 @@ uptr->capac = (uptr->flags & UNIT_RL02)? RL02_SIZE: RL01_SIZE;
 r = attach_unit (uptr, cptr);                           /* attach unit */
 if (r != SCPE_OK)                                       /* error? */
     return r;
+rl_context* ctx = new rl_context (uptr);                /* xfer context */
+ctx->dptr = &rl_dev;
+uptr->rl_ctx = ctx;
+uptr->IOSTATE = RL_IOIDLE;
+if (sim_asynch_enabled) {                               /* async I/O? */
+    uptr->a_check_completion = rl_io_complete;
+    ctx->asynch_init (rl_io_thread, (void*) uptr);
+    ctx->asynch_io = TRUE;
+    }
+uptr->io_flush = rl_io_flush;
 uptr->TRK = 0;                                          /* cylinder 0 */
 uptr->STAT = RLDS_VCK;                                  /* new volume */
 if ((p = sim_fsize (uptr->fileref)) == 0) {             /* new disk image? */
@@ -627,6 +839,32 @@ else {
 return SCPE_OK;
 }
 
+/* Detach routine */
+
+t_stat rl_detach (UNIT *uptr)
+{
+rl_context* ctx = (rl_context*) uptr->rl_ctx;
+t_bool async;
+
+if (ctx) {
+    async = ctx->asynch_io;
+    ctx->flush();                                       /* wait for xfer */
+    ctx->asynch_uninit();                               /* stop IOP thread */
+    uptr->rl_ctx = NULL;
+    delete ctx;
+    if (async)                                          /* drop its event */
+        sim_async_process_io_events_for_console();
+    }
+uptr->io_flush = NULL;
+uptr->a_check_completion = NULL;
+if (uptr->IOSTATE != RL_IOIDLE) {                       /* xfer cut short? */
+    uptr->IOSTATE = RL_IOIDLE;
+    sim_cancel (uptr);
+    rl_set_done (RLCS_ERR | RLCS_INCMP);
+    }
+return detach_unit (uptr);
+}
+
 /* Set size routine */
 
 t_stat rl_set_size (UNIT *uptr, int32 val, char *cptr, void *desc)
@@ -626,9 +626,14 @@ typedef struct
     uint32              htmo;                           /* host timeout */
     struct uq_ring      cq;                             /* cmd ring */
     struct uq_ring      rq;                             /* rsp ring */
+    t_bool              rint_batch;                     /* defer ring intr to end of pass */
+    uint32              rint_pend;                      /* deferred ring intr, RINT_xx */
     struct rqpkt        pak[RQ_NPKTS];                  /* packet queue */
 } MSC;
 
+#define RINT_CQ         1                               /* cmd ring went full to non-full */
+#define RINT_RQ         2                               /* rsp ring went empty to non-empty */
+
 /* debugging bitmaps */
 #define DBG_TRC  0x0001                                 /* trace routine calls */
 #define DBG_INI  0x0002                                 /* display setup/init sequence info */
@@ -680,6 +685,8 @@ static char *rq_cmdname[] = {
 
 t_stat rq_rd (int32 *data, int32 PA, int32 access);
 t_stat rq_wr (int32 data, int32 PA, int32 access);
+t_stat rq_rdl (int32 *data, int32 PA);
+t_stat rq_wrl (int32 data, int32 PA);
 t_stat rq_svc (RUN_SVC_DECL, UNIT *uptr);
 t_stat rq_tmrsvc (RUN_SVC_DECL, UNIT *uptr);
 t_stat rq_quesvc (RUN_SVC_DECL, UNIT *uptr);
@@ -725,6 +732,8 @@ void rq_putr_unit (MSC *cp, int32 pkt, UNIT *uptr, uint32 lu, t_bool all);
 void rq_setf_unit (MSC *cp, int32 pkt, UNIT *uptr);
 void rq_init_int (MSC *cp);
 void rq_ring_int (RUN_DECL, MSC *cp, struct uq_ring *ring);
+void rq_ring_int_flush (RUN_DECL, MSC *cp);
+t_bool rq_drain (RUN_DECL, MSC *cp);
 t_bool rq_fatal (MSC *cp, uint32 err);
 UNIT *rq_getucb (MSC *cp, uint32 lu);
 int32 rq_map_pa (uint32 pa);
@@ -744,7 +753,7 @@ MSC rq_ctx = { 0 };
 
 DIB rq_dib = {
     IOBA_RQ, IOLN_RQ, &rq_rd, &rq_wr,
-    1, IVCL (RQ), 0, { &rq_inta }
+    1, IVCL (RQ), 0, { &rq_inta }, &rq_rdl, &rq_wrl
     };
 
 UNIT* rq_unit[] = {
@@ -890,7 +899,7 @@ MSC rqb_ctx = { 1 };
 
 DIB rqb_dib = {
     IOBA_RQB, IOLN_RQB, &rq_rd, &rq_wr,
-    1, IVCL (RQ), 0, { &rq_inta }
+    1, IVCL (RQ), 0, { &rq_inta }, &rq_rdl, &rq_wrl
     };
 
 UNIT* rqb_unit[] = {
@@ -959,7 +968,7 @@ MSC rqc_ctx = { 2 };
 
 DIB rqc_dib = {
     IOBA_RQC, IOLN_RQC, &rq_rd, &rq_wr,
-    1, IVCL (RQ), 0, { &rq_inta }
+    1, IVCL (RQ), 0, { &rq_inta }, &rq_rdl, &rq_wrl
     };
 
 UNIT* rqc_unit[] = {
@@ -1027,7 +1036,7 @@ MSC rqd_ctx = { 3 };
 
 DIB rqd_dib = {
     IOBA_RQD, IOLN_RQD, &rq_rd, &rq_wr,
-    1, IVCL (RQ), 0, { &rq_inta }
+    1, IVCL (RQ), 0, { &rq_inta }, &rq_rdl, &rq_wrl
     };
 
 UNIT* rqd_unit[] = {
@@ -1108,23 +1117,18 @@ static smp_lock** rq_lockmap[RQ_NUMCT] = {
    base + 2     SA      read/write
 */
 
-t_stat rq_rd (int32 *data, int32 PA, int32 access)
+static int32 rq_rd_locked (RUN_DECL, int32 cidx, int32 PA, int32 access)
 {
-    RUN_SCOPE;
-    int32 cidx = rq_map_pa ((uint32) PA);
-    if (cidx < 0)
-        return SCPE_IERR;
-
-    AUTO_LOCK_CTRL(cidx);
     MSC *cp = rq_ctxmap[cidx];
     DEVICE *dptr = rq_devmap[cidx];
+    int32 data = 0;
 
     sim_debug(DBG_REG, dptr, "rq_rd(PA=0x%08X [%s], access=%d)\n", PA, ((PA >> 1) & 01) ? "IP" : "SA", access);
 
     switch ((PA >> 1) & 01)                                 /* decode PA<1> */
     {
     case 0:                                             /* IP */
-        *data = 0;                                      /* reads zero */
+        data = 0;                                       /* reads zero */
         if (cp->csta == CST_S3_PPB)                     /* waiting for poll? */
             rq_step4 (RUN_PASS, cp);
         else if (cp->csta == CST_UP)                    /* if up */
@@ -1136,21 +1140,16 @@ t_stat rq_rd (int32 *data, int32 PA, int32 access)
         break;
 
     case 1:                                             /* SA */
-        *data = cp->sa;
+        data = cp->sa;
         break;
     }
 
-    return SCPE_OK;
+    return data;
 }
 
-t_stat rq_wr (int32 data, int32 PA, int32 access)
+static void rq_wr_locked (int32 cidx, int32 data, int32 PA, int32 access)
 {
     RUN_SCOPE_RSCX_ONLY;
-    int32 cidx = rq_map_pa ((uint32) PA);
-    if (cidx < 0)
-        return SCPE_IERR;
-
-    AUTO_LOCK_CTRL(cidx);
     MSC *cp = rq_ctxmap[cidx];
     DEVICE *dptr = rq_devmap[cidx];
 
@@ -1171,7 +1170,62 @@ t_stat rq_wr (int32 data, int32 PA, int32 access)
             sim_activate (dptr->units[RQ_QUEUE], rq_itime4);
         break;
     }
+}
+
+t_stat rq_rd (int32 *data, int32 PA, int32 access)
+{
+    RUN_SCOPE;
+    int32 cidx = rq_map_pa ((uint32) PA);
+    if (cidx < 0)
+        return SCPE_IERR;
+
+    AUTO_LOCK_CTRL(cidx);
+    *data = rq_rd_locked (RUN_PASS, cidx, PA, access);
+    return SCPE_OK;
+}
+
+t_stat rq_wr (int32 data, int32 PA, int32 access)
+{
+    int32 cidx = rq_map_pa ((uint32) PA);
+    if (cidx < 0)
+        return SCPE_IERR;
+
+    AUTO_LOCK_CTRL(cidx);
+    rq_wr_locked (cidx, data, PA, access);
+    return SCPE_OK;
+}
+
+/*
+ * Longword access to IP and SA is performed as IP access followed by SA access,
+ * same as two word accesses would be, but under a single acquisition of controller lock.
+ */
+
+t_stat rq_rdl (int32 *data, int32 PA)
+{
+    RUN_SCOPE;
+    int32 cidx = rq_map_pa ((uint32) PA);
+    if (cidx < 0)
+    {
+        *data = 0;
+        return SCPE_IERR;
+    }
+
+    AUTO_LOCK_CTRL(cidx);
+    int32 lo = rq_rd_locked (RUN_PASS, cidx, PA, READ);
+    int32 hi = rq_rd_locked (RUN_PASS, cidx, PA + 2, READ);
+    *data = (hi << 16) | (lo & 0xFFFF);
+    return SCPE_OK;
+}
+
+t_stat rq_wrl (int32 data, int32 PA)
+{
+    int32 cidx = rq_map_pa ((uint32) PA);
+    if (cidx < 0)
+        return SCPE_IERR;
 
+    AUTO_LOCK_CTRL(cidx);
+    rq_wr_locked (cidx, data & 0xFFFF, PA, WRITE);
+    rq_wr_locked (cidx, (data >> 16) & 0xFFFF, PA + 2, WRITE);
     return SCPE_OK;
 }
 
@@ -1236,18 +1290,20 @@ t_bool rq_step4 (RUN_DECL, MSC *cp)
    queues, response queue) require servicing.  Also invoked during
    initialization to provide some delay to the next step.
 
+   Service passes are repeated until the queues are idle (or RQ_NPKTS
+   passes have been made), each pass doing the following:
+
    Process at most one item off each unit queue
    If the unit queues were empty, process at most one item off the host queue
-   Process at most one item off the response queue
+   Send as many items off the response queue as the response ring can take
 
+   Ring interrupts raised during the passes are posted once, at the end.
    If all queues are idle, terminate thread
 */
 
 t_stat rq_quesvc (RUN_SVC_DECL, UNIT *uptr)
 {
-    int32 i, cnid;
-    int32 pkt = 0;
-    UNIT *nuptr;
+    int32 i;
     AUTO_LOCK_CTRL(uptr->cnum);
     RUN_SVC_CHECK_CANCELLED(uptr);
     MSC *cp = rq_ctxmap[uptr->cnum];
@@ -1333,6 +1389,29 @@ t_stat rq_quesvc (RUN_SVC_DECL, UNIT *uptr)
         return SCPE_OK;
     }
 
+    t_bool more = FALSE;
+    cp->rint_batch = TRUE;                                  /* coalesce ring intr */
+    for (i = 0; i < RQ_NPKTS; i++)
+    {
+        if (!(more = rq_drain (RUN_PASS, cp)))
+            break;
+    }
+    cp->rint_batch = FALSE;
+    rq_ring_int_flush (RUN_PASS, cp);                       /* post ring intr */
+    if (more)                                               /* more to do? */
+        sim_activate (uptr, rq_qtime);
+    return SCPE_OK;                                         /* done */
+}
+
+/* One queue service pass, returns TRUE if there may be more to do */
+
+t_bool rq_drain (RUN_DECL, MSC *cp)
+{
+    int32 i, cnid;
+    int32 pkt = 0, rpkt;
+    UNIT *nuptr;
+    DEVICE *dptr = rq_devmap[cp->cnum];
+
     for (i = 0; i < RQ_NUMDR; i++)                          /* chk unit q's */
     {
         nuptr = dptr->units[i];                             /* ptr to unit */
@@ -1340,13 +1419,13 @@ t_stat rq_quesvc (RUN_SVC_DECL, UNIT *uptr)
             continue;
         pkt = rq_deqh (cp, &nuptr->pktq);                   /* get top of q */
         if (!rq_mscp (cp, pkt, FALSE))                      /* process */
-            return SCPE_OK;
+            return FALSE;
     }
 
     if (pkt == 0 && cp->pip)                                /* polling? */
     {
         if (!rq_getpkt (RUN_PASS, cp, &pkt))                /* get host pkt */
-            return SCPE_OK;
+            return FALSE;
         if (pkt)                                            /* got one? */
         {
             sim_debug (DBG_REQ, dptr, "cmd=%04X(%3s), mod=%04X, unit=%d, bc=%04X%04X, ma=%04X%04X, lbn=%04X%04X\n", 
@@ -1361,13 +1440,13 @@ t_stat rq_quesvc (RUN_SVC_DECL, UNIT *uptr)
             if (cnid == UQ_CID_MSCP)                        /* MSCP packet? */
             {
                 if (!rq_mscp (cp, pkt, TRUE))               /* proc, q non-seq */
-                    return SCPE_OK;
+                    return FALSE;
             }
             else if (cnid == UQ_CID_DUP)                    /* DUP packet? */
             {
                 rq_putr (cp, pkt, OP_END, 0, ST_CMD | I_OPCD, RSP_LNT, UQ_TYP_SEQ);
                 if (!rq_putpkt (RUN_PASS, cp, pkt, TRUE))             /* ill cmd */
-                    return SCPE_OK;
+                    return FALSE;
             }
             else
             {
@@ -1380,16 +1459,15 @@ t_stat rq_quesvc (RUN_SVC_DECL, UNIT *uptr)
         }
     }
 
-    if (cp->rspq)                                           /* resp q? */
+    while (cp->rspq)                                        /* resp q? */
     {
-        pkt = rq_deqh (cp, &cp->rspq);                      /* get top of q */
-        if (!rq_putpkt (RUN_PASS, cp, pkt, FALSE))          /* send to host */
-            return SCPE_OK;
-        sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_quesvc - rq_putpkt failed - 1\n");
+        pkt = rpkt = rq_deqh (cp, &cp->rspq);               /* get top of q */
+        if (!rq_putpkt (RUN_PASS, cp, rpkt, FALSE))         /* send to host */
+            return FALSE;
+        if (cp->rspq == rpkt)                               /* rsp ring full? */
+            break;
     }
-    if (pkt)                                                /* more to do? */
-        sim_activate (uptr, rq_qtime);
-    return SCPE_OK;                                         /* done */
+    return pkt != 0;
 }
 
 /* Clock service (roughly once per second) */
@@ -2451,17 +2529,26 @@ t_bool rq_getdesc (RUN_DECL, MSC *cp, struct uq_ring *ring, uint32 *desc)
 
 #if defined(VM_VAX_MP)
     /* 
-     * Execute RMB before fetching high word from the host, to ensure that in
-     * multiprocessor case fetching Ownership bit comes before fetching low word
-     * and access is not reordered. Note that OpenVMS PUDRIVER stores descriptors
-     * to memory atomically as a longword with MOVL or BISL.
+     * OpenVMS PUDRIVER stores descriptors to memory atomically as a longword with
+     * MOVL or BISL.  An aligned descriptor is fetched with a single longword read
+     * (see Map_ReadW), which cannot see Ownership bit and address out of step.
+     * Otherwise execute RMB before fetching high word from the host, to ensure that
+     * fetching Ownership bit comes before fetching low word and access is not reordered.
      */
     smp_mb();                                               /* segregate with previous operations */
-    if (Map_ReadW (RUN_PASS, addr + 2, 2, d + 1))           /* fetch desc hi word */
-        return rq_fatal (cp, PE_QRE);                       /* err? dead */
-    smp_rmb();
-    if (Map_ReadW (RUN_PASS, addr, 2, d))                   /* fetch desc low word */
-        return rq_fatal (cp, PE_QRE);                       /* err? dead */
+    if ((addr & 3) == 0)
+    {
+        if (Map_ReadW (RUN_PASS, addr, 4, d))               /* fetch desc as longword */
+            return rq_fatal (cp, PE_QRE);                   /* err? dead */
+    }
+    else
+    {
+        if (Map_ReadW (RUN_PASS, addr + 2, 2, d + 1))       /* fetch desc hi word */
+            return rq_fatal (cp, PE_QRE);                   /* err? dead */
+        smp_rmb();
+        if (Map_ReadW (RUN_PASS, addr, 2, d))               /* fetch desc low word */
+            return rq_fatal (cp, PE_QRE);                   /* err? dead */
+    }
 #else
     if (Map_ReadW (RUN_PASS, addr, 4, d))                   /* fetch desc */
         return rq_fatal (cp, PE_QRE);                       /* err? dead */
@@ -2496,11 +2583,20 @@ t_bool rq_putdesc (RUN_DECL, MSC *cp, struct uq_ring *ring, uint32 desc)
     d[1] = (newd >> 16) & 0xFFFF;
 #if defined(VM_VAX_MP)
     /* execute MB (to sync memory in multiprocessor case) before posting ownership bit back to host */
-    if (Map_WriteW (RUN_PASS, addr, 2, d))                  /* store desc low word */
-        return rq_fatal (cp, PE_QWE);                       /* err? dead */
-    smp_mb();
-    if (Map_WriteW (RUN_PASS, addr + 2, 2, d + 1))          /* store desc hi word (with O-bit) */
-        return rq_fatal (cp, PE_QWE);                       /* err? dead */
+    if ((addr & 3) == 0)
+    {
+        smp_mb();
+        if (Map_WriteW (RUN_PASS, addr, 4, d))              /* store desc as longword */
+            return rq_fatal (cp, PE_QWE);                   /* err? dead */
+    }
+    else
+    {
+        if (Map_WriteW (RUN_PASS, addr, 2, d))              /* store desc low word */
+            return rq_fatal (cp, PE_QWE);                   /* err? dead */
+        smp_mb();
+        if (Map_WriteW (RUN_PASS, addr + 2, 2, d + 1))      /* store desc hi word (with O-bit) */
+            return rq_fatal (cp, PE_QWE);                   /* err? dead */
+    }
 #else
     if (Map_WriteW (RUN_PASS, addr, 4, d))                  /* store desc */
         return rq_fatal (cp, PE_QWE);                       /* err? dead */
@@ -2514,11 +2610,19 @@ t_bool rq_putdesc (RUN_DECL, MSC *cp, struct uq_ring *ring, uint32 desc)
             prva = ring->ba + ((ring->idx - 4) & (ring->lnt - 1));
 #if defined(VM_VAX_MP)
             smp_mb();                                       /* order access */
-            if (Map_ReadW (RUN_PASS, prva + 2, 2, d + 1))   /* read prv hi word (incl. O-bit) */
-                return rq_fatal (cp, PE_QRE);
-            smp_rmb();
-            if (Map_ReadW (RUN_PASS, prva, 2, d))           /* read prv low word */
-                return rq_fatal (cp, PE_QRE);
+            if ((prva & 3) == 0)
+            {
+                if (Map_ReadW (RUN_PASS, prva, 4, d))       /* read prv as longword */
+                    return rq_fatal (cp, PE_QRE);
+            }
+            else
+            {
+                if (Map_ReadW (RUN_PASS, prva + 2, 2, d + 1))   /* read prv hi word (incl. O-bit) */
+                    return rq_fatal (cp, PE_QRE);
+                smp_rmb();
+                if (Map_ReadW (RUN_PASS, prva, 2, d))       /* read prv low word */
+                    return rq_fatal (cp, PE_QRE);
+            }
 #else
             if (Map_ReadW (RUN_PASS, prva, 4, d))           /* read prv */
                 return rq_fatal (cp, PE_QRE);
@@ -2611,13 +2715,26 @@ void rq_init_int (MSC *cp)
     }
 }
 
-/* Post interrupt during putpkt - note that NXMs are ignored! */
+/* Post interrupt during putpkt - note that NXMs are ignored!
+   While the queue service is making its passes, the interrupt is only
+   recorded, and posted for both rings at once by rq_ring_int_flush. */
 
 void rq_ring_int (RUN_DECL, MSC *cp, struct uq_ring *ring)
 {
-    uint32 iadr = cp->comm + ring->ioff;                    /* addr intr wd */
+    cp->rint_pend |= (ring == &cp->cq) ? RINT_CQ : RINT_RQ;
+    if (!cp->rint_batch)
+        rq_ring_int_flush (RUN_PASS, cp);
+}
+
+void rq_ring_int_flush (RUN_DECL, MSC *cp)
+{
+    uint32 pend = cp->rint_pend;
     uint16 flag = 1;
 
+    cp->rint_pend = 0;
+    if (pend == 0 || cp->csta != CST_UP)                    /* nothing or reset? */
+        return;
+
     /*
      * We are about to signal host that command ring transitioned full to non-full
      * or response ring transitioned empty to non-empty. Issue memory barrier
@@ -2625,7 +2742,10 @@ void rq_ring_int (RUN_DECL, MSC *cp, struct uq_ring *ring)
      * to the rings or data buffers.
      */
     smp_mb();
-    Map_WriteW (RUN_PASS, iadr, 2, &flag);                  /* write flag */
+    if (pend & RINT_CQ)                                     /* write flags */
+        Map_WriteW (RUN_PASS, cp->comm + cp->cq.ioff, 2, &flag);
+    if (pend & RINT_RQ)
+        Map_WriteW (RUN_PASS, cp->comm + cp->rq.ioff, 2, &flag);
     smp_mb();
 
     if (cp->s1dat & SA_S1H_VEC)                             /* if enb, intr */
@@ -2882,6 +3002,7 @@ t_stat rq_reset (DEVICE *dptr)
     cp->hat = cp->htmo;                                     /* default timer */
     cp->cq.ba = cp->cq.lnt = cp->cq.idx = 0;                /* clr cmd ring */
     cp->rq.ba = cp->rq.lnt = cp->rq.idx = 0;                /* clr rsp ring */
+    cp->rint_pend = 0;                                      /* no ring intr */
     cp->credits = (RQ_NPKTS / 2) - 1;                       /* init credits */
     cp->freq = 1;                                           /* init free list */
     for (i = 0; i < RQ_NPKTS; i++)                          /* all pkts free */
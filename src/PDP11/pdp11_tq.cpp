@@ -158,6 +158,9 @@ extern int32 cpu_opt;
 
 #define TQ_NPKTS        32                              /* # packets (pwr of 2) */
 #define TQ_M_NPKTS      (TQ_NPKTS - 1)                  /* mask */
+
+#define RINT_CQ         1                               /* cmd ring went full to non-full */
+#define RINT_RQ         2                               /* rsp ring went empty to non-empty */
 #define TQ_PKT_SIZE_W   32                              /* payload size (wds) */
 #define TQ_PKT_SIZE     (TQ_PKT_SIZE_W * sizeof (int16))
 
@@ -262,6 +265,8 @@ static uint32 tq_perr = 0;                              /* last error */
 static uint32 tq_cflgs = 0;                             /* ctrl flags */
 static uint32 tq_prgi = 0;                              /* purge int */
 static uint32 tq_pip = 0;                               /* poll in progress */
+static t_bool tq_rint_batch = FALSE;                    /* defer ring intr to end of pass */
+static uint32 tq_rint_pend = 0;                         /* deferred ring intr, RINT_xx */
 static struct uq_ring tq_cq = { 0 };                    /* cmd ring */
 static struct uq_ring tq_rq = { 0 };                    /* rsp ring */
 static struct tqpkt tq_pkt[TQ_NPKTS];                   /* packet queue */
@@ -407,6 +412,8 @@ void tq_setf_unit (int32 pkt, UNIT *uptr);
 uint32 tq_efl (UNIT *uptr);
 void tq_init_int (void);
 void tq_ring_int (RUN_DECL, struct uq_ring *ring);
+void tq_ring_int_flush (RUN_DECL);
+t_bool tq_drain (RUN_DECL);
 t_bool tq_fatal (uint32 err);
 UNIT *tq_getucb (uint32 lu);
 
@@ -655,10 +662,14 @@ t_bool tq_step4 (RUN_DECL)
    queues, response queue) require servicing.  Also invoked during
    initialization to provide some delay to the next step.
 
+   Service passes are repeated until the queues are idle (or TQ_NPKTS
+   passes have been made), each pass doing the following:
+
    Process at most one item off each unit queue
    If the unit queues were empty, process at most one item off the host queue
-   Process at most one item off the response queue
+   Send as many items off the response queue as the response ring can take
 
+   Ring interrupts raised during the passes are posted once, at the end.
    If all queues are idle, terminate thread
 */
 
@@ -666,9 +677,8 @@ t_stat tq_quesvc (RUN_SVC_DECL, UNIT *uptr)
 {
 AUTO_LOCK(tq_lock);
 RUN_SVC_CHECK_CANCELLED(uptr);
-int32 i, cnid;
-int32 pkt = 0;
-UNIT *nuptr;
+int32 i;
+t_bool more = FALSE;
 
 sim_debug(DBG_TRC, &tq_dev, "tq_quesvc\n");
 
@@ -736,17 +746,37 @@ if (tq_csta < CST_UP) {                                 /* still init? */
     return SCPE_OK;
     }                                                   /* end if */
 
+tq_rint_batch = TRUE;                                   /* coalesce ring intr */
+for (i = 0; i < TQ_NPKTS; i++) {
+    if (!(more = tq_drain (RUN_PASS)))
+        break;
+    }
+tq_rint_batch = FALSE;
+tq_ring_int_flush (RUN_PASS);                           /* post ring intr */
+if (more)                                               /* more to do? */
+    sim_activate (tq_unit[TQ_QUEUE], tq_qtime);
+return SCPE_OK;                                         /* done */
+}
+
+/* One queue service pass, returns TRUE if there may be more to do */
+
+t_bool tq_drain (RUN_DECL)
+{
+int32 i, cnid;
+int32 pkt = 0, rpkt;
+UNIT *nuptr;
+
 for (i = 0; i < TQ_NUMDR; i++) {                        /* chk unit q's */
     nuptr = tq_dev.units[i];                            /* ptr to unit */
     if (nuptr->cpkt || (nuptr->pktq == 0))
         continue;
     pkt = tq_deqh (&nuptr->pktq);                       /* get top of q */
     if (!tq_mscp (pkt, FALSE))                          /* process */
-        return SCPE_OK;
+        return FALSE;
     }
 if ((pkt == 0) && tq_pip) {                             /* polling? */
     if (!tq_getpkt (RUN_PASS, &pkt))                    /* get host pkt */
-        return SCPE_OK;
+        return FALSE;
     if (pkt) {                                          /* got one? */
         UNIT *up = tq_getucb (tq_pkt[pkt].d[CMD_UN]);
 
@@ -769,25 +799,25 @@ if ((pkt == 0) && tq_pip) {                             /* polling? */
         cnid = GETP (pkt, UQ_HCTC, CID);                /* get conn ID */
         if (cnid == UQ_CID_TMSCP) {                     /* TMSCP packet? */
             if (!tq_mscp (pkt, TRUE))                   /* proc, q non-seq */
-                return SCPE_OK;
+                return FALSE;
             }
         else if (cnid == UQ_CID_DUP) {                  /* DUP packet? */
             tq_putr (pkt, OP_END, 0, ST_CMD | I_OPCD, RSP_LNT, UQ_TYP_SEQ);
             if (!tq_putpkt (RUN_PASS, pkt, TRUE))       /* ill cmd */
-                return SCPE_OK;
+                return FALSE;
             }
         else return tq_fatal (PE_ICI);                  /* no, term thread */
         }                                               /* end if pkt */
     else tq_pip = 0;                                    /* discontinue poll */
     }                                                   /* end if pip */
-if (tq_rspq) {                                          /* resp q? */
-    pkt = tq_deqh (&tq_rspq);                           /* get top of q */
-    if (!tq_putpkt (RUN_PASS, pkt, FALSE))              /* send to host */
-        return SCPE_OK;
-    }                                                   /* end if resp q */
-if (pkt)                                                /* more to do? */
-    sim_activate (tq_unit[TQ_QUEUE], tq_qtime);
-return SCPE_OK;                                         /* done */
+while (tq_rspq) {                                       /* resp q? */
+    pkt = rpkt = tq_deqh (&tq_rspq);                    /* get top of q */
+    if (!tq_putpkt (RUN_PASS, rpkt, FALSE))             /* send to host */
+        return FALSE;
+    if (tq_rspq == rpkt)                                /* rsp ring full? */
+        break;
+    }                                                   /* end while resp q */
+return pkt != 0;
 }
 
 /* Clock service (roughly once per second) */
@@ -1911,17 +1941,23 @@ t_bool tq_getdesc (RUN_DECL, struct uq_ring *ring, uint32 *desc)
 
 #if defined(VM_VAX_MP)
     /* 
-     * Execute RMB before fetching high word from the host, to ensure that in
-     * multiprocessor case fetching Ownership bit comes before fetching low word
-     * and access is not reordered. Note that OpenVMS PUDRIVER stores descriptors
-     * to memory atomically as a longword with MOVL or BISL.
+     * Aligned descriptor is fetched with a single longword read, otherwise
+     * execute RMB before fetching high word from the host (see rq_getdesc).
      */
     smp_mb();                                               /* segregate with previous operations */
-    if (Map_ReadW (RUN_PASS, addr + 2, 2, d + 1))           /* fetch desc hi word */
-        return tq_fatal (PE_QRE);                           /* err? dead */
-    smp_rmb();
-    if (Map_ReadW (RUN_PASS, addr, 2, d))                   /* fetch desc low word */
-        return tq_fatal (PE_QRE);                           /* err? dead */
+    if ((addr & 3) == 0)
+    {
+        if (Map_ReadW (RUN_PASS, addr, 4, d))               /* fetch desc as longword */
+            return tq_fatal (PE_QRE);                       /* err? dead */
+    }
+    else
+    {
+        if (Map_ReadW (RUN_PASS, addr + 2, 2, d + 1))       /* fetch desc hi word */
+            return tq_fatal (PE_QRE);                       /* err? dead */
+        smp_rmb();
+        if (Map_ReadW (RUN_PASS, addr, 2, d))               /* fetch desc low word */
+            return tq_fatal (PE_QRE);                       /* err? dead */
+    }
 #else
     if (Map_ReadW (RUN_PASS, addr, 4, d))                   /* fetch desc */
         return tq_fatal (PE_QRE);                           /* err? dead */
@@ -1956,11 +1992,20 @@ t_bool tq_putdesc (RUN_DECL, struct uq_ring *ring, uint32 desc)
     d[1] = (newd >> 16) & 0xFFFF;
 #if defined(VM_VAX_MP)
     /* execute MB (to sync memory in multiprocessor case) before posting ownership bit back to host */
-    if (Map_WriteW (RUN_PASS, addr, 2, d))                  /* store desc low word */
-        return tq_fatal (PE_QWE);                           /* err? dead */
-    smp_mb();
-    if (Map_WriteW (RUN_PASS, addr + 2, 2, d + 1))          /* store desc hi word (with O-bit) */
-        return tq_fatal (PE_QWE);                           /* err? dead */
+    if ((addr & 3) == 0)
+    {
+        smp_mb();
+        if (Map_WriteW (RUN_PASS, addr, 4, d))              /* store desc as longword */
+            return tq_fatal (PE_QWE);                       /* err? dead */
+    }
+    else
+    {
+        if (Map_WriteW (RUN_PASS, addr, 2, d))              /* store desc low word */
+            return tq_fatal (PE_QWE);                       /* err? dead */
+        smp_mb();
+        if (Map_WriteW (RUN_PASS, addr + 2, 2, d + 1))      /* store desc hi word (with O-bit) */
+            return tq_fatal (PE_QWE);                       /* err? dead */
+    }
 #else
     if (Map_WriteW (RUN_PASS, addr, 4, d))                  /* store desc */
         return tq_fatal (PE_QWE);                           /* err? dead */
@@ -1974,11 +2019,19 @@ t_bool tq_putdesc (RUN_DECL, struct uq_ring *ring, uint32 desc)
             prva = ring->ba + ((ring->idx - 4) & (ring->lnt - 1));
 #if defined(VM_VAX_MP)
             smp_mb();                                       /* order access */
-            if (Map_ReadW (RUN_PASS, prva + 2, 2, d + 1))   /* read prv hi word (incl. O-bit) */
-                return tq_fatal (PE_QRE);
-            smp_rmb();
-            if (Map_ReadW (RUN_PASS, prva, 2, d))           /* read prv low word */
-                return tq_fatal (PE_QRE);
+            if ((prva & 3) == 0)
+            {
+                if (Map_ReadW (RUN_PASS, prva, 4, d))       /* read prv as longword */
+                    return tq_fatal (PE_QRE);
+            }
+            else
+            {
+                if (Map_ReadW (RUN_PASS, prva + 2, 2, d + 1))   /* read prv hi word (incl. O-bit) */
+                    return tq_fatal (PE_QRE);
+                smp_rmb();
+                if (Map_ReadW (RUN_PASS, prva, 2, d))       /* read prv low word */
+                    return tq_fatal (PE_QRE);
+            }
 #else
             if (Map_ReadW (RUN_PASS, prva, 4, d))           /* read prv */
                 return tq_fatal (PE_QRE);
@@ -2083,13 +2136,26 @@ void tq_init_int (void)
         SET_INT (TQ);
 }
 
-/* Post interrupt during putpkt - note that NXMs are ignored! */
+/* Post interrupt during putpkt - note that NXMs are ignored!
+   While the queue service is making its passes, the interrupt is only
+   recorded, and posted for both rings at once by tq_ring_int_flush. */
 
 void tq_ring_int (RUN_DECL, struct uq_ring *ring)
 {
-    uint32 iadr = tq_comm + ring->ioff;                     /* addr intr wd */
+    tq_rint_pend |= (ring == &tq_cq) ? RINT_CQ : RINT_RQ;
+    if (!tq_rint_batch)
+        tq_ring_int_flush (RUN_PASS);
+}
+
+void tq_ring_int_flush (RUN_DECL)
+{
+    uint32 pend = tq_rint_pend;
     uint16 flag = 1;
 
+    tq_rint_pend = 0;
+    if (pend == 0 || tq_csta != CST_UP)                     /* nothing or reset? */
+        return;
+
     /*
      * We are about to signal host that command ring transitioned full to non-full
      * or response ring transitioned empty to non-empty. Issue memory barrier
@@ -2097,7 +2163,10 @@ void tq_ring_int (RUN_DECL, struct uq_ring *ring)
      * to the rings or data buffers.
      */
     smp_mb();
-    Map_WriteW (RUN_PASS, iadr, 2, &flag);                  /* write flag */
+    if (pend & RINT_CQ)                                     /* write flags */
+        Map_WriteW (RUN_PASS, tq_comm + tq_cq.ioff, 2, &flag);
+    if (pend & RINT_RQ)
+        Map_WriteW (RUN_PASS, tq_comm + tq_rq.ioff, 2, &flag);
     smp_mb();
 
     if (tq_dib.vec)                                         /* if enb, intr */
@@ -2175,6 +2244,7 @@ tq_htmo = TQ_DHTMO;                                     /* default timeout */
 tq_hat = tq_htmo;                                       /* default timer */
 tq_cq.ba = tq_cq.lnt = tq_cq.idx = 0;                   /* clr cmd ring */
 tq_rq.ba = tq_rq.lnt = tq_rq.idx = 0;                   /* clr rsp ring */
+tq_rint_pend = 0;                                       /* no ring intr */
 tq_credits = (TQ_NPKTS / 2) - 1;                        /* init credits */
 tq_freq = 1;                                            /* init free list */
 for (i = 0; i < TQ_NPKTS; i++) {                        /* all pkts free */
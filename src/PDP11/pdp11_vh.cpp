@@ -282,11 +282,20 @@ typedef struct {
     uint16  tbuf1;
     uint16  tbuf2;
     uint16  txchar;     /* single character I/O */
+    t_uint64    txdma;  /* characters moved by DMA since connect */
+    t_uint64    txcpu;  /* host CPU nsec spent in DMA since connect */
+    t_uint64    txtimed;    /* characters moved by DMA while timing */
 } TMLX;
 
 static TMLN vh_ldsc[VH_MUXES * VH_LINES] = { {0} };
 static TMXR vh_desc = { VH_MUXES * VH_LINES, 0, 0, vh_ldsc };
 static TMLX vh_parm[VH_MUXES * VH_LINES] = { {0} };
+static t_uint64 vh_txcpu = 0;   /* host CPU nsec spent flushing output */
+static t_uint64 vh_txtot = 0;   /* characters moved by DMA */
+static t_uint64 vh_txtimed = 0; /* characters moved by DMA while timing */
+static t_bool vh_timing = FALSE;    /* measure host CPU time of output */
+
+#define VH_DMA_CHUNK    (256)   /* max chars fetched by DMA at once */
 
 /* debugging bitmaps */
 #define DBG_REG  0x0001                                 /* trace read/write registers */
@@ -313,6 +322,7 @@ static t_stat vh_reset (DEVICE *dptr);
 static t_stat vh_attach (UNIT *uptr, char *cptr);
 static t_stat vh_detach (UNIT *uptr);       
 static t_stat vh_show_detail (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
+static t_stat vh_show_stats (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
 static t_stat vh_show_rbuf (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
 static t_stat vh_show_txq (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
 static t_stat vh_putc (int32 vh, TMLX *lp, int32 chan, int32 data);
@@ -321,6 +331,8 @@ static t_stat vh_setnl (UNIT *uptr, int32 val, char *cptr, void *desc);
 static t_stat vh_set_log (UNIT *uptr, int32 val, char *cptr, void *desc);
 static t_stat vh_set_nolog (UNIT *uptr, int32 val, char *cptr, void *desc);
 static t_stat vh_show_log (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
+static t_stat vh_set_timing (UNIT *uptr, int32 val, char *cptr, void *desc);
+static t_stat vh_show_timing (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
 
 int32 tmxr_send_buffered_data (TMLN *lp);
 
@@ -377,7 +389,13 @@ static const MTAB vh_mod[] = {
     { MTAB_XTD | MTAB_VDV | MTAB_NMO, 1, "CONNECTIONS", NULL,
         NULL, &tmxr_show_cstat, (void *) &vh_desc },
     { MTAB_XTD | MTAB_VDV | MTAB_NMO, 0, "STATISTICS", NULL,
-        NULL, &tmxr_show_cstat, (void *) &vh_desc },
+        NULL, &vh_show_stats, (void *) &vh_desc },
+    { MTAB_XTD|MTAB_VDV, 1, NULL, "TIMING",
+        &vh_set_timing, NULL, NULL },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NOTIMING",
+        &vh_set_timing, NULL, NULL },
+    { MTAB_XTD|MTAB_VDV, 0, "TIMING", NULL,
+        NULL, &vh_show_timing, NULL },
     { MTAB_XTD | MTAB_VDV, 1, NULL, "DISCONNECT",
         &tmxr_dscln, NULL, &vh_desc },
     { MTAB_XTD | MTAB_VDV | MTAB_NMO, 0, "DETAIL", NULL,
@@ -1101,6 +1119,71 @@ static t_stat vh_wr (   int32   data,
     return (SCPE_OK);
 }
 
+/* Move DMA output for a line into its transmit buffer a block at a time
+
+   In normal (non-maintenance) mode with the line connected or buffered,
+   characters are fetched from the Qbus in chunks with a single map read and
+   stored with tmxr_putblk_ln.  Otherwise vh_putc handles each character. */
+
+static t_bool doDMA_bulk (  int32   vh,
+                TMLX    *lp,
+                uint32  *ppa,
+                int32   *pstatus    )
+{
+    RUN_SCOPE;
+    uint8   buf[VH_DMA_CHUNK];
+    uint32  pa = *ppa;
+    int32   i, n, got, put, mask;
+    t_bool  cpustat = vh_timing;
+    t_uint64 cpu0 = 0;
+
+    if ((((lp->lnctrl >> LNCTRL_V_MAINT) & LNCTRL_M_MAINT) != 0) ||
+        ((lp->tmln->conn == 0) && (!lp->tmln->txbfd)))
+        return FALSE;
+    if (cpustat)
+        cpu0 = sim_os_thread_cpu_nsec ();
+    mask = bitmask[(lp->lpr >> LPR_V_CHAR_LGTH) & LPR_M_CHAR_LGTH];
+    while (lp->tbuffct) {
+        n = lp->tbuffct;
+        if (n > VH_DMA_CHUNK)
+            n = VH_DMA_CHUNK;
+        if ((uint32) n > (1 << 22) - pa)    /* don't wrap mid-chunk */
+            n = (1 << 22) - pa;
+        got = n - Map_ReadB (RUN_PASS, pa, n, buf);
+        for (i = 0; i < got; i++)
+            buf[i] &= mask;
+        put = tmxr_putblk_ln (lp->tmln, (char *) buf, got);
+        if (put >= 0 && put < got) {
+            /* let's flush and try again */
+            tmxr_send_buffered_data (lp->tmln);
+            n = tmxr_putblk_ln (lp->tmln, (char *) buf + put, got - put);
+            if (n > 0)
+                put += n;
+        }
+        if (put < 0)
+            break;
+        pa = (pa + put) & ((1 << 22) - 1);
+        lp->tbuffct -= put;
+        lp->txdma += put;
+        vh_txtot += put;
+        if (cpustat) {
+            lp->txtimed += put;
+            vh_txtimed += put;
+        }
+        if (put < got)
+            break;
+        if (got < n) {
+            *pstatus |= CSR_TX_DMA_ERR;
+            lp->tbuffct = 0;
+            break;
+        }
+    }
+    if (cpustat)
+        lp->txcpu += sim_os_thread_cpu_nsec () - cpu0;
+    *ppa = pa;
+    return TRUE;
+}
+
 static void doDMA ( int32   vh,
             int32   chan    )
 {
@@ -1112,22 +1195,25 @@ static void doDMA ( int32   vh,
     line = (vh * VH_LINES) + chan;
     lp = &vh_parm[line];
     if ((lp->tbuf2 & TB2_TX_ENA) && (lp->tbuf2 & TB2_TX_DMA_START)) {
-/* BUG: should compare against available xmit buffer space */
         pa = lp->tbuf1;
         pa |= (lp->tbuf2 & TB2_M_TBUFFAD) << 16;
         status = chan << CSR_V_TX_LINE;
-        while (lp->tbuffct) {
-            uint8   buf;
-            if (Map_ReadB (RUN_PASS, pa, 1, &buf)) {
-                status |= CSR_TX_DMA_ERR;
-                lp->tbuffct = 0;
-                break;
+        if (!doDMA_bulk (vh, lp, &pa, &status)) {
+            while (lp->tbuffct) {
+                uint8   buf;
+                if (Map_ReadB (RUN_PASS, pa, 1, &buf)) {
+                    status |= CSR_TX_DMA_ERR;
+                    lp->tbuffct = 0;
+                    break;
+                }
+                if (vh_putc (vh, lp, chan, buf) != SCPE_OK)
+                    break;
+                /* pa = (pa + 1) & PAMASK; */
+                pa = (pa + 1) & ((1 << 22) - 1);
+                lp->tbuffct--;
+                lp->txdma++;
+                vh_txtot++;
             }
-            if (vh_putc (vh, lp, chan, buf) != SCPE_OK)
-                break;
-            /* pa = (pa + 1) & PAMASK; */
-            pa = (pa + 1) & ((1 << 22) - 1);
-            lp->tbuffct--;
         }
         lp->tbuf1 = pa & 0177777;
         lp->tbuf2 = (lp->tbuf2 & ~TB2_M_TBUFFAD) |
@@ -1146,6 +1232,7 @@ static t_stat vh_svc (RUN_SVC_DECL, UNIT *uptr)
     AUTO_LOCK(vh_lock);
     RUN_SVC_CHECK_CANCELLED(uptr);
     int32   vh, newln, i;
+    t_uint64 cpu0;
 
     /* scan all muxes for countdown reset */
     for (vh = 0; vh < vh_desc.lines/VH_LINES; vh++) {
@@ -1164,6 +1251,7 @@ static t_stat vh_svc (RUN_SVC_DECL, UNIT *uptr)
         vh = newln / VH_LINES;  /* determine which mux */
         line = newln - (vh * VH_LINES);
         lp = &vh_parm[newln];
+        lp->txdma = lp->txcpu = lp->txtimed = 0;
         lp->lstat |= STAT_DSR | STAT_DCD | STAT_CTS;
         if (!(lp->lnctrl & LNCTRL_DTR))
             lp->lstat |= STAT_RI;
@@ -1182,7 +1270,13 @@ static t_stat vh_svc (RUN_SVC_DECL, UNIT *uptr)
     tmxr_poll_rx (&vh_desc);
     for (vh = 0; vh < vh_desc.lines/VH_LINES; vh++)
         vh_getc (vh);
-    tmxr_poll_tx (&vh_desc);
+    if (vh_timing) {
+        cpu0 = sim_os_thread_cpu_nsec ();
+        tmxr_poll_tx (&vh_desc);
+        vh_txcpu += sim_os_thread_cpu_nsec () - cpu0;
+    }
+    else
+        tmxr_poll_tx (&vh_desc);
     /* scan all DHU-mode muxes for RX FIFO timeout */
     for (vh = 0; vh < vh_desc.lines/VH_LINES; vh++) {
         if (vh_unit[vh]->flags & UNIT_MODEDHU) {
@@ -1371,6 +1465,53 @@ static t_stat vh_show_detail (   SMP_FILE    *st,
     return (SCPE_OK);
 }
 
+/* SHOW STATISTICS processor
+
+   Adds DMA output throughput and host CPU cost per character to the
+   standard per-line statistics.  Per-line CPU covers moving characters
+   from the Qbus into the line's buffer; the total also covers flushing
+   buffered output to the network.  Host CPU time is only measured while
+   SET VH TIMING is in effect, to keep the clock reads off the normal
+   output path, and is divided by the characters moved while it was. */
+
+static t_stat vh_show_stats (   SMP_FILE    *st,
+                UNIT    *uptr,
+                int32   val,
+                void    *desc   )
+{
+    int32   i, any;
+    uint32  ms;
+    TMLX    *lp;
+    t_uint64 cpu = vh_txcpu;
+
+    for (i = any = 0; i < vh_desc.lines; i++) {
+        lp = &vh_parm[i];
+        cpu += lp->txcpu;
+        if (lp->tmln->conn == 0)
+            continue;
+        any++;
+        tmxr_fstats (st, lp->tmln, i);
+        ms = sim_os_msec () - lp->tmln->cnms;
+        if (lp->txdma) {
+            fprintf (st, "  DMA output = %llu, rate = %.0f chars/sec",
+                (unsigned long long) lp->txdma,
+                ms ? (double) lp->txdma * 1000 / ms : 0.0);
+            if (lp->txtimed)
+                fprintf (st, ", host CPU = %.0f nsec/char", (double) lp->txcpu / lp->txtimed);
+            fprintf (st, "\n");
+        }
+    }
+    if (any == 0)
+        fprintf (st, "all disconnected\n");
+    if (vh_txtot) {
+        fprintf (st, "total DMA output = %llu", (unsigned long long) vh_txtot);
+        if (vh_txtimed)
+            fprintf (st, ", host CPU including network = %.0f nsec/char", (double) cpu / vh_txtimed);
+        fprintf (st, "\n");
+    }
+    return (SCPE_OK);
+}
+
 static t_stat vh_show_rbuf (    SMP_FILE    *st,
                 UNIT    *uptr,
                 int32   val,
@@ -1478,3 +1619,21 @@ for (i = 0; i < vh_desc.lines; i++) {
     }
 return SCPE_OK;
 }
+
+/* SET TIMING/NOTIMING processor */
+
+static t_stat vh_set_timing (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+if (cptr != NULL)
+    return SCPE_ARG;
+vh_timing = (val != 0);
+return SCPE_OK;
+}
+
+/* SHOW TIMING processor */
+
+static t_stat vh_show_timing (SMP_FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+fprintf (st, vh_timing ? "timing" : "notiming");
+return SCPE_OK;
+}
@@ -292,6 +292,9 @@ t_stat xq_show_sanity (SMP_FILE* st, UNIT* uptr, int32 val, void* desc);
 t_stat xq_set_sanity (UNIT* uptr, int32 val, char* cptr, void* desc);
 t_stat xq_show_poll (SMP_FILE* st, UNIT* uptr, int32 val, void* desc);
 t_stat xq_set_poll (UNIT* uptr, int32 val, char* cptr, void* desc);
+t_stat xq_show_rxint (SMP_FILE* st, UNIT* uptr, int32 val, void* desc);
+t_stat xq_set_rxint (UNIT* uptr, int32 val, char* cptr, void* desc);
+t_stat xq_rxint_svc(RUN_SVC_DECL, UNIT * uptr);
 t_stat xq_process_xbdl(CTLR* xq);
 t_stat xq_dispatch_xbdl(CTLR* xq);
 t_stat xq_process_turbo_rbdl(CTLR* xq);
@@ -309,6 +312,7 @@ void xqb_read_callback(int status);
 void xqa_write_callback(int status);
 void xqb_write_callback(int status);
 void xq_setint (CTLR* xq);
+static void xq_rx_done (CTLR* xq, t_bool urgent);
 void xq_clrint (CTLR* xq, t_bool intack = FALSE);
 int32 xq_int (void);
 void xq_csr_set_clr(CTLR* xq, uint16 set_bits, uint16 clear_bits);
@@ -329,7 +333,8 @@ struct xq_device    xqa = {
   XQ_T_DELQA,                               /* mode */
   XQ_SERVICE_INTERVAL,                      /* poll */
   0, 0,                                     /* coalesce */
-  {0}                                       /* sanity */
+  {0},                                      /* sanity */
+  XQ_RXINT_RATE                             /* rxint_rate */
   };
 
 struct xq_device    xqb = {
@@ -344,7 +349,8 @@ struct xq_device    xqb = {
   XQ_T_DELQA,                               /* mode */
   XQ_SERVICE_INTERVAL,                      /* poll */
   0, 0,                                     /* coalesce */
-  {0}                                       /* sanity */
+  {0},                                      /* sanity */
+  XQ_RXINT_RATE                             /* rxint_rate */
   };
 
 /* SIMH device structures */
@@ -353,7 +359,8 @@ DIB xqa_dib = { IOBA_XQ, IOLN_XQ, &xq_rd, &xq_wr,
 
 UNIT* xqa_unit[] = {
    UDATA (&xq_svc, UNIT_IDLE|UNIT_ATTABLE|UNIT_DISABLE, 2047),   /* receive timer */
-   UDATA (&xq_tmrsvc, UNIT_IDLE|UNIT_DIS, 0)
+   UDATA (&xq_tmrsvc, UNIT_IDLE|UNIT_DIS, 0),
+   UDATA (&xq_rxint_svc, UNIT_IDLE|UNIT_DIS, 0)                  /* receive interrupt hold-off */
 };
 
 REG xqa_reg[] = {
@@ -377,6 +384,7 @@ REG xqa_reg[] = {
   { GRDATA_GBL ( POLL, xqa.poll, XQ_RDX, 16, 0), REG_HRO},
   { GRDATA_GBL ( CLAT, xqa.coalesce_latency, XQ_RDX, 16, 0), REG_HRO},
   { GRDATA_GBL ( CLATT, xqa.coalesce_latency_ticks, XQ_RDX, 16, 0), REG_HRO},
+  { GRDATA_GBL ( RXINT, xqa.rxint_rate, XQ_RDX, 16, 0), REG_HRO},
   { GRDATA_GBL ( RBDL_BA, xqa.rbdl_ba, XQ_RDX, 32, 0), REG_HRO},
   { GRDATA_GBL ( XBDL_BA, xqa.xbdl_ba, XQ_RDX, 32, 0), REG_HRO},
   { GRDATA_GBL ( SETUP_PRM, xqa.setup.promiscuous, XQ_RDX, 32, 0), REG_HRO},
@@ -409,7 +417,8 @@ DIB xqb_dib = { IOBA_XQB, IOLN_XQB, &xq_rd, &xq_wr,
 
 UNIT* xqb_unit[] = {
    UDATA (&xq_svc, UNIT_IDLE|UNIT_ATTABLE|UNIT_DISABLE, 2047),  /* receive timer */
-   UDATA (&xq_tmrsvc, UNIT_IDLE|UNIT_DIS, 0)
+   UDATA (&xq_tmrsvc, UNIT_IDLE|UNIT_DIS, 0),
+   UDATA (&xq_rxint_svc, UNIT_IDLE|UNIT_DIS, 0)                  /* receive interrupt hold-off */
 };
 
 REG xqb_reg[] = {
@@ -433,6 +442,7 @@ REG xqb_reg[] = {
   { GRDATA_GBL ( POLL, xqb.poll, XQ_RDX, 16, 0), REG_HRO},
   { GRDATA_GBL ( CLAT, xqb.coalesce_latency, XQ_RDX, 16, 0), REG_HRO},
   { GRDATA_GBL ( CLATT, xqb.coalesce_latency_ticks, XQ_RDX, 16, 0), REG_HRO},
+  { GRDATA_GBL ( RXINT, xqb.rxint_rate, XQ_RDX, 16, 0), REG_HRO},
   { GRDATA_GBL ( RBDL_BA, xqb.rbdl_ba, XQ_RDX, 32, 0), REG_HRO},
   { GRDATA_GBL ( XBDL_BA, xqb.xbdl_ba, XQ_RDX, 32, 0), REG_HRO},
   { GRDATA_GBL ( SETUP_PRM, xqb.setup.promiscuous, XQ_RDX, 32, 0), REG_HRO},
@@ -484,6 +494,8 @@ MTAB xq_mod[] = {
 #endif
   { MTAB_XTD | MTAB_VDV | MTAB_NMO, 0, "SANITY", "SANITY={ON|OFF}",
     &xq_set_sanity, &xq_show_sanity, NULL },
+  { MTAB_XTD | MTAB_VDV, 0, "RXINT", "RXINT={DEFAULT|DISABLED|100..50000}",
+    &xq_set_rxint, &xq_show_rxint, NULL },
   { 0 },
 };
 
@@ -503,7 +515,7 @@ DEBTAB xq_debug[] = {
 
 DEVICE xq_dev = {
   "XQ", xqa_unit, xqa_reg, xq_mod,
-  2, XQ_RDX, 11, 1, XQ_RDX, 16,
+  3, XQ_RDX, 11, 1, XQ_RDX, 16,
   &xq_ex, &xq_dep, &xq_reset,
   NULL, &xq_attach, &xq_detach,
   &xqa_dib, /*DEV_FLTA |*/ DEV_DISABLE | DEV_QBUS | DEV_DEBUG,
@@ -512,7 +524,7 @@ DEVICE xq_dev = {
 
 DEVICE xqb_dev = {
   "XQB", xqb_unit, xqb_reg, xq_mod,
-  2, XQ_RDX, 11, 1, XQ_RDX, 16,
+  3, XQ_RDX, 11, 1, XQ_RDX, 16,
   &xq_ex, &xq_dep, &xq_reset,
   NULL, &xq_attach, &xq_detach,
   &xqb_dib, DEV_FLTA | DEV_DISABLE | DEV_DIS | DEV_QBUS | DEV_DEBUG,
@@ -711,6 +723,8 @@ t_stat xq_show_stats (SMP_FILE* st, UNIT* uptr, int32 val, void* desc)
   fprintf(st, fmt, "SW Reset:",    xq->var->stats.reset);
   fprintf(st, fmt, "Setup:",       xq->var->stats.setup);
   fprintf(st, fmt, "Loopback:",    xq->var->stats.loop);
+  fprintf(st, fmt, "Recv Intr:",   xq->var->stats.rxint);
+  fprintf(st, fmt, "Recv Held:",   xq->var->stats.rxheld);
   fprintf(st, fmt, "ReadQ count:", xq->var->ReadQ.count);
   fprintf(st, fmt, "ReadQ high:",  xq->var->ReadQ.high);
   eth_show_dev(st, xq->var->etherface);
@@ -840,6 +854,38 @@ t_stat xq_set_poll (UNIT* uptr, int32 val, char* cptr, void* desc)
   return SCPE_OK;
 }
 
+t_stat xq_show_rxint (SMP_FILE* st, UNIT* uptr, int32 val, void* desc)
+{
+  CTLR* xq = xq_unit2ctlr(uptr);
+  if (xq->var->rxint_rate)
+    fprintf(st, "rxint=%d/sec", xq->var->rxint_rate);
+  else
+    fprintf(st, "rxint=unmoderated");
+  return SCPE_OK;
+}
+
+t_stat xq_set_rxint (UNIT* uptr, int32 val, char* cptr, void* desc)
+{
+  CTLR* xq = xq_unit2ctlr(uptr);
+  if (!cptr) return SCPE_IERR;
+
+  /* this assumes that the parameter has already been upcased */
+  if (!strcmp(cptr, "DEFAULT"))
+    xq->var->rxint_rate = XQ_RXINT_RATE;
+  else if (!strcmp(cptr, "DISABLED"))
+    xq->var->rxint_rate = 0;
+  else {
+    int rate = 0;
+    if (1 != sscanf(cptr, "%d", &rate))
+      return SCPE_ARG;
+    if (rate < XQ_RXINT_MIN || rate > XQ_RXINT_MAX)
+      return SCPE_ARG;
+    xq->var->rxint_rate = rate;
+  }
+
+  return SCPE_OK;
+}
+
 t_stat xq_show_sanity (SMP_FILE* st, UNIT* uptr, int32 val, void* desc)
 {
   CTLR* xq = xq_unit2ctlr(uptr);
@@ -1168,11 +1214,12 @@ t_stat xq_rd(int32* data, int32 PA, int32 access)
 t_stat xq_process_rbdl(CTLR* xq)
 {
   RUN_SCOPE;
-  int32 rstatus, wstatus, rwstatus;
+  int32 wstatus, rwstatus;
   uint16 b_length, w_length, rbl;
   uint32 address;
   ETH_ITEM* item;
   uint8* rbuf;
+  int frames_received = 0;
 
   if (xq->var->mode == XQ_T_DELQA_PLUS)
     return xq_process_turbo_rbdl(xq);
@@ -1189,6 +1236,9 @@ t_stat xq_process_rbdl(CTLR* xq)
     /* invalid buffer? */
     if (~xq->var->rbdl_buf[1] & XQ_DSC_V) {
       xq_csr_set_clr(xq, XQ_CSR_RL, 0);
+      /* host is out of buffers: let it know about received ones without delay */
+      if (frames_received || xq->var->rxint_deferred)
+        xq_rx_done(xq, TRUE);
       return SCPE_OK;
     }
 
@@ -1201,9 +1251,7 @@ t_stat xq_process_rbdl(CTLR* xq)
     /* stop processing if nothing in read queue */
     if (!xq->var->ReadQ.count) break;
 
-    /* get status words */
-    rstatus = Map_ReadW(RUN_PASS, xq->var->rbdl_ba + 8, 4, &xq->var->rbdl_buf[4]);
-    if (rstatus) return xq_nxm_error(xq);
+    /* status words are not fetched: both are entirely rewritten below */
 
     /* get host memory address */
     address = ((xq->var->rbdl_buf[1] & 0x3F) << 16) | xq->var->rbdl_buf[2];
@@ -1297,14 +1345,17 @@ t_stat xq_process_rbdl(CTLR* xq)
     if (item->packet.used >= item->packet.len)
       ethq_remove(&xq->var->ReadQ);
 
-    /* mark transmission complete */
-    xq_csr_set_clr(xq, XQ_CSR_RI, 0);
+    /* transmission complete (RI) is signalled once for the whole batch */
+    frames_received++;
 
     /* set to next bdl (implicit chain) */
     xq->var->rbdl_ba += 12;
 
  } /* while */
 
+  if (frames_received)
+    xq_rx_done(xq, FALSE);
+
   return SCPE_OK;
 }
 
@@ -1684,6 +1735,7 @@ t_stat xq_process_turbo_rbdl(CTLR* xq)
   int i;
   t_stat status;
   int descriptors_consumed = 0;
+  int cached = 0;                 /* ring entries from rbindx on fetched by this call */
   uint32 rdra = (xq->var->init.rdra_h << 16) | xq->var->init.rdra_l;
 
   sim_debug(DBG_TRC, xq->dev, "xq_process_turbo_rbdl()\n");
@@ -1704,19 +1756,33 @@ t_stat xq_process_turbo_rbdl(CTLR* xq)
 
     i = xq->var->rbindx;
 
-    /* Get receive descriptor from memory */
-    status = Map_ReadW (RUN_PASS, rdra+i*sizeof(xq->var->rring[i]), sizeof(xq->var->rring[i]), (uint16 *)&xq->var->rring[i]);
-    if (status != SCPE_OK)
-        return xq_nxm_error(xq);
+    /* Get receive descriptors from memory: fetch as many entries as queued packets may need
+       (up to the end of the ring) at once, and re-read an entry singly only if its copy is not
+       known to be current and shows it still owned by the driver */
+    if (cached == 0 || (xq->var->rring[i].rmd3 & XQ_RMD3_OWN)) {
+      int n = 1;
+      if (cached == 0) {
+        n = xq->var->ReadQ.count + 1;
+        if (n > XQ_TURBO_RC_BCNT - i)
+          n = XQ_TURBO_RC_BCNT - i;
+      }
+      status = Map_ReadW (RUN_PASS, rdra+i*sizeof(xq->var->rring[i]), n*sizeof(xq->var->rring[i]), (uint16 *)&xq->var->rring[i]);
+      if (status != SCPE_OK)
+          return xq_nxm_error(xq);
+      cached = n;
+    }
 
     /* Done if Buffer not Owned */
     if (xq->var->rring[i].rmd3 & XQ_TMD3_OWN)
         break;
 
     ++descriptors_consumed;
+    --cached;
 
     /* Update ring index */
     xq->var->rbindx = (xq->var->rbindx + 1) % XQ_TURBO_RC_BCNT;
+    if (xq->var->rbindx == 0)
+      cached = 0;
 
     address = ((xq->var->rring[i].hadr & 0x3F ) << 16) | xq->var->rring[i].ladr;
     b_length = ETH_FRAME_SIZE;
@@ -1778,7 +1844,12 @@ t_stat xq_process_turbo_rbdl(CTLR* xq)
       xq->var->ReadQ.loss = 0;          /* reset loss counter */
     }
 
-    Map_ReadW (RUN_PASS, rdra+(uint32)(((char *)(&xq->var->rring[xq->var->rbindx].rmd3))-((char *)&xq->var->rring)), sizeof(xq->var->rring[xq->var->rbindx].rmd3), (uint16 *)&xq->var->rring[xq->var->rbindx].rmd3);
+    /* Next descriptor fetched above and already given to us by the driver needs no re-read,
+       otherwise check its current ownership (and fetch it in full when processing it) */
+    if (cached == 0 || (xq->var->rring[xq->var->rbindx].rmd3 & XQ_RMD3_OWN)) {
+      Map_ReadW (RUN_PASS, rdra+(uint32)(((char *)(&xq->var->rring[xq->var->rbindx].rmd3))-((char *)&xq->var->rring)), sizeof(xq->var->rring[xq->var->rbindx].rmd3), (uint16 *)&xq->var->rring[xq->var->rbindx].rmd3);
+      cached = 0;
+    }
     if (xq->var->rring[xq->var->rbindx].rmd3 & XQ_RMD3_OWN)
       xq->var->rring[i].rmd2 |= XQ_RMD2_EOR;
 
@@ -1800,8 +1871,8 @@ t_stat xq_process_turbo_rbdl(CTLR* xq)
       sim_debug(DBG_WRN, xq->dev, "xq_process_turbo_rbdl() - receive ring full\n");
 
   if (descriptors_consumed)
-    /* Interrupt for Packet Reception Completion */
-    xq_setint(xq);
+    /* Interrupt for Packet Reception Completion, immediate if the ring is full */
+    xq_rx_done(xq, 0 != (xq->var->rring[xq->var->rbindx].rmd3 & XQ_RMD3_OWN));
 
   return SCPE_OK;
 }
@@ -2654,6 +2725,11 @@ t_stat xq_reset(DEVICE* dptr)
   /* stop the receiver */
   sim_cancel(xq->unit[0]);
 
+  /* close receive interrupt hold-off window */
+  sim_cancel(xq->unit[2]);
+  xq->var->rxint_holdoff = 0;
+  xq->var->rxint_deferred = 0;
+
   /* set hardware sanity controls */
   if (xq->var->sanity.enabled) {
     xq->var->sanity.quarter_secs = XQ_HW_SANITY_SECS * 4/*qsec*/;
@@ -3022,6 +3098,64 @@ void xq_setint(CTLR* xq)
     }
 }
 
+/*
+ * Receive interrupt moderation.
+ *
+ * Receive completions are signalled once per batch of frames moved into host buffers.
+ * When moderation is enabled (SET XQ RXINT=n), signalling a completion opens a hold-off window
+ * of 1/n second. Completions within the window are not signalled until the window ends, and
+ * if there were any, they are signalled then and the window is extended by another 1/n second.
+ * Thus a lightly loaded receiver interrupts without delay, whereas under sustained load the
+ * rate of receive interrupts is bounded by n per second and the added latency by 1/n second.
+ * Completions that leave the host without receive buffers are always signalled immediately.
+ */
+
+static void xq_post_rx_intr (CTLR* xq)
+{
+  xq->var->stats.rxint += 1;
+  if (xq->var->mode == XQ_T_DELQA_PLUS)
+    xq_setint(xq);
+  else
+    xq_csr_set_clr(xq, XQ_CSR_RI, 0);
+}
+
+static void xq_rx_done (CTLR* xq, t_bool urgent)
+{
+  if (xq->var->rxint_holdoff && !urgent) {
+    xq->var->rxint_deferred = 1;
+    xq->var->stats.rxheld += 1;
+    return;
+  }
+
+  xq->var->rxint_deferred = 0;
+  xq_post_rx_intr(xq);
+
+  if (xq->var->rxint_rate && !xq->var->rxint_holdoff) {
+    xq->var->rxint_holdoff = 1;
+    xq_activate(xq->unit[2], FALSE, xq->var->rxint_rate);
+  }
+}
+
+t_stat xq_rxint_svc(RUN_SVC_DECL, UNIT* uptr)
+{
+  CTLR* xq = xq_unit2ctlr(uptr);
+
+  AUTO_LOCK_NM(xq_autolock, *xq->xq_lock);
+  RUN_SVC_CHECK_CANCELLED(uptr);
+
+  if (xq->var->rxint_deferred) {
+    xq->var->rxint_deferred = 0;
+    xq_post_rx_intr(xq);
+    if (xq->var->rxint_rate) {
+      xq_activate(uptr, FALSE, xq->var->rxint_rate);
+      return SCPE_OK;
+    }
+  }
+
+  xq->var->rxint_holdoff = 0;
+  return SCPE_OK;
+}
+
 void xq_clrint (CTLR* xq, t_bool intack)
 {
     if (xq->var->irq == 1)
@@ -89,6 +89,9 @@
 #else
 #define XQ_SERVICE_INTERVAL  100                        /* polling interval - X per second */
 #endif
+#define XQ_RXINT_RATE       8000                        /* receive interrupts per second when moderating */
+#define XQ_RXINT_MIN         100                        /* range accepted by SET XQ RXINT */
+#define XQ_RXINT_MAX       50000
 #define XQ_SYSTEM_ID_SECS    540                        /* seconds before system ID timer expires */
 #define XQ_HW_SANITY_SECS    240                        /* seconds before HW sanity timer expires */
 #define XQ_MAX_CONTROLLERS     2                        /* maximum controllers allowed */
@@ -202,6 +205,8 @@ struct xq_stats {
   int               giant;                              /* oversize packets */
   int               setup;                              /* setup packets */
   int               loop;                               /* loopback packets */
+  int               rxint;                              /* receive completion interrupts posted */
+  int               rxheld;                             /* receive completions held off by moderation */
 };
 
 #pragma pack(2)
@@ -258,6 +263,7 @@ struct xq_device {
   uint16            coalesce_latency;                   /* microseconds to hold-off interrupts when not polling */
   uint16            coalesce_latency_ticks;             /* instructions in coalesce_latency microseconds */
   struct xq_sanity  sanity;                             /* sanity timer information */
+  uint16            rxint_rate;                         /* max receive interrupts per second, 0 = unmoderated */
                                                         /*- initialized values - DO NOT MOVE */
 
                                                         /* I/O register storage */
@@ -282,6 +288,8 @@ struct xq_device {
   uint32            rbindx;                             /* Receive Buffer Ring Index */
 
   uint32            irq;                                /* interrupt request flag */
+  uint32            rxint_holdoff;                      /* receive interrupt hold-off window is open */
+  uint32            rxint_deferred;                     /* receive completion awaits end of hold-off window */
 
                                                         /* buffers, etc. */
   struct xq_setup   setup;
@@ -0,0 +1,459 @@
+/*
+ * vax_bench.cpp: built-in CPU micro-benchmarks (PERF BENCH)
+ *
+ * Each benchmark kernel is a short hand-assembled VAX instruction loop exercising one class of
+ * instructions or one of the simulator's hot paths: integer ALU and branches, string moves, procedure
+ * calls, F/D/G floating point, interlocked instructions, instruction emulation traps and translation
+ * buffer misses.  The kernel is deposited into low physical memory, the primary processor is reset
+ * and pointed at it in kernel mode at IPL 31 (so no interrupts are taken), and the processor is then
+ * run through the regular execution path for a fixed interval of host time.  Throughput is derived
+ * from the number of instructions retired during the interval and reported as a JSON document, so
+ * the command can be run from a script (e.g. "vax_mp bench.ini" with "perf bench all" followed by
+ * "exit", or the turbovax_bench executable) to compare interpreter performance across builds and hosts.
+ *
+ * Each kernel is run with 1 to N active VCPUs, N being the number of configured processors.  When
+ * more than one VCPU is used, the primary first executes a start-up stub that issues VAX MP API
+ * INIT_SMP and START_CPU requests, exactly as a guest operating system would, starting secondaries
+ * at the kernel entry point with their own stacks and, for kernels that write memory, their own data
+ * block addressed via R6.  Synchronization window is left off.
+ *
+ * PERF BENCH destroys machine state: it resets the system and overwrites the first 5 MB of memory.
+ * It therefore refuses to run once the machine has executed guest code since the last reset, unless
+ * -F is specified.  The system is reset again when the benchmarks complete.
+ */
+
+#include "sim_defs.h"
+#include "vax_defs.h"
+
+extern int32 sim_switches;
+extern const char *sim_stop_messages[];
+
+#define BENCH_DEFAULT_MSEC  2000                    /* default run time per kernel */
+#define BENCH_MAX_MSEC      600000                  /* longest run time accepted */
+
+#define BENCH_CODE      0x1000                      /* kernel code */
+#define BENCH_STACK     0x3000                      /* initial SP, stack grows down */
+#define BENCH_PADD      0x3030                      /* packed decimal addend, 5 digits */
+#define BENCH_PSUM      0x3038                      /* packed decimal sum, 9 digits */
+#define BENCH_HANDLER   0x1800                      /* exception handler code */
+#define BENCH_SCB       0x2000                      /* system control block */
+#define BENCH_SRC       0x3200                      /* MOVC3 source */
+#define BENCH_START     0x4000                      /* SMP start-up stub executed by the primary */
+#define BENCH_PROLOGUE  0x4200                      /* secondaries' entry, loads SP, 0x10 bytes per VCPU */
+#define BENCH_INITBLK   0x4400                      /* INIT_SMP argument block */
+#define BENCH_STARTBLK  0x4800                      /* START_CPU argument blocks, 0x100 bytes per VCPU */
+#define BENCH_CPUSTACK  0x8000                      /* secondary stacks, 0x400 bytes per VCPU */
+#define BENCH_SPT       0x10000                     /* system page table for TB miss kernel */
+#define BENCH_PERCPU    0x20000                     /* per-VCPU data blocks, 0x400 bytes each, R6 = base */
+#define BENCH_PERCPU_SIZE 0x400
+#define BENCH_QHDR      0x000                       /* ... interlocked queue header, quadword aligned */
+#define BENCH_QENT      0x010                       /* ... interlocked queue entry, quadword aligned */
+#define BENCH_FLAG      0x020                       /* ... bit for BBSSI/BBCCI */
+#define BENCH_WORD      0x024                       /* ... word for ADAWI */
+#define BENCH_DST       0x200                       /* ... MOVC3 destination */
+#define BENCH_TBDATA    0x100000                    /* data pages touched by TB miss kernel */
+#define BENCH_TBPAGES   0x2000                      /* ... their count, twice the TB size */
+#define BENCH_MEMTOP    (BENCH_TBDATA + BENCH_TBPAGES * VA_PAGSIZE)
+
+#define BENCH_S0(pa)    (0x80000000 + (pa))         /* system space address mapped to physical pa */
+
+#define L_BYTES(x)      (uint8) ((x) & 0xFF), (uint8) (((x) >> 8) & 0xFF), (uint8) (((x) >> 16) & 0xFF), (uint8) (((uint32) (x) >> 24) & 0xFF)
+#define ABS(x)          0x9F, L_BYTES(x)            /* @#x operand specifier */
+#define DISPB(d)        0xA6, (d)                   /* B^d(R6) operand specifier */
+#define DISPW(d)        0xC6, ((d) & 0xFF), (((d) >> 8) & 0xFF) /* W^d(R6) operand specifier */
+
+/* integer ALU, shifts and loop branches */
+static const uint8 bench_code_integer[] =
+{
+    0xD0, 0x8F, L_BYTES(0x10000), 0x50,             /* 00: MOVL    #^X10000, R0 */
+    0xC0, 0x51, 0x52,                               /* 07: ADDL2   R1, R2 */
+    0xCC, 0x52, 0x53,                               /* 0A: XORL2   R2, R3 */
+    0xC4, 0x03, 0x53,                               /* 0D: MULL2   #3, R3 */
+    0x78, 0x02, 0x52, 0x54,                         /* 10: ASHL    #2, R2, R4 */
+    0xD6, 0x51,                                     /* 14: INCL    R1 */
+    0xC2, 0x54, 0x55,                               /* 16: SUBL2   R4, R5 */
+    0xF5, 0x50, 0xEB,                               /* 19: SOBGTR  R0, 07 */
+    0x11, 0xE2                                      /* 1C: BRB     00 */
+};
+
+/* character string move */
+static const uint8 bench_code_movc3[] =
+{
+    0x28, 0x8F, 0x00, 0x02, ABS(BENCH_SRC), DISPW(BENCH_DST), /* 00: MOVC3 #512, @#SRC, W^DST(R6) */
+    0x11, 0xF2                                      /* 0C: BRB     00 */
+};
+
+/* procedure and subroutine calls */
+static const uint8 bench_code_calls[] =
+{
+    0xFB, 0x00, 0xAF, 0x05,                         /* 00: CALLS   #0, 09 */
+    0x16, 0xAF, 0x07,                               /* 04: JSB     0E */
+    0x11, 0xF7,                                     /* 07: BRB     00 */
+    0x0C, 0x00,                                     /* 09: .WORD   ^M<R2,R3> */
+    0xD6, 0x52,                                     /* 0B: INCL    R2 */
+    0x04,                                           /* 0D: RET */
+    0xD6, 0x53,                                     /* 0E: INCL    R3 */
+    0x05                                            /* 10: RSB */
+};
+
+/* F, D and G floating point arithmetic */
+static const uint8 bench_code_float[] =
+{
+    0x40, 0x56, 0x57,                               /* 00: ADDF2   R6, R7 */
+    0x44, 0x56, 0x57,                               /* 03: MULF2   R6, R7 */
+    0x46, 0x56, 0x57,                               /* 06: DIVF2   R6, R7 */
+    0x60, 0x52, 0x54,                               /* 09: ADDD2   R2, R4 */
+    0x64, 0x52, 0x54,                               /* 0C: MULD2   R2, R4 */
+    0x66, 0x52, 0x54,                               /* 0F: DIVD2   R2, R4 */
+    0xFD, 0x40, 0x58, 0x5A,                         /* 12: ADDG2   R8, R10 */
+    0xFD, 0x44, 0x58, 0x5A,                         /* 16: MULG2   R8, R10 */
+    0xFD, 0x46, 0x58, 0x5A,                         /* 1A: DIVG2   R8, R10 */
+    0x11, 0xE0                                      /* 1E: BRB     00 */
+};
+
+/* interlocked queue and bit instructions */
+static const uint8 bench_code_interlock[] =
+{
+    0x5C, DISPB(BENCH_QENT), 0x66,                  /* 00: INSQHI  QENT(R6), (R6) */
+    0x5E, 0x66, 0x51,                               /* 04: REMQHI  (R6), R1 */
+    0xE6, 0x00, DISPB(BENCH_FLAG), 0x00,            /* 07: BBSSI   #0, FLAG(R6), 0C */
+    0xE7, 0x00, DISPB(BENCH_FLAG), 0x00,            /* 0C: BBCCI   #0, FLAG(R6), 11 */
+    0x58, 0x01, DISPB(BENCH_WORD),                  /* 11: ADAWI   #1, WORD(R6) */
+    0x11, 0xE9                                      /* 15: BRB     00 */
+};
+
+/* packed decimal instruction: not implemented by KA655, traps to emulation vector that just skips it */
+static const uint8 bench_code_emulate[] =
+{
+    0x20, 0x05, ABS(BENCH_PADD), 0x09, ABS(BENCH_PSUM), /* 00: ADDP4 #5, @#PADD, #9, @#PSUM */
+    0x11, 0xF1                                      /* 0D: BRB     00 */
+};
+
+static const uint8 bench_code_emulate_handler[] =
+{
+    0x9E, 0xAE, 0x28, 0x5E,                         /* 00: MOVAB   40(SP), SP      ; pop all but new PC and PSL */
+    0x02                                            /* 04: REI */
+};
+
+/* memory reads striding across more pages than the TB holds, runs mapped in S0 space */
+static const uint8 bench_code_tbmiss[] =
+{
+    0xD0, 0x8F, L_BYTES(BENCH_S0(BENCH_TBDATA)), 0x51, /* 00: MOVL  #TBDATA, R1 */
+    0xD0, 0x8F, L_BYTES(BENCH_TBPAGES), 0x50,       /* 07: MOVL    #TBPAGES, R0 */
+    0xC0, 0x61, 0x52,                               /* 0E: ADDL2   (R1), R2 */
+    0xC0, 0x8F, L_BYTES(VA_PAGSIZE), 0x51,          /* 11: ADDL2   #512, R1 */
+    0xF5, 0x50, 0xF3,                               /* 18: SOBGTR  R0, 0E */
+    0x11, 0xE3                                      /* 1B: BRB     00 */
+};
+
+static void bench_setup_float(RUN_DECL);
+static void bench_setup_interlock(RUN_DECL);
+static void bench_setup_emulate(RUN_DECL);
+static void bench_setup_tbmiss(RUN_DECL);
+
+typedef struct
+{
+    const char* name;
+    const uint8* code;
+    uint32 size;
+    void (*setup)(RUN_DECL);                        /* extra memory and register setup, optional */
+    t_bool percpu;                                  /* writes memory via R6 = VCPU's data block */
+}
+bench_kernel;
+
+static const bench_kernel bench_kernels[] =
+{
+    { "integer",    bench_code_integer,   sizeof(bench_code_integer),   NULL,                  FALSE },
+    { "movc3",      bench_code_movc3,     sizeof(bench_code_movc3),     NULL,                  TRUE  },
+    { "calls",      bench_code_calls,     sizeof(bench_code_calls),     NULL,                  FALSE },
+    { "float",      bench_code_float,     sizeof(bench_code_float),     bench_setup_float,     FALSE },
+    { "interlock",  bench_code_interlock, sizeof(bench_code_interlock), bench_setup_interlock, TRUE  },
+    { "emulate",    bench_code_emulate,   sizeof(bench_code_emulate),   bench_setup_emulate,   FALSE },
+    { "tbmiss",     bench_code_tbmiss,    sizeof(bench_code_tbmiss),    bench_setup_tbmiss,    FALSE }
+};
+
+#define BENCH_NKERNELS  (sizeof(bench_kernels) / sizeof(bench_kernels[0]))
+
+static void bench_setup_float(RUN_DECL)
+{
+    R[6] = R[7] = 0x00004080;                       /* 1.0 F_floating */
+    R[2] = R[4] = 0x00004080;                       /* 1.0 D_floating */
+    R[3] = R[5] = 0;
+    R[8] = R[10] = 0x00004010;                      /* 1.0 G_floating */
+    R[9] = R[11] = 0;
+}
+
+static void bench_setup_interlock(RUN_DECL)
+{
+    for (uint32 ix = 0;  ix < sim_ncpus;  ix++)
+    {
+        uint32 pa = BENCH_PERCPU + ix * BENCH_PERCPU_SIZE;
+        WriteLP(RUN_PASS, pa + BENCH_QHDR, 0);      /* empty queue */
+        WriteLP(RUN_PASS, pa + BENCH_QHDR + 4, 0);
+        WriteLP(RUN_PASS, pa + BENCH_FLAG, 0);
+    }
+}
+
+static void bench_setup_emulate(RUN_DECL)
+{
+    for (uint32 k = 0;  k < sizeof(bench_code_emulate_handler);  k++)
+        WriteB(RUN_PASS, BENCH_HANDLER + k, bench_code_emulate_handler[k]);
+    WriteLP(RUN_PASS, BENCH_SCB + SCB_EMULATE, BENCH_HANDLER);
+    SCBB = BENCH_SCB;
+}
+
+static void bench_setup_tbmiss(RUN_DECL)
+{
+    uint32 npages = BENCH_MEMTOP >> VA_N_OFF;
+
+    for (uint32 vpn = 0;  vpn < npages;  vpn++)     /* map S0 one-to-one onto low memory */
+        WriteLP(RUN_PASS, BENCH_SPT + 4 * vpn, PTE_V | PTE_M | (4u << PTE_V_ACC) | vpn);
+
+    SBR = BENCH_SPT;
+    SLR = npages;
+    mapen = 1;
+    set_map_reg(RUN_PASS);
+    zap_tb(RUN_PASS, 1);
+    PC = BENCH_S0(BENCH_CODE);
+}
+
+static uint32 bench_emit(RUN_DECL, uint32 pa, const uint8* code, uint32 size)
+{
+    for (uint32 k = 0;  k < size;  k++)
+        WriteB(RUN_PASS, pa + k, code[k]);
+    return pa + size;
+}
+
+/* emit "MTPR #argblk, #MT_SIMH" at physical address pa */
+static uint32 bench_emit_api_call(RUN_DECL, uint32 pa, uint32 argblk)
+{
+    const uint8 code[] = { 0xDA, 0x8F, L_BYTES(argblk), 0x8F, L_BYTES(MT_SIMH) };
+    return bench_emit(RUN_PASS, pa, code, sizeof(code));
+}
+
+/* emit "JMP @#va" at physical address pa */
+static uint32 bench_emit_jmp(RUN_DECL, uint32 pa, uint32 va)
+{
+    const uint8 code[] = { 0x17, ABS(va) };
+    return bench_emit(RUN_PASS, pa, code, sizeof(code));
+}
+
+/*
+ * Prepare start-up of secondary VCPUs 1 to ncpus-1 running the same kernel as the primary.
+ * The primary is redirected to a stub that activates multiprocessing and starts secondaries,
+ * then jumps to the kernel.  Called after kernel setup, so secondaries inherit primary's registers.
+ * START_CPU does not load SP (guest start-up code does it), so secondaries enter the kernel
+ * via a prologue that does.
+ */
+static void bench_setup_smp(RUN_DECL, const bench_kernel* kp, uint32 ncpus)
+{
+    uint32 vbase = mapen ? BENCH_S0(0) : 0;
+    uint32 pa = BENCH_START;
+    uint32 blk, k, ix;
+
+    for (k = 0;  k < 17;  k++)
+        WriteLP(RUN_PASS, BENCH_INITBLK + 4 * k, 0);
+    WriteLP(RUN_PASS, BENCH_INITBLK + 4 * 0, VAXMP_API_SIGNATURE);
+    WriteLP(RUN_PASS, BENCH_INITBLK + 4 * 1, VAXMP_API_OP_INIT_SMP);
+    WriteLP(RUN_PASS, BENCH_INITBLK + 4 * 2, 1);                   /* API version */
+    WriteLP(RUN_PASS, BENCH_INITBLK + 4 * 4, (uint32) -1);         /* no critical section IPL */
+    pa = bench_emit_api_call(RUN_PASS, pa, vbase + BENCH_INITBLK);
+
+    for (ix = 1;  ix < ncpus;  ix++)
+    {
+        uint32 stack = vbase + BENCH_CPUSTACK + ix * 0x400;
+        uint32 pcb[24];
+
+        pcb[0] = pcb[1] = pcb[2] = pcb[3] = stack;                 /* KSP, ESP, SSP, USP */
+        for (k = 0;  k < 14;  k++)                                 /* R0-R11, AP, FP */
+            pcb[4 + k] = R[k];
+        if (kp->percpu)
+            pcb[4 + 6] = vbase + BENCH_PERCPU + ix * BENCH_PERCPU_SIZE;
+        pcb[18] = vbase + BENCH_PROLOGUE + ix * 0x10;             /* PC */
+        pcb[19] = PSL;
+        pcb[20] = 0;                                               /* P0BR */
+        pcb[21] = 4 << 24;                                         /* P0LR, ASTLVL = 4 */
+        pcb[22] = 0;                                               /* P1BR */
+        pcb[23] = 0x200000;                                        /* P1LR */
+
+        blk = BENCH_STARTBLK + ix * 0x100;
+        WriteLP(RUN_PASS, blk + 4 * 0, VAXMP_API_SIGNATURE);
+        WriteLP(RUN_PASS, blk + 4 * 1, VAXMP_API_OP_START_CPU);
+        WriteLP(RUN_PASS, blk + 4 * 2, 1);
+        WriteLP(RUN_PASS, blk + 4 * 3, 0);
+        WriteLP(RUN_PASS, blk + 4 * 4, ix);
+        for (k = 0;  k < 24;  k++)
+            WriteLP(RUN_PASS, blk + 4 * (5 + k), pcb[k]);
+        WriteLP(RUN_PASS, blk + 4 * 29, SCBB);
+        WriteLP(RUN_PASS, blk + 4 * 30, mapen);
+        WriteLP(RUN_PASS, blk + 4 * 31, SBR);
+        WriteLP(RUN_PASS, blk + 4 * 32, SLR);
+        WriteLP(RUN_PASS, blk + 4 * 33, stack);                    /* ISP */
+
+        pa = bench_emit_api_call(RUN_PASS, pa, vbase + blk);
+
+        const uint8 movsp[] = { 0xD0, 0x8F, L_BYTES(stack), 0x5E }; /* MOVL #stack, SP */
+        uint32 pro = bench_emit(RUN_PASS, BENCH_PROLOGUE + ix * 0x10, movsp, sizeof(movsp));
+        bench_emit_jmp(RUN_PASS, pro, vbase + BENCH_CODE);
+    }
+
+    bench_emit_jmp(RUN_PASS, pa, vbase + BENCH_CODE);
+    PC = vbase + BENCH_START;
+}
+
+/* check that multiprocessing was activated and all secondaries started */
+static t_bool bench_smp_started(RUN_DECL, uint32 ncpus)
+{
+    if (ReadLP(RUN_PASS, BENCH_INITBLK + 4 * 3) != 1)
+        return FALSE;
+    for (uint32 ix = 1;  ix < ncpus;  ix++)
+    {
+        if (ReadLP(RUN_PASS, BENCH_STARTBLK + ix * 0x100 + 4 * 3) != 1)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static t_stat bench_run(RUN_DECL, const bench_kernel* kp, uint32 ncpus, uint32 msec, SMP_FILE* fp, t_bool first)
+{
+    t_stat r;
+    uint32 k;
+
+    if ((r = run_boot_prep()) != SCPE_OK)           /* reset machine */
+        return r;
+
+    for (k = 0;  k < kp->size;  k++)
+        WriteB(RUN_PASS, BENCH_CODE + k, kp->code[k]);
+    PC = BENCH_CODE;
+    SP = BENCH_STACK;
+    if (kp->percpu)
+        R[6] = BENCH_PERCPU;
+    if (kp->setup)
+        (*kp->setup)(RUN_PASS);
+    if (ncpus > 1)
+        bench_setup_smp(RUN_PASS, kp, ncpus);
+
+    for (k = 0;  k < ncpus;  k++)
+        cpu_units[k]->sim_instrs = 0;
+
+    uint32 start = sim_os_msec();
+    if ((r = run_timed(msec)) != SCPE_OK)
+        return r;
+    uint32 elapsed = sim_os_msec() - start;
+
+    t_stat code = cpu_unit->cpu_stop_code;
+    const char* status = "ok";
+    if (code != SCPE_STOP)
+        status = (code < SCPE_BASE) ? sim_stop_messages[code] : sim_error_text(code);
+    else if (ncpus > 1 && !bench_smp_started(RUN_PASS, ncpus))
+        status = "smp start failed";
+
+    t_uint64 instrs = 0;
+    for (k = 0;  k < ncpus;  k++)
+        instrs += cpu_units[k]->sim_instrs;
+    double mips = elapsed ? (double) instrs / (elapsed * 1000.0) : 0.0;
+
+    fprintf(fp, "%s    { \"kernel\": \"%s\", \"vcpus\": %u, \"instructions\": %" PRIu64 ", \"elapsed_ms\": %u, \"mips\": %.2f, \"status\": \"%s\" }",
+            first ? "" : ",\n", kp->name, ncpus, instrs, elapsed, mips, status);
+    return SCPE_OK;
+}
+
+/*
+ * PERF BENCH [-F] [name|ALL] [msec] [file]
+ */
+t_stat bench_cmd (char *cptr)
+{
+    run_scope_context* rscx = run_scope_context::get_current();
+    CPU_UNIT* cpu_unit;
+    char gbuf[CBUFSIZE];
+    const bench_kernel* sel = NULL;
+    uint32 msec = BENCH_DEFAULT_MSEC;
+    SMP_FILE* fp = smp_stdout;
+    t_stat r = SCPE_OK;
+    t_bool first = TRUE;
+    uint32 k, ncpus;
+
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (gbuf[0] && !streqi(gbuf, "ALL"))
+    {
+        for (k = 0;  k < BENCH_NKERNELS;  k++)
+        {
+            if (streqi(gbuf, bench_kernels[k].name))
+                sel = & bench_kernels[k];
+        }
+        if (sel == NULL)
+        {
+            smp_printf ("Unknown benchmark %s, valid are:", gbuf);
+            for (k = 0;  k < BENCH_NKERNELS;  k++)
+                smp_printf (" %s", bench_kernels[k].name);
+            smp_printf ("\n");
+            return SCPE_ARG;
+        }
+    }
+
+    if (*cptr)
+    {
+        cptr = get_glyph (cptr, gbuf, 0);
+        msec = (uint32) get_uint (gbuf, 10, BENCH_MAX_MSEC, & r);
+        if (r != SCPE_OK || msec == 0)
+            return SCPE_ARG;
+    }
+
+    if (*cptr)
+    {
+        cptr = get_glyph_nc (cptr, gbuf, 0);
+        if (*cptr)
+            return SCPE_2MARG;
+        if ((fp = smp_fopen (gbuf, "w")) == NULL)
+            return SCPE_OPENERR;
+    }
+
+    /* benchmarks run on the primary processor */
+    rscx->cpu_unit = cpu_unit = &cpu_unit_0;
+
+    if (MEMSIZE < BENCH_MEMTOP)
+    {
+        smp_printf ("PERF BENCH requires at least %dMB of memory\n", (BENCH_MEMTOP + 0xFFFFF) >> 20);
+        if (fp != smp_stdout)
+            fclose (fp);
+        return SCPE_NOFNC;
+    }
+
+    /* machine has executed code since the last reset: likely holds a guest whose memory would be clobbered */
+    for (k = 0;  k < sim_ncpus;  k++)
+    {
+        if (cpu_units[k]->sim_time != 0 && !(sim_switches & SWMASK('F')))
+        {
+            smp_printf ("PERF BENCH resets the system and overwrites the first %dMB of memory, use -F to proceed\n", (BENCH_MEMTOP + 0xFFFFF) >> 20);
+            if (fp != smp_stdout)
+                fclose (fp);
+            return SCPE_NOFNC;
+        }
+    }
+
+    fprintf(fp, "{\n  \"simulator\": \"%s\",\n  \"vcpus\": %u,\n  \"host_cpus\": %d,\n  \"run_ms\": %u,\n  \"results\": [\n",
+            sim_name, sim_ncpus, smp_ncpus, msec);
+
+    for (k = 0;  k < BENCH_NKERNELS && r == SCPE_OK;  k++)
+    {
+        if (sel && sel != & bench_kernels[k])
+            continue;
+        for (ncpus = 1;  ncpus <= sim_ncpus && r == SCPE_OK;  ncpus++)
+        {
+            r = bench_run(RUN_PASS, & bench_kernels[k], ncpus, msec, fp, first);
+            first = FALSE;
+            fflush(fp);
+        }
+    }
+
+    fprintf(fp, "%s  ]\n}\n", first ? "" : "\n");
+
+    /* leave the system reset rather than in the state of the last benchmark */
+    t_stat r2 = run_boot_prep();
+    if (r == SCPE_OK)
+        r = r2;
+
+    if (fp != smp_stdout)
+        fclose (fp);
+    return r;
+}
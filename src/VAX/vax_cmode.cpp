@@ -81,11 +81,12 @@ int32 i, t, src, src2, dst, sign, oc;
 int32 acc = ACC_MASK (USER);
 
 PC = PC & WMASK;                                        /* PC must be 16b */
-if (sim_brk_summ && sim_brk_test (RUN_PASS, PC, SWMASK ('E'))) {  /* breakpoint? */
+if (sim_brk_summ && sim_brk_check (RUN_PASS, PC, SWMASK ('E'), USER)) {  /* breakpoint? */
     ABORT (STOP_IBKPT);                                 /* stop simulation */
 }
 cpu_cycle();                                            /* count cycles */
 cpu_unit->sim_instrs++;                                 /* ... and instructions */
+cpu_stats.instrs++;                                     /* ... for statistics */
 
 IR = RdMemW (PC);                                       /* fetch instruction */
 PC = (PC + 2) & WMASK;                                  /* incr PC, mod 65k */
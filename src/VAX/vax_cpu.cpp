@@ -309,6 +309,7 @@ extern int32 BadCmPSL (RUN_DECL, int32 newpsl);
 extern int32 get_vector (RUN_DECL, int32 lvl);
 extern void set_map_reg (RUN_DECL);
 extern void rom_wr_B (RUN_DECL, int32 pa, int32 val);
+extern void rom_sync_shadow (int32 rg, int32 n);
 extern int32 machine_check (RUN_DECL, int32 p1, int32 opc, int32 cc, int32 delta);
 extern const uint16 drom[NUM_INST][MAX_SPEC + 1];
 extern t_stat cpu_boot (int32 unitno, DEVICE *dptr);
@@ -376,16 +377,31 @@ CPU_UNIT::CPU_UNIT() : UNIT(&cpu_idle_svc, UNIT_FIX|UNIT_BINK|UNIT_ISCPU, INITME
     cpu_idle_sleep_us = 0;
     cpu_idle_sleep_cycles = 0;
 
-    cpu_ssc_delta_timer[0] = NULL;
-    cpu_ssc_delta_timer[1] = NULL;
+    memset(& cpu_perf_stats, 0, sizeof(cpu_perf_stats));
+
+    cpu_throt_state = 0;
+    cpu_throt_wait = 0;
+    cpu_throt_cycles = 0;
+    cpu_throt_ns = 0;
+    cpu_throt_start_ns = 0;
+    cpu_throt_debt_ns = 0;
+    cpu_throt_acps = 0;
+    cpu_throt_calib_ns = 0;
+    cpu_throt_calib_cycles = 0;
+    cpu_throt_total_cycles = 0;
+    cpu_throt_slept_ns = 0;
+    cpu_throt_sleeps = 0;
+
+    cpu_ssc_rt_ns = 0;
+    cpu_ssc_rt_cycles = 0;
+    cpu_ssc_rt_elapsed = 0;
+    cpu_ssc_rt_ns_per_cycle = 0;
 
     clk_active = FALSE;
     cpu_last_synclk_cycles = 0;
     cpu_last_tslice_tick_cycles = 0;
     cpu_last_second_tick_cycles = 0;
 
-    sysd_active_mask = 0;
-
     cpu_active_clk_interrupt = FALSE;
     cpu_active_ipi_interrupt = FALSE;
 
@@ -433,10 +449,8 @@ void CPU_UNIT::init(uint8 cpu_id, uint8 cpu_state)
     init_clock_queue();
     sim_step = 0;
     sim_instrs = 0;
-    cpu_ssc_delta_timer[0] = sim_delta_timer::create();
-    cpu_ssc_delta_timer[1] = sim_delta_timer::create();
     cpu_wakeup_event = smp_event::create();
-    this->cpu_run_gate = smp_semaphore::create(0);
+    this->cpu_run_gate = smp_simple_semaphore::create(0);
     syncw_wait_event = smp_event::create();
     smp_create_thread(sim_cpu_work_thread_proc, this, & this->cpu_thread);
     cpu_thread_created = TRUE;
@@ -683,6 +697,8 @@ MTAB cpu_mod[] = {
       &cpu_set_hist, &cpu_show_hist },
     { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP, 0, "VIRTUAL", NULL,
       NULL, &cpu_show_virt },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO, 0, "STATISTICS", NULL,
+      NULL, &cpu_show_stats },
     { 0 }
 };
 
@@ -1280,7 +1296,10 @@ sim_try
                     SISR = SISR & ~(1u << temp);
                 }
                 if (vec)                                    /* take intr */
+                {
                     cc = intexc (RUN_PASS, vec, cc, temp, IE_INT);
+                    cpu_stats.interrupts++;
+                }
                 GET_CUR;                                    /* set cur mode */
                 SET_IRQL;                                   /* eval interrupts */
             }
@@ -1310,7 +1329,7 @@ sim_try
             }
         }                                                   /* end PSL event */
 
-        if (sim_brk_summ && sim_brk_test (RUN_PASS, (uint32) PC, SWMASK ('E')))       /* breakpoint? */
+        if (sim_brk_summ && sim_brk_check (RUN_PASS, (uint32) PC, SWMASK ('E'), PSL_GETCUR (PSL)))   /* breakpoint? */
         {
             ABORT (STOP_IBKPT);                             /* stop simulation */
         }
@@ -1323,6 +1342,7 @@ sim_try
 
         cpu_cycle();                                        /* count cycles */
         cpu_unit->sim_instrs++;                             /* ... and instructions */
+        cpu_stats.instrs++;                                 /* ... for statistics */
         GET_ISTR_B (opc);                                   /* get opcode */
         if (opc == 0xFD)                                    /* 2 byte op? */
         {
@@ -4510,7 +4530,7 @@ t_stat cpu_reset (DEVICE *dptr)
         return SCPE_IERR;
 
     if (M == NULL)
-        M = (uint32*) calloc_aligned (((uint32) MEMSIZE) >> 2, sizeof (uint32), /*SMP_MAXCACHELINESIZE*/ 512);
+        M = (uint32*) sim_alloc_memory ((uint32) MEMSIZE);
     if (M == NULL)
         return SCPE_MEM;
 
@@ -4525,9 +4545,6 @@ t_stat cpu_reset (DEVICE *dptr)
     }
     cpu_unit->cpu_requeue_syswide_pending = FALSE;
 
-    /* mark all SSC timers as inactive */
-    cpu_unit->sysd_active_mask = 0;
-
     cpu_database_lock->lock();
     if (cpu_unit->is_running())
         cpu_unit->cpu_state = CPU_STATE_RUNNABLE;
@@ -4542,6 +4559,7 @@ t_stat cpu_reset (DEVICE *dptr)
         // do this just once for the reset cycle across all CPUs, and only from the primary CPU
         hlt_pin = 0;
         sim_brk_types = sim_brk_dflt = SWMASK ('E');
+        sim_brk_mode_names = "KESU";                        /* PSL<cur_mode> letters for BREAK /MODE= */
         use_native_interlocked = FALSE;
         syncw_reset();
         return build_dib_tab ();
@@ -4601,6 +4619,7 @@ if (ADDR_IS_MEM (addr) || ADDR_IS_CDG (addr) ||
     }
 if (ADDR_IS_ROM (addr)) {
     rom_wr_B (RUN_PASS, addr, (int32) val);
+    rom_sync_shadow (((addr - ROMBASE) & ROMAMASK) >> 2, 1);
     return SCPE_OK;
     }
 return SCPE_NXM;
@@ -4621,13 +4640,13 @@ t_stat cpu_set_size (UNIT *uptr, int32 val, char *cptr, void *desc)
         mc = mc | M[i >> 2];
     if (mc != 0 && !get_yn ("Really truncate memory [N]?", FALSE))
         return SCPE_OK;
-    nM = (uint32 *) calloc_aligned (val >> 2, sizeof (uint32), /*SMP_MAXCACHELINESIZE*/ 512);
+    nM = (uint32 *) sim_alloc_memory ((uint32) val);
     if (nM == NULL)
         return SCPE_MEM;
     clim = (uint32) (((uint32) val) < MEMSIZE ? val : MEMSIZE);
     for (i = 0; i < clim; i = i + 4)
         nM[i >> 2] = M[i >> 2];
-    free_aligned ((void*) M);
+    sim_free_memory ((void*) M, (uint32) MEMSIZE);
     M = nM;
     CPU_UNIT* sv_cpu_unit = cpu_unit;
     /*
@@ -6047,10 +6066,12 @@ static t_bool cpu_start_secondary(RUN_DECL, CPU_UNIT* xcpu, uint32* pcb, uint32
             syncw_enter_ilk(RUN_PASS);
         }
 
-        /* mark target VCPU as enabled for synchronizaton window */
+        /* mark target VCPU as enabled for synchronizaton window and start its throttle pacing */
         cpu_unit = rscx->cpu_unit = xcpu;
         syncw_reinit_cpu(RUN_PASS, SYNCW_NOLOCK);
         syncw_reeval_sys(RUN_PASS);
+        sim_throt_cancel ();
+        sim_throt_sched ();
         cpu_unit = rscx->cpu_unit = local_cpu;
 
         /* set up SYNCLK and clock tracking */
@@ -6214,8 +6235,8 @@ void cpu_once_a_second(RUN_DECL)
      *    look worth bothering about.
      *
      * 4) When last secondary is being stopped, the primary will get a notification of this via
-     *    SECEXIT interrupt and will drop its priority (except in very unlikely case that calibration
-     *    is active), but it may take some time before IOP and CLOCK threads get wind of change,
+     *    SECEXIT interrupt and will drop its priority, but it may take some time before IOP and
+     *    CLOCK threads get wind of change,
      *    and thus IOP and CLOCK threads may continue for some (typically short) time bumping up
      *    primary VCPU thread priority. They may do it even after SECEXIT dropped priority and thus
      *    negate the drop performed in SECEXIT handler. Furthermore, it is possible (though very
@@ -6230,14 +6251,14 @@ void cpu_once_a_second(RUN_DECL)
      *
      *    The easiest solution is simply to reset primary VCPU thread priority periodically to
      *    CPU_RUN (for some time after going from MP to UniP mode) -- in case thread priority control
-     *    is makerd as "should be disabled" and unless (unlikely) calibration is active.
+     *    is makerd as "should be disabled".
      *
      *    Such resets can be performed in SYNCLK or CLK interrupt handlers, for instance. But the most 
      *    convenient solution is to place the reset in cpu_once_a_second() routine.
      *
      */
 
-    if (!must_control_prio() && !tmr_is_active(RUN_PASS))
+    if (!must_control_prio())
         smp_set_thread_priority(SIMH_THREAD_PRIORITY_CPU_RUN);
 }
 
@@ -1673,9 +1673,8 @@ int32 intexc(RUN_DECL, int32 vec, int32 cc, int32 ipl, int ei) {
 
     PSL = newpsl;
 
-    if (DEBUG_PRI (cpu_dev, LOG_CPU_I))
-        fprintf(sim_deb, ">>IEX: PC=%08x, PSL=%08x, SP=%08x, VEC=%08x, nPSL=%08x, nSP=%08x\n",
-                PC, oldpsl, oldsp, vec, PSL, SP);
+    sim_debug (LOG_CPU_I, &cpu_dev, ">>IEX: PC=%08x, PSL=%08x, SP=%08x, VEC=%08x, nPSL=%08x, nSP=%08x\n",
+               PC, oldpsl, oldsp, vec, PSL, SP);
 
     /*
      * O/S virtualization assistance.
@@ -1800,10 +1799,8 @@ int32 op_rei(RUN_DECL, int32 acc) {
     else
         STK[oldcur] = SP;
 
-    if (DEBUG_PRI (cpu_dev, LOG_CPU_R)) {
-        fprintf(sim_deb, ">>REI: PC=%08x, PSL=%08x, SP=%08x, nPC=%08x, nPSL=%08x, nSP=%08x\n",
-                PC, PSL, SP - 8, newpc, newpsl, ((newpsl & IS) ? IS : STK[newcur]));
-    }
+    sim_debug (LOG_CPU_R, &cpu_dev, ">>REI: PC=%08x, PSL=%08x, SP=%08x, nPC=%08x, nPSL=%08x, nSP=%08x\n",
+               PC, PSL, SP - 8, newpc, newpsl, ((newpsl & IS) ? IS : STK[newcur]));
 
     PSL = (PSL & PSL_TP) | (newpsl & ~CC_MASK);             /* set PSL */
 
@@ -1814,8 +1811,7 @@ int32 op_rei(RUN_DECL, int32 acc) {
     else {
         SP = STK[newcur];                                   /* if ~IS, chk AST */
         if (newcur >= ASTLVL) {
-            if (DEBUG_PRI (cpu_dev, LOG_CPU_R))
-                fprintf(sim_deb, ">>REI: AST delivered\n");
+            sim_debug (LOG_CPU_R, &cpu_dev, ">>REI: AST delivered\n");
             SISR = SISR | SISR_2;
         }
     }
@@ -1909,9 +1905,8 @@ void op_ldpctx(RUN_DECL, int32 acc) {
 
     zap_tb(RUN_PASS, 0);                                   /* clear process TB */
     set_map_reg(RUN_PASS);
-    if (DEBUG_PRI (cpu_dev, LOG_CPU_P))
-        fprintf(sim_deb, ">>LDP: PC=%08x, PSL=%08x, SP=%08x, nPC=%08x, nPSL=%08x, nSP=%08x\n",
-                PC, PSL, SP, newpc, newpsl, KSP);
+    sim_debug (LOG_CPU_P, &cpu_dev, ">>LDP: PC=%08x, PSL=%08x, SP=%08x, nPC=%08x, nPSL=%08x, nSP=%08x\n",
+               PC, PSL, SP, newpc, newpsl, KSP);
     if (PSL & PSL_IS)                                       /* if istk, */
         IS = SP;
     PSL = PSL & ~PSL_IS;                                    /* switch to kstk */
@@ -1933,9 +1928,8 @@ void op_svpctx(RUN_DECL, int32 acc) {
     savpc = Read(RUN_PASS, SP, L_LONG, RA);                /* pop PC, PSL */
     savpsl = Read(RUN_PASS, SP + 4, L_LONG, RA);
 
-    if (DEBUG_PRI (cpu_dev, LOG_CPU_P))
-        fprintf(sim_deb, ">>SVP: PC=%08x, PSL=%08x, SP=%08x, oPC=%08x, oPSL=%08x\n",
-                PC, PSL, SP, savpc, savpsl);
+    sim_debug (LOG_CPU_P, &cpu_dev, ">>SVP: PC=%08x, PSL=%08x, SP=%08x, oPC=%08x, oPSL=%08x\n",
+               PC, PSL, SP, savpc, savpsl);
 
     if (PSL & PSL_IS)                                       /* int stack? */
         SP = SP + 8;
@@ -2461,12 +2455,6 @@ void cpu_reevaluate_thread_priority(RUN_DECL, t_bool synced) {
         return;
     }
 
-    if (unlikely(tmr_is_active(RUN_PASS))) {
-        /* check if SSC clocks are still active */
-        cpu_set_thread_priority(RUN_PASS, SIMH_THREAD_PRIORITY_CPU_CALIBRATION);
-        return;
-    }
-
     if (unlikely(rscx->vm_critical_locks != 0)) {
         /*
          * if code holds VM critical locks, run at elevated priority
@@ -2752,21 +2740,10 @@ void interrupt_set_int(CPU_UNIT *xcpu, uint32 ix_ipl, uint32 dev, t_bool force_w
              * can already be at CRITICAL_VM, so use CRITICAL_VM to avoid undermining the target, but leave the mark 
              * for the target to re-examine its thread priority ASAP.
              *
-             * We assume that CRITICAL_VM is the highest thread priority target may usually have and it is not likely to be
-             * at CALIBRATION priority since SSC clocks (associated with CALIBRATION) are generally not used by VMS
-             * on a MicroVAX after SMP is activated, whereas device interrupts are unlikely during the INIT phase
-             * when SSC calibration is performed. However SYNCLK are quite possible during CALIBRATION.
-             * Nevertheless even if it happened, CRITICAL_VM is close to CALIBRATION, so we use CRITICAL_VM here
-             * instead of CALIBRATION.
-             *
-             * We do however make limited attempt to keep the thread at CALIBRATON if it was already at CALIBRATION
-             * and avoid resetting it to VM. The check below does not have to be perfect.
+             * We assume that CRITICAL_VM is the highest thread priority target may usually have.
              */
             if (must_control_prio()) {
-                if (weak_read(xcpu->sysd_active_mask) == 0)
-                    smp_set_thread_priority(xcpu->cpu_thread, SIMH_THREAD_PRIORITY_CPU_CRITICAL_VM);
-                else
-                    smp_set_thread_priority(xcpu->cpu_thread, SIMH_THREAD_PRIORITY_CPU_CALIBRATION);
+                smp_set_thread_priority(xcpu->cpu_thread, SIMH_THREAD_PRIORITY_CPU_CRITICAL_VM);
 
                 /* Force target VCPU to re-evaluate its thread priority ASAP. Can be xchg(changed, 1). */
                 xcpu->cpu_intreg.cas_changed(0, 1);
@@ -3147,12 +3124,5 @@ t_stat xdev_cmd(int32 flag, char *cptr) {
  * Pre-fault memory into working set
  */
 void cpu_prefault_memory() {
-    int npages = (int) (cpu_unit_0.capac / VA_PAGSIZE);
-    volatile t_byte *p = (volatile t_byte *) M;
-    volatile static t_byte b;
-
-    for (int k = 0; k < npages; k++) {
-        b = *p;
-        p += VA_PAGSIZE;
-    }
+    sim_prefault_range((void*) M, (size_t) cpu_unit_0.capac);
 }
@@ -88,6 +88,7 @@
 #define clk_csr  (cpu_unit->cpu_context.r_clk_csr)
 #define todr_reg  (cpu_unit->cpu_context.r_todr_reg)
 #define todr_blow  (cpu_unit->cpu_context.r_todr_blow)
+#define cpu_stats  (cpu_unit->cpu_perf_stats)
 
 #define primary_todr_reg  (cpu_unit_0.cpu_context.r_todr_reg)
 #define primary_todr_blow  (cpu_unit_0.cpu_context.r_todr_blow)
@@ -99,6 +100,22 @@ typedef struct
 }
 TLBENT;
 
+/*
+ * Live performance counters (SHOW CPU STATISTICS, PERF STATS).
+ * Updated only by the VCPU's own thread and never reset, readers take differences between snapshots.
+ * Kept in CPU_UNIT rather than CPU_CONTEXT so that SAVE/RESTORE does not move them backwards.
+ */
+typedef struct
+{
+    t_uint64    instrs;                                 /* instructions executed */
+    t_uint64    interrupts;                             /* interrupts taken */
+    t_uint64    tlb_misses;                             /* TLB fills */
+    t_uint64    idle_us;                                /* time in idle sleep */
+    t_uint64    syncw_ns;                               /* time stalled in synchronization window */
+    t_uint64    lock_wait_ns;                           /* time waiting for contended locks */
+}
+CPU_STATS;
+
 class CPU_CONTEXT
 {
 private:
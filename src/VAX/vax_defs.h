@@ -818,6 +818,7 @@ void WriteIPR(RUN_DECL, int32 rg, int32 val, t_bool& set_irql);
 t_bool BadCmPSL(RUN_DECL, int32 newpsl);
 void cpu_setup_secondary_model_specific(RUN_DECL, CPU_UNIT* local_cpu);
 void cpu_prefault_memory();
+t_stat cpu_show_stats (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
 void cpu_on_rom_rd(RUN_DECL);
 void cpu_shutdown_secondaries(RUN_DECL);
 void cpu_once_a_second(RUN_DECL);
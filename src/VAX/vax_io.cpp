@@ -137,6 +137,7 @@ t_stat set_autocon (UNIT *uptr, int32 val, char *cptr, void *desc);
 t_stat show_autocon (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
 t_stat show_iospace (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
 t_stat qba_show_virt (SMP_FILE *of, UNIT *uptr, int32 val, void *desc);
+static void build_lw_tab (DIB *dibp);
 
 /* Qbus adapter data structures
 
@@ -190,6 +191,15 @@ DEVICE qba_dev = {
 t_stat (*iodispR[IOPAGESIZE >> 1])(int32 *dat, int32 ad, int32 md);
 t_stat (*iodispW[IOPAGESIZE >> 1])(int32 dat, int32 ad, int32 md);
 
+/*
+ * Longword dispatches, indexed by aligned longword.  An entry is set only when both words
+ * of the longword belong to a device that supplies longword handlers (DIB rdl/wrl),
+ * so that the access is served in a single call under a single acquisition of device lock.
+ * Other longword accesses are split into two word accesses.
+ */
+static t_stat (*iodispRL[IOPAGESIZE >> 2])(int32 *dat, int32 ad);
+static t_stat (*iodispWL[IOPAGESIZE >> 2])(int32 dat, int32 ad);
+
 /* Interrupt request to interrupt action map */
 
 SIM_ALIGN_PTR int32 (* volatile int_ack[IPL_HLVL][32])();                       /* int ack routines */
@@ -242,15 +252,23 @@ void WriteQb (RUN_DECL, uint32 pa, int32 val, int32 mode)
         longword of data
 */
 
-int32 ReadIO (RUN_DECL, uint32 pa, int32 lnt)
+int32 ReadIO (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 iod;
 
-    iod = ReadQb (RUN_PASS, pa);                            /* wd from Qbus */
     if (lnt < L_LONG)                                       /* bw? position */
-        iod = iod << ((pa & 2)? 16: 0);
+    {
+        iod = ReadQb (RUN_PASS, pa) << ((pa & 2)? 16: 0);   /* wd from Qbus */
+    }
+    else if ((pa & 3) == 0 && iodispRL[(pa & IOPAGEMASK) >> 2])
+    {
+        iodispRL[(pa & IOPAGEMASK) >> 2] (&iod, pa);        /* native lw */
+    }
     else
-        iod = (ReadQb (RUN_PASS, pa + 2) << 16) | iod;      /* lw, get 2nd wd */
+    {
+        iod = ReadQb (RUN_PASS, pa);                        /* lw, get 2 wds */
+        iod = (ReadQb (RUN_PASS, pa + 2) << 16) | iod;
+    }
 
     /*
      * Checking here for the change in pending interrupts made sense on a uniprocessor version of the emulator.
@@ -275,12 +293,14 @@ int32 ReadIO (RUN_DECL, uint32 pa, int32 lnt)
         none
 */
 
-void WriteIO (RUN_DECL, uint32 pa, int32 val, int32 lnt)
+void WriteIO (RUN_DECL, int32 pa, int32 val, int32 lnt)
 {
     if (lnt == L_BYTE)
         WriteQb (RUN_PASS, pa, val, WRITEB);
     else if (lnt == L_WORD)
         WriteQb (RUN_PASS, pa, val, WRITE);
+    else if ((pa & 3) == 0 && iodispWL[(pa & IOPAGEMASK) >> 2])
+        iodispWL[(pa & IOPAGEMASK) >> 2] (val, pa);         /* native lw */
     else
     {
         WriteQb (RUN_PASS, pa, val & 0xFFFF, WRITE);
@@ -545,13 +565,11 @@ void read_irqs_to_local(RUN_DECL)
 
             /*
              * If last secondary had exited and only the primary remains active, stop managing thread
-             * priority and drop primary VCPU actual thread priority down to CPU_RUN level. The only 
-             * (extremely unlikely) exception is if calibration is active, in which case priority will
-             * be dropped later when processor exits CALIBRATION level.
+             * priority and drop primary VCPU actual thread priority down to CPU_RUN level.
              *
              * For more detailed explanation of what is done here and why, refer to the comment in cpu_once_a_second().
              */
-            if (!must_control_prio() && !tmr_is_active(RUN_PASS))
+            if (!must_control_prio())
                 smp_set_thread_priority(SIMH_THREAD_PRIORITY_CPU_RUN);
 
             continue;
@@ -676,7 +694,7 @@ void process_synclk(RUN_DECL, t_bool clk_ie)
    IPC          inter-processor communication register
 */
 
-int32 cqbic_rd (RUN_DECL, int32 pa)
+int32 cqbic_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 rg = (pa - CQBICBASE) >> 2;
 
@@ -708,7 +726,7 @@ void cqbic_wr (RUN_DECL, int32 pa, int32 val, int32 lnt)
     {
         int32 sc = (pa & 3) << 3;
         int32 mask = (lnt == L_WORD)? 0xFFFF: 0xFF;
-        int32 t = cqbic_rd (RUN_PASS, pa);
+        int32 t = cqbic_rd (RUN_PASS, pa, L_LONG);
         nval = ((val & mask) << sc) | (t & ~(mask << sc));
         val = val << sc;
     }
@@ -761,7 +779,7 @@ void cqbic_wr (RUN_DECL, int32 pa, int32 val, int32 lnt)
 /* IPC can be read as local register or as Qbus I/O
    Because of the W1C */
 
-int32 cqipc_rd (RUN_DECL, int32 pa)
+int32 cqipc_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     return cq_ipc & CQIPC_MASK;                             /* IPC */
 }
@@ -804,7 +822,7 @@ t_stat dbl_wr (int32 data, int32 addr, int32 access)
  *  Write error: set DSER<0>, latch slave address, memory error interrupt
  */
 
-int32 cqmap_rd (RUN_DECL, int32 pa)
+int32 cqmap_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 ma = (pa & CQMAPAMASK) + cq_mbr;                  /* mem addr */
 
@@ -842,7 +860,7 @@ void cqmap_wr (RUN_DECL, int32 pa, int32 val, int32 lnt)
  * May give master or slave error, depending on where the failure occurs
  */
 
-int32 cqmem_rd (RUN_DECL, int32 pa)
+int32 cqmem_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 qa = pa & CQMAMASK;                               /* Qbus addr */
     uint32 ma;
@@ -1268,11 +1286,18 @@ t_stat qba_dep (t_value val, t_addr exta, UNIT *uptr, int32 sw)
 t_stat build_dib_tab (void)
 {
     int32 i;
+    uint32 k;
     DEVICE *dptr;
     DIB *dibp;
     t_stat r;
 
     init_ubus_tab ();                                       /* init bus tables */
+    for (k = 0; k < (IOPAGESIZE >> 2); k++)                 /* clear lw dispatch */
+    {
+        iodispRL[k] = NULL;
+        iodispWL[k] = NULL;
+    }
+
     for (i = 0; (dptr = sim_devices[i]) != NULL; i++)       /* loop thru dev */
     {
         dibp = (DIB *) dptr->ctxt;                          /* get DIB */
@@ -1280,11 +1305,30 @@ t_stat build_dib_tab (void)
         {
             if (r = build_ubus_tab (dptr, dibp))            /* add to bus tab */
                 return r;
+            build_lw_tab (dibp);                            /* add lw handlers */
         }
     }
     return SCPE_OK;
 }
 
+/* Add longword dispatches for aligned longwords lying wholly within device range */
+
+static void build_lw_tab (DIB *dibp)
+{
+    uint32 ad;
+    int32 idx;
+
+    if (dibp->rdl == NULL && dibp->wrl == NULL)
+        return;
+
+    for (ad = (dibp->ba + 3) & ~3u; ad + 4 <= dibp->ba + dibp->lnt; ad += 4)
+    {
+        idx = (ad & IOPAGEMASK) >> 2;
+        iodispRL[idx] = dibp->rdl;
+        iodispWL[idx] = dibp->wrl;
+    }
+}
+
 /* Show QBA virtual address */
 
 t_stat qba_show_virt (SMP_FILE *of, UNIT *uptr, int32 val, void *desc)
@@ -565,6 +565,7 @@ static TLBENT fill (RUN_DECL, uint32 va, int32 acc, int32 *stat)
     int32 tlbpte, ptead, pte, tbi, vpn;
     static const TLBENT zero_pte = { 0, 0 };
 
+    cpu_stats.tlb_misses++;
     if (va & VA_S0)                                         /* system space? */
     {
         if (ptidx >= d_slr)                                 /* system */
@@ -766,10 +767,7 @@ int32 ReadB_nomem (RUN_DECL, uint32 pa)
     int32 dat;
 
     mchk_ref = REF_V;
-    if (ADDR_IS_IO (pa))
-        dat = ReadIO (RUN_PASS, pa, L_BYTE);
-    else
-        dat = ReadReg (RUN_PASS, pa, L_BYTE);
+    dat = ReadReg (RUN_PASS, pa, L_BYTE);
 
     return ((dat >> ((pa & 3) << 3)) & BMASK);
 }
@@ -779,10 +777,7 @@ int32 ReadW_nonmem (RUN_DECL, uint32 pa)
     int32 dat;
 
     mchk_ref = REF_V;
-    if (ADDR_IS_IO (pa))
-        dat = ReadIO (RUN_PASS, pa, L_WORD);
-    else
-        dat = ReadReg (RUN_PASS, pa, L_WORD);
+    dat = ReadReg (RUN_PASS, pa, L_WORD);
 
     return ((dat >> ((pa & 2)? 16: 0)) & WMASK);
 }
@@ -790,20 +785,14 @@ int32 ReadW_nonmem (RUN_DECL, uint32 pa)
 int32 ReadL_nonmem (RUN_DECL, uint32 pa)
 {
     mchk_ref = REF_V;
-    if (ADDR_IS_IO (pa))
-        return ReadIO (RUN_PASS, pa, L_LONG);
-    else
-        return ReadReg (RUN_PASS, pa, L_LONG);
+    return ReadReg (RUN_PASS, pa, L_LONG);
 }
 
 int32 ReadLP_nonmem (RUN_DECL, uint32 pa)
 {
     mchk_va = pa;
     mchk_ref = REF_P;
-    if (ADDR_IS_IO (pa))
-        return ReadIO (RUN_PASS, pa, L_LONG);
-    else
-        return ReadReg (RUN_PASS, pa, L_LONG);
+    return ReadReg (RUN_PASS, pa, L_LONG);
 }
 
 /*
@@ -813,36 +802,24 @@ int32 ReadLP_nonmem (RUN_DECL, uint32 pa)
 void WriteB_nomem (RUN_DECL, uint32 pa, int32 val)
 {
     mchk_ref = REF_V;
-    if (ADDR_IS_IO (pa))
-        WriteIO (RUN_PASS, pa, val, L_BYTE);
-    else
-        WriteReg (RUN_PASS, pa, val, L_BYTE);
+    WriteReg (RUN_PASS, pa, val, L_BYTE);
 }
 
 void WriteW_nonmem (RUN_DECL, uint32 pa, int32 val)
 {
     mchk_ref = REF_V;
-    if (ADDR_IS_IO (pa))
-        WriteIO (RUN_PASS, pa, val, L_WORD);
-    else
-        WriteReg (RUN_PASS, pa, val, L_WORD);
+    WriteReg (RUN_PASS, pa, val, L_WORD);
 }
 
 void WriteL_nonmem (RUN_DECL, uint32 pa, int32 val)
 {
     mchk_ref = REF_V;
-    if (ADDR_IS_IO (pa))
-        WriteIO (RUN_PASS, pa, val, L_LONG);
-    else
-        WriteReg (RUN_PASS, pa, val, L_LONG);
+    WriteReg (RUN_PASS, pa, val, L_LONG);
 }
 
 void WriteLP_nomem (RUN_DECL, uint32 pa, int32 val)
 {
     mchk_va = pa;
     mchk_ref = REF_P;
-    if (ADDR_IS_IO (pa))
-        WriteIO (RUN_PASS, pa, val, L_LONG);
-    else
-        WriteReg (RUN_PASS, pa, val, L_LONG);
+    WriteReg (RUN_PASS, pa, val, L_LONG);
 }
@@ -6,8 +6,8 @@
 
 extern volatile uint32 *M;
 
-int32 ReadIO (RUN_DECL, uint32 pa, int32 lnt);
-void WriteIO (RUN_DECL, uint32 pa, int32 val, int32 lnt);
+int32 ReadIO (RUN_DECL, int32 pa, int32 lnt);
+void WriteIO (RUN_DECL, int32 pa, int32 val, int32 lnt);
 
 int32 ReadReg (RUN_DECL, uint32 pa, int32 lnt);
 void WriteReg (RUN_DECL, uint32 pa, int32 val, int32 lnt);
@@ -22,6 +22,14 @@ void WriteW_nonmem (RUN_DECL, uint32 pa, int32 val);
 void WriteL_nonmem (RUN_DECL, uint32 pa, int32 val);
 void WriteLP_nomem (RUN_DECL, uint32 pa, int32 val);
 
+extern const uint32 *rom_direct;
+extern uint32 rom_delay;
+extern UNIT rom_unit;
+void cpu_on_rom_rd (RUN_DECL);
+
+/* cycles charged per ROM longword read */
+#define ROM_READ_CHARGE  ((rom_unit.flags & UNIT_NODELAY) ? 0 : (int32) rom_delay)
+
 #if 0
 #  define MEM_REF_ASSERT(cond)  do { if (! (cond))  sim_DebugBreak(); } while (0)
 #else
@@ -76,6 +84,17 @@ SIM_INLINE static int32 ReadW (RUN_DECL, uint32 pa)
     }
 }
 
+/*
+ * Read ROM longword from the read-only shadow (SET ROM SHADOW),
+ * the same as rom_rd but without going through register space dispatch.
+ */
+SIM_INLINE static int32 ReadROM (RUN_DECL, uint32 pa)
+{
+    cpu_on_rom_rd (RUN_PASS);
+    sim_interval -= ROM_READ_CHARGE;
+    return rom_direct[((pa - ROMBASE) & ROMAMASK) >> 2];
+}
+
 /*
  * Read longword.
  * Assumes aligned address.
@@ -92,6 +111,10 @@ SIM_INLINE static int32 ReadL (RUN_DECL, uint32 pa)
         return M[pa >> 2];
 #endif
     }
+    else if (rom_direct && ADDR_IS_ROM (pa))
+    {
+        return ReadROM (RUN_PASS, pa);
+    }
     else
     {
         return ReadL_nonmem (RUN_PASS, pa);
@@ -114,6 +137,10 @@ SIM_INLINE static int32 ReadLP (RUN_DECL, uint32 pa)
         return M[pa >> 2];
 #endif
     }
+    else if (rom_direct && ADDR_IS_ROM (pa))
+    {
+        return ReadROM (RUN_PASS, pa);
+    }
     else
     {
         return ReadLP_nonmem (RUN_PASS, pa);
@@ -134,6 +161,10 @@ SIM_INLINE static int32 ReadL_NA (RUN_DECL, uint32 pa)
         return M[pa >> 2];
 #endif
     }
+    else if (rom_direct && ADDR_IS_ROM (pa))
+    {
+        return ReadROM (RUN_PASS, pa);
+    }
     else
     {
         return ReadL_nonmem(RUN_PASS, pa);
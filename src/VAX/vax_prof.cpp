@@ -0,0 +1,534 @@
+/*
+ * vax_prof.cpp: guest PC sampling profiler (PERF PROFILE)
+ *
+ * A sampler thread wakes up at a fixed rate and, for every VCPU whose thread is executing
+ * instructions, reads the address of the instruction in progress (fault_PC) and the PSL
+ * from the VCPU context.  Samples are accumulated into per-VCPU histograms of PC values,
+ * access modes and IPL levels.  A VCPU that has not retired any instruction since the previous
+ * sample (e.g. its thread is preempted or blocked in the simulator) is counted as stalled
+ * rather than attributed to a PC.  VCPU threads are not involved in sampling at all: the reads
+ * are unsynchronized and can occasionally see a PSL from an adjacent instruction, which is
+ * of no consequence for a statistical profile.  Overhead is one sampler wakeup per period
+ * irrespective of the number of VCPUs.
+ *
+ * PC values can be symbolized through a VMS linker map (e.g. SYS$SYSTEM:SYS.MAP) loaded with
+ * PERF PROFILE MAP <file>.  Only the "Symbols By Value" section is used if the map has one,
+ * otherwise any line holding a hexadecimal value followed by symbol names is accepted.
+ */
+
+#include "sim_defs.h"
+#include "vax_defs.h"
+#include <ctype.h>
+
+#define PROF_DEFAULT_RATE   1000                    /* default samples per second */
+#define PROF_MAX_RATE       20000                   /* highest sampling rate accepted */
+#define PROF_INIT_SLOTS     4096                    /* initial PC histogram size, must be a power of two */
+#define PROF_DEFAULT_TOP    20                      /* PCs listed by PERF PROFILE SHOW */
+#define PROF_MAX_SYMOFFSET  0x10000                 /* larger offsets from nearest symbol are not symbolized */
+
+/* per-VCPU histogram, written by sampler thread only */
+typedef struct
+{
+    uint32* pc;                                     /* open-addressed table of sampled PCs */
+    uint32* count;                                  /* ... and their sample counts, 0 = free slot */
+    uint32 size;                                    /* table size */
+    uint32 used;                                    /* occupied slots */
+    uint32 samples;                                 /* samples taken while VCPU was executing */
+    uint32 idle;                                    /* samples taken while VCPU was idle sleeping */
+    uint32 stalled;                                 /* samples taken while VCPU was not retiring instructions */
+    uint32 last_instrs;                             /* VCPU instruction count at previous sample */
+    uint32 mode[4];                                 /* samples by current access mode */
+    uint32 ipl[32];                                 /* samples by IPL */
+}
+prof_hist;
+
+typedef struct
+{
+    uint32 value;
+    char* name;
+}
+prof_sym;
+
+static prof_hist prof_cpu[SIM_MAX_CPUS];
+static uint32 prof_rate = PROF_DEFAULT_RATE;
+static volatile t_bool prof_active = FALSE;
+static volatile t_bool prof_stop = FALSE;
+static smp_thread_t prof_thread;
+static smp_event* prof_wakeup = NULL;
+static prof_sym* prof_syms = NULL;
+static uint32 prof_nsyms = 0;
+static char* prof_map_name = NULL;
+AUTO_INIT_LOCK(prof_lock, SIM_LOCK_CRITICALITY_NONE, 1000);
+
+static const char* prof_mode_name[4] = { "kernel", "executive", "supervisor", "user" };
+
+static uint32 prof_hash(uint32 pc)
+{
+    return (pc ^ (pc >> 13)) * 0x9E3779B1;
+}
+
+static void prof_add(prof_hist* h, uint32 pc, uint32 n)
+{
+    uint32 k;
+
+    if (h->size == 0 || 4 * (h->used + 1) > 3 * h->size)
+    {
+        uint32 osize = h->size;
+        uint32* opc = h->pc;
+        uint32* ocount = h->count;
+
+        h->size = osize ? 2 * osize : PROF_INIT_SLOTS;
+        h->pc = (uint32*) calloc(h->size, sizeof(uint32));
+        h->count = (uint32*) calloc(h->size, sizeof(uint32));
+        if (h->pc == NULL || h->count == NULL)
+            panic("Unable to allocate memory for PC profile");
+        h->used = 0;
+
+        for (k = 0;  k < osize;  k++)
+        {
+            if (ocount[k])
+                prof_add(h, opc[k], ocount[k]);
+        }
+
+        free(opc);
+        free(ocount);
+    }
+
+    for (k = prof_hash(pc) & (h->size - 1);  h->count[k];  k = (k + 1) & (h->size - 1))
+    {
+        if (h->pc[k] == pc)
+        {
+            h->count[k] += n;
+            return;
+        }
+    }
+
+    h->pc[k] = pc;
+    h->count[k] = n;
+    h->used++;
+}
+
+static void prof_reset_hist(prof_hist* h)
+{
+    free(h->pc);
+    free(h->count);
+    memset(h, 0, sizeof(prof_hist));
+}
+
+static void prof_sample()
+{
+    for (uint32 cpu_ix = 0;  cpu_ix < sim_ncpus;  cpu_ix++)
+    {
+        CPU_UNIT* xcpu = cpu_units[cpu_ix];
+        prof_hist* h = & prof_cpu[cpu_ix];
+
+        if (! cpu_running_set.is_set(cpu_ix))
+            continue;
+
+        if (smp_var(xcpu->cpu_sleeping))
+        {
+            h->idle++;
+            continue;
+        }
+
+        uint32 instrs = xcpu->sim_instrs;
+        if (instrs == h->last_instrs)
+        {
+            h->stalled++;
+            continue;
+        }
+        h->last_instrs = instrs;
+
+        uint32 pc = (uint32) xcpu->cpu_context.r_fault_PC;
+        int32 psl = xcpu->cpu_context.r_PSL;
+
+        prof_add(h, pc, 1);
+        h->samples++;
+        h->mode[PSL_GETCUR(psl)]++;
+        h->ipl[PSL_GETIPL(psl)]++;
+    }
+}
+
+static SMP_THREAD_ROUTINE_DECL prof_thread_main(void* arg)
+{
+    sim_try
+    {
+        smp_thread_init();
+
+        run_scope_context* rscx = new run_scope_context(NULL, SIM_THREAD_TYPE_IOP, prof_thread);
+        rscx->set_current();
+
+        /* sampler must preempt VCPU threads to observe them, a tick takes just a few usec */
+        smp_set_thread_priority(SIMH_THREAD_PRIORITY_CLOCK);
+        smp_set_thread_name("PROFILER");
+
+        while (! prof_stop)
+        {
+            prof_wakeup->timed_wait(1000000 / prof_rate, NULL);
+            if (prof_stop)
+                break;
+            prof_lock->lock();
+            prof_sample();
+            prof_lock->unlock();
+        }
+    }
+    sim_catch (sim_exception_SimError, exc)
+    {
+        fprintf(smp_stderr, "\nFatal error in %s simulator, unexpected exception while executing profiler thread\n", sim_name);
+        fprintf(smp_stderr, "Exception cause: %s\n", exc->get_message());
+        fprintf(smp_stderr, "Terminating the simulator abnormally...\n");
+        exit(1);
+    }
+    sim_end_try
+
+    SMP_THREAD_ROUTINE_END;
+}
+
+static void prof_start(uint32 rate)
+{
+    if (prof_active)
+        return;
+    if (prof_wakeup == NULL)
+        prof_wakeup = smp_event::create();
+    prof_wakeup->clear();
+    prof_rate = rate;
+    prof_stop = FALSE;
+    smp_create_thread(prof_thread_main, NULL, & prof_thread);
+    prof_active = TRUE;
+}
+
+static void prof_halt()
+{
+    if (! prof_active)
+        return;
+    prof_stop = TRUE;
+    prof_wakeup->set();
+    smp_wait_thread(prof_thread);
+    prof_active = FALSE;
+}
+
+/******************************************************************************************
+*  Symbolization                                                                          *
+******************************************************************************************/
+
+static void prof_free_syms()
+{
+    for (uint32 k = 0;  k < prof_nsyms;  k++)
+        free(prof_syms[k].name);
+    free(prof_syms);
+    free(prof_map_name);
+    prof_syms = NULL;
+    prof_nsyms = 0;
+    prof_map_name = NULL;
+}
+
+static int prof_sym_compare(const void* pa, const void* pb)
+{
+    const prof_sym* a = (const prof_sym*) pa;
+    const prof_sym* b = (const prof_sym*) pb;
+    return (a->value < b->value) ? -1 : (a->value > b->value) ? 1 : 0;
+}
+
+/* parse one map line: hexadecimal value followed by one or more symbols */
+static t_stat prof_parse_map_line(char* line, uint32* psize)
+{
+    char* tok = strtok(line, " \t\r\n");
+    char* xp;
+    uint32 value;
+
+    if (tok == NULL || strlen(tok) != 8)
+        return SCPE_OK;
+    value = (uint32) strtoul(tok, & xp, 16);
+    if (*xp)
+        return SCPE_OK;
+
+    while (tok = strtok(NULL, " \t\r\n"))
+    {
+        /* VMS map marks relocatable and universal symbols with R- and U- prefixes */
+        if (strlen(tok) > 2 && tok[1] == '-' && strchr("RUX", tok[0]))
+            tok += 2;
+        if (strlen(tok) < 2 || ! (isalpha((unsigned char) tok[0]) || tok[0] == '$' || tok[0] == '_'))
+            continue;
+        if (prof_nsyms == *psize)
+        {
+            *psize = *psize ? 2 * *psize : 4096;
+            prof_sym* np = (prof_sym*) realloc(prof_syms, *psize * sizeof(prof_sym));
+            if (np == NULL)
+                return SCPE_MEM;
+            prof_syms = np;
+        }
+        if ((prof_syms[prof_nsyms].name = dupstr(tok)) == NULL)
+            return SCPE_MEM;
+        prof_syms[prof_nsyms++].value = value;
+    }
+
+    return SCPE_OK;
+}
+
+static t_stat prof_load_map(char* fname)
+{
+    char line[CBUFSIZE];
+    SMP_FILE* fp;
+    t_bool has_byvalue = FALSE;
+    t_bool in_byvalue = FALSE;
+    uint32 size = 0;
+    t_stat r = SCPE_OK;
+
+    if ((fp = smp_fopen(fname, "r")) == NULL)
+        return SCPE_OPENERR;
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strstr(line, "Symbols By Value"))
+        {
+            has_byvalue = TRUE;
+            break;
+        }
+    }
+    rewind(fp);
+
+    prof_free_syms();
+
+    while (r == SCPE_OK && fgets(line, sizeof(line), fp))
+    {
+        if (has_byvalue && strchr(line, '!'))
+        {
+            /* section banner */
+            in_byvalue = NULL != strstr(line, "Symbols By Value");
+            continue;
+        }
+        if (! has_byvalue || in_byvalue)
+            r = prof_parse_map_line(line, & size);
+    }
+
+    fclose(fp);
+
+    if (r != SCPE_OK)
+    {
+        prof_free_syms();
+        return r;
+    }
+
+    qsort(prof_syms, prof_nsyms, sizeof(prof_sym), prof_sym_compare);
+    prof_map_name = dupstr(fname);
+    return SCPE_OK;
+}
+
+static const char* prof_symbolize(uint32 pc, char* buf)
+{
+    uint32 lo = 0, hi = prof_nsyms;
+
+    /* find last symbol with value <= pc */
+    while (lo < hi)
+    {
+        uint32 mid = (lo + hi) / 2;
+        if (prof_syms[mid].value <= pc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0 || pc - prof_syms[lo - 1].value >= PROF_MAX_SYMOFFSET)
+        return "";
+    if (pc == prof_syms[lo - 1].value)
+        return prof_syms[lo - 1].name;
+    sprintf(buf, "%s+%04X", prof_syms[lo - 1].name, pc - prof_syms[lo - 1].value);
+    return buf;
+}
+
+/******************************************************************************************
+*  Display                                                                                *
+******************************************************************************************/
+
+typedef struct
+{
+    uint32 pc;
+    uint32 count;
+}
+prof_entry;
+
+static int prof_entry_compare(const void* pa, const void* pb)
+{
+    const prof_entry* a = (const prof_entry*) pa;
+    const prof_entry* b = (const prof_entry*) pb;
+    if (a->count != b->count)
+        return (a->count > b->count) ? -1 : 1;
+    return (a->pc < b->pc) ? -1 : (a->pc > b->pc) ? 1 : 0;
+}
+
+static double prof_pct(uint32 n, uint32 total)
+{
+    return total ? 100.0 * n / total : 0.0;
+}
+
+static void prof_show(SMP_FILE* st, uint32 ntop, int cpu_sel)
+{
+    prof_hist sum;
+    char symbuf[CBUFSIZE];
+    uint32 k, cpu_ix;
+
+    memset(& sum, 0, sizeof sum);
+
+    fprintf(st, "PC sampling %s, %u samples per second", prof_active ? "active" : "stopped", prof_rate);
+    if (prof_map_name)
+        fprintf(st, ", %u symbols from %s", prof_nsyms, prof_map_name);
+    fprintf(st, "\n");
+
+    for (cpu_ix = 0;  cpu_ix < sim_ncpus;  cpu_ix++)
+    {
+        prof_hist* h = & prof_cpu[cpu_ix];
+        if (cpu_sel >= 0 && cpu_ix != (uint32) cpu_sel)
+            continue;
+        if (h->samples + h->idle + h->stalled == 0)
+            continue;
+
+        fprintf(st, "CPU%02d: %u samples, %u idle, %u stalled", cpu_ix, h->samples, h->idle, h->stalled);
+        for (k = 0;  k < 4;  k++)
+            fprintf(st, ", %s %.1f%%", prof_mode_name[k], prof_pct(h->mode[k], h->samples));
+        fprintf(st, "\n");
+
+        for (k = 0;  k < h->size;  k++)
+        {
+            if (h->count[k])
+                prof_add(& sum, h->pc[k], h->count[k]);
+        }
+        sum.samples += h->samples;
+        for (k = 0;  k < 32;  k++)
+            sum.ipl[k] += h->ipl[k];
+    }
+
+    if (sum.samples == 0)
+    {
+        prof_reset_hist(& sum);
+        return;
+    }
+
+    fprintf(st, "IPL:");
+    for (k = 0;  k < 32;  k++)
+    {
+        if (sum.ipl[k])
+            fprintf(st, " %u=%.1f%%", k, prof_pct(sum.ipl[k], sum.samples));
+    }
+    fprintf(st, "\n");
+
+    prof_entry* ev = (prof_entry*) malloc(sum.used * sizeof(prof_entry));
+    if (ev == NULL)
+    {
+        prof_reset_hist(& sum);
+        return;
+    }
+    uint32 n = 0;
+    for (k = 0;  k < sum.size;  k++)
+    {
+        if (sum.count[k])
+        {
+            ev[n].pc = sum.pc[k];
+            ev[n++].count = sum.count[k];
+        }
+    }
+    qsort(ev, n, sizeof(prof_entry), prof_entry_compare);
+
+    fprintf(st, "\n   Samples      %%  PC        Symbol\n");
+    for (k = 0;  k < n && k < ntop;  k++)
+    {
+        fprintf(st, "%10u %5.1f%%  %08X  %s\n", ev[k].count, prof_pct(ev[k].count, sum.samples), ev[k].pc,
+                    prof_symbolize(ev[k].pc, symbuf));
+    }
+
+    free(ev);
+    prof_reset_hist(& sum);
+}
+
+/******************************************************************************************
+*  PERF PROFILE command                                                                   *
+******************************************************************************************/
+
+/*
+ * PERF PROFILE ON [rate]           start sampling, rate in samples per second
+ * PERF PROFILE OFF                 stop sampling, histograms are retained
+ * PERF PROFILE RESET               discard collected samples
+ * PERF PROFILE SHOW [n] [cpu-id]   display mode and IPL breakdown and top n PCs
+ * PERF PROFILE MAP [file]          load VMS linker map for symbolization, or unload it
+ */
+t_stat prof_cmd (char *cptr)
+{
+    char gbuf[CBUFSIZE];
+    t_stat r = SCPE_OK;
+    uint32 k;
+
+    cptr = get_glyph (cptr, gbuf, 0);
+
+    if (streqi(gbuf, "ON"))
+    {
+        uint32 rate = PROF_DEFAULT_RATE;
+        if (*cptr)
+        {
+            cptr = get_glyph (cptr, gbuf, 0);
+            rate = (uint32) get_uint (gbuf, 10, PROF_MAX_RATE, & r);
+            if (r != SCPE_OK || rate == 0)
+                return SCPE_ARG;
+        }
+        if (*cptr)
+            return SCPE_2MARG;
+        if (prof_active && rate != prof_rate)
+            prof_halt();
+        prof_start(rate);
+    }
+    else if (streqi(gbuf, "OFF"))
+    {
+        if (*cptr)
+            return SCPE_2MARG;
+        prof_halt();
+    }
+    else if (streqi(gbuf, "RESET"))
+    {
+        if (*cptr)
+            return SCPE_2MARG;
+        prof_lock->lock();
+        for (k = 0;  k < SIM_MAX_CPUS;  k++)
+            prof_reset_hist(& prof_cpu[k]);
+        prof_lock->unlock();
+    }
+    else if (streqi(gbuf, "SHOW") || gbuf[0] == '\0')
+    {
+        uint32 ntop = PROF_DEFAULT_TOP;
+        int cpu_sel = -1;
+        if (*cptr)
+        {
+            cptr = get_glyph (cptr, gbuf, 0);
+            ntop = (uint32) get_uint (gbuf, 10, 1000000, & r);
+            if (r != SCPE_OK)
+                return SCPE_ARG;
+        }
+        if (*cptr)
+        {
+            cptr = get_glyph (cptr, gbuf, 0);
+            cpu_sel = (int) get_uint (gbuf, 10, sim_ncpus - 1, & r);
+            if (r != SCPE_OK)
+                return SCPE_ARG;
+        }
+        if (*cptr)
+            return SCPE_2MARG;
+        prof_lock->lock();
+        prof_show(smp_stdout, ntop, cpu_sel);
+        if (sim_log)
+            prof_show(sim_log, ntop, cpu_sel);
+        prof_lock->unlock();
+    }
+    else if (streqi(gbuf, "MAP"))
+    {
+        if (*cptr == 0)
+        {
+            prof_free_syms();
+            return SCPE_OK;
+        }
+        get_glyph_nc (cptr, gbuf, 0);
+        return prof_load_map(gbuf);
+    }
+    else
+    {
+        return SCPE_ARG;
+    }
+
+    return SCPE_OK;
+}
@@ -0,0 +1,278 @@
+/*
+ * vax_stats.cpp: live per-VCPU performance counters (SHOW CPU STATISTICS, PERF STATS)
+ *
+ * Each VCPU maintains a set of cumulative counters in its CPU_UNIT (cpu_perf_stats): instructions
+ * executed, interrupts taken, TLB fills, time spent in idle sleep, time stalled in the synchronization
+ * window and time spent waiting for contended locks.  Counters are only ever incremented, and only by
+ * the VCPU's own thread, on paths that are already taken anyway (an increment per instruction, per
+ * interrupt and per TLB fill; a host clock read around blocking waits), so they stay enabled at all times.
+ *
+ * Readers never reset the counters: they take a snapshot and report differences against a previous
+ * snapshot.  Reads are not synchronized with the VCPU thread.  This is of no consequence for 64-bit
+ * hosts; on 32-bit hosts a counter can occasionally be read torn, which shows up as a single outlier.
+ *
+ * SHOW CPU STATISTICS displays rates for every VCPU over the interval since the previous display.
+ * PERF STATS FILE <file> [sec] starts a thread that appends the same rates for every VCPU to a CSV
+ * file each <sec> seconds, for graphing and capacity planning.
+ */
+
+#include "sim_defs.h"
+#include "vax_defs.h"
+
+#define STATS_DEFAULT_PERIOD    10                  /* default PERF STATS sampling period, seconds */
+#define STATS_MAX_PERIOD        3600                /* longest sampling period accepted */
+
+typedef struct
+{
+    t_uint64 nsec;                                  /* host time of snapshot */
+    CPU_STATS cpu[SIM_MAX_CPUS];
+}
+stats_snapshot;
+
+/* rates for one VCPU over an interval */
+typedef struct
+{
+    double mips;                                    /* million instructions per second */
+    double idle;                                    /* percent of time in idle sleep */
+    double intr;                                    /* interrupts per second */
+    double tlb;                                     /* TLB fills per second */
+    double syncw;                                   /* percent of time stalled in synchronization window */
+    double lock;                                    /* percent of time waiting for locks */
+}
+stats_rates;
+
+static t_uint64 stats_epoch = sim_os_nsec();        /* simulator start */
+static stats_snapshot stats_shown;                  /* snapshot at previous SHOW CPU STATISTICS */
+static t_bool stats_shown_valid = FALSE;
+
+static uint32 stats_period = STATS_DEFAULT_PERIOD;
+static volatile t_bool stats_active = FALSE;
+static volatile t_bool stats_stop = FALSE;
+static smp_thread_t stats_thread;
+static smp_event* stats_wakeup = NULL;
+static SMP_FILE* stats_file = NULL;
+static char* stats_file_name = NULL;
+
+static void stats_take(stats_snapshot* s)
+{
+    for (uint32 cpu_ix = 0;  cpu_ix < sim_ncpus;  cpu_ix++)
+    {
+        const CPU_STATS* src = & cpu_units[cpu_ix]->cpu_perf_stats;
+        CPU_STATS* dst = & s->cpu[cpu_ix];
+        dst->instrs = src->instrs;
+        dst->interrupts = src->interrupts;
+        dst->tlb_misses = src->tlb_misses;
+        dst->idle_us = src->idle_us;
+        dst->syncw_ns = src->syncw_ns;
+        dst->lock_wait_ns = src->lock_wait_ns;
+    }
+    s->nsec = sim_os_nsec();
+}
+
+static void stats_rate(const stats_snapshot* prev, const stats_snapshot* cur, uint32 cpu_ix, stats_rates* r)
+{
+    const CPU_STATS* a = & prev->cpu[cpu_ix];
+    const CPU_STATS* b = & cur->cpu[cpu_ix];
+    double ns = (double) (cur->nsec - prev->nsec);
+
+    if (ns <= 0)
+    {
+        memset(r, 0, sizeof(stats_rates));
+        return;
+    }
+
+    r->mips = (double) (b->instrs - a->instrs) * 1000.0 / ns;
+    r->idle = (double) (b->idle_us - a->idle_us) * 1000.0 * 100.0 / ns;
+    r->intr = (double) (b->interrupts - a->interrupts) * 1e9 / ns;
+    r->tlb = (double) (b->tlb_misses - a->tlb_misses) * 1e9 / ns;
+    r->syncw = (double) (b->syncw_ns - a->syncw_ns) * 100.0 / ns;
+    r->lock = (double) (b->lock_wait_ns - a->lock_wait_ns) * 100.0 / ns;
+}
+
+/******************************************************************************************
+*  SHOW CPU STATISTICS                                                                    *
+******************************************************************************************/
+
+static void stats_show(SMP_FILE* st, const stats_snapshot* prev, const stats_snapshot* cur)
+{
+    stats_rates r;
+
+    fprintf(st, "Rates over the last %.1f sec (since %s)\n\n", (double) (cur->nsec - prev->nsec) / 1e9,
+            stats_shown_valid ? "previous SHOW CPU STATISTICS" : "simulator start");
+    fprintf(st, "CPU  state         MIPS   idle%%      intr/s   TLB fill/s  syncw%%  lock%%      instructions\n");
+
+    for (uint32 cpu_ix = 0;  cpu_ix < sim_ncpus;  cpu_ix++)
+    {
+        stats_rate(prev, cur, cpu_ix, & r);
+        fprintf(st, "%3d  %-8s  %8.2f  %6.1f  %10.0f  %11.0f  %6.1f  %5.1f  %16" PRIu64 "\n",
+                cpu_ix, cpu_describe_state(cpu_units[cpu_ix]),
+                r.mips, r.idle, r.intr, r.tlb, r.syncw, r.lock, cur->cpu[cpu_ix].instrs);
+    }
+}
+
+t_stat cpu_show_stats (SMP_FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+    static stats_snapshot cur;
+    static stats_snapshot start;
+
+    stats_take(& cur);
+    if (! stats_shown_valid)
+    {
+        memset(& start, 0, sizeof(start));
+        start.nsec = stats_epoch;
+    }
+
+    stats_show(st, stats_shown_valid ? & stats_shown : & start, & cur);
+    stats_shown = cur;
+    stats_shown_valid = TRUE;
+    return SCPE_OK;
+}
+
+/******************************************************************************************
+*  PERF STATS: periodic dump to a file                                                    *
+******************************************************************************************/
+
+static void stats_write_header(SMP_FILE* fp)
+{
+    fprintf(fp, "time_ms,cpu,state,mips,idle_pct,intr_per_sec,tlb_fill_per_sec,syncw_pct,lock_wait_pct,instructions\n");
+    fflush(fp);
+}
+
+static void stats_write(SMP_FILE* fp, const stats_snapshot* prev, const stats_snapshot* cur, t_uint64 time_ms)
+{
+    stats_rates r;
+
+    for (uint32 cpu_ix = 0;  cpu_ix < sim_ncpus;  cpu_ix++)
+    {
+        stats_rate(prev, cur, cpu_ix, & r);
+        fprintf(fp, "%" PRIu64 ",%u,%s,%.3f,%.2f,%.0f,%.0f,%.2f,%.2f,%" PRIu64 "\n",
+                time_ms, cpu_ix, cpu_describe_state(cpu_units[cpu_ix]),
+                r.mips, r.idle, r.intr, r.tlb, r.syncw, r.lock, cur->cpu[cpu_ix].instrs);
+    }
+    fflush(fp);
+}
+
+static SMP_THREAD_ROUTINE_DECL stats_thread_main(void* arg)
+{
+    static stats_snapshot prev;
+    static stats_snapshot cur;
+
+    sim_try
+    {
+        smp_thread_init();
+
+        run_scope_context* rscx = new run_scope_context(NULL, SIM_THREAD_TYPE_IOP, stats_thread);
+        rscx->set_current();
+        smp_set_thread_name("STATS");
+
+        stats_take(& prev);
+        t_uint64 start_nsec = prev.nsec;
+
+        while (! stats_stop)
+        {
+            stats_wakeup->timed_wait(stats_period * 1000 * 1000, NULL);
+            if (stats_stop)
+                break;
+            stats_take(& cur);
+            stats_write(stats_file, & prev, & cur, (cur.nsec - start_nsec) / 1000000);
+            prev = cur;
+        }
+    }
+    sim_catch (sim_exception_SimError, exc)
+    {
+        fprintf(smp_stderr, "\nFatal error in %s simulator, unexpected exception while executing statistics thread\n", sim_name);
+        fprintf(smp_stderr, "Exception cause: %s\n", exc->get_message());
+        fprintf(smp_stderr, "Terminating the simulator abnormally...\n");
+        exit(1);
+    }
+    sim_end_try
+
+    SMP_THREAD_ROUTINE_END;
+}
+
+static void stats_halt()
+{
+    if (! stats_active)
+        return;
+    stats_stop = TRUE;
+    stats_wakeup->set();
+    smp_wait_thread(stats_thread);
+    fclose(stats_file);
+    free(stats_file_name);
+    stats_file = NULL;
+    stats_file_name = NULL;
+    stats_active = FALSE;
+}
+
+static t_stat stats_start(const char* fname, uint32 period)
+{
+    SMP_FILE* fp;
+
+    if ((fp = smp_fopen(fname, "a")) == NULL)
+        return SCPE_OPENERR;
+    stats_halt();
+    stats_write_header(fp);
+    if (stats_wakeup == NULL)
+        stats_wakeup = smp_event::create();
+    stats_wakeup->clear();
+    stats_file = fp;
+    stats_file_name = dupstr(fname);
+    stats_period = period;
+    stats_stop = FALSE;
+    smp_create_thread(stats_thread_main, NULL, & stats_thread);
+    stats_active = TRUE;
+    return SCPE_OK;
+}
+
+/*
+ * PERF STATS FILE <file> [sec]
+ * PERF STATS OFF
+ * PERF STATS [SHOW]
+ */
+t_stat stats_cmd (char *cptr)
+{
+    char gbuf[CBUFSIZE];
+    char fname[CBUFSIZE];
+    uint32 period = STATS_DEFAULT_PERIOD;
+    t_stat r = SCPE_OK;
+
+    cptr = get_glyph (cptr, gbuf, 0);
+
+    if (streqi(gbuf, "FILE"))
+    {
+        if (*cptr == 0)
+            return SCPE_2FARG;
+        cptr = get_glyph_nc (cptr, fname, 0);
+        if (*cptr)
+        {
+            cptr = get_glyph (cptr, gbuf, 0);
+            period = (uint32) get_uint (gbuf, 10, STATS_MAX_PERIOD, & r);
+            if (r != SCPE_OK || period == 0)
+                return SCPE_ARG;
+        }
+        if (*cptr)
+            return SCPE_2MARG;
+        return stats_start(fname, period);
+    }
+    else if (streqi(gbuf, "OFF"))
+    {
+        if (*cptr)
+            return SCPE_2MARG;
+        stats_halt();
+    }
+    else if (streqi(gbuf, "SHOW") || gbuf[0] == '\0')
+    {
+        if (*cptr)
+            return SCPE_2MARG;
+        if (stats_active)
+            smp_printf ("Writing VCPU statistics to %s every %u sec\n", stats_file_name, stats_period);
+        else
+            smp_printf ("VCPU statistics file is not active\n");
+    }
+    else
+    {
+        return SCPE_ARG;
+    }
+
+    return SCPE_OK;
+}
@@ -55,12 +55,18 @@
 #include "sim_defs.h"
 #include "vax_defs.h"
 
+#if !defined(_WIN32)
+#  include <sys/mman.h>
+#endif
+
 #ifndef DONT_USE_INTERNAL_ROM
 #  include "vax_ka655x_bin.h"
 #endif
 
-#define UNIT_V_NODELAY  (UNIT_V_UF + 0)                 /* ROM access equal to RAM access */
-#define UNIT_NODELAY    (1u << UNIT_V_NODELAY)
+#define UNIT_V_SHADOW   (UNIT_V_UF + 1)                 /* ROM shadowed in read-only host page */
+#define UNIT_SHADOW     (1u << UNIT_V_SHADOW)
+
+#define ROM_SHADOW_ALIGN  (64 * 1024)                   /* covers host page and allocation granularity */
 
 /* Console storage control/status */
 
@@ -179,13 +185,13 @@
 
 #define SSCADS_MASK     0x3FFFFFFC                      /* match or mask */
 
-#define sysd_activating(tmr)       do { cpu_unit->sysd_active_mask |= (1 << (tmr)); } while (0)
-#define sysd_deactivating(tmr)     do { cpu_unit->sysd_active_mask &= ~(1 << (tmr)); } while (0)
-
 extern UNIT clk_unit;
 extern int32 sim_switches;
 
 uint32 *rom = NULL;                                     /* boot ROM */
+static uint32 *rom_shadow = NULL;                       /* read-only copy of ROM */
+const uint32 *rom_image = NULL;                         /* guest reads: rom or rom_shadow */
+const uint32 *rom_direct = NULL;                        /* rom_shadow if read on the fast paths */
 uint32 *nvr = NULL;                                     /* non-volatile mem */
 int32 conpc, conpsl;                                    /* console reg */
 int32 csi_csr = 0;                                      /* control/status */
@@ -193,11 +199,13 @@ int32 cso_csr = 0;                                      /* control/status */
 int32 ka_bdr = BDR_BRKENB;                              /* KA655 boot diag */
 int32 ssc_base = SSCBASE;                               /* SSC base */
 int32 ssc_cnf = 0;                                      /* SSC conf */
-static uint32 rom_delay = 0;
+uint32 rom_delay = 0;                                   /* cycles per ROM read, 0 = none */
 
 t_stat rom_ex (t_value *vptr, t_addr exta, UNIT *uptr, int32 sw);
 t_stat rom_dep (t_value val, t_addr exta, UNIT *uptr, int32 sw);
 t_stat rom_reset (DEVICE *dptr);
+t_stat rom_set_shadow (UNIT *uptr, int32 val, char *cptr, void *desc);
+void rom_sync_shadow (int32 rg, int32 n);
 t_stat nvr_ex (t_value *vptr, t_addr exta, UNIT *uptr, int32 sw);
 t_stat nvr_dep (t_value val, t_addr exta, UNIT *uptr, int32 sw);
 t_stat nvr_reset (DEVICE *dptr);
@@ -209,8 +217,8 @@ t_stat cso_svc (RUN_SVC_DECL, UNIT *uptr);
 t_stat tmr_svc (RUN_SVC_DECL, UNIT *uptr);
 t_stat sysd_reset (DEVICE *dptr);
 
-int32 rom_rd (RUN_DECL, int32 pa);
-int32 nvr_rd (RUN_DECL, int32 pa);
+int32 rom_rd (RUN_DECL, int32 pa, int32 lnt);
+int32 nvr_rd (RUN_DECL, int32 pa, int32 lnt);
 void nvr_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
 int32 csrs_rd (RUN_DECL);
 int32 csrd_rd (RUN_DECL);
@@ -218,34 +226,34 @@ int32 csts_rd (RUN_DECL);
 void csrs_wr (RUN_DECL, int32 dat);
 void csts_wr (RUN_DECL, int32 dat);
 void cstd_wr (RUN_DECL, int32 dat);
-int32 cmctl_rd (RUN_DECL, int32 pa);
+int32 cmctl_rd (RUN_DECL, int32 pa, int32 lnt);
 void cmctl_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
-int32 ka_rd (RUN_DECL, int32 pa);
+int32 ka_rd (RUN_DECL, int32 pa, int32 lnt);
 void ka_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
-int32 cdg_rd (RUN_DECL, int32 pa);
+int32 cdg_rd (RUN_DECL, int32 pa, int32 lnt);
 void cdg_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
-int32 ssc_rd (RUN_DECL, int32 pa);
+int32 ssc_rd (RUN_DECL, int32 pa, int32 lnt);
 void ssc_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
 int32 tmr_tir_rd (RUN_DECL, int32 tmr, t_bool interp);
 void tmr_csr_wr (RUN_DECL, int32 tmr, int32 val);
-void tmr_sched (RUN_DECL, int32 tmr, t_bool is_realtime);
-void tmr_incr (RUN_DECL, int32 tmr, uint32 inc, t_bool is_realtime);
+void tmr_sched (RUN_DECL, int32 tmr);
+void tmr_incr (RUN_DECL, int32 tmr, uint32 inc);
 int32 tmr0_inta (void);
 int32 tmr1_inta (void);
 static int32 tmr_tir_rd_realtime (RUN_DECL, int32 tmr);
 static void tmr_csr_wr_realtime (RUN_DECL, int32 tmr, int32 val);
-static void tmr_adjust_thread_priority(RUN_DECL, t_bool force_high = FALSE);
+static void tmr_rt_sample (RUN_DECL);
 int32 parity (int32 val, int32 odd);
 t_stat sysd_powerup (RUN_DECL);
 
 extern int32 intexc (RUN_DECL, int32 vec, int32 cc, int32 ipl, int ei);
-extern int32 cqmap_rd (RUN_DECL, int32 pa);
+extern int32 cqmap_rd (RUN_DECL, int32 pa, int32 lnt);
 extern void cqmap_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
-extern int32 cqipc_rd (RUN_DECL, int32 pa);
+extern int32 cqipc_rd (RUN_DECL, int32 pa, int32 lnt);
 extern void cqipc_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
-extern int32 cqbic_rd (RUN_DECL, int32 pa);
+extern int32 cqbic_rd (RUN_DECL, int32 pa, int32 lnt);
 extern void cqbic_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
-extern int32 cqmem_rd (RUN_DECL, int32 pa);
+extern int32 cqmem_rd (RUN_DECL, int32 pa, int32 lnt);
 extern void cqmem_wr (RUN_DECL, int32 pa, int32 val, int32 lnt);
 extern int32 iccs_rd (RUN_DECL);
 extern int32 todr_rd (RUN_DECL);
@@ -275,12 +283,15 @@ UNIT rom_unit UDATA_SINGLE (NULL, UNIT_FIX+UNIT_BINK, ROMSIZE);
 UNIT_TABLE_SINGLE(rom_unit);
 
 REG rom_reg[] = {
+    { DRDATA_GBL (DELAY, rom_delay, 24), PV_LEFT },
     { NULL }
     };
 
 MTAB rom_mod[] = {
     { UNIT_NODELAY, UNIT_NODELAY, "fast access", "NODELAY", NULL },
-    { UNIT_NODELAY, 0, "1usec calibrated access", "DELAY", NULL },
+    { UNIT_NODELAY, 0, "emulated access delay", "DELAY", NULL },
+    { UNIT_SHADOW, UNIT_SHADOW, "shadowed", "SHADOW", &rom_set_shadow },
+    { UNIT_SHADOW, 0, "not shadowed", "NOSHADOW", &rom_set_shadow },
     { 0 }
     };
 
@@ -457,65 +468,89 @@ AUTO_INIT_DEVLOCK(csio_lock);
    into instruction based timing loops. As the host platform gets
    much faster than the original VAX, the assumptions embedded in
    these code loops are no longer valid.
-   
-   Code has been added to the ROM implementation to limit CPU speed
-   to about 500K instructions per second.  This heads off any future
-   issues with the embedded timing loops.  
+
+   Rather than busy-waiting the host thread, a ROM longword read can
+   be charged against the simulated instruction clock (sim_interval):
+   DELAY cycles per read.  Device and timer events then see ROM code
+   running slower, while the host runs it at full speed and does not
+   steal time from other processes.  SET ROM NODELAY disables the
+   charge.
+
+   DELAY defaults to 0, no charge.  The self-test timer checks pass
+   without one, since ROM and SSC timers here count simulated cycles.
+   A charge makes cycles per host second differ between code running
+   from ROM and from RAM; clock calibration (tmr_poll) chases the
+   difference and the interval timer test (?55) can then fail.
+
+   SET ROM SHADOW keeps a copy of the ROM in its own read-only host
+   pages and maps it into the longword read fast path: ReadL and
+   ReadLP, which also serves instruction prefetch outside of RAM, read
+   it inline instead of going through register space dispatch.  The
+   prefetcher still fetches ROM a longword at a time rather than
+   straight out of the shadow as it does from RAM: ROM memory test
+   (?54) loops fail when ROM code runs that fast.  Console writes
+   (LOAD -R, DEPOSIT) still go to the master copy and are propagated
+   to the shadow once per command.
 */
 
-int32 rom_swapb(int32 val)
+static t_bool rom_protect (uint32 *p, t_bool ro)
 {
-    return ((val << 24) & 0xff000000) | (( val << 8) & 0xff0000) |
-        ((val >> 8) & 0xff00) | ((val >> 24) & 0xff);
+#if defined(_WIN32)
+    DWORD old;
+    return VirtualProtect (p, ROMSIZE, ro ? PAGE_READONLY : PAGE_READWRITE, &old) != 0;
+#else
+    return mprotect (p, ROMSIZE, ro ? PROT_READ : (PROT_READ | PROT_WRITE)) == 0;
+#endif
 }
 
-int32 rom_read_delay (int32 val)
+static void rom_free_shadow ()
 {
-    uint32 i, l = rom_delay;
-    volatile int32 loopval = 0;
-
-    if (rom_unit.flags & UNIT_NODELAY)
-        return val;
-
-    /* Calibrate the loop delay factor when first used.
-       Do this 4 times to and use the largest value computed. */
+    if (rom_shadow)
+    {
+        rom_image = rom;
+        rom_direct = NULL;
+        rom_protect (rom_shadow, FALSE);
+        free_aligned (rom_shadow);
+        rom_shadow = NULL;
+    }
+}
 
-    if (rom_delay == 0)
+t_stat rom_set_shadow (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+    if (val == 0)
     {
-        uint32 ts, te, c = 10000, samples = 0;
-        while (1)
-        {
-            c = c * 2;
-            te = sim_os_msec();
-            while (te == (ts = sim_os_msec ()));            /* align on ms tick */
-
-    /* This is merely a busy wait with some "work" that won't get optimized
-       away by a good compiler. loopval always is zero.  To avoid smart compilers,
-       the loopval variable is referenced in the function arguments so that the
-       function expression is not loop invariant.  It also must be referenced
-       by subsequent code or to avoid the whole computation being eliminated. */
-
-            for (i = 0; i < c; i++)
-                loopval |= (loopval + ts) ^ rom_swapb (rom_swapb (loopval + ts));
-            te = sim_os_msec (); 
-            if ((te - ts) < 50)                         /* sample big enough? */
-                continue;
-            if (rom_delay < (loopval + (c / (te - ts) / 1000) + 1))
-                rom_delay = loopval + (c / (te - ts) / 1000) + 1;
-            if (++samples >= 4)
-                break;
-            c = c / 2;
-        }
-        if (rom_delay < 5)
-            rom_delay = 5;
+        rom_free_shadow ();
+        return SCPE_OK;
+    }
+    if (rom == NULL)
+        return SCPE_IERR;
+    if (rom_shadow == NULL)
+    {
+        rom_shadow = (uint32*) malloc_aligned (ROMSIZE, ROM_SHADOW_ALIGN);
+        if (rom_shadow == NULL)
+            return SCPE_MEM;
+    }
+    memcpy (rom_shadow, rom, ROMSIZE);
+    if (! rom_protect (rom_shadow, TRUE))
+    {
+        rom_free_shadow ();
+        return SCPE_NOFNC;
     }
+    rom_image = rom_direct = rom_shadow;
+    return SCPE_OK;
+}
 
-    for (i = 0; i < l; i++)
-        loopval |= (loopval + val) ^ rom_swapb (rom_swapb (loopval + val));
-    return val + loopval;
+/* Copy n master ROM longwords starting at rg into the shadow, with one protection change */
+void rom_sync_shadow (int32 rg, int32 n)
+{
+    if (rom_shadow && rom_protect (rom_shadow, FALSE))
+    {
+        memcpy (rom_shadow + rg, rom + rg, n * sizeof (uint32));
+        rom_protect (rom_shadow, TRUE);
+    }
 }
 
-int32 rom_rd (RUN_DECL, int32 pa)
+int32 rom_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     /*
      * Kludge: Detect that primary processor jumped into ROM while secondary
@@ -529,8 +564,13 @@ int32 rom_rd (RUN_DECL, int32 pa)
      */
     cpu_on_rom_rd(RUN_PASS);
 
+    if (! (rom_unit.flags & UNIT_NODELAY))
+    {
+        sim_interval -= (int32) rom_delay;
+    }
+
     int32 rg = ((pa - ROMBASE) & ROMAMASK) >> 2;
-    return rom_read_delay (rom[rg]);
+    return rom_image[rg];
 }
 
 void rom_wr_B (RUN_DECL, int32 pa, int32 val)
@@ -566,6 +606,7 @@ t_stat rom_dep (t_value val, t_addr exta, UNIT *uptr, int32 sw)
     if (addr >= ROMSIZE)
         return SCPE_NXM;
     rom[addr >> 2] = (uint32) val;
+    rom_sync_shadow (addr >> 2, 1);
     return SCPE_OK;
 }
 
@@ -577,12 +618,14 @@ t_stat rom_reset (DEVICE *dptr)
         rom = (uint32*) calloc (ROMSIZE >> 2, sizeof (uint32));
     if (rom == NULL)
         return SCPE_MEM;
+    if (rom_image == NULL)
+        rom_image = rom;
     return SCPE_OK;
 }
 
 /* NVR: non-volatile RAM - stored in a buffered file */
 
-int32 nvr_rd (RUN_DECL, int32 pa)
+int32 nvr_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 rg = (pa - NVRBASE) >> 2;
     return nvr[rg];
@@ -960,18 +1003,26 @@ void WriteIPR (RUN_DECL, int32 rg, int32 val, t_bool& set_irql)
 /* Read/write I/O register space
 
    These routines are the 'catch all' for address space map.  Any
-   address that doesn't explicitly belong to memory, I/O, or ROM
-   is given to these routines for processing.
+   address that doesn't belong to memory is given to these routines
+   for processing.
+
+   The target region is located through a two-level page map built
+   from regtable at reset: a 64KB block map, each entry pointing to
+   a map of 256-byte pages, each page holding the region that covers
+   it.  256 bytes is fine enough that no two regions share a page
+   (CQBIC, CMCTL and IPC all live within the first VAX page of REG
+   space).  Blocks wholly inside one region share a single page map.
 */
 
 struct reglink {                                        /* register linkage */
     uint32      low;                                    /* low addr */
     uint32      high;                                   /* high addr */
-    int32       (*read)(RUN_DECL, int32 pa);                        /* read routine */
+    int32       (*read)(RUN_DECL, int32 pa, int32 lnt);             /* read routine */
     void        (*write)(RUN_DECL, int32 pa, int32 val, int32 lnt); /* write routine */
     };
 
-struct reglink regtable[] = {
+static struct reglink regtable[] = {
+    { IOPAGEBASE, IOPAGEBASE+IOPAGESIZE, &ReadIO, &WriteIO },
     { CQMAPBASE, CQMAPBASE+CQMAPSIZE, &cqmap_rd, &cqmap_wr },
     { ROMBASE, ROMBASE+ROMSIZE+ROMSIZE, &rom_rd, NULL },
     { NVRBASE, NVRBASE+NVRSIZE, &nvr_rd, &nvr_wr },
@@ -985,24 +1036,105 @@ struct reglink regtable[] = {
     { 0, 0, NULL, NULL }
     };
 
+#define REGMAP_V_PAG    8                               /* page: 256 bytes */
+#define REGMAP_V_BLK    16                              /* block: 64 KB */
+#define REGMAP_NPAG     (1u << (REGMAP_V_BLK - REGMAP_V_PAG))   /* pages per block */
+#define REGMAP_NBLK     (1u << (PAWIDTH - REGMAP_V_BLK))        /* blocks in phys space */
+
+typedef const struct reglink* regmap_blk[REGMAP_NPAG];
+
+static const regmap_blk* regmap[REGMAP_NBLK];           /* block map */
+static t_bool regmap_built = FALSE;
+
+/* Build the page map from regtable */
+
+static t_stat reg_build_map (void)
+{
+    static regmap_blk* shared[sizeof(regtable) / sizeof(regtable[0])];
+    static t_bool priv[REGMAP_NBLK];
+    struct reglink *p;
+    uint32 blk, pg;
+
+    for (p = &regtable[0]; p->low != 0; p++)
+    {
+        for (blk = p->low >> REGMAP_V_BLK; blk <= (p->high - 1) >> REGMAP_V_BLK; blk++)
+        {
+            uint32 blo = blk << REGMAP_V_BLK;
+            uint32 bhi = blo + (1u << REGMAP_V_BLK);
+            regmap_blk* bm;
+
+            if (blo >= p->low && bhi <= p->high)        /* region covers block? */
+            {
+                if (regmap[blk])
+                    return SCPE_IERR;
+                size_t ix = p - regtable;
+                if (shared[ix] == NULL)
+                {
+                    shared[ix] = (regmap_blk*) calloc(1, sizeof(regmap_blk));
+                    if (shared[ix] == NULL)
+                        return SCPE_MEM;
+                    for (pg = 0; pg < REGMAP_NPAG; pg++)
+                        (*shared[ix])[pg] = p;
+                }
+                regmap[blk] = shared[ix];
+                continue;
+            }
+
+            if (regmap[blk] == NULL)                    /* partial, private map */
+            {
+                if ((bm = (regmap_blk*) calloc(1, sizeof(regmap_blk))) == NULL)
+                    return SCPE_MEM;
+                regmap[blk] = bm;
+                priv[blk] = TRUE;
+            }
+            else if (! priv[blk])
+            {
+                return SCPE_IERR;
+            }
+            bm = (regmap_blk*) regmap[blk];
+
+            uint32 lo = (p->low > blo) ? p->low : blo;
+            uint32 hi = (p->high < bhi) ? p->high : bhi;
+            for (pg = (lo - blo) >> REGMAP_V_PAG; pg <= (hi - 1 - blo) >> REGMAP_V_PAG; pg++)
+            {
+                if ((*bm)[pg] != NULL)                  /* two regions on a page */
+                    return SCPE_IERR;
+                (*bm)[pg] = p;
+            }
+        }
+    }
+
+    regmap_built = TRUE;
+    return SCPE_OK;
+}
+
+static SIM_INLINE const struct reglink* reg_lookup (uint32 pa)
+{
+    const regmap_blk* bm = regmap[(pa & PAMASK) >> REGMAP_V_BLK];
+    if (bm)
+    {
+        const struct reglink* p = (*bm)[(pa >> REGMAP_V_PAG) & (REGMAP_NPAG - 1)];
+        if (p && pa >= p->low && pa < p->high)
+            return p;
+    }
+    return NULL;
+}
+
 /* ReadReg - read register space
 
    Inputs:
         pa      =       physical address
-        lnt     =       length (BWLQ) - ignored
+        lnt     =       length (BWLQ)
    Output:
         longword of data
 */
 
 int32 ReadReg (RUN_DECL, uint32 pa, int32 lnt)
 {
-    struct reglink *p;
+    const struct reglink *p = reg_lookup (pa);
 
-    for (p = &regtable[0]; p->low != 0; p++)
-    {
-        if ((pa >= p->low) && (pa < p->high) && p->read)
-            return p->read (RUN_PASS, pa);
-    }
+    if (p && p->read)
+        return p->read (RUN_PASS, pa, lnt);
     ssc_bto = ssc_bto | SSCBTO_BTO | SSCBTO_RWT;
     MACH_CHECK (MCHK_READ);
     return 0;
@@ -1020,15 +1152,12 @@ int32 ReadReg (RUN_DECL, uint32 pa, int32 lnt)
 
 void WriteReg (RUN_DECL, uint32 pa, int32 val, int32 lnt)
 {
-    struct reglink *p;
+    const struct reglink *p = reg_lookup (pa);
 
-    for (p = &regtable[0]; p->low != 0; p++)
+    if (p && p->write)
     {
-        if ((pa >= p->low) && (pa < p->high) && p->write)
-        {
-            p->write (RUN_PASS, pa, val, lnt);  
-            return;
-        }
+        p->write (RUN_PASS, pa, val, lnt);
+        return;
     }
     ssc_bto = ssc_bto | SSCBTO_BTO | SSCBTO_RWT;
     MACH_CHECK (MCHK_WRITE);
@@ -1051,7 +1180,7 @@ void WriteReg (RUN_DECL, uint32 pa, int32 val, int32 lnt)
    The CMCTL registers are cleared at power up.
 */
 
-int32 cmctl_rd (RUN_DECL, int32 pa)
+int32 cmctl_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 rg = (pa - CMCTLBASE) >> 2;
 
@@ -1116,7 +1245,7 @@ void cmctl_wr (RUN_DECL, int32 pa, int32 val, int32 lnt)
 
 /* KA655 registers */
 
-int32 ka_rd (RUN_DECL, int32 pa)
+int32 ka_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 rg = (pa - KABASE) >> 2;
 
@@ -1150,7 +1279,7 @@ int32 sysd_hlt_enb (void)
 
 /* Cache diagnostic space */
 
-int32 cdg_rd (RUN_DECL, int32 pa)
+int32 cdg_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 t, row = CDG_GETROW (pa);
 
@@ -1190,7 +1319,7 @@ int32 parity (int32 val, int32 odd)
 
 /* SSC registers - byte/word merges done in WriteReg */
 
-int32 ssc_rd (RUN_DECL, int32 pa)
+int32 ssc_rd (RUN_DECL, int32 pa, int32 lnt)
 {
     int32 rg = (pa - SSCBASE) >> 2;
 
@@ -1283,7 +1412,7 @@ void ssc_wr (RUN_DECL, int32 pa, int32 val, int32 lnt)
     {
         int32 sc = (pa & 3) << 3;                           /* merge */
         int32 mask = (lnt == L_WORD)? 0xFFFF: 0xFF;
-        int32 t = ssc_rd (RUN_PASS, pa);
+        int32 t = ssc_rd (RUN_PASS, pa, L_LONG);
         val = ((val & mask) << sc) | (t & ~(mask << sc));
     }
 
@@ -1498,8 +1627,7 @@ int32 tmr_tir_rd (RUN_DECL, int32 tmr, t_bool interp)
      * with virtual mapping enabled (mapen=1) and uses only TMR0.
      */
 
-    t_bool is_realtime = (mapen == 1);
-    if (is_realtime)
+    if (mapen == 1)
         return tmr_tir_rd_realtime(RUN_PASS, tmr);
 
     uint32 delta;
@@ -1564,10 +1692,8 @@ void tmr_csr_wr (RUN_DECL, int32 tmr, int32 val)
         ABORT_INVALID_SYSOP;
     }
 
-    /* do not elevate thread priority for ROM tests and Ethernet bootstrap */
-    t_bool is_realtime = (mapen == 1);
-
-    if (is_realtime)
+    /* ROM tests and Ethernet bootstrap use instruction-driven timers */
+    if (mapen == 1)
     {
         tmr_csr_wr_realtime (RUN_PASS, tmr, val);
         return;
@@ -1576,7 +1702,6 @@ void tmr_csr_wr (RUN_DECL, int32 tmr, int32 val)
     if ((val & TMR_CSR_RUN) == 0)                           /* clearing run? */
     {
         sim_cancel (sysd_unit[tmr]);                        /* cancel timer */
-        sysd_deactivating(tmr);                             /* note as inactive */
         if (tmr_csr[tmr] & TMR_CSR_RUN)                     /* run 1 -> 0? */
             tmr_tir[tmr] = tmr_tir_rd (RUN_PASS, tmr, TRUE);    /* update itr */
     }
@@ -1587,19 +1712,14 @@ void tmr_csr_wr (RUN_DECL, int32 tmr, int32 val)
         tmr_tir[tmr] = tmr_tnir[tmr];
     if (val & TMR_CSR_RUN)                                  /* run? */
     {
-        if (is_realtime)
-            tmr_adjust_thread_priority(RUN_PASS, TRUE);
         if (val & TMR_CSR_XFR)                              /* new tir? */
-        {
             sim_cancel (sysd_unit[tmr]);                    /* stop prev */
-            sysd_deactivating(tmr);                         /* note as inactive */
-        }
         if (!sim_is_active (sysd_unit[tmr]))                /* not running? */
-            tmr_sched (RUN_PASS, tmr, is_realtime);         /* activate */
+            tmr_sched (RUN_PASS, tmr);                      /* activate */
     }
     else if (val & TMR_CSR_SGL)                             /* single step? */
     {
-        tmr_incr (RUN_PASS, tmr, 1, is_realtime);           /* incr tmr */
+        tmr_incr (RUN_PASS, tmr, 1);                        /* incr tmr */
         if (tmr_tir[tmr] == 0)                              /* if ovflo, */
             tmr_tir[tmr] = tmr_tnir[tmr];                   /* reload tir */
     }
@@ -1611,9 +1731,6 @@ void tmr_csr_wr (RUN_DECL, int32 tmr, int32 val)
         else
             CLR_INT (TMR0);
     }
-
-    if (is_realtime)
-        tmr_adjust_thread_priority(RUN_PASS);
 }
 
 /* Unit service */
@@ -1623,46 +1740,13 @@ t_stat tmr_svc (RUN_SVC_DECL, UNIT *uptr)
     // RUN_SVC_CHECK_CANCELLED(uptr);    // not required for per-CPU devices
     int32 tmr = sim_unit_index (uptr);                      /* get timer # */
 
-    uint32 sv_sysd_active_mask = cpu_unit->sysd_active_mask;
-    t_bool is_realtime = 0 != (sv_sysd_active_mask & (1 << tmr));
-    sysd_deactivating(tmr);                                 /* note as inactive */
-
-    tmr_incr (RUN_PASS, tmr, tmr_inc[tmr], is_realtime);    /* incr timer */
-
-    if ((sv_sysd_active_mask == 0) != (cpu_unit->sysd_active_mask == 0))
-        tmr_adjust_thread_priority(RUN_PASS);
-
+    tmr_incr (RUN_PASS, tmr, tmr_inc[tmr]);                 /* incr timer */
     return SCPE_OK;
 }
 
-/*
- * SSC timers are used by the operating system to calibrate processor loops for various critical
- * time-waits, including spinlocks timeout and device access delays.
- *
- * If the thread is paused during loop calibration, loop will be under-calibrated to a smaller
- * number of cycles, resulting in shorter subsequent waits, and hence unstable system.
- *
- * To avoid this, boost current thread priority while the loop is beng calibrated, 
- * i.e. SSC clocks are active or about to be activated.
- */
-static void tmr_adjust_thread_priority(RUN_DECL, t_bool force_high)
-{
-    if (force_high || tmr_is_active(RUN_PASS))
-    {
-        /* raise thread priority */
-        RUN_SCOPE_RSCX_ONLY;
-        cpu_set_thread_priority(RUN_RSCX_PASS, SIMH_THREAD_PRIORITY_CPU_CALIBRATION);
-    }
-    else
-    {
-        /* lower thread priority */
-        cpu_reevaluate_thread_priority(RUN_PASS);
-    }
-}
-
 /* Timer increment */
 
-void tmr_incr (RUN_DECL, int32 tmr, uint32 inc, t_bool is_realtime)
+void tmr_incr (RUN_DECL, int32 tmr, uint32 inc)
 {
     uint32 new_tir = tmr_tir[tmr] + inc;                    /* add incr */
 
@@ -1681,7 +1765,7 @@ void tmr_incr (RUN_DECL, int32 tmr, uint32 inc, t_bool is_realtime)
         if (tmr_csr[tmr] & TMR_CSR_RUN)                     /* run? */
         {
             tmr_tir[tmr] = tmr_tnir[tmr];                   /* reload */
-            tmr_sched (RUN_PASS, tmr, is_realtime);             /* reactivate */
+            tmr_sched (RUN_PASS, tmr);                      /* reactivate */
         }
         if (tmr_csr[tmr] & TMR_CSR_IE)                      /* set int req */
         {
@@ -1695,13 +1779,13 @@ void tmr_incr (RUN_DECL, int32 tmr, uint32 inc, t_bool is_realtime)
     {
         tmr_tir[tmr] = new_tir;                             /* no, upd tir */
         if (tmr_csr[tmr] & TMR_CSR_RUN)                     /* still running? */
-            tmr_sched (RUN_PASS, tmr, is_realtime);             /* reactivate */
+            tmr_sched (RUN_PASS, tmr);                      /* reactivate */
     }
 }
 
 /* Timer scheduling */
 
-void tmr_sched (RUN_DECL, int32 tmr, t_bool is_realtime)
+void tmr_sched (RUN_DECL, int32 tmr)
 {
     int32 clk_time = sim_is_active (&clk_unit) - 1;
     int32 tmr_time;
@@ -1735,9 +1819,6 @@ void tmr_sched (RUN_DECL, int32 tmr, t_bool is_realtime)
     }
 
     sim_activate (sysd_unit[tmr], tmr_time);
-
-    if (is_realtime)
-        sysd_activating(tmr);                               /* note as active */
 }
 
 int32 tmr0_inta (void)
@@ -1752,6 +1833,51 @@ int32 tmr1_inta (void)
     return tmr_tivr[1];
 }
 
+/*
+ * OpenVMS uses TMR0 only to calibrate its busy-wait loops (EXE$INI_TIMWAIT): it starts the timer,
+ * runs a loop a known number of times and reads TIR to find out how long it took. TIR is derived
+ * from host monotonic time (vDSO clock backed by invariant TSC where available, see sim_os_nsec),
+ * so reads are microsecond-accurate without calibrating the timer itself.
+ *
+ * If VCPU thread is preempted while the loop is being timed, raw host time would include the period
+ * the VCPU did not execute, loops would be undercalibrated and subsequent time-waits too short.
+ * Rather than elevating thread priority during calibration, each interval between samples is checked
+ * against the number of instructions executed in it: if it took more than TMR_RT_SLACK times longer than
+ * the fastest rate seen on this VCPU accounts for, the VCPU was descheduled and the interval is charged
+ * at that rate instead. The fastest rate is kept across runs, so repeated calibrations converge on
+ * undisturbed execution speed regardless of host load. Until a rate has been measured, the one implied
+ * by system clock calibration (tmr_poll) is used.
+ */
+
+#define TMR_RT_SLACK        2               /* interval/expected ratio taken as preemption */
+#define TMR_RT_MIN_CYCLES   1000            /* shortest interval used to measure execution rate */
+
+static void tmr_rt_sample (RUN_DECL)
+{
+    t_uint64 now = sim_os_nsec ();
+    uint32 cycles = CPU_CURRENT_CYCLES;
+    uint32 dc = cycles - cpu_unit->cpu_ssc_rt_cycles;
+    t_uint64 dt = (now > cpu_unit->cpu_ssc_rt_ns) ? now - cpu_unit->cpu_ssc_rt_ns : 0;
+    double nspc = cpu_unit->cpu_ssc_rt_ns_per_cycle;
+
+    if (dc >= TMR_RT_MIN_CYCLES)
+    {
+        double rate = (double) dt / dc;
+        if (nspc == 0 || rate < nspc)
+            cpu_unit->cpu_ssc_rt_ns_per_cycle = rate;
+    }
+
+    if (nspc == 0 && weak_read_var(tmr_poll) > 0)
+        nspc = 1.0e9 / ((double) weak_read_var(tmr_poll) * clk_tps);
+
+    if (nspc != 0 && (double) dt > TMR_RT_SLACK * nspc * dc)
+        dt = (t_uint64) (nspc * dc);                        /* descheduled: discount */
+
+    cpu_unit->cpu_ssc_rt_elapsed += dt;
+    cpu_unit->cpu_ssc_rt_ns = now;
+    cpu_unit->cpu_ssc_rt_cycles = cycles;
+}
+
 static void tmr_csr_wr_realtime (RUN_DECL, int32 tmr, int32 val)
 {
     t_bool unexpected = FALSE;
@@ -1774,19 +1900,15 @@ static void tmr_csr_wr_realtime (RUN_DECL, int32 tmr, int32 val)
         
     if (val & TMR_CSR_RUN)
     {
-        tmr_adjust_thread_priority(RUN_PASS, TRUE);
         tmr_csr[tmr] |= TMR_CSR_RUN;
-        sysd_activating(tmr);
         tmr_tir_rtstart[tmr] = tmr_tir[tmr];
-        cpu_unit->cpu_ssc_delta_timer[tmr]->begin(RUN_PASS);
+        cpu_unit->cpu_ssc_rt_ns = sim_os_nsec ();
+        cpu_unit->cpu_ssc_rt_cycles = CPU_CURRENT_CYCLES;
+        cpu_unit->cpu_ssc_rt_elapsed = 0;
     }
     else
     {
-        uint32 sv_sysd_active_mask = cpu_unit->sysd_active_mask;
         tmr_csr[tmr] &= ~TMR_CSR_RUN;
-        sysd_deactivating(tmr);
-        if ((sv_sysd_active_mask == 0) != (cpu_unit->sysd_active_mask == 0))
-            cpu_reevaluate_thread_priority(RUN_PASS);
     }
 }
 
@@ -1802,9 +1924,8 @@ static int32 tmr_tir_rd_realtime (RUN_DECL, int32 tmr)
 
     if (tmr_csr[tmr] & TMR_CSR_RUN)
     {
-        sim_delta_timer* dt = cpu_unit->cpu_ssc_delta_timer[tmr];
-        dt->sample(RUN_PASS);
-        uint32 usec = dt->us_since_start(RUN_PASS);
+        tmr_rt_sample (RUN_PASS);
+        uint32 usec = (uint32) (cpu_unit->cpu_ssc_rt_elapsed / 1000);
         uint32 tir = (uint32) tmr_tir_rtstart[tmr] + usec;
         /* real measurments do not incur overflow */
         if (tir > (uint32) tmr_tir[tmr])
@@ -2104,8 +2225,12 @@ t_stat cpu_boot (int32 unitno, DEVICE *dptr)
 t_stat sysd_reset (DEVICE *dptr)
 {
     int32 i;
+    t_stat r;
     RUN_SCOPE;
 
+    if (! regmap_built && (r = reg_build_map ()) != SCPE_OK)
+        return r;
+
     if (sim_switches & SWMASK ('P'))
         sysd_powerup (RUN_PASS);       /* powerup? */
 
@@ -2114,7 +2239,6 @@ t_stat sysd_reset (DEVICE *dptr)
         tmr_csr[i] = tmr_tnir[i] = tmr_tir[i] = 0;
         tmr_inc[i] = tmr_sav[i] = 0;
         sim_cancel (sysd_unit[i]);
-        sysd_deactivating(i);
     }
 
     if (cpu_unit->is_primary_cpu())
@@ -36,6 +36,7 @@ char sim_name[] = "VAX MP";
 extern int32 sim_switches;
 extern void WriteB (RUN_DECL, uint32 pa, int32 val);
 extern void rom_wr_B (RUN_DECL, int32 pa, int32 val);
+extern void rom_sync_shadow (int32 rg, int32 n);
 
 /* when adding extra QBus device to sim_devices,
    be sure to also include it in the Qbus interrupt reset list
@@ -120,14 +121,19 @@ else {
             return SCPE_ARG;
         }
     }
+r = SCPE_OK;
 while ((i = getc (fileref)) != EOF) {                   /* read byte stream */
-    if (origin >= limit)                                /* NXM? */
-        return SCPE_NXM;
+    if (origin >= limit) {                              /* NXM? */
+        r = SCPE_NXM;
+        break;
+        }
     if (sim_switches & SWMASK ('R'))                    /* ROM? */
         rom_wr_B (RUN_PASS, origin, i);                           /* not writeable */
     else WriteB (RUN_PASS, origin, i);                            /* store byte */
     origin = origin + 1;
     }
-return SCPE_OK;
+if (sim_switches & SWMASK ('R'))                        /* ROM shadow, once per load */
+    rom_sync_shadow (0, ROMSIZE >> 2);
+return r;
 }
 
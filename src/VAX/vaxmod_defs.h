@@ -160,6 +160,8 @@
 #define ROMBASE         0x20040000                      /* ROM base */
 #define ADDR_IS_ROM(x)  ((((uint32) (x)) >= ROMBASE) && \
                         (((uint32) (x)) < (ROMBASE + ROMSIZE + ROMSIZE)))
+#define UNIT_V_NODELAY  (UNIT_V_UF + 0)                 /* ROM access equal to RAM access */
+#define UNIT_NODELAY    (1u << UNIT_V_NODELAY)
 #define ROM_PC_CONTINUE_MAPEN     (ROMBASE + 0x393)     /* MTPR MAPEN instruction for ROM CONTINUE command */
 #define ROM_PC_CONTINUE_REI       (ROMBASE + 0x394)     /* MTPR REI instruction for ROM CONTINUE command */
 #define ROM_PC_TEST31_TIR1_RD_A   (ROMBASE + 0xE9C5)    /* ROM Test 31 instructon to read TIR1 1st time */
@@ -285,6 +287,8 @@ typedef struct {
     int32               vloc;                           /* locator */
     atomic_int32        vec;                            /* value */
     int32               (*ack[VEC_DEVMAX])(void);       /* ack routine */
+    t_stat              (*rdl)(int32 *dat, int32 ad);   /* aligned longword read, optional */
+    t_stat              (*wrl)(int32 dat, int32 ad);    /* aligned longword write, optional */
     } DIB;
 
 /* I/O page layout - RQB,RQC,RQD float based on number of DZ's */
@@ -229,6 +229,10 @@
 #include <dlfcn.h>
 #endif
 
+#if defined(ETH_TEST_MAIN)
+#include "sim_ether.h"
+#endif
+
 #define EX_D            0                               /* deposit */
 #define EX_E            1                               /* examine */
 #define EX_I            2                               /* interactive */
@@ -418,7 +422,8 @@ t_stat cpu_cmd_smt (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cp
 /* Breakpoint package */
 
 t_stat sim_brk_init (void);
-t_stat sim_brk_set (t_addr loc, int32 sw, int32 ncnt, char *act);
+t_stat sim_brk_set (t_addr loc, int32 sw, int32 ncnt, char *act, uint32 cpus, uint32 modes);
+static void sim_brk_filter (void);
 t_stat sim_brk_clr (t_addr loc, int32 sw);
 t_stat sim_brk_clrall (int32 sw);
 t_stat sim_brk_show (SMP_FILE *st, t_addr loc, int32 sw);
@@ -459,7 +464,7 @@ t_stat attach_err (UNIT *uptr, t_stat stat);
 t_stat detach_all (int32 start_device, t_bool shutdown);
 t_stat assign_device (DEVICE *dptr, char *cptr);
 t_stat deassign_device (DEVICE *dptr);
-t_stat ssh_break_one (SMP_FILE *st, int32 flg, t_addr lo, int32 cnt, char *aptr);
+t_stat ssh_break_one (SMP_FILE *st, int32 flg, t_addr lo, int32 cnt, char *aptr, uint32 cpus, uint32 modes);
 t_stat run_boot_prep (void);
 t_stat exdep_reg_loop (SMP_FILE *ofile, SCHTAB *schptr, int32 flag, char *cptr,
     REG *lowr, REG *highr, uint32 lows, uint32 highs);
@@ -475,7 +480,7 @@ static void print_prompt (SMP_FILE* fp, const char* component = NULL);
 static void make_prompt (char* bp, const char* component = NULL);
 void fprint_stopped_instr_or_state (RUN_DECL, SMP_FILE *st, const char* msg, REG *pc, DEVICE *dptr);
 void fprint_stopped_instr (RUN_DECL, SMP_FILE *st, const char* msg, REG *pc, DEVICE *dptr);
-static t_stat run_cmd_core (RUN_DECL, int32 runcmd);
+static t_stat run_cmd_core (RUN_DECL, int32 runcmd, uint32 run_msec = 0);
 void int_handler (int signal);
 static clock_queue_entry* reverse_cqe_list(clock_queue_entry* list);
 static void setup_cotimed_cqe_list(clock_queue_entry* list, int32 nticks);
@@ -484,6 +489,10 @@ void sim_reevaluate_noncpu_thread_priority(run_scope_context* rscx);
 t_stat set_on (int32 flag, char *cptr);
 t_stat set_asynch (int32 flag, char *cptr);
 t_stat sim_set_asynch (int32 flag, char *cptr);
+t_stat sim_set_affinity (int32 flag, char *cptr);
+t_stat sim_show_affinity (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr);
+t_stat sim_set_prefault (int32 flag, char *cptr);
+t_stat sim_show_prefault (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr);
 t_stat sim_set_environment (int32 flag, char *cptr);
 t_bool sim_cpu_has_syswide_events(RUN_DECL);
 
@@ -499,6 +508,8 @@ DEVICE *sim_dfdev = NULL;
 UNIT *sim_dfunit = NULL;
 int32 sim_opt_out = 0;
 uint32 sim_brk_summ = 0;
+uint32 sim_brk_pgmask[SIM_BRK_PG_SLOTS];
+const char *sim_brk_mode_names = NULL;
 uint32 sim_brk_types = 0;
 uint32 sim_brk_dflt = 0;
 BRKTAB *sim_brk_tab = NULL;
@@ -521,6 +532,8 @@ static t_stat sim_last_cmd_stat;                           /* command status */
 static SCHTAB sim_stab;
 t_bool sim_vcpu_per_core = FALSE;                          /* VCPU affinity control: if set true, try to assign at most 
                                                               one VCPU per single host PCPU core */
+t_bool sim_vcpu_topology = FALSE;                          /* VCPU affinity control: if set true, pin each VCPU to its own
+                                                              host core and housekeeping threads to remaining cores */
 t_bool sim_vsmp_active = FALSE;                            /* virtual multiprocessing initialized (VSMP had called VAXMP_API_OP_INIT_SMP) */
 uint32 sim_vsmp_os = 0;                                    /* guest OS ID (valid only if sim_vsmp_active is TRUE) */
 t_bool sim_vsmp_idle_sleep = FALSE;                        /* TRUE if idle sleep is enabled (VSMP SET IDLE=ON), valid only if sim_vsmp_active is TRUE */
@@ -535,7 +548,7 @@ on_init_call* on_init_call::head = NULL;
 smp_lock* cpu_database_lock = NULL;
 smp_semaphore* cpu_attention = NULL;
 smp_barrier* cpu_pause_sync_barrier = NULL;
-smp_semaphore* cpu_clock_run_gate = NULL;
+smp_simple_semaphore* cpu_clock_run_gate = NULL;
 t_bool sim_clock_thread_created = FALSE;
 t_bool use_clock_thread = USE_CLOCK_THREAD;
 /*
@@ -584,6 +597,7 @@ t_bool sim_ws_settings_changed = FALSE;                    /* if TRUE, working s
 t_bool sim_ws_lock = FALSE;                                /* if TRUE, lock all pages in working set */
 uint32 sim_ws_min = 0;                                     /* minimum working set size (MB) */
 uint32 sim_ws_max = 0;                                     /* maximum working set size (MB) */
+uint32 sim_ws_prefault = SIM_PREFAULT_TOUCH;               /* how memory is faulted in before run (SIM_PREFAULT_xxx) */
 uint32 sim_host_turbo = 120;                               /* host CPU turbo factor (max cpu freq / min cpu freq) */
 t_bool sim_host_dedicated = FALSE;                         /* if TRUE, host is wholly dedicated to running the simulator,
                                                               therefore do not perform VCPU thread priority managemenet */
@@ -606,9 +620,7 @@ static const char *sim_snet = "no Ethernet";
 
 /* Tables and strings */
 
-const char save_vercur[] = "M3.5";
-const char save_ver32[] = "V3.2";
-const char save_ver30[] = "V3.0";
+const char save_vercur[] = "MP1.0";
 const struct scp_error
 {
     char *code;
@@ -716,7 +728,8 @@ static CTAB cmd_table[] = {
     { "BOOT", &run_cmd, RU_BOOT,
       "b{oot} <unit>              bootstrap unit\n" },
     { "BREAK", &brk_cmd, SSH_ST,
-      "br{eak} <list>             set breakpoints\n" },
+      "br{eak} <list>             set breakpoints\n"
+      "br{eak} <list> CPU=n MODE=m set breakpoints taken only by VCPU n in mode(s) m\n" },
     { "NOBREAK", &brk_cmd, SSH_CL,
       "nobr{eak} <list>           clear breakpoints\n" },
     { "ATTACH", &attach_cmd, 0,
@@ -766,6 +779,10 @@ static CTAB cmd_table[] = {
       "set nothrottle             set simulation rate to maximum\n"
       "set asynch                 enable asynchronous I/O\n"
       "set noasynch               disable asynchronous I/O\n"
+      "set affinity ALL|PERCORE|TOPOLOGY\n"
+      "                           set VCPU and IOP thread placement on host processors\n"
+      "set prefault NONE|TOUCH|POPULATE|ADVISE\n"
+      "                           set how memory is faulted in before run\n"
       "set environment name=val   set environment variable\n"
       "set <dev> OCT|DEC|HEX      set device display radix\n"
       "set <dev> ENABLED          enable device\n"
@@ -791,6 +808,7 @@ static CTAB cmd_table[] = {
       "sh{ow} ti{me}              show simulated time\n"
       "sh{ow} th{rottle}          show simulation rate\n" 
       "sh{ow} a{synch}            show asynchronouse I/O state\n" 
+      "sh{ow} af{finity}          show VCPU and IOP thread placement\n" 
       "sh{ow} ve{rsion}           show simulator version\n" 
       "sh{ow} <dev> RADIX         show device display radix\n"
       "sh{ow} <dev> DEBUG         show device debug flags\n"
@@ -812,7 +830,16 @@ static CTAB cmd_table[] = {
       "perf on [counter]          enable performance counter(s)\n" 
       "perf off [counter]         disable performance counter(s)\n" 
       "perf reset [counter]       reset performance counter(s)\n" 
-      "perf show [counter]        display performance counter(s)\n" },
+      "perf show [counter]        display performance counter(s)\n" 
+      "perf profile on [rate]     start guest PC sampling\n" 
+      "perf profile off           stop guest PC sampling\n" 
+      "perf profile reset         discard PC samples\n" 
+      "perf profile show [n] [id] display top n sampled PCs\n" 
+      "perf profile map [file]    symbolize PCs with VMS linker map\n"
+      "perf bench [k] [ms] [file] run CPU micro-benchmarks on 1..N VCPUs, report as JSON\n"
+      "perf bench -f ...          run benchmarks even if the machine holds a guest\n"
+      "perf stats file <f> [sec]  append VCPU statistics to CSV file every sec\n"
+      "perf stats off             stop writing VCPU statistics file\n" },
     { "DO", &do_cmd, 1,
       "do <file> {arg,arg...}     process command file\n" },
     { "ECHO", &echo_cmd, 0,
@@ -884,12 +911,13 @@ int main (int argc, char *argv[])
 
         smp_stdin = smp_file_wrap(stdin);
         smp_stdout = smp_file_wrap(stdout);
+        smp_stdout->deferred = TRUE;
         smp_stderr = smp_file_wrap(stderr);
 
         cpu_database_lock = smp_lock::create(smp_spinwait_min_us, 1000, 10000);
         cpu_database_lock->set_criticality(SIM_LOCK_CRITICALITY_VM);
         cpu_attention = smp_semaphore::create(0);
-        cpu_clock_run_gate = smp_semaphore::create(0);
+        cpu_clock_run_gate = smp_simple_semaphore::create(0);
         cpu_pause_sync_barrier = smp_barrier::create(2);
         cpu_cycles_per_second_lock = smp_lock::create(smp_spinwait_min_us, 1000, 3000);
         cpu_cycles_per_second_lock->set_criticality(SIM_LOCK_CRITICALITY_VM);
@@ -938,6 +966,7 @@ static int main_exec (int argc, char *argv[])
     t_stat stat;
     CTAB *cmdp;
     DEVICE *dptr;
+    int exit_status = 0;
 
     for (i = 0; (dptr = sim_devices[i]) != NULL; i++)
     {
@@ -1044,6 +1073,34 @@ static int main_exec (int argc, char *argv[])
     if (sim_dflt_dev == NULL)                               /* if no default */
         sim_dflt_dev = sim_devices[0];
 
+#if defined(VAX_BENCH_MAIN)
+    /*
+     * Benchmark executable: process startup file "name.ini" if present (e.g. to SET CPU MULTI),
+     * then run PERF BENCH with command line arguments and exit
+     */
+    if (*argv[0])
+    {
+        char nbuf[PATH_MAX + 7], *np;
+        nbuf[0] = '"';
+        strncpy (nbuf + 1, argv[0], PATH_MAX + 1);
+        if (np = match_ext (nbuf, "EXE"))
+            *np = 0;
+        strcat (nbuf, ".ini\"");
+        do_cmd (-1, nbuf);
+    }
+    {
+        char bbuf[CBUFSIZE + 8];
+        sprintf (bbuf, "BENCH %s", cbuf);
+        if ((stat = perf_cmd (0, bbuf)) >= SCPE_BASE)
+            smp_printf ("%s\n", sim_error_text (stat));
+        stat = SCPE_EXIT;                                   /* skip command loop */
+    }
+#elif defined(ETH_TEST_MAIN)
+    /* Ethernet test executable: run the CRC32 and multicast hash filter tests and exit with their status */
+    if (eth_test () != SCPE_OK)
+        exit_status = 1;
+    stat = SCPE_EXIT;                                       /* skip command loop */
+#else
     if (*cbuf)                                              /* cmd file arg? */
         stat = do_cmd (0, cbuf);                            /* proc cmd file */
     else if (*argv[0])                                      /* sim name arg? */
@@ -1056,6 +1113,7 @@ static int main_exec (int argc, char *argv[])
         strcat (nbuf, ".ini\"");                            /* add .ini" */
         stat = do_cmd (-1, nbuf);                           /* proc cmd file */
     }
+#endif
 
     while (stat != SCPE_EXIT)                               /* in case exit */
     {
@@ -1148,7 +1206,7 @@ static int main_exec (int argc, char *argv[])
     sim_set_logoff (0, NULL);                               /* close log */
     sim_set_notelnet (0, NULL);                             /* close Telnet */
     sim_ttclose ();                                         /* close console */
-    return 0;
+    return exit_status;
 }
 
 t_stat process_new_brk_actions (int flag)
@@ -1744,6 +1802,8 @@ static CTAB set_glob_tab[] = {
     { "NOTHROTTLE", &sim_set_throt, 0 },
     { "ASYNCH", &sim_set_asynch, 1 },
     { "NOASYNCH", &sim_set_asynch, 0 },
+    { "AFFINITY", &sim_set_affinity, 0 },
+    { "PREFAULT", &sim_set_prefault, 0 },
     { "ENV", &sim_set_environment, 1 },
     { NULL, NULL, 0 }
     };
@@ -1812,6 +1872,96 @@ t_stat sim_show_asynch (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char
     return SCPE_OK;
 }
 
+/* Set/show VCPU and housekeeping thread placement on host processors */
+
+t_stat sim_set_affinity (int32 flag, char *cptr)
+{
+    char gbuf[CBUFSIZE];
+
+    if ((!cptr) || (*cptr == 0))                            /* now eol? */
+        return SCPE_2FARG;
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (*cptr != 0)
+        return SCPE_2MARG;
+
+    if (strcmp (gbuf, "ALL") == 0)
+    {
+        sim_vcpu_per_core = FALSE;
+        sim_vcpu_topology = FALSE;
+    }
+    else if (strcmp (gbuf, "PERCORE") == 0)
+    {
+        sim_vcpu_per_core = TRUE;
+        sim_vcpu_topology = FALSE;
+    }
+    else if (strcmp (gbuf, "TOPOLOGY") == 0)
+    {
+        if (! smp_can_alloc_topology(sim_ncpus))
+            return SCPE_NOFNC;
+        sim_vcpu_per_core = FALSE;
+        sim_vcpu_topology = TRUE;
+    }
+    else
+    {
+        return SCPE_ARG;
+    }
+
+    return SCPE_OK;
+}
+
+t_stat sim_show_affinity (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr)
+{
+    if (cptr && (*cptr != 0))
+        return SCPE_2MARG;
+    fprintf (st, "VCPU affinity: %s\n", sim_vcpu_topology ? "TOPOLOGY (own host core per VCPU, IOP threads on remaining cores)" :
+                                       sim_vcpu_per_core ? "PERCORE (one processor per host core)" : "ALL (any host processor)");
+    smp_show_affinity (st, sim_vcpu_topology);
+    return SCPE_OK;
+}
+
+/* Set/show how memory is faulted in before run */
+
+static const char* sim_prefault_names[] = { "NONE", "TOUCH", "POPULATE", "ADVISE" };
+
+t_stat sim_set_prefault (int32 flag, char *cptr)
+{
+    char gbuf[CBUFSIZE];
+    uint32 mode;
+
+    if ((!cptr) || (*cptr == 0))                            /* now eol? */
+        return SCPE_2FARG;
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (*cptr != 0)
+        return SCPE_2MARG;
+
+    for (mode = 0;  mode < sizeof (sim_prefault_names) / sizeof (sim_prefault_names[0]);  mode++)
+    {
+        if (strcmp (gbuf, sim_prefault_names[mode]) == 0)
+        {
+            sim_ws_prefault = mode;
+            sim_ws_prefaulted = FALSE;                      /* apply on next run */
+            return SCPE_OK;
+        }
+    }
+
+    return SCPE_ARG;
+}
+
+t_stat sim_show_prefault (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr)
+{
+    static const char* descr[] = {
+        "pages are faulted in by VCPUs on first touch",
+        "pages are faulted in before run by parallel threads",
+        "pages are populated by host when memory is allocated",
+        "host is advised memory will be needed"
+        };
+
+    if (cptr && (*cptr != 0))
+        return SCPE_2MARG;
+    fprintf (st, "Memory prefault: %s (%s)\n", sim_prefault_names[sim_ws_prefault], descr[sim_ws_prefault]);
+    return SCPE_OK;
+}
+
 /* Set environment routine */
 
 t_stat sim_set_environment (int32 flag, char *cptr)
@@ -2099,6 +2249,8 @@ static SHTAB show_glob_tab[] = {
     { "DEBUG", &sim_show_debug, 0 },                    /* deprecated */
     { "THROTTLE", &sim_show_throt, 0 },
     { "ASYNCH", &sim_show_asynch, 0 },
+    { "AFFINITY", &sim_show_affinity, 0 },
+    { "PREFAULT", &sim_show_prefault, 0 },
     { NULL, NULL, 0 }
     };
 
@@ -2846,6 +2998,40 @@ t_stat brk_cmd (int32 flg, char *cptr)
     return ssh_break (NULL, cptr, flg);                     /* call common code */
 }
 
+/* Parse breakpoint qualifier CPU=n (may be repeated) or MODE=m, where m is
+   one or more mode letters from sim_brk_mode_names.  Returns FALSE if gbuf
+   is not a qualifier, SCPE_ARG in *r if it is an invalid one */
+
+static t_bool ssh_break_qual (char *gbuf, uint32 *cpus, uint32 *modes, t_stat *r)
+{
+    char *vptr;
+    const char *mp;
+    uint32 n;
+
+    *r = SCPE_OK;
+    if (strncmp (gbuf, "CPU=", 4) == 0)
+    {
+        n = (uint32) strtotv (gbuf + 4, &vptr, 10);
+        if (vptr == gbuf + 4 || *vptr != 0 || n >= SIM_MAX_CPUS)
+            *r = SCPE_ARG;
+        else *cpus |= 1u << n;
+        return TRUE;
+    }
+    if (strncmp (gbuf, "MODE=", 5) == 0 && sim_brk_mode_names)
+    {
+        if (gbuf[5] == 0)
+            *r = SCPE_ARG;
+        for (vptr = gbuf + 5; *vptr; vptr++)
+        {
+            if ((mp = strchr (sim_brk_mode_names, *vptr)) == NULL)
+                *r = SCPE_ARG;
+            else *modes |= 1u << (mp - sim_brk_mode_names);
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
 t_stat ssh_break (SMP_FILE *st, char *cptr, int32 flg)
 {
     if (sim_brk_types == 0) 
@@ -2860,7 +3046,8 @@ t_stat ssh_break (SMP_FILE *st, char *cptr, int32 flg)
     char gbuf[CBUFSIZE], *tptr, *t1ptr, *aptr;
     t_stat r;
     t_addr lo, hi, max = uptr->capac - 1;
-    int32 cnt;
+    int32 cnt, naddr;
+    uint32 cpus, modes;
 
     if (aptr = strchr (cptr, ';'))                          /* ;action? */
     {
@@ -2869,15 +3056,30 @@ t_stat ssh_break (SMP_FILE *st, char *cptr, int32 flg)
         *aptr++ = 0;                                        /* separate strings */
     }
 
-    if (*cptr == 0)                                         /* no argument? */
+    cpus = modes = 0;                                       /* collect qualifiers */
+    naddr = 0;
+    for (tptr = cptr; *tptr; )
+    {
+        tptr = get_glyph (tptr, gbuf, ',');
+        if (!ssh_break_qual (gbuf, &cpus, &modes, &r))
+            naddr++;
+        else if (r != SCPE_OK)
+            return r;
+    }
+    if ((cpus | modes) && flg != SSH_ST)
+        return SCPE_ARG;
+
+    if (naddr == 0)                                         /* no address? */
     {
         lo = (t_addr) get_rval (sim_PC, 0);                 /* use PC */
-        return ssh_break_one (st, flg, lo, 0, aptr);
+        return ssh_break_one (st, flg, lo, 0, aptr, cpus, modes);
     }
 
     while (*cptr)
     {
         cptr = get_glyph (cptr, gbuf, ',');
+        if (ssh_break_qual (gbuf, &cpus, &modes, &r))      /* skip qualifiers */
+            continue;
         tptr = get_range (dptr, gbuf, &lo, &hi, dptr->aradix, max, 0);
         if (tptr == NULL)
             return SCPE_ARG;
@@ -2906,7 +3108,7 @@ t_stat ssh_break (SMP_FILE *st, char *cptr, int32 flg)
         {
             for ( ; lo <= hi; lo = lo + 1)
             {
-                r = ssh_break_one (st, flg, lo, cnt, aptr);
+                r = ssh_break_one (st, flg, lo, cnt, aptr, cpus, modes);
                 if (r != SCPE_OK)
                     return r;
             }
@@ -2916,12 +3118,12 @@ t_stat ssh_break (SMP_FILE *st, char *cptr, int32 flg)
     return SCPE_OK;
 }
 
-t_stat ssh_break_one (SMP_FILE *st, int32 flg, t_addr lo, int32 cnt, char *aptr)
+t_stat ssh_break_one (SMP_FILE *st, int32 flg, t_addr lo, int32 cnt, char *aptr, uint32 cpus, uint32 modes)
 {
 switch (flg) {
 
     case SSH_ST:
-        return sim_brk_set (lo, sim_switches, cnt, aptr);
+        return sim_brk_set (lo, sim_switches, cnt, aptr, cpus, modes);
         break;
 
     case SSH_CL:
@@ -3427,16 +3629,24 @@ const char *sim_dname (DEVICE *dptr)
 /* Save command
 
    sa[ve] filename              save state to specified file
+
+   The save file holds, in order:
+
+        header          format, simulator name, build options, number of VCPUs,
+                        sizes of the raw per-VCPU structures
+        VCPUs           per VCPU: state, time, raw CPU_CONTEXT, pending interrupts,
+                        synchronization window position and countdowns
+        syncw           synchronization window parameters
+        devices         per device: flags, units, memory and registers as in SIMH;
+                        main memory is written once, as a compressed block image
+        clock queues    per VCPU: pending events as (device, unit, time, cosched)
+
+   Events for units that do not belong to any device (throttle, step) are not
+   saved, RUN reschedules them.
 */
 
 t_stat save_cmd (int32 flag, char *cptr)
 {
-#if 1
-    smp_printf ("Save/Restore functionality is not implemented yet in VAX MP simulator\n");
-    if (sim_log)
-        fprintf (sim_log, "Save/Restore functionality is not implemented yet in VAX MP simulator\n");
-    return SCPE_NOFNC;
-#else
     SMP_FILE *sfile;
     t_stat r;
     GET_SWITCHES (cptr);                                    /* get switches */
@@ -3448,14 +3658,75 @@ t_stat save_cmd (int32 flag, char *cptr)
     r = sim_save (sfile);
     fclose (sfile);
     return r;
-#endif
+}
+
+static void sim_save_cpu (SMP_FILE *sfile, CPU_UNIT *xcpu)
+{
+uint32 ipl, lvl;
+uint32 ix = xcpu->cpu_id;
+uint32 cycles = atomic_var(xcpu->cpu_adv_cycles);
+uint32 syncw_sys = weak_read_var(syncw_sys_active[ix]);
+
+#define WRITE_I(xx) sim_fwrite (&(xx), sizeof (xx), 1, sfile)
+
+WRITE_I (xcpu->cpu_state);
+WRITE_I (xcpu->sim_time);
+WRITE_I (xcpu->sim_rtime);
+WRITE_I (cycles);
+sim_fwrite (&xcpu->cpu_context, sizeof (xcpu->cpu_context), 1, sfile);
+for (ipl = 0; ipl < IPL_HLVL; ipl++) {                  /* pending interrupts */
+    lvl = xcpu->cpu_intreg.get_level (ipl);
+    WRITE_I (lvl);
+    }
+WRITE_I (xcpu->cpu_active_clk_interrupt);
+WRITE_I (xcpu->cpu_active_ipi_interrupt);
+WRITE_I (xcpu->clk_active);
+WRITE_I (xcpu->cpu_synclk_pending);
+WRITE_I (xcpu->cpu_synclk_protect_os);
+WRITE_I (xcpu->cpu_synclk_protect_dev);
+WRITE_I (xcpu->cpu_synclk_protect);
+WRITE_I (xcpu->syncw_active);
+WRITE_I (xcpu->syncw_countdown);
+WRITE_I (xcpu->syncw_countdown_start);
+WRITE_I (xcpu->syncw_countdown_sys);
+WRITE_I (xcpu->syncw_countdown_ilk);
+WRITE_I (syncw.cpu[ix].active);
+WRITE_I (syncw.cpu[ix].pos);
+WRITE_I (syncw_sys);
+WRITE_I (xcpu->cpu_con_rei);
+WRITE_I (xcpu->cpu_con_rei_on);
+}
+
+static void sim_save_clock_queue (SMP_FILE *sfile, CPU_UNIT *xcpu)
+{
+clock_queue_entry *cqe;
+UNIT *uptr;
+int32 accum = 0;
+int32 unitno;
+
+for (cqe = xcpu->clock_queue; cqe != NULL; cqe = cqe->next) {
+    if (cqe == xcpu->clock_queue)                       /* head counts down in sim_interval */
+        accum += imax (cpu_sim_interval (xcpu), 0);
+    else accum += cqe->time;
+    uptr = cqe->uptr;
+    if (uptr == &sim_throt_unit || uptr->device == NULL)
+        continue;                                       /* rescheduled by RUN */
+    if (!IS_PERCPU_UNIT (uptr) && uptr->clock_queue_cpu != xcpu)
+        continue;                                       /* cancelled by another VCPU */
+    unitno = sim_unit_index (uptr);
+    fputs (uptr->device->name, sfile);
+    fputc ('\n', sfile);
+    WRITE_I (unitno);
+    WRITE_I (accum);
+    WRITE_I (cqe->clk_cosched);
+    }
+fputc ('\n', sfile);                                    /* end queue */
 }
 
 t_stat sim_save (SMP_FILE *sfile)
 {
-// ToDo: reimplement for VAX MP, accounting for additional fields in UNIT, CPU_UNIT, 
-//       multiple CPUs, CPU database and other global variables
-RUN_SCOPE;
+RUN_SCOPE_RSCX;
+CPU_UNIT *sv_cpu_unit = cpu_unit;
 void *mbuf;
 int32 l, t;
 uint32 i, j;
@@ -3468,52 +3739,74 @@ DEVICE *dptr;
 UNIT *uptr;
 REG *rptr;
 
-#define WRITE_I(xx) sim_fwrite (&(xx), sizeof (xx), 1, sfile)
-
-fprintf (sfile, "%s\n%s\n%s\n%s\n%s\n%.0f\n",
-    save_vercur,                                        /* [V2.5] save format */
+fprintf (sfile, "%s\n%s\n%s\n%s\n%s\n%d\n%d %d\n",
+    save_vercur,                                        /* save format */
     sim_name,                                           /* sim name */
-    sim_si64, sim_sa64, sim_snet,                       /* [V3.5] options */
-    cpu_unit->sim_time);                                /* [V3.2] sim time (ToDo) */
-WRITE_I (cpu_unit->sim_rtime);                          /* [V2.6] sim rel time (ToDo) */
+    sim_si64, sim_sa64, sim_snet,                       /* options */
+    sim_ncpus,                                          /* VCPUs */
+    (int) sizeof (CPU_CONTEXT), IPL_HLVL);              /* raw layout */
+
+for (i = 0; i < sim_ncpus; i++) {                       /* VCPUs */
+    rscx->cpu_unit = cpu_unit = cpu_units[i];
+    UPDATE_CPU_SIM_TIME ();                             /* fold elapsed time in */
+    sim_save_cpu (sfile, cpu_unit);
+    }
+rscx->cpu_unit = cpu_unit = sv_cpu_unit;
+
+WRITE_I (syncw.on);                                     /* syncw parameters */
+WRITE_I (syncw.vsmp_winsize_sys);
+WRITE_I (syncw.vsmp_winsize_ilk);
+WRITE_I (syncw.winsize_sys);
+WRITE_I (syncw.winsize_ilk);
+WRITE_I (syncw.maxdrift);
+WRITE_I (syncw.ipl_syslock);
+WRITE_I (syncw.ipl_resched);
+WRITE_I (syncw.checkinterval_sys);
+WRITE_I (syncw.checkinterval_ilk);
+WRITE_I (syncw.checkinterval_none);
+WRITE_I (syncw.quant);
 
 for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {     /* loop thru devices */
     fputs (dptr->name, sfile);                          /* device name */
     fputc ('\n', sfile);
-    if (dptr->lname)                                    /* [V3.0] logical name */
+    if (dptr->lname)                                    /* logical name */
         fputs (dptr->lname, sfile);
     fputc ('\n', sfile);
-    WRITE_I (dptr->flags);                              /* [V2.10] flags */
+    WRITE_I (dptr->flags);                              /* flags */
     for (j = 0; j < dptr->numunits; j++) {
         uptr = dptr->units[j];
-        t = sim_is_active (uptr);                       /* ToDo: redo for SMP */
         WRITE_I (j);                                    /* unit number */
-        WRITE_I (t);                                    /* activation time */
         WRITE_I (uptr->u3);                             /* unit specific */
         WRITE_I (uptr->u4);
-        WRITE_I (uptr->u5);                             /* [V3.0] more unit */
+        WRITE_I (uptr->u5);
         WRITE_I (uptr->u6);
-        WRITE_I (uptr->flags);                          /* [V2.10] flags */
-        WRITE_I (uptr->capac);                          /* [V3.5] capacity */
+        WRITE_I (uptr->flags);                          /* flags */
+        WRITE_I (uptr->capac);                          /* capacity */
         if (uptr->flags & UNIT_ATT)
             fputs (uptr->filename, sfile);
         fputc ('\n', sfile);
-        if (((uptr->flags & (UNIT_FIX + UNIT_ATTABLE)) == UNIT_FIX) &&
+        if (uptr->flags & UNIT_ISCPU) {                 /* main memory, shared by VCPUs */
+            high = (j == 0) ? uptr->capac : 0;
+            WRITE_I (high);
+            if (high && (r = sim_memimg_save (sfile, (const t_byte *) M, high)) != SCPE_OK)
+                return r;
+            }
+        else if (((uptr->flags & (UNIT_FIX + UNIT_ATTABLE)) == UNIT_FIX) &&
              (dptr->examine != NULL) &&
              ((high = uptr->capac) != 0)) {             /* memory-like unit? */
-            WRITE_I (high);                             /* [V2.5] write size */
+            WRITE_I (high);                             /* write size */
             sz = SZ_D (dptr);
-            if ((mbuf = calloc (SRBSIZ, sz)) == NULL) {
-                fclose (sfile);
+            if ((mbuf = calloc (SRBSIZ, sz)) == NULL)
                 return SCPE_MEM;
-                }
             for (k = 0; k < high; ) {                   /* loop thru mem */
                 zeroflg = TRUE;
                 for (l = 0; (l < SRBSIZ) && (k < high); l++,
                      k = k + (dptr->aincr)) {           /* check for 0 block */
                     r = dptr->examine (&val, k, uptr, SIM_SW_REST);
-                    if (r != SCPE_OK)
+                    if (r != SCPE_OK) {
+                        free (mbuf);
                         return r;
+                        }
                     if (val) zeroflg = FALSE;
                     SZ_STORE (sz, val, mbuf, l);
                     }                                   /* end for l */
@@ -3539,7 +3832,7 @@ for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {     /* loop thru devices */
          (rptr->name != NULL); rptr++) {
         fputs (rptr->name, sfile);                      /* name */
         fputc ('\n', sfile);
-        WRITE_I (rptr->depth);                          /* [V2.10] depth */
+        WRITE_I (rptr->depth);                          /* depth */
         for (j = 0; j < rptr->depth; j++) {             /* loop thru values */
             val = get_rval (rptr, j);                   /* get value */
             WRITE_I (val);                              /* store */
@@ -3548,6 +3841,10 @@ for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {     /* loop thru devices */
     fputc ('\n', sfile);                                /* end registers */
     }
 fputc ('\n', sfile);                                    /* end devices */
+
+for (i = 0; i < sim_ncpus; i++)                         /* clock queues */
+    sim_save_clock_queue (sfile, cpu_units[i]);
+
 return (ferror (sfile))? SCPE_IOERR: SCPE_OK;           /* error during save? */
 }
 
@@ -3558,12 +3855,6 @@ return (ferror (sfile))? SCPE_IOERR: SCPE_OK;           /* error during save? */
 
 t_stat restore_cmd (int32 flag, char *cptr)
 {
-#if 1
-    smp_printf ("Save/Restore functionality is not implemented yet in VAX MP simulator\n");
-    if (sim_log)
-        fprintf (sim_log, "Save/Restore functionality is not implemented yet in VAX MP simulator\n");
-    return SCPE_NOFNC;
-#else
     SMP_FILE *rfile;
     t_stat r;
 
@@ -3576,39 +3867,117 @@ t_stat restore_cmd (int32 flag, char *cptr)
     r = sim_rest (rfile);
     fclose (rfile);
     return r;
-#endif
+}
+
+/* Empty the clock queue of the VCPU in context, releasing system-wide units it holds */
+
+static void sim_flush_clock_queue (RUN_DECL)
+{
+clock_queue_entry *cqe;
+
+while ((cqe = cpu_unit->clock_queue) != NULL) {
+    cpu_unit->clock_queue = cqe->next;
+    if (!IS_PERCPU_UNIT (cqe->uptr) && cqe->uptr->clock_queue_cpu == cpu_unit)
+        cqe->uptr->clock_queue_cpu = NULL;
+    cqe->next = cpu_unit->clock_queue_freelist;
+    cpu_unit->clock_queue_freelist = cqe;
+    }
+sim_interval = cpu_unit->noqueue_time = NOQUEUE_WAIT;
+}
+
+#define READ_S(xx) if (read_line ((xx), CBUFSIZE, rfile) == NULL) \
+    return SCPE_IOERR;
+#define READ_I(xx) if (sim_fread (&xx, sizeof (xx), 1, rfile) == 0) \
+    return SCPE_IOERR;
+
+static t_stat sim_rest_cpu (SMP_FILE *rfile, CPU_UNIT *cpu_unit)
+{
+uint32 ipl, lvl;
+uint32 ix = cpu_unit->cpu_id;
+uint32 cycles, syncw_sys;
+
+READ_I (cpu_unit->cpu_state);
+READ_I (cpu_unit->sim_time);
+READ_I (cpu_unit->sim_rtime);
+READ_I (cycles);
+atomic_var(cpu_unit->cpu_adv_cycles) = cycles;
+if (sim_fread (&cpu_unit->cpu_context, sizeof (cpu_unit->cpu_context), 1, rfile) == 0)
+    return SCPE_IOERR;
+FLUSH_ISTR;                                             /* prefetch pointed into old memory */
+for (ipl = 0; ipl < IPL_HLVL; ipl++) {                  /* pending interrupts */
+    READ_I (lvl);
+    cpu_unit->cpu_intreg.set_level (ipl, lvl);
+    }
+READ_I (cpu_unit->cpu_active_clk_interrupt);
+READ_I (cpu_unit->cpu_active_ipi_interrupt);
+READ_I (cpu_unit->clk_active);
+READ_I (cpu_unit->cpu_synclk_pending);
+READ_I (cpu_unit->cpu_synclk_protect_os);
+READ_I (cpu_unit->cpu_synclk_protect_dev);
+READ_I (cpu_unit->cpu_synclk_protect);
+READ_I (cpu_unit->syncw_active);
+READ_I (cpu_unit->syncw_countdown);
+READ_I (cpu_unit->syncw_countdown_start);
+READ_I (cpu_unit->syncw_countdown_sys);
+READ_I (cpu_unit->syncw_countdown_ilk);
+READ_I (syncw.cpu[ix].active);
+READ_I (syncw.cpu[ix].pos);
+READ_I (syncw_sys);
+smp_var(syncw_sys_active[ix]) = syncw_sys;
+READ_I (cpu_unit->cpu_con_rei);
+READ_I (cpu_unit->cpu_con_rei_on);
+
+if (cpu_unit->cpu_state == CPU_STATE_RUNNING)
+    cpu_running_set.set (ix);
+else cpu_running_set.clear (ix);
+return SCPE_OK;
+}
+
+static t_stat sim_rest_clock_queue (SMP_FILE *rfile, CPU_UNIT *cpu_unit)
+{
+char buf[CBUFSIZE];
+int32 unitno, time, cosched;
+DEVICE *dptr;
+UNIT *uptr;
+
+sim_flush_clock_queue (RUN_PASS);
+for ( ;; ) {
+    READ_S (buf);                                       /* device name */
+    if (buf[0] == 0)                                    /* end queue? */
+        break;
+    READ_I (unitno);
+    READ_I (time);
+    READ_I (cosched);
+    if ((dptr = find_dev (buf)) == NULL || unitno < 0 || (uint32) unitno >= dptr->numunits) {
+        smp_printf ("Invalid event unit: %s%d\n", buf, unitno);
+        return SCPE_INCOMP;
+        }
+    uptr = dptr->units[unitno];
+    if (cosched)
+        sim_activate_clk_cosched (uptr, cosched);
+    else sim_activate (uptr, imax (time, 0));
+    }
+return SCPE_OK;
 }
 
 t_stat sim_rest (SMP_FILE *rfile)
 {
-// ToDo: reimplement for VAX MP, accounting for additional fields in UNIT, CPU_UNIT, 
-//       multiple CPUs, CPU database and other global variables
-RUN_SCOPE;
+RUN_SCOPE_RSCX;
+CPU_UNIT *sv_cpu_unit = cpu_unit;
 char buf[CBUFSIZE];
 void *mbuf;
-int32 j, blkcnt, limit, unitno, time, flg;
-uint32 us, depth;
+int32 j, blkcnt, limit, unitno, flg, ctxsize, nlvl;
+uint32 i, us, depth, ncpus;
 t_addr k, high, old_capac;
 t_value val, mask;
 t_stat r;
 size_t sz;
-t_bool v35, v32;
 DEVICE *dptr;
 UNIT *uptr;
 REG *rptr;
 
-#define READ_S(xx) if (read_line ((xx), CBUFSIZE, rfile) == NULL) \
-    return SCPE_IOERR;
-#define READ_I(xx) if (sim_fread (&xx, sizeof (xx), 1, rfile) == 0) \
-    return SCPE_IOERR;
-
-READ_S (buf);                                           /* [V2.5+] read version */
-v35 = v32 = FALSE;
-if (strcmp (buf, save_vercur) == 0)                     /* version 3.5? */
-    v35 = v32 = TRUE;  
-else if (strcmp (buf, save_ver32) == 0)                 /* version 3.2? */
-    v32 = TRUE;
-else if (strcmp (buf, save_ver30) != 0) {               /* version 3.0? */
+READ_S (buf);                                           /* read version */
+if (strcmp (buf, save_vercur) != 0) {
     smp_printf ("Invalid file version: %s\n", buf);
     return SCPE_INCOMP;
     }
@@ -3617,25 +3986,56 @@ if (strcmp (buf, sim_name)) {                           /* name match? */
     smp_printf ("Wrong system type: %s, not %s\n", buf, sim_name);
     return SCPE_INCOMP;
     }
-if (v35) {                                              /* [V3.5+] options */
-    READ_S (buf);                                       /* integer size */
-    if (strcmp (buf, sim_si64) != 0) {
-        smp_printf ("Incompatible integer size, save file = %s\n", buf);
-        return SCPE_INCOMP;
-        }
-    READ_S (buf);                                       /* address size */
-    if (strcmp (buf, sim_sa64) != 0) {
-        smp_printf ("Incompatible address size, save file = %s\n", buf);
-        return SCPE_INCOMP;
-        }
-    READ_S (buf);                                       /* Ethernet */
+READ_S (buf);                                           /* integer size */
+if (strcmp (buf, sim_si64) != 0) {
+    smp_printf ("Incompatible integer size, save file = %s\n", buf);
+    return SCPE_INCOMP;
+    }
+READ_S (buf);                                           /* address size */
+if (strcmp (buf, sim_sa64) != 0) {
+    smp_printf ("Incompatible address size, save file = %s\n", buf);
+    return SCPE_INCOMP;
     }
-if (v32) {                                              /* [V3.2+] time as string */
-    READ_S (buf);
-    sscanf (buf, "%lf", &cpu_unit->sim_time);
+READ_S (buf);                                           /* Ethernet */
+READ_S (buf);                                           /* VCPUs */
+if (sscanf (buf, "%u", &ncpus) != 1 || ncpus == 0 || ncpus > SIM_MAX_CPUS)
+    return SCPE_INCOMP;
+READ_S (buf);                                           /* raw layout */
+if (sscanf (buf, "%d %d", &ctxsize, &nlvl) != 2 ||
+    ctxsize != (int32) sizeof (CPU_CONTEXT) || nlvl != IPL_HLVL) {
+    smp_printf ("Save file was written by a different build of %s\n", sim_name);
+    return SCPE_INCOMP;
+    }
+if (ncpus < sim_ncpus) {
+    smp_printf ("Save file has %d processors, %d are configured\n", ncpus, sim_ncpus);
+    return SCPE_INCOMP;
     }
-else READ_I (cpu_unit->sim_time);                       /* sim time (ToDo)*/
-READ_I (cpu_unit->sim_rtime);                           /* [V2.6+] sim rel time (ToDo) */
+if (ncpus > sim_ncpus && !cpu_create_cpus (ncpus))
+    return SCPE_AFAIL;
+
+for (i = 0; i < sim_ncpus; i++) {                       /* VCPUs */
+    rscx->cpu_unit = cpu_unit = cpu_units[i];
+    sim_flush_clock_queue (RUN_PASS);
+    if ((r = sim_rest_cpu (rfile, cpu_unit)) != SCPE_OK) {
+        rscx->cpu_unit = cpu_unit = sv_cpu_unit;
+        return r;
+        }
+    }
+rscx->cpu_unit = cpu_unit = sv_cpu_unit;
+sim_mp_active_update ();
+
+READ_I (syncw.on);                                      /* syncw parameters */
+READ_I (syncw.vsmp_winsize_sys);
+READ_I (syncw.vsmp_winsize_ilk);
+READ_I (syncw.winsize_sys);
+READ_I (syncw.winsize_ilk);
+READ_I (syncw.maxdrift);
+READ_I (syncw.ipl_syslock);
+READ_I (syncw.ipl_resched);
+READ_I (syncw.checkinterval_sys);
+READ_I (syncw.checkinterval_ilk);
+READ_I (syncw.checkinterval_none);
+READ_I (syncw.quant);
 
 for ( ;; ) {                                            /* device loop */
     READ_S (buf);                                       /* read device name */
@@ -3645,15 +4045,12 @@ for ( ;; ) {                                            /* device loop */
         smp_printf ("Invalid device name: %s\n", buf);
         return SCPE_INCOMP;
         }
-    READ_S (buf);                                       /* [V3.0+] logical name */
+    READ_S (buf);                                       /* logical name */
     deassign_device (dptr);                             /* delete old name */
     if ((buf[0] != 0) && 
         ((r = assign_device (dptr, buf)) != SCPE_OK))
         return r;
-    READ_I (flg);                                       /* [V2.10+] ctlr flags */
-    if (!v32)
-        flg = ((flg & DEV_UFMASK_31) << (DEV_V_UF - DEV_V_UF_31)) |
-            (flg & ~DEV_UFMASK_31);                     /* [V3.2+] flags moved */
+    READ_I (flg);                                       /* ctlr flags */
     dptr->flags = (dptr->flags & ~DEV_RFLAGS) |         /* restore ctlr flags */
          (flg & DEV_RFLAGS);
     for ( ;; ) {                                        /* unit loop */
@@ -3665,23 +4062,14 @@ for ( ;; ) {                                            /* device loop */
             smp_printf ("Invalid unit number: %s%d\n", sim_dname (dptr), unitno);
             return SCPE_INCOMP;
             }
-        READ_I (time);                                  /* event time */
         uptr = dptr->units[unitno];
-        sim_cancel (uptr);
-        if (time > 0)
-            sim_activate (uptr, time - 1);
         READ_I (uptr->u3);                              /* device specific */
         READ_I (uptr->u4);
-        READ_I (uptr->u5);                              /* [V3.0+] more dev spec */
+        READ_I (uptr->u5);
         READ_I (uptr->u6);
-        READ_I (flg);                                   /* [V2.10+] unit flags */
+        READ_I (flg);                                   /* unit flags */
         old_capac = uptr->capac;                        /* save current capacity */
-        if (v35) {                                      /* [V3.5+] capacity */
-            READ_I (uptr->capac);
-            }
-        if (!v32)
-            flg = ((flg & UNIT_UFMASK_31) << (UNIT_V_UF - UNIT_V_UF_31)) |
-                (flg & ~UNIT_UFMASK_31);                /* [V3.2+] flags moved */
+        READ_I (uptr->capac);
         uptr->flags = (uptr->flags & ~UNIT_RFLAGS) |
             (flg & UNIT_RFLAGS);                        /* restore */
         READ_S (buf);                                   /* attached file */
@@ -3696,14 +4084,14 @@ for ( ;; ) {                                            /* device loop */
             ((uptr->flags & UNIT_ATTABLE) ||            /*  and unit is attachable */
              (dptr->attach != NULL))) {                 /*    or VM attach routine provided? */
             uptr->flags = uptr->flags & ~UNIT_DIS;      /* ensure device is enabled */
-            if (flg & UNIT_RO)                          /* [V2.10+] saved flgs & RO? */
+            if (flg & UNIT_RO)                          /* saved flgs & RO? */
                 sim_switches |= SWMASK ('R');           /* RO attach */
             r = scp_attach_unit (dptr, uptr, buf);      /* reattach unit */
             if (r != SCPE_OK)
                 return r;
             }
         READ_I (high);                                  /* memory capacity */
-        if (high > 0) {                                 /* [V2.5+] any memory? */
+        if (high > 0) {                                 /* any memory? */
             if (((uptr->flags & (UNIT_FIX + UNIT_ATTABLE)) != UNIT_FIX) ||
                  (dptr->deposit == NULL)) {
                 smp_printf ("Can't restore memory: %s%d\n", sim_dname (dptr), unitno);
@@ -3723,23 +4111,33 @@ for ( ;; ) {                                            /* device loop */
                 fprint_capac (smp_stdout, dptr, uptr);
                 smp_printf ("\n");
                 }
+            if (uptr->flags & UNIT_ISCPU) {             /* main memory image */
+                if ((r = sim_memimg_restore (rfile, (t_byte *) M, high)) != SCPE_OK)
+                    return r;
+                continue;
+                }
             sz = SZ_D (dptr);                           /* allocate buffer */
             if ((mbuf = calloc (SRBSIZ, sz)) == NULL)
                 return SCPE_MEM;
             for (k = 0; k < high; ) {                   /* loop thru mem */
-                READ_I (blkcnt);                        /* block count */
-                if (blkcnt < 0)                         /* compressed? */
+                if (sim_fread (&blkcnt, sizeof (blkcnt), 1, rfile) == 0)
+                    limit = 0;                          /* block count */
+                else if (blkcnt < 0)                    /* compressed? */
                     limit = -blkcnt;
                 else limit = (int32) sim_fread (mbuf, sz, blkcnt, rfile);
-                if (limit <= 0)                         /* invalid or err? */
+                if (limit <= 0) {                       /* invalid or err? */
+                    free (mbuf);
                     return SCPE_IOERR;
+                    }
                 for (j = 0; j < limit; j++, k = k + (dptr->aincr)) {
                     if (blkcnt < 0)                     /* compressed? */
                         val = 0;
                     else SZ_LOAD (sz, val, mbuf, j);    /* saved value */
                     r = dptr->deposit (val, k, uptr, SIM_SW_REST);
-                    if (r != SCPE_OK)
+                    if (r != SCPE_OK) {
+                        free (mbuf);
                         return r;
+                        }
                     }                                   /* end for j */
                 }                                       /* end for k */
             free (mbuf);                                /* dealloc buffer */
@@ -3749,7 +4147,7 @@ for ( ;; ) {                                            /* device loop */
         READ_S (buf);                                   /* read reg name */
         if (buf[0] == 0)                                /* last? */
             break;
-        READ_I (depth);                                 /* [V2.10+] depth */
+        READ_I (depth);                                 /* depth */
         if ((rptr = find_reg (buf, NULL, dptr)) == NULL) {
             smp_printf ("Invalid register name: %s %s\n", sim_dname (dptr), buf);
             for (us = 0; us < depth; us++) {            /* skip values */
@@ -3757,7 +4155,7 @@ for ( ;; ) {                                            /* device loop */
                 }
             continue;
             }
-        if (depth != rptr->depth)                       /* [V2.10+] mismatch? */
+        if (depth != rptr->depth)                       /* mismatch? */
             smp_printf ("Register depth mismatch: %s %s, file = %d, sim = %d\n",
                 sim_dname (dptr), buf, depth, rptr->depth);
         mask = width_mask[rptr->width];                 /* get mask */
@@ -3770,7 +4168,15 @@ for ( ;; ) {                                            /* device loop */
             }
         }
     }                                                   /* end device loop */
-return SCPE_OK;
+
+r = SCPE_OK;
+for (i = 0; i < sim_ncpus; i++) {                       /* clock queues, replacing */
+    rscx->cpu_unit = cpu_unit = cpu_units[i];           /* events posted by attach */
+    if ((r = sim_rest_clock_queue (rfile, cpu_unit)) != SCPE_OK)
+        break;
+    }
+rscx->cpu_unit = cpu_unit = sv_cpu_unit;
+return r;
 }
 
 /* Run, go, cont, step commands
@@ -3947,13 +4353,19 @@ t_stat run_cmd (int32 flag, char *cptr)
         }
     }
 
-    if ((r = run_cmd_core (RUN_PASS, flag)) != SCPE_OK)
+    smp_fileout_start ();                                   /* defer console and log output */
+    r = run_cmd_core (RUN_PASS, flag);
+    smp_fileout_stop ();                                    /* write out pending output */
+    if (r != SCPE_OK)
         return r;
 
     if (sim_log)                                            /* flush console log */
         fflush (sim_log);
     if (sim_deb)                                            /* flush debug log */
+    {
+        sim_dbgring_flush ();
         fflush (sim_deb);
+    }
     for (i = 1; (dptr = sim_devices[i]) != NULL; i++)       /* flush attached files */
     {
         for (j = 0; j < dptr->numunits; j++)                /* if not buffered in mem */
@@ -4004,7 +4416,26 @@ t_stat run_boot_prep (void)
     return reset_all (0);
 }
 
-static t_stat run_cmd_core (RUN_DECL, int32 runcmd)
+/* Run current CPU for at most run_msec milliseconds of host time.
+   Unlike RUN/GO, performs no command-level checks and prints no stop message:
+   used by built-in measurement commands (PERF BENCH) that prepare CPU state themselves
+   and examine it after the run. */
+
+t_stat run_timed (uint32 run_msec)
+{
+    RUN_SCOPE;
+    t_stat r;
+
+    sim_step = 0;
+    if ((r = run_cmd_core (RUN_PASS, RU_GO, run_msec)) != SCPE_OK)
+        return r;
+    sim_async_process_io_events_for_console();
+    if (sim_log)                                            /* flush console log */
+        fflush (sim_log);
+    return SCPE_OK;
+}
+
+static t_stat run_cmd_core (RUN_DECL, int32 runcmd, uint32 run_msec)
 {
     run_scope_context* rscx = run_scope_context::get_current();
     CPU_UNIT* current_cpu_unit = cpu_unit;
@@ -4070,7 +4501,22 @@ static t_stat run_cmd_core (RUN_DECL, int32 runcmd)
     *  set up VCPUs affinity                                    *
     ************************************************************/
 
-    if (sim_vcpu_per_core)
+    if (sim_vcpu_topology)
+    {
+        if (smp_can_alloc_topology(sim_ncpus))
+        {
+            sim_vcpu_affinity = SMP_AFFINITY_TOPOLOGY;
+        }
+        else
+        {
+            sim_vcpu_affinity = SMP_AFFINITY_ALL;
+            sim_vcpu_topology = FALSE;
+            smp_printf("Warning!!! %s is unable to place VCPUs on distinct PCPU cores by host topology.\n", sim_name);
+            if (sim_log)
+                fprintf(sim_log, "Warning!!! %s is unable to place VCPUs on distinct PCPU cores by host topology.\n", sim_name);
+        }
+    }
+    else if (sim_vcpu_per_core)
     {
         if (smp_can_alloc_per_core(sim_ncpus))
         {
@@ -4090,6 +4536,18 @@ static t_stat run_cmd_core (RUN_DECL, int32 runcmd)
         sim_vcpu_affinity = SMP_AFFINITY_ALL;
     }
 
+    smp_set_housekeeping_affinity(sim_vcpu_affinity);
+
+    /************************************************************
+    *  fault in memory ahead of execution, near its VCPUs       *
+    ************************************************************/
+
+    if (! sim_ws_prefaulted && sim_ws_prefault != SIM_PREFAULT_NONE)
+    {
+        sim_prefault_memory();
+        sim_ws_prefaulted = TRUE;
+    }
+
     /************************************************************
     *  prepare to launch CPUs                                   *
     ************************************************************/
@@ -4141,23 +4599,39 @@ static t_stat run_cmd_core (RUN_DECL, int32 runcmd)
     ************************************************************/
 
     smp_pollable_synch_object* objs[2];
+    int nobjs = 2;
     objs[0] = cpu_attention;
     objs[1] = smp_pollable_console_keyboard::get();
 
+    uint32 run_start = sim_os_msec ();
+
     while (! weak_read(stop_cpus))
     {
-        int wres = smp_wait_any(objs, 2, -1);
+        int wait_ms = -1;
+
+        if (run_msec)                                       /* time-limited run? */
+        {
+            uint32 elapsed = sim_os_msec () - run_start;
+            if (elapsed >= run_msec)
+                break;
+            wait_ms = (int) (run_msec - elapsed);
+        }
+
+        int wres = smp_wait_any(objs, nobjs, wait_ms);
 
         if (wres == 1)           /* cpu_attention */
             break;
 
         if (wres == 2)           /* console keyboard */
         {
-            for (;;)
+            for (t_bool got = FALSE;;  got = TRUE)
             {
                 r = sim_os_poll_kbd ();
                 if (r == SCPE_OK)                      /* no keyboard input */
                 {
+                    /* input file or pipe signalled but yielded nothing: it is at EOF, stop polling it */
+                    if (! got && ! sim_ttisatty ())
+                        nobjs = 1;
                     break;
                 }
                 else if (r == SCPE_STOP)               /* Ctrl/E */
@@ -4270,10 +4744,11 @@ SMP_THREAD_ROUTINE_DECL sim_cpu_work_thread_proc (void* arg)
 
             smp_rmb();                                      /* redundant after sync primitive, but let it be */
 
-            if (affinity != sim_vcpu_affinity)
+            /* topology placement is re-applied on every start since the plan may have changed */
+            if (affinity != sim_vcpu_affinity || affinity == SMP_AFFINITY_TOPOLOGY)
             {
                 affinity = sim_vcpu_affinity;
-                smp_set_affinity(cpu_unit->cpu_thread, affinity);
+                smp_set_affinity(cpu_unit->cpu_thread, affinity, cpu_unit->cpu_id);
             }
 
             /*
@@ -4352,6 +4827,7 @@ SMP_THREAD_ROUTINE_DECL sim_cpu_work_thread_proc (void* arg)
                     sim_mp_active_update();
                     syncw_leave_all(RUN_PASS, SYNCW_OVERRIDE_ALL | SYNCW_DISABLE_CPU);
                     cpu_stopping_ips_rate_update(RUN_PASS);
+                    sim_throt_cancel ();
 
                     /* update sim time */
                     UPDATE_CPU_SIM_TIME();
@@ -7107,6 +7583,15 @@ void sim_bind_devunits_lock(DEVICE* dptr, smp_lock* lock)
    is the bitwise OR of all the type fields).  A simulator need only check for
    a breakpoint of type X if bit SWMASK('X') is set in sim_brk_sum.
 
+   sim_brk_pgmask holds the same summary per page of SIM_BRK_PG_SHIFT address bits,
+   hashed into SIM_BRK_PG_SLOTS slots.  sim_brk_check consults it inline and goes
+   to the table only if a breakpoint of the requested type may be set in the page,
+   so that armed breakpoints cost next to nothing for code and data elsewhere.
+
+   A breakpoint can be restricted to particular VCPUs (cpus) and processor
+   modes (modes); the simulator passes the current mode to sim_brk_test, with mode
+   letters for the BREAK command given by sim_brk_mode_names.
+
    The package contains the following public routines:
 
         sim_brk_init            initialize
@@ -7116,6 +7601,7 @@ void sim_bind_devunits_lock(DEVICE* dptr, smp_lock* lock)
         sim_brk_show            show breakpoint
         sim_brk_showall         show all breakpoints
         sim_brk_test            test for breakpoint
+        sim_brk_check           test for breakpoint, consulting the page filter first
         sim_brk_npc             PC has been changed
         sim_brk_clract          clear pending actions in CPUs
 
@@ -7130,11 +7616,29 @@ t_stat sim_brk_init (void)
     if (sim_brk_tab == NULL)
         return SCPE_MEM;
     sim_brk_ent = sim_brk_ins = 0;
+    sim_brk_filter ();
     // sim_brk_act = NULL;
     sim_brk_npc (RUN_PASS, 0);
     return SCPE_OK;
 }
 
+/* Recalculate type summary and page filter */
+
+static void sim_brk_filter (void)
+{
+    BRKTAB *bp;
+    uint32 summ = 0;
+
+    memset (sim_brk_pgmask, 0, sizeof (sim_brk_pgmask));
+    for (bp = sim_brk_tab; bp < (sim_brk_tab + sim_brk_ent); bp++)
+    {
+        sim_brk_pgmask[SIM_BRK_PG_HASH (bp->addr)] |= bp->typ;
+        summ = summ | bp->typ;
+    }
+    smp_wmb ();
+    sim_brk_summ = summ;
+}
+
 /* Search for a breakpoint in the sorted breakpoint table */
 
 BRKTAB *sim_brk_fnd (t_addr loc)
@@ -7202,13 +7706,15 @@ BRKTAB *sim_brk_new (t_addr loc)
     bp->typ = 0;
     bp->cnt = 0;
     bp->act = NULL;
+    bp->cpus = 0;
+    bp->modes = 0;
     sim_brk_ent = sim_brk_ent + 1;
     return bp;
 }
 
 /* Set a breakpoint of type sw */
 
-t_stat sim_brk_set (t_addr loc, int32 sw, int32 ncnt, char *act)
+t_stat sim_brk_set (t_addr loc, int32 sw, int32 ncnt, char *act, uint32 cpus, uint32 modes)
 {
     BRKTAB *bp;
 
@@ -7222,6 +7728,8 @@ t_stat sim_brk_set (t_addr loc, int32 sw, int32 ncnt, char *act)
         return SCPE_MEM;
     bp->typ = sw;                                           /* set type */
     bp->cnt = ncnt;                                         /* set count */
+    bp->cpus = cpus;                                        /* set VCPU and mode filter */
+    bp->modes = modes;
     if (bp->act != NULL && act != NULL)                     /* replace old action? */
     {
         free (bp->act);                                     /* deallocate */
@@ -7235,7 +7743,7 @@ t_stat sim_brk_set (t_addr loc, int32 sw, int32 ncnt, char *act)
         strncpy (newp, act, CBUFSIZE);                      /* copy action */
         bp->act = newp;                                     /* set pointer */
     }
-    sim_brk_summ = sim_brk_summ | sw;
+    sim_brk_filter ();                                      /* update summary */
     return SCPE_OK;
 }
 
@@ -7251,15 +7759,16 @@ t_stat sim_brk_clr (t_addr loc, int32 sw)
         sw = SIM_BRK_ALLTYP;
     bp->typ = bp->typ & ~sw;
     if (bp->typ)                                            /* clear all types? */
+    {
+        sim_brk_filter ();                                  /* update summary */
         return SCPE_OK;
+    }
     if (bp->act != NULL)                                    /* deallocate action */
         free (bp->act);
     for ( ; bp < (sim_brk_tab + sim_brk_ent - 1); bp++)     /* erase entry */
         *bp = *(bp + 1);
     sim_brk_ent = sim_brk_ent - 1;                          /* decrement count */
-    sim_brk_summ = 0;                                       /* recalc summary */
-    for (bp = sim_brk_tab; bp < (sim_brk_tab + sim_brk_ent); bp++)
-        sim_brk_summ = sim_brk_summ | bp->typ;
+    sim_brk_filter ();                                      /* recalc summary */
     return SCPE_OK;
 }
 
@@ -7306,6 +7815,17 @@ t_stat sim_brk_show (SMP_FILE *st, t_addr loc, int32 sw)
             any = 1;
             }
         }
+    for (i = 0; i < SIM_MAX_CPUS; i++) {
+        if ((bp->cpus >> i) & 1)
+            fprintf (st, " CPU=%d", i);
+        }
+    if (bp->modes && sim_brk_mode_names) {
+        fprintf (st, " MODE=");
+        for (i = 0; sim_brk_mode_names[i]; i++) {
+            if ((bp->modes >> i) & 1)
+                fputc (sim_brk_mode_names[i], st);
+            }
+        }
     if (bp->cnt > 0)
         fprintf (st, " [%d]", bp->cnt);
     if (bp->act != NULL)
@@ -7332,12 +7852,14 @@ t_stat sim_brk_showall (SMP_FILE *st, int32 sw)
 
 /* Test for breakpoint */
 
-uint32 sim_brk_test (RUN_DECL, t_addr loc, uint32 btyp)
+uint32 sim_brk_test (RUN_DECL, t_addr loc, uint32 btyp, int32 mode)
 {
     uint32 spc = (btyp >> SIM_BKPT_V_SPC) & (SIM_BKPT_N_SPC - 1);
     BRKTAB* bp = sim_brk_fnd (loc);
 
-    if (bp && (btyp & bp->typ))                             /* in table, type match? */
+    if (bp && (btyp & bp->typ) &&                           /* in table, type match? */
+        (bp->cpus == 0 || (bp->cpus >> cpu_unit->cpu_id) & 1) &&      /* VCPU match? */
+        (bp->modes == 0 || mode < 0 || (bp->modes >> mode) & 1))      /* mode match? */
     {
         /* previous location? */
         if (cpu_unit->sim_brk_pend[spc] && (loc == cpu_unit->sim_brk_ploc[spc]))
@@ -7671,6 +8193,20 @@ static void sim_debug_prefix (uint32 dbits, DEVICE* dptr)
 void sim_debug_u16(uint32 dbits, DEVICE* dptr, const char* const* bitdefs,
     uint16 before, uint16 after, int terminate)
 {
+    if (sim_deb && (dptr->dctrl & dbits) && sim_dbgring_active)
+    {
+        char buf[1024];
+        int32 i, len = 0;
+
+        for (i = 15; i >= 0 && len < (int32) sizeof(buf) - 64; i--)
+        {
+            int off = ((after >> i) & 1) + (((before ^ after) >> i) & 1) * 2;
+            len += sprintf(buf + len, "%s%c ", bitdefs[i], debug_bstates[off]);
+        }
+        if (sim_dbgring_text(dbits, dptr, buf, len, terminate ? 1 : 0))
+            return;
+    }
+
     if (sim_deb && (dptr->dctrl & dbits))
     {
         int32 i;
@@ -7687,6 +8223,53 @@ void sim_debug_u16(uint32 dbits, DEVICE* dptr, const char* const* bitdefs,
     }
 }
 
+/* Writes out register dump produced by sim_debug_u16 (deferred debug output writer) */
+
+void sim_debug_write_u16 (uint32 dbits, DEVICE* dptr, const char* buf, int32 len, int terminate)
+{
+    if (sim_deb == NULL)
+        return;
+    sim_debug_prefix(dbits, dptr);
+    fwrite (buf, 1, len, sim_deb);
+    if (terminate)
+        fprintf(sim_deb, "\r\n");
+    debug_unterm = terminate ? 0 : 1;
+}
+
+/* Writes out formatted debug message expanding newlines where they exist */
+
+void sim_debug_write (uint32 dbits, DEVICE* dptr, const char* buf, int32 len)
+{
+    int32 i, j;
+    char* debug_type;
+
+    if (sim_deb == NULL)
+        return;
+    debug_type = get_dbg_verb (dbits, dptr);
+
+    for (i = j = 0; i < len; ++i)
+    {
+        if ('\n' == buf[i])
+        {
+            if (i > j)
+            {
+                if (debug_unterm)
+                    fprintf (sim_deb, "%.*s\r\n", i-j, &buf[j]);
+                else                                    /* print prefix when required */
+                    fprintf (sim_deb, "DBG> %s %s: %.*s\r\n", dptr->name, debug_type, i-j, &buf[j]);
+                debug_unterm = 0;
+            }
+            j = i + 1;
+        }
+    }
+    if (i > j)
+        fwrite (&buf[j], 1, i-j, sim_deb);
+
+/* Set unterminated flag for next time */
+
+    debug_unterm = (len && (buf[len-1]=='\n')) ? 0 : 1;
+}
+
 #if defined (_WIN32)
 #define vsnprintf _vsnprintf
 #endif
@@ -7707,19 +8290,33 @@ void sim_debug_u16(uint32 dbits, DEVICE* dptr, const char* const* bitdefs,
    
    Callers should be calling sim_debug() which is a macro
    defined in scp.h which evaluates the action condition before 
-   incurring call overhead. */
+   incurring call overhead. 
+   
+   When debug output is deferred (see sim_dbgring.cpp), the event is 
+   only recorded here and is formatted later by the debug writer thread. */
 
 void _sim_debug (uint32 dbits, DEVICE* dptr, const char* fmt, ...)
 {
+    if (sim_deb && (dptr->dctrl & dbits) && sim_dbgring_active)
+    {
+        va_list arglist;
+        t_bool done;
+
+        va_start (arglist, fmt);
+        done = sim_dbgring_vlog (dbits, dptr, fmt, arglist);
+        va_end (arglist);
+        if (done)
+            return;
+    }
+
     if (sim_deb && (dptr->dctrl & dbits))
     {
         char stackbuf[STACKBUFSIZE];
         int32 bufsize = sizeof(stackbuf);
         char *buf = stackbuf;
         va_list arglist;
-        int32 i, j, len;
+        int32 len;
 
-        char* debug_type = get_dbg_verb (dbits, dptr);
         buf[bufsize-1] = '\0';
         // sim_debug_prefix(dbits, dptr);                      /* print prefix if required */
 
@@ -7765,29 +8362,7 @@ void _sim_debug (uint32 dbits, DEVICE* dptr, const char* fmt, ...)
             break;
         }
 
-    /* Output the formatted data expanding newlines where they exist */
-
-        for (i = j = 0; i < len; ++i)
-        {
-            if ('\n' == buf[i])
-            {
-                if (i > j)
-                {
-                    if (debug_unterm)
-                        fprintf (sim_deb, "%.*s\r\n", i-j, &buf[j]);
-                    else                                    /* print prefix when required */
-                        fprintf (sim_deb, "DBG> %s %s: %.*s\r\n", dptr->name, debug_type, i-j, &buf[j]);
-                    debug_unterm = 0;
-                }
-                j = i + 1;
-            }
-        }
-        if (i > j)
-            fwrite (&buf[j], 1, i-j, sim_deb);
-
-    /* Set unterminated flag for next time */
-
-        debug_unterm = (len && (buf[len-1]=='\n')) ? 0 : 1;
+        sim_debug_write (dbits, dptr, buf, len);
         if (buf != stackbuf)
             free (buf);
     }
@@ -7897,6 +8472,16 @@ t_stat perf_cmd (int32 flag, char *cptr)
 
     cptr = get_glyph (cptr, gbuf, 0);
 
+    if (streqi(gbuf, "PROFILE"))
+        return prof_cmd(cptr);
+    if (streqi(gbuf, "BENCH"))
+    {
+        GET_SWITCHES (cptr);                                /* get switches */
+        return bench_cmd(cptr);
+    }
+    if (streqi(gbuf, "STATS"))
+        return stats_cmd(cptr);
+
     if (streqi(gbuf, "SHOW"))
         verb = PERF_CMD_VERB_SHOW;
     else if (streqi(gbuf, "ON"))
@@ -8180,6 +8765,18 @@ void critical_unlock(sim_lock_criticality_t criticality)
      */
 }
 
+/* Called when a contended lock has been acquired, to account VCPU lock wait time (SHOW CPU STATISTICS) */
+void sim_lock_waited(t_uint64 wait_start)
+{
+    RUN_SCOPE_RSCX_ONLY;
+
+    if (rscx && rscx->thread_type == SIM_THREAD_TYPE_CPU)
+    {
+        CPU_UNIT* cpu_unit = rscx->cpu_unit;
+        cpu_stats.lock_wait_ns += sim_os_nsec() - wait_start;
+    }
+}
+
 void sim_reevaluate_noncpu_thread_priority(run_scope_context* rscx)
 {
     sim_thread_priority_t prio;
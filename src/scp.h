@@ -67,6 +67,8 @@ t_stat exdep_cmd (int32 flag, char *ptr);
 t_stat eval_cmd (int32 flag, char *ptr);
 t_stat load_cmd (int32 flag, char *ptr);
 t_stat run_cmd (int32 flag, char *ptr);
+t_stat run_boot_prep (void);
+t_stat run_timed (uint32 run_msec);
 t_stat attach_cmd (int32 flag, char *ptr);
 t_stat detach_cmd (int32 flag, char *ptr);
 t_stat assign_cmd (int32 flag, char *ptr);
@@ -77,6 +79,9 @@ t_stat exit_cmd (int32 flag, char *ptr);
 t_stat set_cmd (int32 flag, char *ptr);
 t_stat show_cmd (int32 flag, char *ptr);
 t_stat perf_cmd (int32 flag, char *ptr);
+t_stat prof_cmd (char *cptr);
+t_stat bench_cmd (char *cptr);
+t_stat stats_cmd (char *cptr);
 t_stat cpu_cmd (int32 flag, char *ptr);
 t_stat brk_cmd (int32 flag, char *ptr);
 t_stat do_cmd (int32 flag, char *ptr);
@@ -137,12 +142,23 @@ CTAB *find_ctab (CTAB *tab, const char *gbuf);
 C1TAB *find_c1tab (C1TAB *tab, const char *gbuf);
 SHTAB *find_shtab (SHTAB *tab, const char *gbuf);
 BRKTAB *sim_brk_fnd (t_addr loc);
-uint32 sim_brk_test (RUN_DECL, t_addr bloc, uint32 btyp);
+uint32 sim_brk_test (RUN_DECL, t_addr bloc, uint32 btyp, int32 mode = -1);
 void sim_brk_clrspc (RUN_DECL, uint32 spc);
 char *match_ext (char *fnam, char *ext);
 const char *sim_error_text (t_stat stat);
 t_stat sim_string_to_stat (char *cptr, t_stat *cond);
 void sim_debug_u16 (uint32 dbits, DEVICE* dptr, const char* const* bitdefs, uint16 before, uint16 after, int terminate);
+void sim_debug_write (uint32 dbits, DEVICE* dptr, const char* buf, int32 len);
+void sim_debug_write_u16 (uint32 dbits, DEVICE* dptr, const char* buf, int32 len, int terminate);
+t_stat sim_memimg_save (SMP_FILE* sfile, const t_byte* mem, t_addr size);
+t_stat sim_memimg_restore (SMP_FILE* rfile, t_byte* mem, t_addr size);
+void sim_dbgring_start (void);
+void sim_dbgring_stop (void);
+void sim_dbgring_flush (void);
+t_bool sim_dbgring_direct (void);
+void sim_dbgring_show (SMP_FILE* st);
+t_bool sim_dbgring_vlog (uint32 dbits, DEVICE* dptr, const char* fmt, va_list args);
+t_bool sim_dbgring_text (uint32 dbits, DEVICE* dptr, const char* text, int32 len, int32 u16_terminate);
 
 #if defined (__DECC) && defined (__VMS) && (defined (__VAX) || (__DECC_VER < 60590001))
 #  define CANT_USE_MACRO_VA_ARGS 1
@@ -162,6 +178,9 @@ SMP_THREAD_ROUTINE_DECL sim_cpu_work_thread_proc (void* arg);
 SMP_THREAD_ROUTINE_DECL sim_clock_thread_proc (void* arg);
 void sim_ws_setup();
 void sim_prefault_memory();
+void sim_prefault_range(void* base, size_t size);
+void* sim_alloc_memory(size_t size);
+void sim_free_memory(void* p, size_t size);
 t_stat xdev_cmd(int32 flag, char *ptr);
 
 /* SIM <-> CPU routines */
@@ -196,7 +215,7 @@ extern atomic_uint32_var cpu_cycles_per_second;
 
 extern smp_semaphore* cpu_attention;
 extern smp_barrier* cpu_pause_sync_barrier;
-extern smp_semaphore* cpu_clock_run_gate;
+extern smp_simple_semaphore* cpu_clock_run_gate;
 extern t_bool sim_ttrun_mode;
 extern t_bool use_clock_thread;
 extern t_bool sim_clock_thread_created;
@@ -205,9 +224,30 @@ extern smp_thread_t sim_clock_thread;
 /* VCPU affinity control */
 
 extern t_bool sim_vcpu_per_core;
+extern t_bool sim_vcpu_topology;
+extern smp_affinity_kind_t sim_vcpu_affinity;
 
 /* other globals */
 extern SMP_FILE* sim_deb;
+extern t_bool sim_dbgring_active;
+extern t_bool smp_fileout_enabled;
+extern uint32 sim_brk_pgmask[SIM_BRK_PG_SLOTS];
+extern const char *sim_brk_mode_names;
+
+/* Test for breakpoint, skipping the table search if no breakpoint
+   of the requested type is set in the page of loc */
+
+SIM_INLINE static uint32 sim_brk_check (RUN_DECL, t_addr loc, uint32 btyp, int32 mode)
+{
+    if (likely((sim_brk_pgmask[SIM_BRK_PG_HASH (loc)] & btyp) == 0))
+    {
+        uint32 spc = (btyp >> SIM_BKPT_V_SPC) & (SIM_BKPT_N_SPC - 1);
+        if (cpu_unit->sim_brk_pend[spc])
+            cpu_unit->sim_brk_pend[spc] = FALSE;
+        return 0;
+    }
+    return sim_brk_test (RUN_PASS, loc, btyp, mode);
+}
 extern uint32 sim_vsmp_os;
 
 #endif
@@ -97,6 +97,8 @@
    sim_set_cons_nolog - set console nolog
    sim_show_cons_buff - show console buffered
    sim_show_cons_log -  show console log
+   sim_set_cons_defer - set console and log output deferred while running
+   sim_show_cons_defer - show deferred output state
    sim_tt_inpcvt -      convert input character per mode
    sim_tt_outcvt -      convert output character per mode
 
@@ -142,7 +144,7 @@ AUTO_INIT_LOCK(sim_con_lock,                            /* lock for sim_con_ldsc
         SIM_LOCK_CRITICALITY_OS_HI,
         DEVLOCK_SPINWAIT_CYCLES);                        
 
-extern int32 sim_quiet;
+extern int32 sim_quiet, sim_switches;
 extern SMP_FILE *sim_log, *sim_deb;
 extern SMP_FILEREF *sim_log_ref, *sim_deb_ref;
 
@@ -159,6 +161,8 @@ static CTAB set_con_tab[] = {
     { "NOLOG", &sim_set_logoff, 0 },
     { "DEBUG", &sim_set_debon, 0 },
     { "NODEBUG", &sim_set_deboff, 0 },
+    { "DEFER", &sim_set_cons_defer, 1 },
+    { "NODEFER", &sim_set_cons_defer, 0 },
     { NULL, NULL, 0 }
     };
 
@@ -171,6 +175,7 @@ static SHTAB show_con_tab[] = {
     { "TELNET", &sim_show_telnet, 0 },
     { "DEBUG", &sim_show_debug, 0 },
     { "BUFFERED", &sim_show_cons_buff, 0 },
+    { "DEFER", &sim_show_cons_defer, 0 },
     { NULL, NULL, 0 }
     };
 
@@ -371,10 +376,15 @@ if ((cptr == NULL) || (*cptr == 0))                     /* need arg */
 cptr = get_glyph_nc (cptr, gbuf, 0);                    /* get file name */
 if (*cptr != 0)                                         /* now eol? */
     return SCPE_2MARG;
+sim_dbgring_stop ();                                    /* write out pending output */
 r = sim_open_logfile (gbuf, FALSE, &sim_deb, &sim_deb_ref);
 
 if (r != SCPE_OK)
     return r;
+if (sim_deb_ref && sim_deb_ref->file == sim_deb)        /* own file: written by debug ring writer */
+    sim_deb->deferred = FALSE;                          /* or synchronously, never requeued */
+if (!(sim_switches & SWMASK ('S')))                     /* -S: format synchronously */
+    sim_dbgring_start ();
 if (!sim_quiet)
     smp_printf ("Debug output to \"%s\"\n", 
             sim_logfile_name (sim_deb, sim_deb_ref));
@@ -394,6 +404,7 @@ if (cptr && (*cptr != 0))                               /* now eol? */
     return SCPE_2MARG;
 if (sim_deb == NULL)                                    /* no log? */
     return SCPE_OK;
+sim_dbgring_stop ();                                    /* write out pending output */
 r = sim_close_logfile (&sim_deb_ref);
 sim_deb = NULL;
 if (!sim_quiet)
@@ -409,9 +420,11 @@ t_stat sim_show_debug (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char
 {
 if (cptr && (*cptr != 0))
     return SCPE_2MARG;
-if (sim_deb)
+if (sim_deb) {
     fprintf (st, "Debug output enabled to \"%s\"\n", 
                  sim_logfile_name (sim_deb, sim_deb_ref));
+    sim_dbgring_show (st);
+    }
 else fprintf (st, "Debug output disabled\n");
 return SCPE_OK;
 }
@@ -543,6 +556,26 @@ else
 return SCPE_OK;
 }
 
+/* Set console and log output deferred (written by a writer thread) while running */
+
+t_stat sim_set_cons_defer (int32 flg, char *cptr)
+{
+if (cptr && (*cptr != 0))                               /* now eol? */
+    return SCPE_2MARG;
+smp_fileout_enabled = flg;
+return SCPE_OK;
+}
+
+/* Show deferred output state */
+
+t_stat sim_show_cons_defer (SMP_FILE *st, DEVICE *dunused, UNIT *uunused, int32 flag, char *cptr)
+{
+if (cptr && (*cptr != 0))
+    return SCPE_2MARG;
+smp_fileout_show (st);
+return SCPE_OK;
+}
+
 /* Log File Open/Close/Show Support */
 
 /* Open log file */
@@ -594,6 +627,7 @@ else {
         *pref = NULL;
         return SCPE_OPENERR;
         }
+    (*pf)->deferred = TRUE;                             /* written by writer thread while running */
     (*pref)->file = *pf;
     (*pref)->refcount = 1;                               /* need close */
     }
@@ -737,6 +771,7 @@ t_stat sim_putchar (int32 c)
     {
         if (sim_log)                                        /* log file? */
             fputc (c, sim_log);
+        fflush (smp_stdout);                                /* deferred smp_printf text and stdio buffer first */
         return sim_os_putchar (c);                          /* in-window version */
     }
     if (sim_log && !sim_con_ldsc.txlog)                     /* log file, but no line log? */
@@ -762,6 +797,7 @@ t_stat sim_putchar_s (int32 c)
     {
         if (sim_log)                                        /* log file? */
             fputc (c, sim_log);
+        fflush (smp_stdout);                                /* deferred smp_printf text and stdio buffer first */
         return sim_os_putchar (c);                          /* in-window version */
     }
     if (sim_log && !sim_con_ldsc.txlog)                     /* log file, but no line log? */
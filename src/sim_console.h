@@ -60,6 +60,7 @@ t_stat sim_set_logoff (int32 flag, char *cptr);
 t_stat sim_set_debon (int32 flag, char *cptr);
 t_stat sim_set_deboff (int32 flag, char *cptr);
 t_stat sim_set_cons_buff (int32 flg, char *cptr);
+t_stat sim_set_cons_defer (int32 flg, char *cptr);
 t_stat sim_set_cons_unbuff (int32 flg, char *cptr);
 t_stat sim_set_cons_log (int32 flg, char *cptr);
 t_stat sim_set_cons_nolog (int32 flg, char *cptr);
@@ -71,6 +72,7 @@ t_stat sim_show_log (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *c
 t_stat sim_show_debug (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr);
 t_stat sim_show_pchar (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr);
 t_stat sim_show_cons_buff (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr);
+t_stat sim_show_cons_defer (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr);
 t_stat sim_show_cons_log (SMP_FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, char *cptr);
 t_stat sim_check_console (int32 sec);
 t_stat sim_open_logfile (char *filename, t_bool binary, SMP_FILE **pf, SMP_FILEREF **pref);
@@ -0,0 +1,871 @@
+/*
+ * sim_dbgring.cpp: deferred debug output
+ *
+ * While deferred output is active, sim_debug does not format anything on the calling thread.
+ * The event is recorded into the thread's own ring buffer as a reference to the parsed format
+ * string, a timestamp and the raw argument values; no lock is taken and no stdio is involved.
+ * A writer thread periodically merges the rings of all threads in timestamp order, formats
+ * the events and writes them to the debug file.
+ *
+ * Format strings are parsed the first time they are seen into segments carrying at most one
+ * conversion each, so the writer can replay them through snprintf one argument at a time
+ * without reconstructing a va_list.  Formats the parser does not handle (%n, long double,
+ * wide strings, too many arguments) are formatted on the spot and recorded as text.
+ * %s arguments are copied into the record up to their precision, if any; events too large
+ * for the ring are written out on the spot, after the events recorded before them.
+ *
+ * A thread whose ring is full does not drop events: it drains the rings itself, formatting
+ * and writing as the synchronous path would, until there is room again.
+ * Events still in the rings are lost if the simulator crashes; SET -S DEBUG selects the
+ * synchronous output path for such cases.
+ *
+ * A thread marks its ring busy while recording and checks sim_dbgring_active only after that,
+ * so sim_dbgring_stop can wait for recordings in progress before the final drain; a thread
+ * that finds deferred output turned off falls back to the synchronous path.
+ */
+
+#include "sim_defs.h"
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <time.h>
+#endif
+
+#if !defined(va_copy)
+#  if defined(__va_copy)
+#    define va_copy(dst, src)  __va_copy(dst, src)
+#  else
+#    define va_copy(dst, src)  ((dst) = (src))
+#  endif
+#endif
+
+#define DBGRING_SIZE        (1024 * 1024)           /* per-thread ring size, must be a power of two */
+#define DBGRING_MAXCONV     16                      /* conversions in a deferrable format */
+#define DBGRING_MAXWORDS    (3 * DBGRING_MAXCONV)   /* argument words: conversions and '*' values */
+#define DBGRING_MAXREC      (DBGRING_SIZE / 4)      /* larger events are written out on the spot */
+#define DBGRING_FMT_SLOTS   4096                    /* format cache size, must be a power of two */
+#define DBGRING_PERIOD      10000                   /* writer pass interval, usec */
+#define DBGRING_HOLDBACK    2000000                 /* events younger than this (nsec) wait for the next pass */
+
+/* kinds of conversion arguments */
+#define DBGARG_NONE         0                       /* literal text only */
+#define DBGARG_INT32        1
+#define DBGARG_INT64        2
+#define DBGARG_DOUBLE       3
+#define DBGARG_STRING       4
+#define DBGARG_PTR          5
+
+/* kinds of ring records */
+#define DBGREC_PAD          0                       /* filler up to the end of the ring */
+#define DBGREC_EVENT        1                       /* format and arguments */
+#define DBGREC_TEXT         2                       /* text formatted by the caller */
+#define DBGREC_U16          3                       /* sim_debug_u16 register dump */
+
+typedef struct
+{
+    char* text;                                     /* segment text, containing at most one conversion */
+    t_byte kind;                                    /* DBGARG_xxx */
+    t_byte nstar;                                   /* '*' width and precision arguments */
+    int prec;                                       /* precision: -1 if none, -2 if '*' */
+}
+dbgfmt_seg;
+
+typedef struct
+{
+    const char* fmt;                                /* caller's format string, the cache key */
+    t_bool direct;                                  /* cannot be deferred, format on the spot */
+    int nsegs;
+    dbgfmt_seg seg[DBGRING_MAXCONV + 1];
+}
+dbgfmt;
+
+typedef struct
+{
+    uint32 size;                                    /* record size in bytes, multiple of 8 */
+    uint16 kind;                                    /* DBGREC_xxx */
+    uint16 flags;                                   /* DBGREC_U16: terminate line */
+    uint32 dbits;
+    uint32 len;                                     /* text length or number of argument words */
+    t_uint64 ts;                                    /* timestamp, nsec */
+    DEVICE* dptr;
+    const dbgfmt* fmt;
+    /* followed by argument words (t_uint64) and copies of string arguments, or by text */
+}
+dbgrec;
+
+typedef struct __tag_dbgring
+{
+    struct __tag_dbgring* next;                     /* list of all rings, walked by the writer */
+    t_byte* buf;
+    t_bool kicked;                                  /* writer has been woken for this ring */
+    uint32 stalls;                                  /* times the owner waited for space */
+    SIM_ALIGN_CACHELINE volatile uint32 head;       /* written by the owning thread only */
+    volatile t_bool busy;                           /* owning thread is recording an event */
+    SIM_ALIGN_CACHELINE volatile uint32 tail;       /* written by the writer only */
+    t_byte pad[SMP_MAXCACHELINESIZE - sizeof(uint32)];
+}
+dbgring;
+
+t_bool sim_dbgring_active = FALSE;
+
+static const dbgfmt* volatile dbgfmt_cache[DBGRING_FMT_SLOTS];
+static dbgring* volatile dbgring_list = NULL;
+static smp_event* dbgring_wakeup = NULL;
+static smp_thread_t dbgring_writer;
+static volatile t_bool dbgring_writer_stop = FALSE;
+static uint32 dbgring_events = 0;                   /* statistics, maintained by the writer */
+static uint32 dbgring_texts = 0;
+static uint32 dbgring_exited_stalls = 0;            /* stalls of rings released on thread exit */
+
+static SMP_TLS_DTOR_DECL dbgring_release(void* arg);
+
+AUTO_TLS_DTOR(dbgring_key, dbgring_release);
+AUTO_INIT_LOCK(dbgfmt_lock, SIM_LOCK_CRITICALITY_NONE, 1000);
+AUTO_INIT_LOCK(dbgring_list_lock, SIM_LOCK_CRITICALITY_NONE, 1000);
+AUTO_INIT_LOCK(dbgring_drain_lock, SIM_LOCK_CRITICALITY_NONE, 1000);
+
+static t_uint64 dbgring_now()
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER c;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(& freq);
+    QueryPerformanceCounter(& c);
+    return (t_uint64) (c.QuadPart / freq.QuadPart) * 1000000000 +
+           (t_uint64) (c.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, & ts);
+    return (t_uint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/******************************************************************************************
+*  Format string parsing                                                                  *
+******************************************************************************************/
+
+static char* dbgfmt_dup(const char* p, size_t len)
+{
+    char* s = (char*) malloc(len + 1);
+    if (s == NULL)
+        panic("Unable to allocate memory");
+    memcpy(s, p, len);
+    s[len] = '\0';
+    return s;
+}
+
+static t_byte dbgfmt_intkind(size_t size)
+{
+    return (size == 8) ? DBGARG_INT64 : DBGARG_INT32;
+}
+
+static dbgfmt* dbgfmt_parse(const char* fmt)
+{
+    dbgfmt* f = (dbgfmt*) calloc(1, sizeof(dbgfmt));
+    const char* start = fmt;
+    const char* p = fmt;
+    int nwords = 0;
+
+    if (f == NULL)
+        panic("Unable to allocate memory");
+    f->fmt = fmt;
+
+    while (*p && !f->direct)
+    {
+        if (*p != '%')
+        {
+            p++;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            p += 2;
+            continue;
+        }
+
+        const char* q = p + 1;
+        int nstar = 0;
+        int prec = -1;
+        int lmod = 0;                               /* 'h', 'l', 'L', 'q' (ll, I64), 'z' (z, t, I) or 'j' */
+        t_byte kind;
+
+        while (*q && strchr("-+ #0'", *q))
+            q++;
+        if (*q == '*')
+            nstar++, q++;
+        else while (*q >= '0' && *q <= '9')
+            q++;
+        if (*q == '.')
+        {
+            q++;
+            if (*q == '*')
+                nstar++, q++, prec = -2;
+            else for (prec = 0;  *q >= '0' && *q <= '9';  q++)
+                prec = 10 * prec + (*q - '0');
+        }
+
+        if (q[0] == 'h')
+            lmod = 'h', q += (q[1] == 'h') ? 2 : 1;
+        else if (q[0] == 'l' && q[1] == 'l')
+            lmod = 'q', q += 2;
+        else if (q[0] == 'l')
+            lmod = 'l', q++;
+        else if (q[0] == 'I' && q[1] == '6' && q[2] == '4')
+            lmod = 'q', q += 3;
+        else if (q[0] == 'I' && q[1] == '3' && q[2] == '2')
+            lmod = 'h', q += 3;
+        else if (q[0] == 'I' || q[0] == 'z' || q[0] == 't')
+            lmod = 'z', q++;
+        else if (q[0] == 'L' || q[0] == 'q' || q[0] == 'j')
+            lmod = q[0], q++;
+
+        switch (*q)
+        {
+        case 'd':  case 'i':  case 'u':  case 'o':  case 'x':  case 'X':  case 'c':
+            switch (lmod)
+            {
+            case 'l':  kind = dbgfmt_intkind(sizeof(long));        break;
+            case 'q':  kind = DBGARG_INT64;                        break;
+            case 'j':  kind = dbgfmt_intkind(sizeof(intmax_t));    break;
+            case 'z':  kind = dbgfmt_intkind(sizeof(size_t));      break;
+            case 'L':  kind = DBGARG_NONE;                         break;
+            default:   kind = DBGARG_INT32;                        break;
+            }
+            break;
+        case 'e':  case 'E':  case 'f':  case 'F':  case 'g':  case 'G':  case 'a':  case 'A':
+            kind = (lmod == 'L') ? DBGARG_NONE : DBGARG_DOUBLE;
+            break;
+        case 's':
+            kind = (lmod == 'l') ? DBGARG_NONE : DBGARG_STRING;
+            break;
+        case 'p':
+            kind = DBGARG_PTR;
+            break;
+        default:                                    /* %n, %S, %C or malformed */
+            kind = DBGARG_NONE;
+            break;
+        }
+
+        nwords += nstar + 1;
+        if (kind == DBGARG_NONE || f->nsegs == DBGRING_MAXCONV || nwords > DBGRING_MAXWORDS)
+        {
+            f->direct = TRUE;
+            break;
+        }
+
+        p = q + 1;
+        f->seg[f->nsegs].text = dbgfmt_dup(start, p - start);
+        f->seg[f->nsegs].kind = kind;
+        f->seg[f->nsegs].nstar = nstar;
+        f->seg[f->nsegs].prec = prec;
+        f->nsegs++;
+        start = p;
+    }
+
+    if (!f->direct && *start)
+    {
+        f->seg[f->nsegs].text = dbgfmt_dup(start, strlen(start));
+        f->seg[f->nsegs].kind = DBGARG_NONE;
+        f->seg[f->nsegs].prec = -1;
+        f->nsegs++;
+    }
+
+    return f;
+}
+
+/*
+ * Look up format descriptor by the address of the format string.  Lookups are lock-free,
+ * insertions (once per format string for the lifetime of the simulator) are serialized.
+ * Returns NULL if the cache is full.
+ */
+static const dbgfmt* dbgfmt_lookup(const char* fmt)
+{
+    uint32 h = (uint32) (((t_uint64) (size_t) fmt * 0x9E3779B97F4A7C15ull) >> 40);
+    uint32 k, ix;
+    const dbgfmt* f;
+
+    for (k = 0;  k < DBGRING_FMT_SLOTS;  k++)
+    {
+        ix = (h + k) & (DBGRING_FMT_SLOTS - 1);
+        if ((f = dbgfmt_cache[ix]) == NULL)
+            break;
+        if (f->fmt == fmt)
+            return f;
+    }
+    if (k == DBGRING_FMT_SLOTS)
+        return NULL;
+
+    AUTO_LOCK(dbgfmt_lock);
+    for (;  k < DBGRING_FMT_SLOTS;  k++)
+    {
+        ix = (h + k) & (DBGRING_FMT_SLOTS - 1);
+        if ((f = dbgfmt_cache[ix]) == NULL)
+        {
+            f = dbgfmt_parse(fmt);
+            smp_wmb();
+            dbgfmt_cache[ix] = f;
+            return f;
+        }
+        if (f->fmt == fmt)
+            return f;
+    }
+    return NULL;
+}
+
+/******************************************************************************************
+*  Recording side: runs on the thread issuing sim_debug                                   *
+******************************************************************************************/
+
+static dbgring* dbgring_current()
+{
+    dbgring* r = (dbgring*) tls_get_value(dbgring_key);
+
+    if (unlikely(r == NULL))
+    {
+        r = (dbgring*) calloc(1, sizeof(dbgring));
+        if (r == NULL || (r->buf = (t_byte*) malloc(DBGRING_SIZE)) == NULL)
+            panic("Unable to allocate memory");
+        dbgring_list_lock->lock();
+        r->next = dbgring_list;
+        smp_wmb();
+        dbgring_list = r;
+        dbgring_list_lock->unlock();
+        tls_set_value(dbgring_key, r);
+    }
+
+    return r;
+}
+
+static void dbgring_drain(t_uint64 cutoff);
+
+/*
+ * Thread exit: write out the exiting thread's events and free its ring.  The list is
+ * walked by drainers under dbgring_drain_lock, so the ring is unlinked under it as well.
+ */
+static SMP_TLS_DTOR_DECL dbgring_release(void* arg)
+{
+    dbgring* r = (dbgring*) arg;
+    dbgring* volatile* pp;
+
+    dbgring_drain_lock->lock();
+    dbgring_drain((t_uint64) -1);
+    dbgring_list_lock->lock();
+    for (pp = & dbgring_list;  *pp;  pp = & (*pp)->next)
+    {
+        if (*pp == r)
+        {
+            *pp = r->next;
+            break;
+        }
+    }
+    dbgring_list_lock->unlock();
+    dbgring_exited_stalls += r->stalls;
+    dbgring_drain_lock->unlock();
+
+    free(r->buf);
+    free(r);
+}
+
+/*
+ * Mark the current thread's ring busy for recording an event.  Returns NULL if deferred
+ * output has been turned off meanwhile, the caller must then use the synchronous path.
+ */
+static dbgring* dbgring_enter()
+{
+    dbgring* r = dbgring_current();
+
+    r->busy = TRUE;
+    smp_mb();                                       /* pairs with sim_dbgring_stop */
+    if (unlikely(! sim_dbgring_active))
+    {
+        r->busy = FALSE;
+        return NULL;
+    }
+    return r;
+}
+
+static void dbgring_leave(dbgring* r)
+{
+    smp_wmb();
+    r->busy = FALSE;
+}
+
+/*
+ * Write out an event too large for the ring, after all events recorded before it.
+ */
+static void dbgring_write_now(uint32 dbits, DEVICE* dptr, const char* text, int32 len, int32 u16_terminate)
+{
+    dbgring_drain_lock->lock();
+    dbgring_drain(dbgring_now());
+    if (u16_terminate >= 0)
+        sim_debug_write_u16(dbits, dptr, text, len, u16_terminate);
+    else
+        sim_debug_write(dbits, dptr, text, len);
+    dbgring_texts++;
+    dbgring_drain_lock->unlock();
+}
+
+/*
+ * Reserve size bytes (multiple of 8, at most DBGRING_MAXREC) in the current thread's ring,
+ * draining the rings on the writer's behalf if the ring is full.
+ */
+static dbgrec* dbgring_reserve(dbgring* r, uint32 size)
+{
+    uint32 head = r->head;
+    uint32 off = head & (DBGRING_SIZE - 1);
+    uint32 need = (off + size > DBGRING_SIZE) ? DBGRING_SIZE - off + size : size;
+
+    if (unlikely(DBGRING_SIZE - (head - r->tail) < need))
+    {
+        r->stalls++;
+        while (DBGRING_SIZE - (head - r->tail) < need)
+        {
+            dbgring_drain_lock->lock();
+            dbgring_drain(dbgring_now());
+            dbgring_drain_lock->unlock();
+        }
+    }
+    smp_rmb();                                      /* writer is done with the space */
+
+    if (off + size > DBGRING_SIZE)
+    {
+        dbgrec* pad = (dbgrec*) (r->buf + off);
+        pad->size = DBGRING_SIZE - off;
+        pad->kind = DBGREC_PAD;
+        off = 0;
+    }
+
+    return (dbgrec*) (r->buf + off);
+}
+
+static void dbgring_commit(dbgring* r, dbgrec* rec)
+{
+    uint32 head = r->head;
+    uint32 off = head & (DBGRING_SIZE - 1);
+
+    if ((t_byte*) rec != r->buf + off)              /* wrapped: skip over the pad */
+        head += DBGRING_SIZE - off;
+    head += rec->size;
+
+    smp_wmb();
+    r->head = head;
+
+    if (unlikely(head - r->tail > DBGRING_SIZE / 2) && !r->kicked)
+    {
+        r->kicked = TRUE;
+        dbgring_wakeup->set();
+    }
+}
+
+/*
+ * Record text already formatted by the caller.  Returns FALSE if deferred output has been
+ * turned off, the caller must then use the synchronous path.
+ */
+t_bool sim_dbgring_text (uint32 dbits, DEVICE* dptr, const char* text, int32 len, int32 u16_terminate)
+{
+    dbgring* r = dbgring_enter();
+    dbgrec* rec;
+    t_uint64 size;
+
+    if (r == NULL)
+        return FALSE;
+
+    size = (sizeof(dbgrec) + (t_uint64) len + 7) & ~7;
+    if (size > DBGRING_MAXREC)
+    {
+        dbgring_write_now(dbits, dptr, text, len, u16_terminate);
+        dbgring_leave(r);
+        return TRUE;
+    }
+
+    rec = dbgring_reserve(r, (uint32) size);
+    rec->size = (uint32) size;
+    rec->kind = (u16_terminate >= 0) ? DBGREC_U16 : DBGREC_TEXT;
+    rec->flags = (u16_terminate > 0);
+    rec->dbits = dbits;
+    rec->len = len;
+    rec->ts = dbgring_now();
+    rec->dptr = dptr;
+    rec->fmt = NULL;
+    memcpy(rec + 1, text, len);
+    dbgring_commit(r, rec);
+    dbgring_leave(r);
+    return TRUE;
+}
+
+/* Format on the spot and record as text */
+static t_bool dbgring_vtext(uint32 dbits, DEVICE* dptr, const char* fmt, va_list args)
+{
+    char stackbuf[1024];
+    char* buf = stackbuf;
+    va_list ac;
+    t_bool res;
+    int len;
+
+    va_copy(ac, args);
+    len = vsnprintf(buf, sizeof(stackbuf), fmt, ac);
+    va_end(ac);
+    if (len < 0)                                    /* let the synchronous path deal with it */
+        return FALSE;
+    if (len >= (int) sizeof(stackbuf))
+    {
+        if ((buf = (char*) malloc(len + 1)) == NULL)
+            panic("Unable to allocate memory");
+        vsnprintf(buf, len + 1, fmt, args);
+    }
+
+    res = sim_dbgring_text(dbits, dptr, buf, len, -1);
+
+    if (buf != stackbuf)
+        free(buf);
+    return res;
+}
+
+/*
+ * Record sim_debug event.  Returns FALSE if deferred output has been turned off, the caller
+ * must then use the synchronous path.
+ */
+t_bool sim_dbgring_vlog (uint32 dbits, DEVICE* dptr, const char* fmt, va_list args)
+{
+    const dbgfmt* f = dbgfmt_lookup(fmt);
+    t_uint64 w[DBGRING_MAXWORDS];
+    const char* str[DBGRING_MAXCONV];
+    size_t slen[DBGRING_MAXCONV];
+    uint32 nw = 0, ns = 0;
+    t_uint64 strsize = 0, size;
+    va_list ac;
+    dbgring* r;
+    int k, j;
+
+    if (f == NULL || f->direct)
+        return dbgring_vtext(dbits, dptr, fmt, args);
+
+    va_copy(ac, args);
+    for (k = 0;  k < f->nsegs;  k++)
+    {
+        const dbgfmt_seg* sg = & f->seg[k];
+        for (j = 0;  j < sg->nstar;  j++)
+            w[nw++] = (t_uint64) (t_int64) va_arg(ac, int);
+        switch (sg->kind)
+        {
+        case DBGARG_INT32:
+            w[nw++] = (t_uint64) (t_int64) va_arg(ac, int);
+            break;
+        case DBGARG_INT64:
+            w[nw++] = (t_uint64) va_arg(ac, t_int64);
+            break;
+        case DBGARG_DOUBLE:
+            if (1)
+            {
+                double d = va_arg(ac, double);
+                memcpy(& w[nw++], & d, sizeof(d));
+            }
+            break;
+        case DBGARG_PTR:
+            w[nw++] = (t_uint64) (size_t) va_arg(ac, void*);
+            break;
+        case DBGARG_STRING:
+            if (1)
+            {
+                /* '*' precision is the last '*' argument, negative means none */
+                int prec = (sg->prec == -2) ? (int) w[nw - 1] : sg->prec;
+                const char* s = va_arg(ac, const char*);
+                size_t len = 0;
+                if (s == NULL)
+                    s = "(null)";
+                if (prec < 0)
+                    len = strlen(s);
+                else while (len < (size_t) prec && s[len])
+                    len++;
+                w[nw++] = strsize;                  /* offset into string area */
+                str[ns] = s;
+                slen[ns++] = len;
+                strsize += len + 1;
+            }
+            break;
+        }
+    }
+    va_end(ac);
+
+    size = (sizeof(dbgrec) + nw * sizeof(t_uint64) + strsize + 7) & ~7;
+    if (size > DBGRING_MAXREC)
+        return dbgring_vtext(dbits, dptr, fmt, args);
+
+    if ((r = dbgring_enter()) == NULL)
+        return FALSE;
+    dbgrec* rec = dbgring_reserve(r, (uint32) size);
+    rec->size = (uint32) size;
+    rec->kind = DBGREC_EVENT;
+    rec->flags = 0;
+    rec->dbits = dbits;
+    rec->len = nw;
+    rec->ts = dbgring_now();
+    rec->dptr = dptr;
+    rec->fmt = f;
+    memcpy(rec + 1, w, nw * sizeof(t_uint64));
+    char* sp = (char*) (rec + 1) + nw * sizeof(t_uint64);
+    for (k = 0;  k < (int) ns;  k++)
+    {
+        memcpy(sp, str[k], slen[k]);
+        sp[slen[k]] = '\0';
+        sp += slen[k] + 1;
+    }
+    dbgring_commit(r, rec);
+    dbgring_leave(r);
+    return TRUE;
+}
+
+/******************************************************************************************
+*  Writer side                                                                            *
+******************************************************************************************/
+
+static int dbgfmt_seg_print(char* out, size_t cap, const dbgfmt_seg* sg, const t_uint64* w, const char* strs)
+{
+    int st0 = sg->nstar > 0 ? (int) w[0] : 0;
+    int st1 = sg->nstar > 1 ? (int) w[1] : 0;
+    t_uint64 v = w[sg->nstar];
+
+#define DBGSEG_PRINT(arg)                                                    \
+    ((sg->nstar == 0) ? snprintf(out, cap, sg->text, arg) :                  \
+     (sg->nstar == 1) ? snprintf(out, cap, sg->text, st0, arg) :             \
+                        snprintf(out, cap, sg->text, st0, st1, arg))
+
+    switch (sg->kind)
+    {
+    case DBGARG_INT32:
+        return DBGSEG_PRINT((int) v);
+    case DBGARG_INT64:
+        return DBGSEG_PRINT((t_int64) v);
+    case DBGARG_DOUBLE:
+        {
+            double d;
+            memcpy(& d, & v, sizeof(d));
+            return DBGSEG_PRINT(d);
+        }
+    case DBGARG_PTR:
+        return DBGSEG_PRINT((void*) (size_t) v);
+    case DBGARG_STRING:
+        return DBGSEG_PRINT(strs + v);
+    default:
+        return snprintf(out, cap, sg->text, 0);
+    }
+
+#undef DBGSEG_PRINT
+}
+
+static void dbgring_emit(const dbgrec* rec)
+{
+    if (rec->kind == DBGREC_TEXT)
+    {
+        sim_debug_write(rec->dbits, rec->dptr, (const char*) (rec + 1), rec->len);
+        dbgring_texts++;
+        return;
+    }
+    if (rec->kind == DBGREC_U16)
+    {
+        sim_debug_write_u16(rec->dbits, rec->dptr, (const char*) (rec + 1), rec->len, rec->flags);
+        return;
+    }
+
+    static char* buf = NULL;
+    static size_t bufsize = 0;
+    const dbgfmt* f = rec->fmt;
+    const t_uint64* w = (const t_uint64*) (rec + 1);
+    const char* strs = (const char*) (w + rec->len);
+    size_t pos = 0;
+    int k;
+
+    if (buf == NULL)
+    {
+        bufsize = 2048;
+        if ((buf = (char*) malloc(bufsize)) == NULL)
+            panic("Unable to allocate memory");
+    }
+
+    for (k = 0;  k < f->nsegs;  k++)
+    {
+        const dbgfmt_seg* sg = & f->seg[k];
+        int n = dbgfmt_seg_print(buf + pos, bufsize - pos, sg, w, strs);
+        if (n < 0 || (size_t) n >= bufsize - pos)
+        {
+            /* grow buffer and redo the segment */
+            bufsize = 2 * bufsize + ((n > 0) ? n : 0);
+            if ((buf = (char*) realloc(buf, bufsize)) == NULL)
+                panic("Unable to allocate memory");
+            k--;
+            continue;
+        }
+        pos += n;
+        w += sg->nstar + (sg->kind != DBGARG_NONE);
+    }
+
+    sim_debug_write(rec->dbits, rec->dptr, buf, (int32) pos);
+    dbgring_events++;
+}
+
+/*
+ * Write out events recorded no later than cutoff, merging the rings of all threads by timestamp.
+ * Must be called with dbgring_drain_lock held.
+ */
+static void dbgring_drain(t_uint64 cutoff)
+{
+    for (;;)
+    {
+        dbgring* best = NULL;
+        const dbgrec* brec = NULL;
+        dbgring* r;
+
+        for (r = dbgring_list;  r;  r = r->next)
+        {
+            uint32 tail = r->tail;
+            const dbgrec* rec;
+
+            if (tail == r->head)
+                continue;
+            smp_rmb();
+            rec = (const dbgrec*) (r->buf + (tail & (DBGRING_SIZE - 1)));
+            if (rec->kind == DBGREC_PAD)
+            {
+                r->tail = tail + rec->size;
+                if (r->tail == r->head)
+                    continue;
+                smp_rmb();
+                rec = (const dbgrec*) r->buf;
+            }
+            if (rec->ts <= cutoff && (brec == NULL || rec->ts < brec->ts))
+            {
+                best = r;
+                brec = rec;
+            }
+        }
+
+        if (best == NULL)
+            break;
+
+        dbgring_emit(brec);
+        smp_mb();                                   /* done reading before releasing the space */
+        best->tail += brec->size;
+    }
+
+    for (dbgring* r = dbgring_list;  r;  r = r->next)
+    {
+        if (r->kicked && r->head - r->tail <= DBGRING_SIZE / 2)
+            r->kicked = FALSE;
+    }
+}
+
+static SMP_THREAD_ROUTINE_DECL dbgring_writer_main(void* arg)
+{
+    sim_try
+    {
+        smp_thread_init();
+
+        run_scope_context* rscx = new run_scope_context(NULL, SIM_THREAD_TYPE_IOP, dbgring_writer);
+        rscx->set_current();
+
+        smp_set_thread_priority(SIMH_THREAD_PRIORITY_IOP);
+        smp_set_thread_name("DBG_WRITER");
+
+        while (! dbgring_writer_stop)
+        {
+            /* a ring filling up is drained completely, otherwise young events are left for the next pass */
+            t_bool kicked = dbgring_wakeup->timed_wait(DBGRING_PERIOD, NULL);
+            dbgring_wakeup->clear();
+            dbgring_drain_lock->lock();
+            dbgring_drain(kicked ? dbgring_now() : dbgring_now() - DBGRING_HOLDBACK);
+            dbgring_drain_lock->unlock();
+        }
+    }
+    sim_catch (sim_exception_SimError, exc)
+    {
+        fprintf(smp_stderr, "\nFatal error in %s simulator, unexpected exception while executing debug writer thread\n", sim_name);
+        fprintf(smp_stderr, "Exception cause: %s\n", exc->get_message());
+        fprintf(smp_stderr, "Terminating the simulator abnormally...\n");
+        exit(1);
+    }
+    sim_end_try
+
+    SMP_THREAD_ROUTINE_END;
+}
+
+/******************************************************************************************
+*  Control, called by the console thread                                                  *
+******************************************************************************************/
+
+void sim_dbgring_start (void)
+{
+    if (sim_dbgring_active)
+        return;
+    if (dbgring_wakeup == NULL)
+        dbgring_wakeup = smp_event::create();
+    dbgring_wakeup->clear();
+    dbgring_events = dbgring_texts = 0;
+    dbgring_writer_stop = FALSE;
+    smp_create_thread(dbgring_writer_main, NULL, & dbgring_writer);
+    smp_wmb();
+    sim_dbgring_active = TRUE;
+}
+
+/*
+ * Write out everything recorded so far and revert to synchronous output.  Threads that are
+ * recording an event when deferred output is turned off are let to finish first, so their
+ * events make it into the final drain.
+ */
+void sim_dbgring_stop (void)
+{
+    dbgring* r;
+
+    if (! sim_dbgring_active)
+        return;
+    sim_dbgring_active = FALSE;
+    smp_mb();                                       /* pairs with dbgring_enter */
+    dbgring_list_lock->lock();
+    for (r = dbgring_list;  r;  r = r->next)
+    {
+        while (r->busy)
+            sim_os_ms_sleep(1);
+    }
+    dbgring_list_lock->unlock();
+
+    dbgring_writer_stop = TRUE;
+    dbgring_wakeup->set();
+    smp_wait_thread(dbgring_writer);
+    dbgring_drain_lock->lock();
+    dbgring_drain((t_uint64) -1);
+    dbgring_drain_lock->unlock();
+}
+
+/* Write out everything recorded so far */
+void sim_dbgring_flush (void)
+{
+    if (! sim_dbgring_active)
+        return;
+    dbgring_drain_lock->lock();
+    dbgring_drain((t_uint64) -1);
+    dbgring_drain_lock->unlock();
+}
+
+/* Called before writing to sim_deb directly (DEBUG_PRS etc.), always returns TRUE */
+t_bool sim_dbgring_direct (void)
+{
+    sim_dbgring_flush ();
+    return TRUE;
+}
+
+void sim_dbgring_show (SMP_FILE* st)
+{
+    uint32 stalls;
+    dbgring* r;
+
+    if (! sim_dbgring_active)
+        return;
+    dbgring_drain_lock->lock();
+    stalls = dbgring_exited_stalls;
+    for (r = dbgring_list;  r;  r = r->next)
+        stalls += r->stalls;
+    dbgring_drain_lock->unlock();
+    fprintf(st, "Debug output is deferred: %u events written, %u formatted by caller, %u waits for writer\n",
+                dbgring_events + dbgring_texts, dbgring_texts, stalls);
+}
@@ -223,6 +223,7 @@ class SMP_FILE
 public:
     FILE* stream;
     smp_file_critical_section* lock_cs;
+    int deferred;                       /* output may be deferred to the writer thread */
 };
 
 extern SMP_FILE* smp_stdin;
@@ -278,6 +279,10 @@ int smp_putchar(int c);
 SMP_FILE *smp_fopen(const char* filename, const char* mode);
 SMP_FILE *smp_fopen64(const char* filename, const char* mode);
 SMP_FILE *smp_file_wrap(FILE* fp);
+void smp_fileout_start();
+void smp_fileout_stop();
+void smp_fileout_flush();
+void smp_fileout_show(SMP_FILE* st);
 #if defined (__linux)
 int fseeko64(SMP_FILE *sfd, off64_t offset, int whence);
 off64_t ftello64(SMP_FILE *sfd);
@@ -440,6 +445,12 @@ static int32 SIM_INLINE imin(int32 a, int32 b)
 #define SIM_BKPT_N_SPC  64                              /* max number spaces */
 #define SIM_BKPT_V_SPC  26                              /* location in arg */
 
+/* Breakpoint page filter: types of breakpoints set in each (hashed) page */
+
+#define SIM_BRK_PG_SHIFT 9                              /* page size, log2 */
+#define SIM_BRK_PG_SLOTS 4096                           /* filter slots, power of 2 */
+#define SIM_BRK_PG_HASH(loc)  ((uint32) ((loc) >> SIM_BRK_PG_SHIFT) & (SIM_BRK_PG_SLOTS - 1))
+
 /* Extended switch definitions (bits >= 26) */
 
 #define SIM_SW_HIDE     (1u << 26)                      /* enable hiding */
@@ -1022,6 +1033,8 @@ struct sim_brktab
     int32               typ;                            /* mask of types */
     int32               cnt;                            /* proceed count */     
     char                *act;                           /* action string */
+    uint32              cpus;                           /* mask of VCPUs, 0 = any */
+    uint32              modes;                          /* mask of modes, 0 = any */
 };
 
 /* Debug table */
@@ -1032,10 +1045,11 @@ struct sim_debtab
     uint32              mask;                           /* control bit */
 };
 
-#define DEBUG_PRS(d)    (sim_deb && d.dctrl)
-#define DEBUG_PRD(d)    (sim_deb && d->dctrl)
-#define DEBUG_PRI(d,m)  (sim_deb && (d.dctrl & (m)))
-#define DEBUG_PRJ(d,m)  (sim_deb && (d->dctrl & (m)))
+/* for direct writes to sim_deb: write out deferred debug output first, to keep the log in order */
+#define DEBUG_PRS(d)    (sim_deb && d.dctrl && sim_dbgring_direct ())
+#define DEBUG_PRD(d)    (sim_deb && d->dctrl && sim_dbgring_direct ())
+#define DEBUG_PRI(d,m)  (sim_deb && (d.dctrl & (m)) && sim_dbgring_direct ())
+#define DEBUG_PRJ(d,m)  (sim_deb && (d->dctrl & (m)) && sim_dbgring_direct ())
 
 t_value reg_irdata_dev_rd(REG* r, uint32 idx);
 void reg_irdata_dev_wr(REG* r, uint32 idx, t_value value);
@@ -1292,6 +1306,9 @@ public:
     /* CPU cycles accrued */
     atomic_uint32_var                  cpu_adv_cycles;
 
+    /* performance counters, not cleared by reset or restored by RESTORE */
+    SIM_ALIGN_64   CPU_STATS           cpu_perf_stats;
+
     /* CPU context */
     SIM_ALIGN_32   CPU_CONTEXT         cpu_context;
 
@@ -1343,11 +1360,25 @@ public:
     uint32                             cpu_idle_sleep_us;                   /* usecs in voluntary sleep */
     uint32                             cpu_idle_sleep_cycles;               /* cycles in idle sleep */
 
-    /* SSC delta timers */
-    sim_delta_timer*                   cpu_ssc_delta_timer[2];
-
-    /* mask of active SSC clocks (accounts only for clocks sampled real time, not ROM tests) */
-    uint32                             sysd_active_mask;
+    /* throttle pacing (sim_throt_svc) */
+    uint32                             cpu_throt_state;                     /* 0 = measuring, 1 = pacing */
+    int32                              cpu_throt_wait;                      /* cycles between pacing checks */
+    uint32                             cpu_throt_cycles;                    /* cpu_adv_cycles at last check */
+    t_uint64                           cpu_throt_ns;                        /* host time at last check */
+    t_uint64                           cpu_throt_start_ns;                  /* host time at start of pacing */
+    double                             cpu_throt_debt_ns;                   /* host time owed to target rate */
+    double                             cpu_throt_acps;                      /* unthrottled cycles per second */
+    t_uint64                           cpu_throt_calib_ns;                  /* measurement: host time */
+    t_uint64                           cpu_throt_calib_cycles;              /* measurement: cycles */
+    t_uint64                           cpu_throt_total_cycles;              /* cycles since start of pacing */
+    t_uint64                           cpu_throt_slept_ns;                  /* host time in pacing sleeps */
+    uint32                             cpu_throt_sleeps;                    /* count of pacing sleeps */
+
+    /* SSC TMR0 sampled in real time (OpenVMS loop calibration) */
+    t_uint64                           cpu_ssc_rt_ns;                       /* host time of last sample */
+    uint32                             cpu_ssc_rt_cycles;                   /* cycle count at last sample */
+    t_uint64                           cpu_ssc_rt_elapsed;                  /* ns charged since timer start */
+    double                             cpu_ssc_rt_ns_per_cycle;             /* fastest execution rate seen */
 
     /* clock interrupt is being processed or pending */
     t_bool                             cpu_active_clk_interrupt;
@@ -1373,7 +1404,7 @@ public:
     t_bool                             cpu_redo_reevaluate_thread_priority;
 
     /* CPU thread and "run" gate */
-    smp_semaphore*                     cpu_run_gate;
+    smp_simple_semaphore*              cpu_run_gate;
     smp_thread_t                       cpu_thread;
     t_bool                             cpu_thread_created;
 
@@ -1462,11 +1493,6 @@ inline CPU_UNIT* CPU_UNIT::getBy(CPU_CONTEXT* ctxt)
 /* control VCPU thread priority if more than one VCPU is currently active and host is not a dedicated machine */
 #define must_control_prio()  (sim_mp_active && !sim_host_dedicated)
 
-static SIM_INLINE t_bool tmr_is_active(RUN_DECL)
-{
-    return 0 != cpu_unit->sysd_active_mask;
-}
-
 extern CPU_UNIT cpu_unit_0;
 extern CPU_UNIT* cpu_units[SIM_MAX_CPUS];
 extern UNIT* cpu_units_as_units[SIM_MAX_CPUS];
@@ -1737,17 +1763,19 @@ class on_init_tls : public on_init_call
 {
 protected:
     smp_tls_key* pkey;
+    smp_tls_dtor_t dtor;
 
     void invoke()
     {
-        if (! smp_tls_alloc(pkey))
+        if (! smp_tls_alloc(pkey, dtor))
             panic("Unable to initialize TLS variable");
     }
 
 public:
-    on_init_tls(smp_tls_key* pkey) : on_init_call(NULL)
+    on_init_tls(smp_tls_key* pkey, smp_tls_dtor_t dtor = NULL) : on_init_call(NULL)
     {
         this->pkey = pkey;
+        this->dtor = dtor;
     }
 };
 
@@ -1755,6 +1783,11 @@ public:
     static smp_tls_key key;                                    \
     static on_init_tls __oninit_tls_##key(& key)
 
+/* dtor (declared SMP_TLS_DTOR_DECL) is called on thread exit with the thread's value */
+#define AUTO_TLS_DTOR(key, dtor)                               \
+    static smp_tls_key key;                                    \
+    static on_init_tls __oninit_tls_##key(& key, dtor)
+
 #define ON_INIT_INVOKE(routine)                                \
     static on_init_call __oninit_call_##routine(routine)
 
@@ -1826,8 +1859,15 @@ extern t_bool sim_ws_settings_changed;
 extern t_bool sim_ws_lock;
 extern uint32 sim_ws_min;
 extern uint32 sim_ws_max;
+extern uint32 sim_ws_prefault;
 extern uint32 sim_host_turbo;
 extern t_bool sim_host_dedicated;
 extern uint32 use_native_interlocked;
 
+/* guest memory prefault modes (SET PREFAULT) */
+#define SIM_PREFAULT_NONE       0                       /* pages faulted in on first touch by VCPUs */
+#define SIM_PREFAULT_TOUCH      1                       /* pages faulted in before run by parallel threads */
+#define SIM_PREFAULT_POPULATE   2                       /* pages populated by host on allocation, then as TOUCH */
+#define SIM_PREFAULT_ADVISE     3                       /* host advised memory will be needed, no faulting */
+
 #endif
@@ -150,6 +150,25 @@
                       specified at open time.  This functionality is only 
                       available on *nix platforms since the vde api isn't 
                       available on Windows.
+  USE_PACKET_RING   - Specifies that device names of the form packet:eth0 can
+                      be used to capture directly from a Linux AF_PACKET 
+                      socket through a memory-mapped TPACKET_V3 ring, bypassing
+                      libpcap.  The reader thread receives whole blocks of 
+                      frames at once, filters them itself and inserts each 
+                      batch into the read queue with a single lock 
+                      acquisition.  Defined by default on Linux when 
+                      USE_READER_THREAD is in effect.
+  USE_SHM_NETWORK   - Specifies that device names of the form shm:name can be
+                      used to connect simulators running on the same host 
+                      through a POSIX shared memory segment (/vaxmp-eth-name)
+                      instead of through the host's network stack.  Every
+                      frame written to the segment is seen by every attached
+                      simulator, as on a single Ethernet cable, and each 
+                      receiver does its own address filtering.  No host 
+                      privileges are needed.  The segment persists after the
+                      simulators exit; remove /dev/shm/vaxmp-eth-name to 
+                      discard it.  Defined by default on *nix hosts when 
+                      USE_READER_THREAD is in effect.
 
   NEED_PCAP_SENDPACKET
                     - Specifies that you are using an older version of libpcap
@@ -458,12 +477,53 @@ static const uint32 crcTable[256] = {
   0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
 };
 
-uint32 eth_crc32(uint32 crc, const void* vbuf, size_t len)
-{
-  const uint32 mask = 0xFFFFFFFF;
-  const unsigned char* buf = (const unsigned char*)vbuf;
+/*
+   CRC32 computation.
+
+   eth_crc32 runs once per transmitted frame (when the device needs a CRC), once per
+   received multicast frame for the AUTODIN II hash filter, and on behalf of devices
+   that validate or generate frame check sequences.  Three implementations are kept
+   and the fastest one the host supports is selected at initialization:
+
+     - the original byte-at-a-time table walk (reference; also handles short tails);
+     - slicing-by-8, which consumes 8 bytes per step with eight derived tables
+       and is portable to any host;
+     - carry-less multiply folding (PCLMULQDQ) on x64 hosts whose CPUID reports
+       PCLMULQDQ and SSE4.1, which folds 64 bytes per step and Barrett-reduces
+       the result, as described in Intel's "Fast CRC Computation for Generic
+       Polynomials Using PCLMULQDQ Instruction".
+
+   All three produce bit-identical results.  At initialization the fast paths are
+   cross-checked against the reference over a range of lengths and alignments, and
+   any path that disagrees is not used.
+*/
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(_MSC_VER) || \
+                            (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || \
+                            defined(__clang__))
+#  define ETH_CRC32_CLMUL
+#  include <wmmintrin.h>
+#  include <smmintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#    define ETH_CLMUL_TARGET
+#  else
+#    include <cpuid.h>
+#    define ETH_CLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#  endif
+#endif
+
+#define ETH_CRC32_CLMUL_MIN  128                        /* shortest buffer worth folding */
+
+typedef uint32 (*eth_crc32_routine)(uint32 crc, const unsigned char* buf, size_t len);
+
+static uint32 crcSlice[8][256];                         /* slicing-by-8 tables, [0] == crcTable */
+static eth_crc32_routine eth_crc32_impl = NULL;         /* selected implementation */
+static const char* eth_crc32_impl_name = "table";
 
-  crc ^= mask;
+/* reference implementation; crc is the raw (pre-inverted) register */
+static uint32 eth_crc32_table(uint32 crc, const unsigned char* buf, size_t len)
+{
   while (len > 8) {
     crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
     crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
@@ -477,8 +537,447 @@ uint32 eth_crc32(uint32 crc, const void* vbuf, size_t len)
   }
   while (0 != len--)
     crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-  return(crc ^ mask);
+  return crc;
+}
+
+static uint32 eth_crc32_slice8(uint32 crc, const unsigned char* buf, size_t len)
+{
+  while (len >= 8) {
+    uint32 lo = crc ^ ((uint32) buf[0] | ((uint32) buf[1] << 8) | ((uint32) buf[2] << 16) | ((uint32) buf[3] << 24));
+    uint32 hi = (uint32) buf[4] | ((uint32) buf[5] << 8) | ((uint32) buf[6] << 16) | ((uint32) buf[7] << 24);
+    crc = crcSlice[7][lo & 0xFF] ^ crcSlice[6][(lo >> 8) & 0xFF] ^
+          crcSlice[5][(lo >> 16) & 0xFF] ^ crcSlice[4][lo >> 24] ^
+          crcSlice[3][hi & 0xFF] ^ crcSlice[2][(hi >> 8) & 0xFF] ^
+          crcSlice[1][(hi >> 16) & 0xFF] ^ crcSlice[0][hi >> 24];
+    buf += 8;
+    len -= 8;
+  }
+  while (0 != len--)
+    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
+  return crc;
+}
+
+#if defined(ETH_CRC32_CLMUL)
+/*
+ * Fold a buffer whose length is at least 64 and a multiple of 16.
+ * Constants are the bit-reflected x^n mod P(x) values for CRC-32 (IEEE 802.3).
+ */
+ETH_CLMUL_TARGET
+static uint32 eth_crc32_clmul_fold(uint32 crc, const unsigned char* buf, size_t len)
+{
+  __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+  x1 = _mm_loadu_si128((const __m128i*) (buf + 0x00));
+  x2 = _mm_loadu_si128((const __m128i*) (buf + 0x10));
+  x3 = _mm_loadu_si128((const __m128i*) (buf + 0x20));
+  x4 = _mm_loadu_si128((const __m128i*) (buf + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) crc));
+  x0 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL);          /* k2:k1, fold by 4 */
+  buf += 64;
+  len -= 64;
+
+  while (len >= 64) {
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+    x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+    y5 = _mm_loadu_si128((const __m128i*) (buf + 0x00));
+    y6 = _mm_loadu_si128((const __m128i*) (buf + 0x10));
+    y7 = _mm_loadu_si128((const __m128i*) (buf + 0x20));
+    y8 = _mm_loadu_si128((const __m128i*) (buf + 0x30));
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+    buf += 64;
+    len -= 64;
+  }
+
+  /* fold the four lanes into one */
+  x0 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL);          /* k4:k3, fold by 1 */
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+  x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+  x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+  while (len >= 16) {
+    x2 = _mm_loadu_si128((const __m128i*) buf);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    buf += 16;
+    len -= 16;
+  }
+
+  /* 128 -> 64 bits */
+  x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+  x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+  x1 = _mm_srli_si128(x1, 8);
+  x1 = _mm_xor_si128(x1, x2);
+  x0 = _mm_set_epi64x(0, 0x0163CD6124LL);                       /* k5 */
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, x3);
+  x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  /* Barrett reduction to 32 bits */
+  x0 = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL);          /* mu':P' */
+  x2 = _mm_and_si128(x1, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+  x2 = _mm_and_si128(x2, x3);
+  x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return (uint32) _mm_extract_epi32(x1, 1);
+}
+
+static uint32 eth_crc32_clmul(uint32 crc, const unsigned char* buf, size_t len)
+{
+  if (len >= ETH_CRC32_CLMUL_MIN) {
+    size_t chunk = len & ~(size_t) 15;
+    crc = eth_crc32_clmul_fold(crc, buf, chunk);
+    buf += chunk;
+    len -= chunk;
+  }
+  return eth_crc32_slice8(crc, buf, len);
+}
+
+static t_bool eth_crc32_have_clmul()
+{
+  unsigned int ecx;
+#  if defined(_MSC_VER)
+  int regs[4];
+  __cpuid(regs, 0);
+  if (regs[0] < 1)  return FALSE;
+  __cpuid(regs, 1);
+  ecx = (unsigned int) regs[2];
+#  else
+  unsigned int eax, ebx, edx;
+  if (! __get_cpuid(1, &eax, &ebx, &ecx, &edx))  return FALSE;
+#  endif
+  return (ecx & (1 << 1)) && (ecx & (1 << 19));    /* PCLMULQDQ, SSE4.1 */
+}
+#endif
+
+/* compare an implementation against the reference over assorted lengths and alignments */
+static t_bool eth_crc32_selfcheck(eth_crc32_routine routine)
+{
+  static const size_t lengths[] = { 0, 1, 6, 7, 8, 9, 15, 16, 17, 60, 63, 64, 65, 127, 128, 129,
+                                    191, 200, 255, 256, 257, 1000, 1514, 1518, 4096, 9018 };
+  const size_t maxlen = 9018 + 16;
+  unsigned char* buf = (unsigned char*) malloc(maxlen);
+  uint32 seed = 0x2545F491;
+  t_bool ok = TRUE;
+  size_t k, i;
+  uint32 off;
+
+  if (buf == NULL)
+    return FALSE;
+  for (k = 0; k < maxlen; k++) {
+    seed = seed * 1103515245 + 12345;
+    buf[k] = (unsigned char) (seed >> 16);
+  }
+  for (i = 0; ok && i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    for (off = 0; ok && off < 16; off += 3) {
+      uint32 crc0 = (uint32) (i * 0x9E3779B9);
+      if (eth_crc32_table(crc0, buf + off, lengths[i]) != (*routine)(crc0, buf + off, lengths[i]))
+        ok = FALSE;
+    }
+  }
+  free(buf);
+  return ok;
+}
+
+/* a fast path that disagrees with the reference indicates a build or host CPU defect: report it */
+static void eth_crc32_selfcheck_failed(const char* name)
+{
+  smp_printf ("Eth: %s CRC32 failed self-check against the reference table and is disabled\n", name);
+}
+
+static void eth_crc32_init()
+{
+  int k, n;
+
+  for (n = 0; n < 256; n++)
+    crcSlice[0][n] = crcTable[n];
+  for (k = 1; k < 8; k++)
+    for (n = 0; n < 256; n++)
+      crcSlice[k][n] = (crcSlice[k - 1][n] >> 8) ^ crcTable[crcSlice[k - 1][n] & 0xFF];
+
+  eth_crc32_impl = eth_crc32_table;
+  eth_crc32_impl_name = "table";
+
+  if (eth_crc32_selfcheck(eth_crc32_slice8)) {
+    eth_crc32_impl = eth_crc32_slice8;
+    eth_crc32_impl_name = "slicing-by-8";
+  }
+  else
+    eth_crc32_selfcheck_failed("slicing-by-8");
+
+#if defined(ETH_CRC32_CLMUL)
+  if (eth_crc32_impl == eth_crc32_slice8 && eth_crc32_have_clmul()) {
+    if (eth_crc32_selfcheck(eth_crc32_clmul)) {
+      eth_crc32_impl = eth_crc32_clmul;
+      eth_crc32_impl_name = "PCLMULQDQ";
+    }
+    else
+      eth_crc32_selfcheck_failed("PCLMULQDQ");
+  }
+#endif
+}
+
+static on_init_call eth_crc32_init_call(eth_crc32_init);
+
+uint32 eth_crc32(uint32 crc, const void* vbuf, size_t len)
+{
+  const uint32 mask = 0xFFFFFFFF;
+  eth_crc32_routine routine = eth_crc32_impl;
+
+  if (unlikely(routine == NULL))
+    routine = eth_crc32_table;                          /* called before initialization */
+  return (*routine)(crc ^ mask, (const unsigned char*) vbuf, len) ^ mask;
+}
+
+const char* eth_crc32_method()
+{
+  return eth_crc32_impl_name;
+}
+
+/* AUTODIN II multicast hash filter lookup through the per-device hash cache */
+static int
+_eth_hash_lookup(ETH_DEV* dev, const u_char* data)
+{
+struct eth_hash_cache* hc = &dev->hash_cache[(data[3] ^ data[4] ^ (data[5] << 1) ^ (data[5] >> 4)) & (ETH_HASH_CACHE_SIZE - 1)];
+int key;
+
+if (memcmp(hc->mac, data, 6) == 0) {
+  key = hc->key;
+  dev->hash_cache_hits++;
+  }
+else {
+  key = 0x3f & (eth_crc32(0, data, 6) >> 26);
+  key ^= 0x3f;
+  memcpy(hc->mac, data, 6);
+  hc->key = (uint8) key;
+  dev->hash_cache_misses++;
+  }
+return (dev->hash[key>>3] & (1 << (key&0x7)));
+}
+
+#if defined(ETH_TEST_MAIN)
+/*
+   Ethernet test executable (built with ETH_TEST_MAIN, see scp.cpp).
+
+   Every CRC32 implementation is checked against published CRC-32 check values
+   and against a bit-at-a-time reference for all lengths 0..2048 at 16 buffer
+   alignments, whole and continued across a split.  The multicast hash filter
+   is checked for members and non-members, on cache misses, cache hits and
+   after a cache entry has been evicted.
+*/
+
+/* independent reference, one bit at a time, same convention as eth_crc32 */
+static uint32 eth_test_crc32_bitwise(uint32 crc, const unsigned char* buf, size_t len)
+{
+  int k;
+
+  crc = ~crc;
+  while (0 != len--) {
+    crc ^= *buf++;
+    for (k = 0; k < 8; k++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+static uint32 eth_test_crc32_call(eth_crc32_routine routine, uint32 crc, const unsigned char* buf, size_t len)
+{
+  return (*routine)(crc ^ 0xFFFFFFFF, buf, len) ^ 0xFFFFFFFF;
+}
+
+static t_bool eth_test_crc32(const char* name, eth_crc32_routine routine)
+{
+  static const struct {
+    const char* text;
+    uint32 crc;
+  } vectors[] = {
+    { "",                                                                                 0x00000000 },
+    { "a",                                                                                0xE8B7BE43 },
+    { "abc",                                                                              0x352441C2 },
+    { "123456789",                                                                        0xCBF43926 },
+    { "message digest",                                                                   0x20159D7F },
+    { "abcdefghijklmnopqrstuvwxyz",                                                       0x4C2750BD },
+    { "The quick brown fox jumps over the lazy dog",                                      0x414FA339 },
+    { "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",                   0x1FC2E6D2 },
+    { "12345678901234567890123456789012345678901234567890123456789012345678901234567890", 0x7CA94A72 }
+  };
+  static const struct {
+    int fill;                                           /* byte value, -1 for 00 01 02 ... */
+    uint32 crc;
+  } blocks[] = {
+    { 0x00, 0xF1E8BA9E },
+    { 0xFF, 0x3F55D17F },
+    { -1,   0x9F5EDD58 }
+  };
+  const size_t maxlen = 2048;
+  unsigned char* buf = (unsigned char*) malloc(maxlen + 16);
+  uint32 seed = 0x2545F491;
+  uint32 crc, ref;
+  size_t i, len, split;
+  uint32 off;
+  int errors = 0;
+
+  if (buf == NULL) {
+    smp_printf ("Eth test: out of memory\n");
+    return FALSE;
+  }
+
+  /* published check values; the 2 KB blocks go through the folding path */
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    len = strlen(vectors[i].text);
+    memcpy(buf + 1, vectors[i].text, len);
+    if ((crc = eth_test_crc32_call(routine, 0, buf + 1, len)) != vectors[i].crc && errors++ < 10)
+      smp_printf ("Eth test: %s CRC32 of \"%s\" is %08X, expected %08X\n", name, vectors[i].text, crc, vectors[i].crc);
+  }
+  for (i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+    for (len = 0; len < maxlen; len++)
+      buf[len] = (unsigned char) ((blocks[i].fill < 0) ? len : blocks[i].fill);
+    if ((crc = eth_test_crc32_call(routine, 0, buf, maxlen)) != blocks[i].crc && errors++ < 10)
+      smp_printf ("Eth test: %s CRC32 of %d bytes of %02X is %08X, expected %08X\n",
+                  name, (int) maxlen, blocks[i].fill & 0xFF, crc, blocks[i].crc);
+  }
+
+  /* all lengths at all alignments, whole and continued across a split */
+  for (len = 0; len < maxlen + 16; len++) {
+    seed = seed * 1103515245 + 12345;
+    buf[len] = (unsigned char) (seed >> 16);
+  }
+  for (len = 0; len <= maxlen; len++) {
+    for (off = 0; off < 16; off++) {
+      ref = eth_test_crc32_bitwise(0, buf + off, len);
+      if ((crc = eth_test_crc32_call(routine, 0, buf + off, len)) != ref && errors++ < 10)
+        smp_printf ("Eth test: %s CRC32 of %d bytes at offset %d is %08X, expected %08X\n",
+                    name, (int) len, off, crc, ref);
+      split = (len * 7 + off) / 16;
+      crc = eth_test_crc32_call(routine, 0, buf + off, split);
+      if ((crc = eth_test_crc32_call(routine, crc, buf + off + split, len - split)) != ref && errors++ < 10)
+        smp_printf ("Eth test: %s CRC32 of %d bytes at offset %d split at %d is %08X, expected %08X\n",
+                    name, (int) len, off, (int) split, crc, ref);
+    }
+  }
+
+  free(buf);
+  smp_printf ("Eth test: %s CRC32 %s\n", name, errors ? "FAILED" : "passed");
+  return errors == 0;
+}
+
+static t_bool eth_test_hash_lookup()
+{
+  /* multicast addresses and the filter hash a DEQNA/DELQA driver would load for them */
+  static const ETH_MAC members[] = {
+    {0xAB, 0x00, 0x04, 0x01, 0xAC, 0x10},
+    {0xAB, 0x00, 0x00, 0x04, 0x00, 0x00},
+    {0x09, 0x00, 0x2B, 0x00, 0x00, 0x0F},
+    {0x09, 0x00, 0x2B, 0x02, 0x01, 0x04},
+    {0x09, 0x00, 0x2B, 0x02, 0x01, 0x07},
+    {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+    {0x01, 0x00, 0x5E, 0x00, 0x00, 0x01}};
+  static const ETH_MULTIHASH hash = {0x01, 0x40, 0x00, 0x00, 0x48, 0x88, 0x40, 0x00};
+  /* addresses whose hash bits are clear; the first shares its cache entry with members[2],
+     the others use cache entries of their own */
+  static const ETH_MAC others[] = {
+    {0x09, 0x00, 0x2B, 0x01, 0x01, 0x0F},
+    {0x01, 0x00, 0x5E, 0x00, 0x00, 0xFB},
+    {0x09, 0x00, 0x2B, 0x00, 0x00, 0x04},
+    {0xAB, 0x00, 0x00, 0x03, 0x00, 0x00},
+    {0x01, 0x00, 0x5E, 0x7F, 0xFF, 0xFA}};
+  const int nmembers = sizeof(members) / sizeof(members[0]);
+  const int nothers = sizeof(others) / sizeof(others[0]);
+  ETH_DEV* dev = (ETH_DEV*) calloc(1, sizeof(ETH_DEV));
+  uint32 hits, misses;
+  int errors = 0;
+  int pass, i;
+
+  if (dev == NULL) {
+    smp_printf ("Eth test: out of memory\n");
+    return FALSE;
+  }
+  memcpy(dev->hash, hash, sizeof(hash));
+
+#define ETH_TEST_CHECK(cond, mac)                                                           \
+  if (!(cond)) {                                                                            \
+    smp_printf ("Eth test: hash lookup of %02X-%02X-%02X-%02X-%02X-%02X failed: %s\n",      \
+                mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], #cond);                     \
+    errors++;                                                                               \
+  }
+
+  /* the first pass fills the cache, the second one hits it except where entries were evicted */
+  for (pass = 0; pass < 2; pass++) {
+    for (i = 0; i < nmembers; i++) {
+      hits = dev->hash_cache_hits;
+      misses = dev->hash_cache_misses;
+      ETH_TEST_CHECK(_eth_hash_lookup(dev, members[i]) != 0, members[i]);
+      ETH_TEST_CHECK(dev->hash_cache_hits == hits + pass, members[i]);
+      ETH_TEST_CHECK(dev->hash_cache_misses == misses + 1 - pass, members[i]);
+    }
+    for (i = 0; i < nothers; i++) {
+      hits = dev->hash_cache_hits;
+      misses = dev->hash_cache_misses;
+      ETH_TEST_CHECK(_eth_hash_lookup(dev, others[i]) == 0, others[i]);
+      if (pass == 0 || i == 0) {                        /* others[0] and members[2] evict each other */
+        ETH_TEST_CHECK(dev->hash_cache_misses == misses + 1, others[i]);
+        }
+      else {
+        ETH_TEST_CHECK(dev->hash_cache_hits == hits + 1, others[i]);
+        }
+    }
+    /* look members[2] up again after its eviction */
+    misses = dev->hash_cache_misses;
+    ETH_TEST_CHECK(_eth_hash_lookup(dev, members[2]) != 0, members[2]);
+    ETH_TEST_CHECK(dev->hash_cache_misses == misses + 1, members[2]);
+  }
+
+  /* the cache holds hash bit indexes, not results, so a new filter takes effect at once */
+  memset(dev->hash, 0, sizeof(dev->hash));
+  for (i = 0; i < nmembers; i++)
+    ETH_TEST_CHECK(_eth_hash_lookup(dev, members[i]) == 0, members[i]);
+
+#undef ETH_TEST_CHECK
+
+  free(dev);
+  smp_printf ("Eth test: multicast hash lookup %s\n", errors ? "FAILED" : "passed");
+  return errors == 0;
+}
+
+/* Run the tests, returns SCPE_OK if all of them pass */
+t_stat eth_test (void)
+{
+  t_bool ok = TRUE;
+
+  smp_printf ("Eth test: CRC32 method in use is %s\n", eth_crc32_method());
+  ok &= eth_test_crc32("table", eth_crc32_table);
+  ok &= eth_test_crc32("slicing-by-8", eth_crc32_slice8);
+#if defined(ETH_CRC32_CLMUL)
+  if (eth_crc32_have_clmul())
+    ok &= eth_test_crc32("PCLMULQDQ", eth_crc32_clmul);
+  else
+    smp_printf ("Eth test: PCLMULQDQ CRC32 skipped, not supported by the host CPU\n");
+#else
+  smp_printf ("Eth test: PCLMULQDQ CRC32 skipped, not built for this host\n");
+#endif
+  ok &= eth_test_hash_lookup();
+
+  return ok ? SCPE_OK : SCPE_IERR;
 }
+#endif
 
 int eth_get_packet_crc32_data(const uint8 *msg, int len, uint8 *crcdata)
 {
@@ -833,6 +1332,26 @@ void eth_show_dev (SMP_FILE* st, ETH_DEV* dev)
 #  include <libvdeplug.h>
 #endif /* USE_VDE_NETWORK */
 
+#ifdef USE_PACKET_RING
+#  include <sys/socket.h>
+#  include <sys/mman.h>
+#  include <net/if.h>
+#  include <arpa/inet.h>
+#  include <linux/if_packet.h>
+#  include <linux/if_ether.h>
+#endif /* USE_PACKET_RING */
+
+#ifdef USE_SHM_NETWORK
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  if defined(__linux)
+#    include <limits.h>
+#    include <sys/syscall.h>
+#    include <linux/futex.h>
+#  endif
+#endif /* USE_SHM_NETWORK */
+
 /* Allows windows to look up user-defined adapter names */
 #if defined(_WIN32)
 #  include <winreg.h>
@@ -1399,7 +1918,7 @@ static void eth_get_nic_hw_addr(ETH_DEV* dev, char *devname)
               NULL
         };
 
-        if (0 == strncmp("vde:", devname, 4))
+        if ((0 == strncmp("vde:", devname, 4)) || (0 == strncmp("shm:", devname, 4)))
             return;
         memset(command, 0, sizeof(command));
         for (i = 0;  patterns[i] && 0 == dev->have_host_nic_phy_addr; ++i)
@@ -1458,6 +1977,447 @@ _eth_write(ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine);
 
 #if defined(USE_READER_THREAD)
 
+/* Move frames accumulated by the reader thread into the read queue */
+static void
+_eth_batch_flush(ETH_DEV* dev)
+{
+struct eth_batch* batch = dev->rx_batch;
+int i;
+
+if (batch->count == 0)
+  return;
+dev->lock->lock();
+for (i = 0; i < batch->count; i++) {
+  struct eth_batch_item* bi = &batch->item[i];
+  ethq_insert_data(&dev->read_queue, 2, bi->data, 0, bi->len, bi->crc_len, bi->crc_data, 0);
+  }
+dev->lock->unlock();
+dev->rx_batches++;
+dev->rx_batched += batch->count;
+if ((uint32) batch->count > dev->rx_batch_peak)
+  dev->rx_batch_peak = batch->count;
+batch->count = 0;
+}
+
+/* Read all frames available from a tap or vde device into the batch arena */
+static int
+_eth_read_batch(ETH_DEV* dev)
+{
+struct eth_batch* batch = dev->rx_batch;
+struct pcap_pkthdr header;
+size_t off = 0;
+int len, status = 0;
+
+memset(&header, 0, sizeof(header));
+batch->hold = TRUE;
+while (off + ETH_MAX_JUMBO_FRAME <= ETH_BATCH_ARENA) {
+  switch (dev->eth_api) {
+#ifdef USE_TAP_NETWORK
+    case ETH_API_TAP:
+      len = read(dev->fd_handle, batch->arena + off, ETH_MAX_JUMBO_FRAME);
+      break;
+#endif /* USE_TAP_NETWORK */
+#ifdef USE_VDE_NETWORK
+    case ETH_API_VDE:
+      len = vde_recv((VDECONN *)dev->handle, batch->arena + off, ETH_MAX_JUMBO_FRAME, MSG_DONTWAIT);
+      break;
+#endif /* USE_VDE_NETWORK */
+    default:
+      len = 0;
+      break;
+    }
+  if (len <= 0)
+    break;
+  status = 1;
+  header.caplen = header.len = len;
+  _eth_callback((u_char *)dev, &header, batch->arena + off);
+  off += len;
+  }
+_eth_batch_flush(dev);
+batch->hold = FALSE;
+return status;
+}
+
+#if defined(USE_PACKET_RING)
+
+#define ETH_RING_BLOCK_SIZE  (1 << 18)                  /* 256 KB per block */
+#define ETH_RING_BLOCKS      16
+#define ETH_RING_FRAME_SIZE  2048
+#define ETH_RING_BLOCK_TMO   2                          /* msec before partly filled block is handed over */
+
+static int
+_eth_ring_open(ETH_DEV* dev, const char* ifname, char* errbuf, size_t errsize)
+{
+struct tpacket_req3 req;
+struct sockaddr_ll sll;
+struct packet_mreq mr;
+int fd, ver = TPACKET_V3;
+unsigned int ifindex;
+void* ring;
+
+if (0 == (ifindex = if_nametoindex(ifname))) {
+  strncpy(errbuf, strerror(errno), errsize-1);
+  return -1;
+  }
+if ((fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL))) < 0) {
+  strncpy(errbuf, strerror(errno), errsize-1);
+  return -1;
+  }
+memset(&req, 0, sizeof(req));
+req.tp_block_size = ETH_RING_BLOCK_SIZE;
+req.tp_block_nr = ETH_RING_BLOCKS;
+req.tp_frame_size = ETH_RING_FRAME_SIZE;
+req.tp_frame_nr = (ETH_RING_BLOCK_SIZE / ETH_RING_FRAME_SIZE) * ETH_RING_BLOCKS;
+req.tp_retire_blk_tov = ETH_RING_BLOCK_TMO;
+memset(&sll, 0, sizeof(sll));
+sll.sll_family = AF_PACKET;
+sll.sll_protocol = htons(ETH_P_ALL);
+sll.sll_ifindex = ifindex;
+memset(&mr, 0, sizeof(mr));
+mr.mr_ifindex = ifindex;
+mr.mr_type = PACKET_MR_PROMISC;
+if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof(ver)) ||
+    setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) ||
+    MAP_FAILED == (ring = mmap(NULL, (size_t) ETH_RING_BLOCK_SIZE * ETH_RING_BLOCKS, 
+                               PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0))) {
+  strncpy(errbuf, strerror(errno), errsize-1);
+  close(fd);
+  return -1;
+  }
+if (bind(fd, (struct sockaddr *) &sll, sizeof(sll)) ||
+    setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mr, sizeof(mr))) {
+  strncpy(errbuf, strerror(errno), errsize-1);
+  munmap(ring, (size_t) ETH_RING_BLOCK_SIZE * ETH_RING_BLOCKS);
+  close(fd);
+  return -1;
+  }
+dev->rx_ring = (uint8*) ring;
+dev->rx_ring_size = (size_t) ETH_RING_BLOCK_SIZE * ETH_RING_BLOCKS;
+dev->rx_ring_blocks = ETH_RING_BLOCKS;
+dev->rx_ring_block_size = ETH_RING_BLOCK_SIZE;
+dev->rx_ring_next = 0;
+dev->fd_handle = fd;
+return 0;
+}
+
+static void
+_eth_ring_close(ETH_DEV* dev, int fd)
+{
+munmap(dev->rx_ring, dev->rx_ring_size);
+dev->rx_ring = NULL;
+close(fd);
+}
+
+/* Accumulate frames dropped by the kernel because the ring was full */
+static void
+_eth_ring_stats(ETH_DEV* dev)
+{
+struct tpacket_stats_v3 st;
+socklen_t len = sizeof(st);
+
+if (dev->fd_handle && 0 == getsockopt(dev->fd_handle, SOL_PACKET, PACKET_STATISTICS, &st, &len))
+  dev->rx_host_drops += st.tp_drops;
+}
+
+/* Process every block the kernel has handed over, one batch per block */
+static int
+_eth_ring_read(ETH_DEV* dev)
+{
+struct eth_batch* batch = dev->rx_batch;
+struct pcap_pkthdr header;
+int status = 0;
+
+memset(&header, 0, sizeof(header));
+for (;;) {
+  struct tpacket_block_desc* bd = (struct tpacket_block_desc*) (dev->rx_ring + (size_t) dev->rx_ring_next * dev->rx_ring_block_size);
+  struct tpacket3_hdr* ppd;
+  uint32 i, n;
+
+  if (0 == (bd->hdr.bh1.block_status & TP_STATUS_USER))
+    break;
+  smp_rmb();
+  n = bd->hdr.bh1.num_pkts;
+  ppd = (struct tpacket3_hdr*) ((uint8*) bd + bd->hdr.bh1.offset_to_first_pkt);
+  batch->hold = TRUE;
+  for (i = 0; i < n; i++) {
+    struct sockaddr_ll* sll = (struct sockaddr_ll*) ((uint8*) ppd + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+    if (sll->sll_pkttype != PACKET_OUTGOING) {    /* skip our own transmissions */
+      header.caplen = ppd->tp_snaplen;
+      header.len = ppd->tp_len;
+      _eth_callback((u_char *)dev, &header, (uint8*) ppd + ppd->tp_mac);
+      status = 1;
+      }
+    ppd = (struct tpacket3_hdr*) ((uint8*) ppd + ppd->tp_next_offset);
+    }
+  _eth_batch_flush(dev);
+  batch->hold = FALSE;
+  smp_mb();
+  bd->hdr.bh1.block_status = TP_STATUS_KERNEL;    /* hand block back to kernel */
+  dev->rx_ring_next = (dev->rx_ring_next + 1) % dev->rx_ring_blocks;
+  }
+return status;
+}
+
+#endif /* USE_PACKET_RING */
+
+#if defined(USE_SHM_NETWORK)
+
+/*
+ * Layout of the shared memory segment behind shm: devices.  A sender claims
+ * the next ticket from head, copies its frame into the slot the ticket selects
+ * and publishes it by storing ticket + 1 into the slot's seq.  Each receiver
+ * follows the ring with its own ticket.  A receiver that falls more than a ring
+ * behind loses the overwritten frames and counts them as host capture loss.
+ * Receivers with nothing to do spin briefly and then sleep on the wake futex,
+ * which senders only signal when somebody is actually asleep.
+ */
+#define ETH_SHM_MAGIC        0x45534D56                 /* segment initialized */
+#define ETH_SHM_VERSION      1
+#define ETH_SHM_SLOTS        1024                       /* ring size, must be a power of two */
+#define ETH_SHM_SLOT_SIZE    1536
+#define ETH_SHM_SPIN         2000                       /* polls before a receiver goes to sleep */
+#define ETH_SHM_PREFIX       "/vaxmp-eth-"
+
+struct eth_shm_slot {
+  volatile uint32 seq;                                  /* ticket + 1 once published, 0 while being written */
+  uint32        len;                                    /* frame length */
+  uint32        sender;                                 /* attachment id of the sender */
+  uint32        reserved;
+  uint8         data[ETH_SHM_SLOT_SIZE - 4 * sizeof(uint32)];
+};
+
+struct eth_shm_hdr {
+  volatile uint32 magic;                                /* stored last by the creator */
+  uint32        version;
+  uint32        slots;
+  uint32        slot_size;
+  smp_interlocked_uint32_var attach;                    /* attachment id generator */
+  smp_interlocked_uint32_var head;                      /* next ticket to hand out */
+  smp_interlocked_uint32_var wake;                      /* futex word, bumped on every publish */
+  smp_interlocked_uint32_var waiters;                   /* receivers asleep on wake */
+  struct eth_shm_slot slot[ETH_SHM_SLOTS];
+};
+
+static int
+_eth_shm_open(ETH_DEV* dev, const char* name, char* errbuf, size_t errsize)
+{
+char path[256];
+struct eth_shm_hdr* hdr;
+struct stat st;
+int fd, i;
+t_bool created = TRUE;
+
+if ((*name == 0) || strchr(name, '/') || (strlen(name) + sizeof(ETH_SHM_PREFIX) > sizeof(path))) {
+  strncpy(errbuf, "Invalid shared memory segment name", errsize-1);
+  return -1;
+  }
+sprintf(path, "%s%s", ETH_SHM_PREFIX, name);
+fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0660);
+if ((fd < 0) && (errno == EEXIST)) {
+  created = FALSE;
+  fd = shm_open(path, O_RDWR, 0);
+  }
+if (fd < 0) {
+  strncpy(errbuf, strerror(errno), errsize-1);
+  return -1;
+  }
+if (created && ftruncate(fd, sizeof(struct eth_shm_hdr))) {
+  strncpy(errbuf, strerror(errno), errsize-1);
+  shm_unlink(path);
+  close(fd);
+  return -1;
+  }
+/* another simulator may still be creating the segment */
+for (i = 0; ; i++) {
+  if (fstat(fd, &st)) {
+    strncpy(errbuf, strerror(errno), errsize-1);
+    close(fd);
+    return -1;
+    }
+  if (st.st_size != 0)
+    break;
+  if (i == 1000) {
+    strncpy(errbuf, "Shared memory segment was never initialized", errsize-1);
+    close(fd);
+    return -1;
+    }
+  usleep(1000);
+  }
+if (st.st_size != sizeof(struct eth_shm_hdr)) {
+  strncpy(errbuf, "Shared memory segment has incompatible layout", errsize-1);
+  close(fd);
+  return -1;
+  }
+hdr = (struct eth_shm_hdr*) mmap(NULL, sizeof(struct eth_shm_hdr), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+close(fd);
+if (hdr == (struct eth_shm_hdr*) MAP_FAILED) {
+  strncpy(errbuf, strerror(errno), errsize-1);
+  return -1;
+  }
+if (created) {
+  hdr->version = ETH_SHM_VERSION;
+  hdr->slots = ETH_SHM_SLOTS;
+  hdr->slot_size = sizeof(struct eth_shm_slot);
+  smp_wmb();
+  hdr->magic = ETH_SHM_MAGIC;
+  }
+else {
+  for (i = 0; (hdr->magic != ETH_SHM_MAGIC) && (i < 1000); i++)
+    usleep(1000);
+  smp_rmb();
+  if ((hdr->magic != ETH_SHM_MAGIC) || (hdr->version != ETH_SHM_VERSION) ||
+      (hdr->slots != ETH_SHM_SLOTS) || (hdr->slot_size != sizeof(struct eth_shm_slot))) {
+    strncpy(errbuf, "Shared memory segment has incompatible layout", errsize-1);
+    munmap(hdr, sizeof(struct eth_shm_hdr));
+    return -1;
+    }
+  }
+dev->shm = hdr;
+dev->shm_id = smp_interlocked_increment(&smp_var(hdr->attach));
+dev->shm_next = smp_var(hdr->head);
+return 0;
+}
+
+/* Nudge receivers sleeping on the segment (ours included) */
+static void
+_eth_shm_wakeup(ETH_DEV* dev)
+{
+struct eth_shm_hdr* hdr = dev->shm;
+
+smp_interlocked_increment(&smp_var(hdr->wake));
+#if defined(__linux)
+if (smp_var(hdr->waiters))
+  syscall(SYS_futex, &smp_var(hdr->wake), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+static void
+_eth_shm_close(ETH_DEV* dev)
+{
+munmap(dev->shm, sizeof(struct eth_shm_hdr));
+dev->shm = NULL;
+}
+
+static int
+_eth_shm_write(ETH_DEV* dev, const uint8* msg, int len)
+{
+struct eth_shm_hdr* hdr = dev->shm;
+struct eth_shm_slot* slot;
+uint32 ticket;
+
+if ((len <= 0) || (len > (int) sizeof(slot->data)))
+  return -1;
+ticket = smp_interlocked_increment(&smp_var(hdr->head)) - 1;
+slot = &hdr->slot[ticket & (ETH_SHM_SLOTS - 1)];
+slot->seq = 0;
+smp_wmb();
+slot->len = len;
+slot->sender = dev->shm_id;
+memcpy(slot->data, msg, len);
+smp_wmb();
+slot->seq = ticket + 1;
+_eth_shm_wakeup(dev);
+return 0;
+}
+
+/* Is there a frame to receive, or a stalled slot to skip? */
+static t_bool
+_eth_shm_ready(ETH_DEV* dev)
+{
+struct eth_shm_hdr* hdr = dev->shm;
+uint32 next = dev->shm_next;
+uint32 behind = smp_var(hdr->head) - next;
+
+return (behind != 0) && 
+       ((hdr->slot[next & (ETH_SHM_SLOTS - 1)].seq == next + 1) || (behind > ETH_SHM_SLOTS / 2));
+}
+
+/* Wait up to msec for frames to arrive; returns TRUE if there is something to receive */
+static t_bool
+_eth_shm_wait(ETH_DEV* dev, int msec)
+{
+struct eth_shm_hdr* hdr = dev->shm;
+int i;
+
+for (i = 0; i < ETH_SHM_SPIN; i++) {
+  if (_eth_shm_ready(dev))
+    return TRUE;
+  smp_cpu_relax();
+  }
+#if defined(__linux)
+if (1) {
+  struct timespec ts;
+  uint32 wake = smp_var(hdr->wake);
+
+  ts.tv_sec = msec / 1000;
+  ts.tv_nsec = (msec % 1000) * 1000000;
+  smp_interlocked_increment(&smp_var(hdr->waiters));
+  if (dev->handle && !_eth_shm_ready(dev))
+    syscall(SYS_futex, &smp_var(hdr->wake), FUTEX_WAIT, wake, &ts, NULL, 0);
+  smp_interlocked_decrement(&smp_var(hdr->waiters));
+  }
+#else
+usleep(1000);
+#endif
+return _eth_shm_ready(dev);
+}
+
+/* Receive every frame published since the last call, handing them over in batches */
+static int
+_eth_shm_read(ETH_DEV* dev)
+{
+struct eth_shm_hdr* hdr = dev->shm;
+struct eth_batch* batch = dev->rx_batch;
+struct pcap_pkthdr header;
+size_t off = 0;
+int status = 0;
+
+memset(&header, 0, sizeof(header));
+batch->hold = TRUE;
+while (off + ETH_SHM_SLOT_SIZE <= ETH_BATCH_ARENA) {
+  uint32 next = dev->shm_next;
+  uint32 behind = smp_var(hdr->head) - next;
+  struct eth_shm_slot* slot = &hdr->slot[next & (ETH_SHM_SLOTS - 1)];
+  uint32 seq = slot->seq;
+  uint32 len, sender;
+
+  if (seq != next + 1) {
+    if (behind >= ETH_SHM_SLOTS) {                  /* lapped: resume half a ring behind the senders */
+      dev->rx_host_drops += behind - ETH_SHM_SLOTS / 2;
+      dev->shm_next = next + behind - ETH_SHM_SLOTS / 2;
+      continue;
+      }
+    if (behind > ETH_SHM_SLOTS / 2) {               /* sender died in the middle of a write */
+      dev->rx_host_drops++;
+      dev->shm_next = next + 1;
+      continue;
+      }
+    break;
+    }
+  smp_rmb();
+  len = slot->len;
+  sender = slot->sender;
+  if (len > sizeof(slot->data))
+    len = 0;
+  memcpy(batch->arena + off, slot->data, len);
+  smp_rmb();
+  if (slot->seq != seq)                             /* overwritten while we copied it */
+    continue;
+  dev->shm_next = next + 1;
+  if ((sender == dev->shm_id) || (len == 0))        /* skip our own transmissions */
+    continue;
+  header.caplen = header.len = len;
+  _eth_callback((u_char *)dev, &header, batch->arena + off);
+  off += len;
+  status = 1;
+  }
+_eth_batch_flush(dev);
+batch->hold = FALSE;
+return status;
+}
+
+#endif /* USE_SHM_NETWORK */
+
 static void *
 _eth_reader(void *arg)
 {
@@ -1479,6 +2439,7 @@ switch (dev->eth_api) {
     break;
   case ETH_API_TAP:
   case ETH_API_VDE:
+  case ETH_API_PACKET:
     do_select = 1;
     select_fd = dev->fd_handle;
     break;
@@ -1499,6 +2460,10 @@ while (dev->handle) {
     timeout.tv_usec = 250*1000;
     sel_ret = select(1+select_fd, &setl, NULL, NULL, &timeout);
     }
+#if defined(USE_SHM_NETWORK)
+  else if (dev->eth_api == ETH_API_SHM)
+    sel_ret = _eth_shm_wait(dev, 250);
+#endif
   else
     sel_ret = 1;
   if (sel_ret < 0 && errno != EINTR) break;
@@ -1513,42 +2478,24 @@ while (dev->handle) {
         break;
 #ifdef USE_TAP_NETWORK
       case ETH_API_TAP:
-        if (1) {
-          struct pcap_pkthdr header;
-          int len;
-          u_char buf[ETH_MAX_JUMBO_FRAME];
-
-          memset(&header, 0, sizeof(header));
-          len = read(dev->fd_handle, buf, sizeof(buf));
-          if (len > 0) {
-            status = 1;
-            header.caplen = header.len = len;
-            _eth_callback((u_char *)dev, &header, buf);
-            }
-          else
-            status = 0;
-          }
+        status = _eth_read_batch(dev);
         break;
 #endif /* USE_TAP_NETWORK */
 #ifdef USE_VDE_NETWORK
       case ETH_API_VDE:
-        if (1) {
-          struct pcap_pkthdr header;
-          int len;
-          u_char buf[ETH_MAX_JUMBO_FRAME];
-
-          memset(&header, 0, sizeof(header));
-          len = vde_recv((VDECONN *)dev->handle, buf, sizeof(buf), 0);
-          if (len > 0) {
-            status = 1;
-            header.caplen = header.len = len;
-            _eth_callback((u_char *)dev, &header, buf);
-            }
-          else
-            status = 0;
-          }
+        status = _eth_read_batch(dev);
         break;
 #endif /* USE_VDE_NETWORK */
+#ifdef USE_PACKET_RING
+      case ETH_API_PACKET:
+        status = _eth_ring_read(dev);
+        break;
+#endif /* USE_PACKET_RING */
+#ifdef USE_SHM_NETWORK
+      case ETH_API_SHM:
+        status = _eth_shm_read(dev);
+        break;
+#endif /* USE_SHM_NETWORK */
       }
     if (status > 0 && dev->asynch_io) {
       int wakeup_needed;
@@ -1858,6 +2805,33 @@ else
     strncpy(errbuf, "No support for vde: network devices", sizeof(errbuf)-1);
 #endif /* !defined(__linux) && !defined(USE_BSDTUNTAP) */
     }
+  else if (0 == strncmp("packet:", savname, 7)) {
+#if defined(USE_PACKET_RING)
+    if (0 == _eth_ring_open(dev, savname+7, errbuf, sizeof(errbuf))) {
+      dev->eth_api = ETH_API_PACKET;
+      dev->handle = (void *)1;  /* Flag used to indicated open */
+      memmove(savname, savname+7, strlen(savname+7)+1);
+      }
+#else
+    strncpy(errbuf, "No support for packet: devices", sizeof(errbuf)-1);
+#endif /* USE_PACKET_RING */
+    }
+  else if (0 == strncmp("shm:", savname, 4)) {
+#if defined(USE_SHM_NETWORK)
+    if (!strcmp(savname, "shm:name")) {
+      msg = "Eth: Must specify actual shared memory segment name (i.e. shm:lan0)\r\n";
+      smp_printf (msg, errbuf);
+      if (sim_log) fprintf (sim_log, msg, errbuf);
+      return SCPE_OPENERR;
+      }
+    if (0 == _eth_shm_open(dev, savname+4, errbuf, sizeof(errbuf))) {
+      dev->eth_api = ETH_API_SHM;
+      dev->handle = (void *)1;  /* Flag used to indicated open */
+      }
+#else
+    strncpy(errbuf, "No support for shm: devices", sizeof(errbuf)-1);
+#endif /* USE_SHM_NETWORK */
+    }
   else {
     dev->handle = (void*) x_pcap_open_live(savname, bufsz, ETH_PROMISC, PCAP_READ_TIMEOUT, errbuf);
     if (!dev->handle) { /* can't open device */
@@ -1906,6 +2880,12 @@ if (1)
   x_pcap_setmintocopy ((pcap_t*) dev->handle, 0);
 #endif
   ethq_init (&dev->read_queue, 200);         /* initialize FIFO queue */
+  dev->rx_batch = (struct eth_batch*) calloc(1, sizeof(struct eth_batch));
+  if (! dev->rx_batch) eth_panic_mem();
+  if ((dev->eth_api == ETH_API_TAP) || (dev->eth_api == ETH_API_VDE) || (dev->eth_api == ETH_API_SHM)) {
+    dev->rx_batch->arena = (uint8*) malloc(ETH_BATCH_ARENA);
+    if (! dev->rx_batch->arena) eth_panic_mem();
+    }
   dev->asynch_io_latency = 0;
   dev->lock = smp_lock::create(1000);
   eth_register_perf_object(dev, dev->lock, "lock");
@@ -1966,6 +2946,10 @@ dev->fd_handle = 0;
 dev->have_host_nic_phy_addr = 0;
 
 #if defined(USE_READER_THREAD)
+#if defined(USE_SHM_NETWORK)
+if (dev->eth_api == ETH_API_SHM)
+  _eth_shm_wakeup(dev);
+#endif
 if (dev->reader_thread_created)
 {
     smp_wait_thread(dev->reader_thread);
@@ -1992,6 +2976,11 @@ if (1) {
     }
   }
 ethq_destroy (&dev->read_queue);         /* release FIFO queue */
+if (dev->rx_batch) {
+  free(dev->rx_batch->arena);
+  free(dev->rx_batch);
+  dev->rx_batch = NULL;
+  }
 #endif
 
 switch (dev->eth_api) {
@@ -2007,6 +2996,16 @@ switch (dev->eth_api) {
   case ETH_API_VDE:
     vde_close((VDECONN*)pcap);
     break;
+#endif
+#ifdef USE_PACKET_RING
+  case ETH_API_PACKET:
+    _eth_ring_close(dev, pcap_fd);
+    break;
+#endif
+#ifdef USE_SHM_NETWORK
+  case ETH_API_SHM:
+    _eth_shm_close(dev);
+    break;
 #endif
   }
 printf (msg, dev->name);
@@ -2193,6 +3192,16 @@ if ((packet->len >= ETH_MIN_PACKET) && (packet->len <= ETH_MAX_PACKET)) {
       status = ((packet->len == write(dev->fd_handle, (void *)packet->msg, packet->len)) ? 0 : -1);
       break;
 #endif
+#ifdef USE_PACKET_RING
+    case ETH_API_PACKET:
+      status = ((packet->len == send(dev->fd_handle, (void *)packet->msg, packet->len, 0)) ? 0 : -1);
+      break;
+#endif
+#ifdef USE_SHM_NETWORK
+    case ETH_API_SHM:
+      status = _eth_shm_write(dev, packet->msg, packet->len);
+      break;
+#endif
 #ifdef USE_VDE_NETWORK
     case ETH_API_VDE:
       status = vde_send((VDECONN*)dev->handle, (void *)packet->msg, packet->len, 0);
@@ -2285,15 +3294,6 @@ return _eth_write(dev, packet, routine);
 #endif
 }
 
-static int
-_eth_hash_lookup(ETH_MULTIHASH hash, const u_char* data)
-{
-int key = 0x3f & (eth_crc32(0, data, 6) >> 26);
-
-key ^= 0x3f;
-return (hash[key>>3] & (1 << (key&0x7)));
-}
-
 static int
 _eth_hash_validate(ETH_MAC *MultiCastList, int count, ETH_MULTIHASH hash)
 {
@@ -2744,6 +3744,15 @@ if ((dev->have_host_nic_phy_addr) &&
   memcpy(datacopy, data, header->len);
   memcpy(datacopy, dev->physical_addr, sizeof(ETH_MAC));
   memcpy(datacopy+18, dev->physical_addr, sizeof(ETH_MAC));
+#if defined(USE_READER_THREAD)
+  if (dev->rx_batch->hold) {             /* datacopy is about to go away */
+    _eth_batch_flush(dev);
+    dev->rx_batch->hold = FALSE;
+    _eth_callback(info, header, datacopy);
+    dev->rx_batch->hold = TRUE;
+    }
+  else
+#endif
   _eth_callback(info, header, datacopy);
   free(datacopy);
   return;
@@ -2756,11 +3765,13 @@ switch (dev->eth_api) {
     to_me = 1;
     /* AUTODIN II hash mode? */
     if ((dev->hash_filter) && (data[0] & 0x01) && (!dev->promiscuous) && (!dev->all_multicast))
-      to_me = _eth_hash_lookup(dev->hash, data);
+      to_me = _eth_hash_lookup(dev, data);
     break;
 #endif /* USE_BPF */
   case ETH_API_TAP:
   case ETH_API_VDE:
+  case ETH_API_PACKET:
+  case ETH_API_SHM:
     bpf_used = 0;
     to_me = 0;
     eth_packet_trace (dev, data, header->len, "received");
@@ -2778,7 +3789,7 @@ switch (dev->eth_api) {
 
     /* AUTODIN II hash mode? */
     if ((dev->hash_filter) && (!to_me) && (data[0] & 0x01))
-      to_me = _eth_hash_lookup(dev->hash, data);
+      to_me = _eth_hash_lookup(dev, data);
     break;
   }
 
@@ -2806,10 +3817,19 @@ if ((LOOPBACK_SELF_FRAME(dev->physical_addr, data)) ||
 
 if (bpf_used ? to_me : (to_me && !from_me)) {
   if (header->len > ETH_MIN_JUMBO_FRAME) {
+#if defined(USE_READER_THREAD)
+    /* fragmenting rewrites the frame in place, so queue fragments one at a time */
+    t_bool hold = dev->rx_batch->hold;
+    _eth_batch_flush(dev);
+    dev->rx_batch->hold = FALSE;
+#endif
     if (header->len <= header->caplen) /* Whole Frame captured? */
       _eth_fix_ip_jumbo_offload(dev, data, header->len);
     else
       ++dev->jumbo_truncated;
+#if defined(USE_READER_THREAD)
+    dev->rx_batch->hold = hold;
+#endif
     return;
     }
 #if defined(USE_READER_THREAD)
@@ -2840,9 +3860,25 @@ if (bpf_used ? to_me : (to_me && !from_me)) {
 
     eth_packet_trace (dev, data, len, "rcvqd");
 
-    dev->lock->lock();
-    ethq_insert_data(&dev->read_queue, 2, data, 0, len, crc_len, crc_data, 0);
-    dev->lock->unlock();
+    if (dev->rx_batch->hold) {
+      struct eth_batch* batch = dev->rx_batch;
+      struct eth_batch_item* bi = &batch->item[batch->count++];
+      if (moved_data) {
+        memcpy(bi->pad, moved_data, ETH_MIN_PACKET);
+        data = bi->pad;
+        }
+      bi->data = data;
+      bi->len = len;
+      bi->crc_len = crc_len;
+      memcpy(bi->crc_data, crc_data, sizeof(crc_data));
+      if (batch->count == ETH_BATCH_MAX)
+        _eth_batch_flush(dev);
+      }
+    else {
+      dev->lock->lock();
+      ethq_insert_data(&dev->read_queue, 2, data, 0, len, crc_len, crc_data, 0);
+      dev->lock->unlock();
+      }
     free(moved_data);
     }
 #else /* !USE_READER_THREAD */
@@ -3258,6 +4294,13 @@ if (used < max) {
   ++used;
   }
 #endif
+#ifdef USE_SHM_NETWORK
+if (used < max) {
+  sprintf(list[used].name, "%s", "shm:name");
+  sprintf(list[used].desc, "%s", "Shared memory segment between simulators on this host");
+  ++used;
+  }
+#endif
 
 return used;
 }
@@ -3324,6 +4367,9 @@ if (dev->have_host_nic_phy_addr) {
   eth_mac_fmt(&dev->host_nic_phy_hw_addr, hw_mac);
   fprintf(st, "  Host NIC Address:      %s\n", hw_mac);
   }
+fprintf(st, "  CRC32 Method:          %s\n", eth_crc32_method());
+if (dev->hash_filter)
+  fprintf(st, "  Hash Cache Hits/Misses: %u/%u\n", dev->hash_cache_hits, dev->hash_cache_misses);
 if (dev->jumbo_dropped)
   fprintf(st, "  Jumbo Dropped:         %d\n", dev->jumbo_dropped);
 if (dev->jumbo_fragmented)
@@ -3335,6 +4381,21 @@ fprintf(st, "  Asynch Interrupts:       %s\n", dev->asynch_io ? "Enabled" : "Dis
 fprintf(st, "  Read Queue: Count:       %d\n", dev->read_queue.count);
 fprintf(st, "  Read Queue: High:        %d\n", dev->read_queue.high);
 fprintf(st, "  Read Queue: Loss:        %d\n", dev->read_queue.loss);
+#if defined(USE_PACKET_RING)
+if (dev->eth_api == ETH_API_PACKET) {
+  _eth_ring_stats(dev);
+  fprintf(st, "  Host Capture Loss:       %u\n", dev->rx_host_drops);
+  }
+#endif
+#if defined(USE_SHM_NETWORK)
+if (dev->eth_api == ETH_API_SHM)
+  fprintf(st, "  Host Capture Loss:       %u\n", dev->rx_host_drops);
+#endif
+if (dev->rx_batches) {
+  fprintf(st, "  Read Batches:            %u\n", dev->rx_batches);
+  fprintf(st, "  Read Batch Size: Avg:    %.1f\n", (double) dev->rx_batched / dev->rx_batches);
+  fprintf(st, "  Read Batch Size: Peak:   %u\n", dev->rx_batch_peak);
+  }
 fprintf(st, "  Peak Write Queue Size:   %d\n", dev->write_queue_peak);
 #endif
 }
@@ -90,6 +90,16 @@
 #  undef USE_READER_THREAD
 #endif
 
+/* Linux AF_PACKET memory-mapped capture ring (packet:ethX devices) */
+#if defined(__linux) && defined(USE_READER_THREAD) && !defined(DONT_USE_PACKET_RING)
+#  define USE_PACKET_RING 1
+#endif
+
+/* shared memory broadcast segment between simulators on one host (shm:name devices) */
+#if defined(USE_READER_THREAD) && !defined(_WIN32) && !defined(VMS) && !defined(DONT_USE_SHM_NETWORK)
+#  define USE_SHM_NETWORK 1
+#endif
+
 /* make common winpcap code a bit easier to read in this file */
 #if defined(_WIN32) || defined(VMS)
 #  define PCAP_READ_TIMEOUT -1
@@ -191,6 +201,32 @@ struct eth_queue {
   struct eth_item*    item;
 };
 
+#if defined (USE_READER_THREAD)
+/*
+ * Frames accepted by the reader thread and waiting to be moved into the read queue.
+ * While "hold" is set, the caller guarantees that frame data stays in place until
+ * the batch is flushed, so only descriptors are kept; the whole batch is then inserted
+ * into the read queue under a single acquisition of the device lock.
+ */
+#define ETH_BATCH_MAX         64                        /* frames per batch */
+#define ETH_BATCH_ARENA (4 * ETH_MAX_JUMBO_FRAME)       /* read buffer for tap/vde batches */
+
+struct eth_batch_item {
+  const uint8*  data;                                   /* frame data */
+  int           len;                                    /* frame length */
+  int           crc_len;                                /* frame length with CRC */
+  uint8         crc_data[ETH_CRC_SIZE];                 /* CRC */
+  uint8         pad[ETH_MIN_PACKET];                    /* copy of padded runt frame */
+};
+
+struct eth_batch {
+  t_bool        hold;                                   /* frame data stays valid until flush */
+  int           count;                                  /* frames in batch */
+  uint8*        arena;                                  /* read buffer (tap/vde) */
+  struct eth_batch_item item[ETH_BATCH_MAX];
+};
+#endif
+
 struct eth_list {
   char    name[ETH_DEV_NAME_MAX];
   char    desc[ETH_DEV_DESC_MAX];
@@ -205,6 +241,19 @@ typedef struct eth_list ETH_LIST;
 typedef struct eth_queue ETH_QUE;
 typedef struct eth_item ETH_ITEM;
 
+/*
+ * Direct-mapped cache of multicast destination address -> AUTODIN II hash bit index,
+ * so the hash filter does not recompute a CRC for every received multicast frame.
+ * The index depends only on the address, so entries never need invalidation; a zeroed
+ * entry holds a unicast address and can never match a multicast lookup.
+ */
+#define ETH_HASH_CACHE_SIZE 32                          /* entries, power of 2 */
+
+struct eth_hash_cache {
+  ETH_MAC       mac;                                    /* multicast destination address */
+  uint8         key;                                    /* hash bit index (0..63) */
+};
+
 #if defined (USE_READER_THREAD)
 struct eth_write_request
 {
@@ -221,6 +270,8 @@ struct eth_device {
 #define ETH_API_PCAP 0                                  /* Pcap API in use */
 #define ETH_API_TAP  1                                  /* tun/tap API in use */
 #define ETH_API_VDE  2                                  /* VDE API in use */
+#define ETH_API_PACKET 3                                /* AF_PACKET capture ring in use */
+#define ETH_API_SHM  4                                  /* shared memory segment in use */
   ETH_PCALLBACK read_callback;                          /* read callback function */
   ETH_PCALLBACK write_callback;                         /* write callback function */
   ETH_PACK*     read_packet;                            /* read packet */
@@ -230,6 +281,9 @@ struct eth_device {
   ETH_BOOL      all_multicast;                          /* receive all multicast messages */
   ETH_BOOL      hash_filter;                            /* filter using AUTODIN II multicast hash */
   ETH_MULTIHASH hash;                                   /* AUTODIN II multicast hash */
+  struct eth_hash_cache hash_cache[ETH_HASH_CACHE_SIZE]; /* multicast address -> hash bit index */
+  uint32        hash_cache_hits;                        /* hash filter lookups satisfied by cache */
+  uint32        hash_cache_misses;                      /* hash filter lookups that computed a CRC */
   int32         loopback_self_sent;                     /* loopback packets sent but not seen */
   int32         loopback_self_sent_total;               /* total loopback packets sent */
   int32         loopback_self_rcvd_total;               /* total loopback packets seen */
@@ -259,6 +313,23 @@ struct eth_device {
   int write_queue_peak;
   struct eth_write_request* write_buffers;
   t_stat write_status;
+  struct eth_batch* rx_batch;                           /* frames pending insertion into read queue */
+  uint32        rx_batches;                             /* batches inserted into read queue */
+  uint32        rx_batched;                             /* frames inserted by batches */
+  uint32        rx_batch_peak;                          /* largest batch */
+  uint32        rx_host_drops;                          /* frames dropped by host before capture */
+#endif
+#if defined (USE_PACKET_RING)
+  uint8*        rx_ring;                                /* mapped AF_PACKET receive ring */
+  size_t        rx_ring_size;                           /* size of the ring */
+  int           rx_ring_blocks;                         /* number of blocks in the ring */
+  int           rx_ring_block_size;                     /* size of a block */
+  int           rx_ring_next;                           /* next block to examine */
+#endif
+#if defined (USE_SHM_NETWORK)
+  struct eth_shm_hdr* shm;                              /* mapped shared memory segment */
+  uint32        shm_id;                                 /* our attachment id in the segment */
+  uint32        shm_next;                               /* next ticket to receive */
 #endif
 };
 
@@ -289,6 +360,10 @@ void eth_setcrc   (ETH_DEV* dev, int need_crc);         /* enable/disable CRC mo
 t_stat eth_set_async (ETH_DEV* dev, int latency);       /* set read behavior to be async */
 t_stat eth_clr_async (ETH_DEV* dev);                    /* set read behavior to be not async */
 uint32 eth_crc32(uint32 crc, const void* vbuf, size_t len); /* Compute Ethernet Autodin II CRC for buffer */
+const char* eth_crc32_method();                         /* name of the CRC32 implementation in use */
+#if defined(ETH_TEST_MAIN)
+t_stat eth_test (void);                                 /* CRC32 and multicast hash filter tests */
+#endif
 
 void eth_packet_trace (ETH_DEV* dev, const uint8 *msg, int len, char* txt); /* trace ethernet packet header+crc */
 void eth_packet_trace_ex (ETH_DEV* dev, const uint8 *msg, int len, const char* txt, int detail, uint32 reason); /* trace ethernet packet */
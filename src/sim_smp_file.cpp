@@ -1,10 +1,38 @@
 /*
  * Thread-safe file I/O
+ *
+ * While the simulator is running, output to streams marked as deferred (console stdout,
+ * log files) does not touch stdio on the calling thread.  The text is appended to the
+ * thread's own ring as a record tagged with a global output sequence number; no lock is
+ * taken.  A writer thread merges the rings of all threads in sequence order and writes
+ * the records out, so output to any stream keeps the order in which it was produced.
+ *
+ * Any other operation on a deferred stream (fflush, fseek, read, close etc.) first writes
+ * out everything recorded so far, and all pending output is written out when the run
+ * command returns to the SCP prompt.  A thread whose ring is full writes out the rings
+ * itself until there is room again, so memory use stays bounded and nothing is dropped;
+ * writes longer than a quarter of the ring are performed synchronously.
  */
 
 #define SIM_THREADS_H_FULL_INCLUDE
 #include "sim_defs.h"
 
+#if !defined(va_copy)
+#  if defined(__va_copy)
+#    define va_copy(dst, src)  __va_copy(dst, src)
+#  else
+#    define va_copy(dst, src)  ((dst) = (src))
+#  endif
+#endif
+
+#define FILEOUT_RING_SIZE   (64 * 1024)             /* per-thread ring size, must be a power of two */
+#define FILEOUT_MAXREC      (FILEOUT_RING_SIZE / 4) /* longer writes are performed synchronously */
+#define FILEOUT_PERIOD      5000                    /* writer pass interval, usec */
+
+/* kinds of ring records */
+#define FILEOUT_PAD         0                       /* filler up to the end of the ring */
+#define FILEOUT_TEXT        1                       /* text for the stream */
+
 SMP_FILE* smp_stdin = NULL;
 SMP_FILE* smp_stdout = NULL;
 SMP_FILE* smp_stderr = NULL;
@@ -30,6 +58,8 @@ public:
 // };
 
 #define DynLock(sfd)                             \
+    if (sfd->deferred || sfd == smp_stderr)      \
+        smp_fileout_flush();                     \
     sfd->lock_cs->lock();                        \
     DynUnlocker _dyn_unlocker(sfd->lock_cs);
 
@@ -48,11 +78,371 @@ public:
     }
 };
 
+typedef struct
+{
+    uint32 size;                                    /* record size in bytes, multiple of 8 */
+    uint16 kind;                                    /* FILEOUT_xxx */
+    uint16 spare;
+    uint32 seq;                                     /* output sequence number */
+    uint32 len;                                     /* text length */
+    SMP_FILE* sfd;
+    /* followed by text */
+}
+fileout_rec;
+
+typedef struct __tag_fileout_ring
+{
+    struct __tag_fileout_ring* next;                /* list of all rings, walked by the writer */
+    t_byte* buf;
+    t_bool kicked;                                  /* writer has been woken for this ring */
+    uint32 stalls;                                  /* times the owner waited for space */
+    SIM_ALIGN_CACHELINE volatile uint32 head;       /* written by the owning thread only */
+    SIM_ALIGN_CACHELINE volatile uint32 tail;       /* written under fileout_drain_lock only */
+    t_byte pad[SMP_MAXCACHELINESIZE - sizeof(uint32)];
+}
+fileout_ring;
+
+t_bool smp_fileout_enabled = TRUE;                  /* SET CONSOLE DEFER / NODEFER */
+volatile t_bool smp_fileout_active = FALSE;
+
+static fileout_ring* volatile fileout_list = NULL;
+static smp_interlocked_uint32_var fileout_seq = smp_var_init(0);  /* next sequence number to assign */
+static volatile uint32 fileout_next = 0;            /* next sequence number to write out */
+static smp_event* fileout_wakeup = NULL;
+static smp_thread_t fileout_writer;
+static volatile t_bool fileout_writer_stop = FALSE;
+static t_uint64 fileout_records = 0;                /* statistics */
+static t_uint64 fileout_bytes = 0;
+static uint32 fileout_direct = 0;
+static uint32 fileout_exited_stalls = 0;
+
+static SMP_TLS_DTOR_DECL fileout_release(void* arg);
+
+AUTO_TLS_DTOR(fileout_key, fileout_release);
+AUTO_INIT_LOCK(fileout_list_lock, SIM_LOCK_CRITICALITY_NONE, 1000);
+AUTO_INIT_LOCK(fileout_drain_lock, SIM_LOCK_CRITICALITY_NONE, 1000);
+
+static fileout_ring* fileout_current()
+{
+    fileout_ring* r = (fileout_ring*) tls_get_value(fileout_key);
+
+    if (unlikely(r == NULL))
+    {
+        r = (fileout_ring*) calloc(1, sizeof(fileout_ring));
+        if (r == NULL || (r->buf = (t_byte*) malloc(FILEOUT_RING_SIZE)) == NULL)
+            panic("Unable to allocate memory");
+        fileout_list_lock->lock();
+        r->next = fileout_list;
+        smp_wmb();
+        fileout_list = r;
+        fileout_list_lock->unlock();
+        tls_set_value(fileout_key, r);
+    }
+
+    return r;
+}
+
+static void fileout_drain(t_bool wait, uint32 upto);
+
+/*
+ * Thread exit: write out everything recorded so far, including the exiting thread's
+ * records, and free its ring.  The list is walked by drainers under fileout_drain_lock,
+ * so the ring is unlinked under it as well.
+ */
+static SMP_TLS_DTOR_DECL fileout_release(void* arg)
+{
+    fileout_ring* r = (fileout_ring*) arg;
+    fileout_ring* volatile* pp;
+
+    fileout_drain_lock->lock();
+    fileout_drain(TRUE, smp_var(fileout_seq));
+    fileout_list_lock->lock();
+    for (pp = & fileout_list;  *pp;  pp = & (*pp)->next)
+    {
+        if (*pp == r)
+        {
+            *pp = r->next;
+            break;
+        }
+    }
+    fileout_exited_stalls += r->stalls;
+    fileout_list_lock->unlock();
+    fileout_drain_lock->unlock();
+
+    free(r->buf);
+    free(r);
+}
+
+/*
+ * Write out records in sequence order, up to sequence number "upto" if "wait" is set
+ * (waiting for records that have been numbered but not yet committed), or as many as
+ * are available in order otherwise.  Must be called with fileout_drain_lock held.
+ */
+static void fileout_drain(t_bool wait, uint32 upto)
+{
+    while (! wait || (int32) (upto - fileout_next) > 0)
+    {
+        const fileout_rec* rec = NULL;
+        fileout_ring* r;
+
+        for (r = fileout_list;  r;  r = r->next)
+        {
+            uint32 tail = r->tail;
+
+            if (tail == r->head)
+                continue;
+            smp_rmb();
+            rec = (const fileout_rec*) (r->buf + (tail & (FILEOUT_RING_SIZE - 1)));
+            if (rec->kind == FILEOUT_PAD)
+            {
+                r->tail = tail += rec->size;
+                if (tail == r->head)
+                    continue;
+                smp_rmb();
+                rec = (const fileout_rec*) r->buf;
+            }
+            if (rec->seq == fileout_next)
+                break;
+        }
+
+        if (r == NULL)
+        {
+            /* next record has been numbered but not committed yet, or there is nothing left */
+            if (! wait || fileout_next == smp_var(fileout_seq))
+                break;
+            smp_cpu_relax();
+            continue;
+        }
+
+        SMP_FILE* sfd = rec->sfd;
+        sfd->lock_cs->lock();
+        fwrite(rec + 1, 1, rec->len, sfd->stream);
+        sfd->lock_cs->unlock();
+        fileout_records++;
+        fileout_bytes += rec->len;
+
+        smp_mb();                                   /* done reading before releasing the space */
+        r->tail += rec->size;
+        fileout_next++;
+    }
+
+    for (fileout_ring* r = fileout_list;  r;  r = r->next)
+    {
+        if (r->kicked && r->head - r->tail <= FILEOUT_RING_SIZE / 2)
+            r->kicked = FALSE;
+    }
+}
+
+/* Write out everything recorded so far */
+void smp_fileout_flush()
+{
+    uint32 upto = smp_var(fileout_seq);
+    if (fileout_next == upto)
+        return;
+    smp_rmb();
+    fileout_drain_lock->lock();
+    fileout_drain(TRUE, upto);
+    fileout_drain_lock->unlock();
+}
+
+/*
+ * Append text to the current thread's ring.  Returns FALSE if the text should be written
+ * synchronously instead: it is too long, or deferred output has been turned off meanwhile.
+ */
+static t_bool fileout_put(SMP_FILE* sfd, const void* text, size_t len)
+{
+    if (len > FILEOUT_MAXREC)
+    {
+        fileout_direct++;
+        return FALSE;
+    }
+
+    fileout_ring* r = fileout_current();
+    uint32 size = (uint32) (sizeof(fileout_rec) + len + 7) & ~7;
+    uint32 head = r->head;
+    uint32 off = head & (FILEOUT_RING_SIZE - 1);
+    uint32 need = (off + size > FILEOUT_RING_SIZE) ? FILEOUT_RING_SIZE - off + size : size;
+
+    if (unlikely(FILEOUT_RING_SIZE - (head - r->tail) < need))
+    {
+        r->stalls++;
+        while (FILEOUT_RING_SIZE - (head - r->tail) < need)
+        {
+            if (! smp_fileout_active)
+                return FALSE;
+            fileout_drain_lock->lock();
+            fileout_drain(FALSE, 0);
+            fileout_drain_lock->unlock();
+        }
+    }
+    smp_rmb();                                      /* writer is done with the space */
+
+    if (off + size > FILEOUT_RING_SIZE)
+    {
+        fileout_rec* pad = (fileout_rec*) (r->buf + off);
+        pad->size = FILEOUT_RING_SIZE - off;
+        pad->kind = FILEOUT_PAD;
+        head += FILEOUT_RING_SIZE - off;
+        off = 0;
+    }
+
+    /* nothing between taking the sequence number and publishing the record may block */
+    fileout_rec* rec = (fileout_rec*) (r->buf + off);
+    rec->size = size;
+    rec->kind = FILEOUT_TEXT;
+    rec->len = (uint32) len;
+    rec->sfd = sfd;
+    memcpy(rec + 1, text, len);
+    rec->seq = smp_interlocked_increment(& smp_var(fileout_seq)) - 1;
+    smp_wmb();
+    r->head = head + size;
+
+    if (unlikely(r->head - r->tail > FILEOUT_RING_SIZE / 2) && !r->kicked)
+    {
+        r->kicked = TRUE;
+        fileout_wakeup->set();
+    }
+
+    /* deferred output was stopped while the record was being added: write it out ourselves */
+    smp_mb();
+    if (unlikely(! smp_fileout_active))
+        smp_fileout_flush();
+
+    return TRUE;
+}
+
+static SIM_INLINE t_bool fileout_defer(SMP_FILE* sfd)
+{
+    return sfd->deferred && smp_fileout_active;
+}
+
+/*
+ * Format into a local buffer and append the result to the ring.
+ * Returns -2 if the output should be performed synchronously instead.
+ */
+static int fileout_vprintf(SMP_FILE* sfd, t_bool ttfix, const char* fmt, va_list va)
+{
+    char sbuf[1024];
+    char* buf = sbuf;
+    size_t pos = 0;
+    size_t len;
+    va_list va2;
+    int res;
+
+    if (ttfix && fmt[0] == '\n')
+        buf[pos++] = '\r';
+
+    va_copy(va2, va);
+    res = vsnprintf(buf + pos, sizeof(sbuf) - pos - 1, fmt, va);
+    if (res >= 0 && (size_t) res >= sizeof(sbuf) - pos - 1)
+    {
+        if (res > FILEOUT_MAXREC || (buf = (char*) malloc(pos + res + 2)) == NULL)
+        {
+            fileout_direct++;
+            va_end(va2);
+            return -2;
+        }
+        memcpy(buf, sbuf, pos);
+        vsnprintf(buf + pos, res + 1, fmt, va2);
+    }
+    va_end(va2);
+    if (res < 0)
+        return res;
+    pos += res;
+
+    if (ttfix && (len = strlen(fmt)) && fmt[len - 1] == '\n')
+        buf[pos++] = '\r';
+
+    if (! fileout_put(sfd, buf, pos))
+        res = -2;
+    if (buf != sbuf)
+        free(buf);
+    return res;
+}
+
+static SMP_THREAD_ROUTINE_DECL fileout_writer_main(void* arg)
+{
+    sim_try
+    {
+        smp_thread_init();
+
+        run_scope_context* rscx = new run_scope_context(NULL, SIM_THREAD_TYPE_IOP, fileout_writer);
+        rscx->set_current();
+
+        smp_set_thread_priority(SIMH_THREAD_PRIORITY_IOP);
+        smp_set_thread_name("FILE_WRITER");
+
+        while (! fileout_writer_stop)
+        {
+            fileout_wakeup->timed_wait(FILEOUT_PERIOD, NULL);
+            fileout_wakeup->clear();
+            fileout_drain_lock->lock();
+            fileout_drain(FALSE, 0);
+            fileout_drain_lock->unlock();
+            if (smp_stdout && smp_stdout->deferred)
+                fflush(smp_stdout->stream);
+        }
+    }
+    sim_catch (sim_exception_SimError, exc)
+    {
+        fprintf(smp_stderr, "\nFatal error in %s simulator, unexpected exception while executing file writer thread\n", sim_name);
+        fprintf(smp_stderr, "Exception cause: %s\n", exc->get_message());
+        fprintf(smp_stderr, "Terminating the simulator abnormally...\n");
+        exit(1);
+    }
+    sim_end_try
+
+    SMP_THREAD_ROUTINE_END;
+}
+
+/* Start deferring output to deferred streams, called by the console thread when starting to run */
+void smp_fileout_start()
+{
+    if (smp_fileout_active || ! smp_fileout_enabled)
+        return;
+    if (fileout_wakeup == NULL)
+        fileout_wakeup = smp_event::create();
+    fileout_wakeup->clear();
+    fileout_writer_stop = FALSE;
+    smp_create_thread(fileout_writer_main, NULL, & fileout_writer);
+    smp_wmb();
+    smp_fileout_active = TRUE;
+}
+
+/* Write out everything recorded so far and revert to synchronous output */
+void smp_fileout_stop()
+{
+    if (! smp_fileout_active)
+        return;
+    smp_fileout_active = FALSE;
+    smp_mb();
+    fileout_writer_stop = TRUE;
+    fileout_wakeup->set();
+    smp_wait_thread(fileout_writer);
+    smp_fileout_flush();
+}
+
+void smp_fileout_show(SMP_FILE* st)
+{
+    uint32 stalls;
+    fileout_ring* r;
+
+    fileout_list_lock->lock();
+    stalls = fileout_exited_stalls;
+    for (r = fileout_list;  r;  r = r->next)
+        stalls += r->stalls;
+    fileout_list_lock->unlock();
+    fprintf(st, "Console and log output is %s while running\n", smp_fileout_enabled ? "deferred" : "synchronous");
+    fprintf(st, "    %.0f records (%.0f bytes) written by writer, %u written synchronously, %u waits for writer\n",
+            (double) fileout_records, (double) fileout_bytes, fileout_direct, stalls);
+}
+
 SMP_FILE* smp_file_wrap(FILE* fp)
 {
     SMP_FILE* sfd = new SMP_FILE();
     sfd->stream = fp;
     sfd->lock_cs = new smp_file_critical_section();
+    sfd->deferred = FALSE;
     return sfd;
 }
 
@@ -72,6 +462,7 @@ SMP_FILE* smp_fopen64(const char* filename, const char* mode)
 
 int fclose(SMP_FILE* sfd)
 {
+    if (sfd->deferred)  smp_fileout_flush();
     sfd->lock_cs->lock();
     int res = fclose(sfd->stream);
     sfd->lock_cs->unlock();
@@ -89,6 +480,10 @@ void smp_perror(const char* string)
 
 int smp_putchar(int c)
 {
+    char ch = (char) c;
+    if (fileout_defer(smp_stdout) && fileout_put(smp_stdout, & ch, 1))
+        return (unsigned char) c;
+    if (smp_stdout->deferred)  smp_fileout_flush();
     smp_stdout->lock_cs->lock();
     int res = putchar(c);
     smp_stdout->lock_cs->unlock();
@@ -99,11 +494,21 @@ int smp_printf(const char* fmt, ...)
 {
     size_t len;
     va_list va;
+    int res;
+    if (smp_stdout && fileout_defer(smp_stdout))
+    {
+        va_start(va, fmt);
+        res = fileout_vprintf(smp_stdout, sim_ttrun_mode, fmt, va);
+        va_end(va);
+        if (res != -2)
+            return res;
+    }
     va_start(va, fmt);
+    if (smp_stdout && smp_stdout->deferred)  smp_fileout_flush();
     if (smp_stdout)  smp_stdout->lock_cs->lock();
     if (sim_ttrun_mode && fmt[0] == '\n')
         printf("\r");
-    int res = vfprintf(stdout, fmt, va);
+    res = vfprintf(stdout, fmt, va);
     if (sim_ttrun_mode && (len = strlen(fmt)) && fmt[len - 1] == '\n')
         printf("\r");
     if (smp_stdout)  smp_stdout->lock_cs->unlock();
@@ -137,18 +542,25 @@ size_t fread(void* buffer, size_t size, size_t count, SMP_FILE* sfd)
 
 int fputc(int c, SMP_FILE* sfd)
 {
+    char ch = (char) c;
+    if (fileout_defer(sfd) && fileout_put(sfd, & ch, 1))
+        return (unsigned char) c;
     DynLock(sfd);
     return fputc(c, sfd->stream);
 }
 
 int fputs(const char* string, SMP_FILE* sfd)
 {
+    if (fileout_defer(sfd) && fileout_put(sfd, string, strlen(string)))
+        return 0;
     DynLock(sfd);
     return fputs(string, sfd->stream);
 }
 
 size_t fwrite(const void* buffer, size_t size, size_t count, SMP_FILE* sfd)
 {
+    if (fileout_defer(sfd) && fileout_put(sfd, buffer, size * count))
+        return count;
     DynLock(sfd);
     return fwrite(buffer, size, count, sfd->stream);
 }
@@ -173,6 +585,15 @@ void rewind(SMP_FILE* sfd)
 
 int vfprintf(SMP_FILE* sfd, const char* format, va_list argptr)
 {
+    if (fileout_defer(sfd))
+    {
+        va_list va;
+        va_copy(va, argptr);
+        int res = fileout_vprintf(sfd, FALSE, format, va);
+        va_end(va);
+        if (res != -2)
+            return res;
+    }
     DynLock(sfd);
     return vfprintf(sfd->stream, format, argptr);
 }
@@ -203,6 +624,9 @@ int getc(SMP_FILE* sfd)
 
 int putc(int c, SMP_FILE* sfd)
 {
+    char ch = (char) c;
+    if (fileout_defer(sfd) && fileout_put(sfd, & ch, 1))
+        return (unsigned char) c;
     DynLock(sfd);
     return putc(c, sfd->stream);
 }
@@ -238,8 +662,16 @@ int setvbuf(SMP_FILE *sfd, char *buffer, int mode, size_t size)
 int fprintf(SMP_FILE* sfd, const char* fmt, ...)
 {
     size_t len;
-    DynLock(sfd);
     va_list va;
+    if (fileout_defer(sfd))
+    {
+        va_start(va, fmt);
+        int res = fileout_vprintf(sfd, sim_ttrun_mode && sfd == smp_stdout, fmt, va);
+        va_end(va);
+        if (res != -2)
+            return res;
+    }
+    DynLock(sfd);
     va_start(va, fmt);
     if (sim_ttrun_mode && sfd == smp_stdout && fmt[0] == '\n')
         printf("\r");
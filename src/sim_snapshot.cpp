@@ -0,0 +1,400 @@
+/*
+ * sim_snapshot.cpp: memory image for SAVE/RESTORE
+ *
+ * Simulated memory is written as a sequence of MEMIMG_BLOCK sized blocks, each preceded by
+ * a 32-bit record header:
+ *
+ *     0        all-zero block, nothing follows
+ *     n > 0    n bytes of compressed block data follow
+ *     n < 0    -n bytes of block data follow uncompressed (block did not compress)
+ *
+ * Blocks are compressed independently of each other with a small LZ77 coder, so the work
+ * can be spread across host threads.  SAVE compresses a batch of MEMIMG_BATCH blocks in
+ * parallel, then writes the records out in order; RESTORE reads a batch of records and
+ * expands the blocks in parallel straight into simulated memory.  Worker threads are started
+ * once per SAVE or RESTORE and released for each batch; they claim blocks one at a time.
+ *
+ * Compressed block data is a sequence of (literals, match) pairs.  Each pair starts with
+ * a token byte: the high nibble is the literal count, the low nibble is the match length
+ * minus LZ_MINMATCH; a nibble value of 15 means the count continues in following bytes,
+ * each adding up to 255, until a byte less than 255.  The literals follow, then a 16-bit
+ * little-endian match offset and any match length continuation bytes.  The last pair of
+ * a block carries only literals and ends the block data.
+ */
+
+#include "sim_defs.h"
+
+#define MEMIMG_BLOCK        (64 * 1024)                 /* memory block size, offsets must fit 16 bits */
+#define MEMIMG_BATCH        256                         /* blocks per parallel batch */
+#define MEMIMG_MAXTHREADS   16                          /* limit on host threads used */
+
+#define LZ_MINMATCH         4                           /* shortest match encoded */
+#define LZ_HASH_BITS        14                          /* match finder table size */
+#define LZ_SKIP_SHIFT       6                           /* search step grows with unmatched run */
+
+typedef struct __tag_memimg_batch
+{
+    t_byte*             mem;                            /* simulated memory */
+    t_addr              size;                           /* memory size */
+    t_addr              first;                          /* first block of the batch */
+    uint32              nblocks;                        /* blocks in the batch */
+    t_byte*             buf;                            /* block data, MEMIMG_BLOCK per block */
+    int32*              hdr;                            /* record header per block */
+    void                (*process)(struct __tag_memimg_batch* b, uint32 k);
+    smp_interlocked_uint32_var next;                    /* next block of the batch to claim */
+    volatile t_bool     error;                          /* corrupt record found */
+    uint32              nthreads;                       /* threads working on a batch, including caller */
+    smp_thread_t        thread[MEMIMG_MAXTHREADS];      /* worker threads, [0] unused */
+    smp_semaphore*      go;                             /* released once per worker per batch */
+    smp_semaphore*      done;                           /* released by a worker when the batch is drained */
+    volatile t_bool     quit;                           /* workers should exit */
+}
+memimg_batch;
+
+static SIM_INLINE uint32 lz_read32 (const t_byte* p)
+{
+    uint32 v;
+    memcpy (&v, p, sizeof(v));
+    return v;
+}
+
+/* Append a count continuation for a nibble that overflowed */
+static SIM_INLINE int32 lz_put_count (t_byte* dst, int32 op, int32 n)
+{
+    for (n -= 15;  n >= 255;  n -= 255)
+        dst[op++] = 255;
+    dst[op++] = (t_byte) n;
+    return op;
+}
+
+/* Append one (literals, match) pair, mlen = 0 for the final pair; returns -1 if it does not fit */
+static int32 lz_put_pair (t_byte* dst, int32 op, int32 cap, const t_byte* lit, int32 nlit, int32 off, int32 mlen)
+{
+    int32 m = mlen ? mlen - LZ_MINMATCH : 0;
+
+    if (op + 1 + nlit / 255 + 1 + nlit + (mlen ? 2 + m / 255 + 1 : 0) > cap)
+        return -1;
+
+    dst[op++] = (t_byte) ((imin(nlit, 15) << 4) | imin(m, 15));
+    if (nlit >= 15)
+        op = lz_put_count (dst, op, nlit);
+    memcpy (dst + op, lit, nlit);
+    op += nlit;
+
+    if (mlen)
+    {
+        dst[op++] = (t_byte) (off & 0xFF);
+        dst[op++] = (t_byte) (off >> 8);
+        if (m >= 15)
+            op = lz_put_count (dst, op, m);
+    }
+
+    return op;
+}
+
+/* Compress n (<= MEMIMG_BLOCK) bytes; returns compressed length or -1 if it would not be below cap */
+static int32 lz_compress (const t_byte* src, int32 n, t_byte* dst, int32 cap)
+{
+    uint16 htab[1 << LZ_HASH_BITS];
+    int32 ip = 0, anchor = 0, op = 0;
+
+    memset (htab, 0, sizeof(htab));
+
+    while (ip <= n - LZ_MINMATCH)
+    {
+        uint32 seq = lz_read32 (src + ip);
+        uint32 h = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+        int32 cand = htab[h];
+        htab[h] = (uint16) ip;
+
+        if (cand < ip && lz_read32 (src + cand) == seq)
+        {
+            int32 mlen = LZ_MINMATCH;
+            while (ip + mlen < n && src[cand + mlen] == src[ip + mlen])
+                mlen++;
+            if ((op = lz_put_pair (dst, op, cap, src + anchor, ip - anchor, ip - cand, mlen)) < 0)
+                return -1;
+            ip += mlen;
+            anchor = ip;
+        }
+        else
+        {
+            ip += 1 + ((ip - anchor) >> LZ_SKIP_SHIFT);
+        }
+    }
+
+    return lz_put_pair (dst, op, cap, src + anchor, n - anchor, 0, 0);
+}
+
+/* Read a count continuation; returns FALSE if the data ends first */
+static SIM_INLINE t_bool lz_get_count (const t_byte* src, int32 n, int32* ip, int32* count)
+{
+    uint32 b;
+    do
+    {
+        if (*ip >= n)
+            return FALSE;
+        b = src[(*ip)++];
+        *count += b;
+    }
+    while (b == 255);
+    return TRUE;
+}
+
+/* Expand compressed data into exactly dn bytes; returns FALSE if the data is malformed */
+static t_bool lz_expand (const t_byte* src, int32 n, t_byte* dst, int32 dn)
+{
+    int32 ip = 0, op = 0;
+
+    while (ip < n)
+    {
+        uint32 tok = src[ip++];
+        int32 nlit = tok >> 4;
+        int32 mlen = tok & 15;
+
+        if (nlit == 15 && !lz_get_count (src, n, &ip, &nlit))
+            return FALSE;
+        if (nlit > n - ip || nlit > dn - op)
+            return FALSE;
+        memcpy (dst + op, src + ip, nlit);
+        ip += nlit;
+        op += nlit;
+
+        if (ip == n)                                    /* final pair */
+            break;
+
+        if (n - ip < 2)
+            return FALSE;
+        int32 off = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        if (mlen == 15 && !lz_get_count (src, n, &ip, &mlen))
+            return FALSE;
+        mlen += LZ_MINMATCH;
+        if (off == 0 || off > op || mlen > dn - op)
+            return FALSE;
+
+        /* byte by byte: source and destination overlap when off < mlen */
+        const t_byte* mp = dst + op - off;
+        for (int32 k = 0;  k < mlen;  k++)
+            dst[op + k] = mp[k];
+        op += mlen;
+    }
+
+    return op == dn;
+}
+
+static SIM_INLINE int32 memimg_block_size (memimg_batch* b, uint32 k)
+{
+    t_addr base = (b->first + k) * MEMIMG_BLOCK;
+    return (int32) ((b->size - base) < MEMIMG_BLOCK ? (b->size - base) : MEMIMG_BLOCK);
+}
+
+static t_bool memimg_is_zero (const t_byte* p, int32 n)
+{
+    const t_byte* ep = p + n;
+    for (;  p + sizeof(t_uint64) <= ep;  p += sizeof(t_uint64))
+    {
+        t_uint64 v;
+        memcpy (&v, p, sizeof(v));
+        if (v)  return FALSE;
+    }
+    for (;  p < ep;  p++)
+    {
+        if (*p)  return FALSE;
+    }
+    return TRUE;
+}
+
+static void memimg_compress_block (memimg_batch* b, uint32 k)
+{
+    const t_byte* src = b->mem + (b->first + k) * MEMIMG_BLOCK;
+    int32 n = memimg_block_size (b, k);
+    t_byte* dst = b->buf + (t_addr) k * MEMIMG_BLOCK;
+    int32 clen;
+
+    if (memimg_is_zero (src, n))
+        b->hdr[k] = 0;
+    else if ((clen = lz_compress (src, n, dst, n - 1)) > 0)
+        b->hdr[k] = clen;
+    else
+        b->hdr[k] = -n;                                 /* written from memory as is */
+}
+
+static void memimg_expand_block (memimg_batch* b, uint32 k)
+{
+    t_byte* dst = b->mem + (b->first + k) * MEMIMG_BLOCK;
+    int32 n = memimg_block_size (b, k);
+    const t_byte* src = b->buf + (t_addr) k * MEMIMG_BLOCK;
+
+    if (b->hdr[k] == 0)
+        memset (dst, 0, n);
+    else if (b->hdr[k] < 0)
+        memcpy (dst, src, n);
+    else if (! lz_expand (src, b->hdr[k], dst, n))
+        b->error = TRUE;
+}
+
+static void memimg_work (memimg_batch* b)
+{
+    uint32 k;
+    while ((k = smp_interlocked_increment (& smp_var(b->next)) - 1) < b->nblocks)
+        b->process (b, k);
+}
+
+static SMP_THREAD_ROUTINE_DECL memimg_thread (void* arg)
+{
+    memimg_batch* b = (memimg_batch*) arg;
+
+    smp_thread_init();
+    smp_set_thread_name("MEMIMG");
+
+    for (;;)
+    {
+        b->go->wait();
+        if (b->quit)
+            break;
+        memimg_work (b);
+        b->done->release();
+    }
+
+    SMP_THREAD_ROUTINE_END;
+}
+
+/* Process all blocks of the batch, the calling thread taking part */
+static void memimg_run (memimg_batch* b, void (*process)(memimg_batch* b, uint32 k))
+{
+    b->process = process;
+    smp_var(b->next) = 0;
+
+    if (b->nthreads > 1)
+        b->go->release(b->nthreads - 1);
+    memimg_work (b);
+    for (uint32 ix = 1;  ix < b->nthreads;  ix++)
+        b->done->wait();
+}
+
+static t_bool memimg_init (memimg_batch* b, t_byte* mem, t_addr size)
+{
+    b->mem = mem;
+    b->size = size;
+    b->error = FALSE;
+    b->quit = FALSE;
+    b->nthreads = 1;
+    b->go = b->done = NULL;
+    b->buf = (t_byte*) malloc ((size_t) MEMIMG_BATCH * MEMIMG_BLOCK);
+    b->hdr = (int32*) malloc (MEMIMG_BATCH * sizeof(int32));
+    if (! b->buf || ! b->hdr)
+        return FALSE;
+
+    uint32 nthreads = (uint32) imax(1, imin(smp_ncpus, MEMIMG_MAXTHREADS));
+    if (nthreads > 1)
+    {
+        b->go = smp_semaphore::create(0);
+        b->done = smp_semaphore::create(0);
+        for (;  b->nthreads < nthreads;  b->nthreads++)
+            smp_create_thread (memimg_thread, b, & b->thread[b->nthreads]);
+    }
+
+    return TRUE;
+}
+
+static void memimg_done (memimg_batch* b)
+{
+    if (b->nthreads > 1)
+    {
+        b->quit = TRUE;
+        b->go->release(b->nthreads - 1);
+        for (uint32 ix = 1;  ix < b->nthreads;  ix++)
+            smp_wait_thread (b->thread[ix]);
+    }
+    delete b->go;
+    delete b->done;
+    free (b->buf);
+    free (b->hdr);
+}
+
+/* Write memory image of the given size */
+t_stat sim_memimg_save (SMP_FILE* sfile, const t_byte* mem, t_addr size)
+{
+    t_addr nblocks = (size + MEMIMG_BLOCK - 1) / MEMIMG_BLOCK;
+    memimg_batch b;
+    t_stat r = SCPE_OK;
+
+    if (! memimg_init (&b, (t_byte*) mem, size))
+    {
+        memimg_done (&b);
+        return SCPE_MEM;
+    }
+
+    for (b.first = 0;  b.first < nblocks && r == SCPE_OK;  b.first += b.nblocks)
+    {
+        b.nblocks = (uint32) ((nblocks - b.first) < MEMIMG_BATCH ? (nblocks - b.first) : MEMIMG_BATCH);
+        memimg_run (&b, memimg_compress_block);
+
+        for (uint32 k = 0;  k < b.nblocks;  k++)
+        {
+            int32 hdr = b.hdr[k];
+            sim_fwrite (&hdr, sizeof(hdr), 1, sfile);
+            if (hdr > 0)
+                fwrite (b.buf + (t_addr) k * MEMIMG_BLOCK, 1, hdr, sfile);
+            else if (hdr < 0)
+                fwrite (mem + (b.first + k) * MEMIMG_BLOCK, 1, -hdr, sfile);
+        }
+        if (ferror (sfile))
+            r = SCPE_IOERR;
+    }
+
+    memimg_done (&b);
+    return r;
+}
+
+/* Read memory image of the given size, as written by sim_memimg_save */
+t_stat sim_memimg_restore (SMP_FILE* rfile, t_byte* mem, t_addr size)
+{
+    t_addr nblocks = (size + MEMIMG_BLOCK - 1) / MEMIMG_BLOCK;
+    memimg_batch b;
+    t_stat r = SCPE_OK;
+
+    if (! memimg_init (&b, mem, size))
+    {
+        memimg_done (&b);
+        return SCPE_MEM;
+    }
+
+    for (b.first = 0;  b.first < nblocks && r == SCPE_OK;  b.first += b.nblocks)
+    {
+        b.nblocks = (uint32) ((nblocks - b.first) < MEMIMG_BATCH ? (nblocks - b.first) : MEMIMG_BATCH);
+
+        for (uint32 k = 0;  k < b.nblocks && r == SCPE_OK;  k++)
+        {
+            int32 hdr;
+            int32 len;
+            if (sim_fread (&hdr, sizeof(hdr), 1, rfile) != 1)
+            {
+                r = SCPE_IOERR;
+                break;
+            }
+            if (hdr < -MEMIMG_BLOCK || hdr > MEMIMG_BLOCK)      /* checked before negating */
+            {
+                r = SCPE_INCOMP;
+                break;
+            }
+            len = (hdr < 0) ? -hdr : hdr;
+            if (hdr < 0 && len != memimg_block_size (&b, k))
+                r = SCPE_INCOMP;
+            else if (len && fread (b.buf + (t_addr) k * MEMIMG_BLOCK, 1, len, rfile) != (size_t) len)
+                r = SCPE_IOERR;
+            b.hdr[k] = hdr;
+        }
+
+        if (r == SCPE_OK)
+        {
+            memimg_run (&b, memimg_expand_block);
+            if (b.error)
+                r = SCPE_INCOMP;
+        }
+    }
+
+    memimg_done (&b);
+    return r;
+}
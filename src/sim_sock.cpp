@@ -48,6 +48,7 @@
    sim_accept_conn      accept connection
    sim_read_sock        read from socket
    sim_write_sock       write from socket
+   sim_writev_sock      write two buffers to socket in one call
    sim_close_sock       close socket
    sim_setnonblock      set socket non-blocking
    sim_msg_sock         send message to socket
@@ -87,6 +88,11 @@ int32 sim_write_sock (SOCKET sock, const char *msg, int32 nbytes)
 return 0;
 }
 
+int32 sim_writev_sock (SOCKET sock, const char *msg1, int32 nbytes1, const char *msg2, int32 nbytes2)
+{
+return 0;
+}
+
 void sim_close_sock (SOCKET sock, t_bool master)
 {
 return;
@@ -278,6 +284,41 @@ int32 sim_write_sock (SOCKET sock, const char *msg, int32 nbytes)
 return send (sock, msg, nbytes, 0);
 }
 
+/* Write two buffers (typically both parts of a wrapped ring) with a single
+   system call; returns total number of bytes sent or SOCKET_ERROR */
+
+int32 sim_writev_sock (SOCKET sock, const char *msg1, int32 nbytes1, const char *msg2, int32 nbytes2)
+{
+#if defined (_WIN32)
+WSABUF wb[2];
+DWORD sent;
+
+wb[0].buf = (char *) msg1;
+wb[0].len = nbytes1;
+wb[1].buf = (char *) msg2;
+wb[1].len = nbytes2;
+if (WSASend (sock, wb, 2, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+    return SOCKET_ERROR;
+return (int32) sent;
+#elif defined (VMS) || defined (__EMX__)
+int32 sbytes1, sbytes2;
+
+sbytes1 = sim_write_sock (sock, msg1, nbytes1);
+if (sbytes1 != nbytes1)                                 /* error or short write? */
+    return sbytes1;
+sbytes2 = sim_write_sock (sock, msg2, nbytes2);
+return (sbytes2 == SOCKET_ERROR)? sbytes1: sbytes1 + sbytes2;
+#else
+struct iovec iov[2];
+
+iov[0].iov_base = (void *) msg1;
+iov[0].iov_len = nbytes1;
+iov[1].iov_base = (void *) msg2;
+iov[1].iov_len = nbytes2;
+return (int32) writev (sock, iov, 2);
+#endif
+}
+
 void sim_close_sock (SOCKET sock, t_bool master)
 {
 #if defined (_WIN32)
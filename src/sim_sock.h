@@ -61,6 +61,9 @@
 #include <netinet/in.h>                                 /* for sockaddr_in */
 #include <netdb.h>
 #include <sys/time.h>                                   /* for EMX */
+#if !defined (VMS) && !defined (__EMX__)
+#include <sys/uio.h>                                    /* for writev */
+#endif
 #endif
 
 #if defined (VMS)                                       /* VMS unique */
@@ -82,6 +85,7 @@ SOCKET sim_accept_conn (SOCKET master, uint32 *ipaddr);
 int32 sim_check_conn (SOCKET sock, t_bool rd);
 int32 sim_read_sock (SOCKET sock, char *buf, int32 nbytes);
 int32 sim_write_sock (SOCKET sock, const char *msg, int32 nbytes);
+int32 sim_writev_sock (SOCKET sock, const char *msg1, int32 nbytes1, const char *msg2, int32 nbytes2);
 void sim_close_sock (SOCKET sock, t_bool master);
 int32 sim_setnonblock (SOCKET sock);
 
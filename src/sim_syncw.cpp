@@ -1086,7 +1086,9 @@ t_stat syncw_checkinterval(RUN_DECL, t_bool resuming)
                 cpu_unit->syncw_wait_event->clear();
                 cpu_database_lock->unlock();
                 syncw_wakeup_wakeset();
+                t_uint64 wait_start = sim_os_nsec();
                 cpu_unit->syncw_wait_event->wait();
+                cpu_stats.syncw_ns += sim_os_nsec() - wait_start;
                 cpu_database_lock->lock();
                 syncw.seq++;
 
@@ -110,6 +110,7 @@ t_stat sim_tape_ioerr (UNIT *uptr);
 t_stat sim_tape_wrdata (UNIT *uptr, uint32 dat);
 uint32 sim_tape_tpc_map (UNIT *uptr, t_addr *map);
 t_addr sim_tape_tpc_fnd (UNIT *uptr, t_addr *map);
+static t_stat sim_tape_tpc_build (UNIT *uptr);
 
 #define TOP_DONE  0             /* close */
 #define TOP_RDRF  1             /* sim_tape_rdrecf_a */
@@ -130,6 +131,29 @@ t_addr sim_tape_tpc_fnd (UNIT *uptr, t_addr *map);
 #define TOP_RWND 16             /* sim_tape_rewind_a */
 #define TOP_POSN 17             /* sim_tape_position_a */
 
+/*
+ * Tape images are overwhelmingly accessed sequentially, whereas SIMH tape format code reads
+ * every record length and every record body with a separate seek-and-read through SMP_FILE,
+ * which takes the file lock and discards stdio buffer on each seek.
+ *
+ * To reduce this overhead, tape_context maintains a read-ahead window over the tape image.
+ * Record lengths and record data are served from the window while they fall within it, and
+ * the window is refilled with a single large read when they do not. Reverse reads refill
+ * the window so that it ends at the requested position. The window is invalidated by any
+ * write to the tape.
+ *
+ * On the write side the stream is given a large stdio buffer, and the seek preceding each
+ * write is elided if the stream is already positioned at the tape position, so consecutive
+ * records written forward are coalesced in the stdio buffer and issued to the host as large
+ * writes, either when the buffer fills or when the unit is flushed (by IOP thread for
+ * asynchronous units).
+ *
+ * Window and write state are accessed only by the thread currently performing I/O on the unit,
+ * i.e. either IOP thread or (for synchronous units) VCPU or console thread holding unit lock.
+ */
+#define TAPE_RDAHEAD_SIZE  (256 * 1024)                 /* read-ahead window size */
+#define TAPE_STDIO_BUFSIZE (256 * 1024)                 /* stdio buffer size for write coalescing */
+
 class tape_context : public aio_context
 {
 public:
@@ -137,11 +161,24 @@ public:
     {
         io_top = TOP_DONE;
         callback = NULL;
+        rd_buf = NULL;
+        rd_base = 0;
+        rd_len = 0;
+        rd_data = 0;
+        wr_pos = 0;
+        wr_valid = FALSE;
+        stdio_buf = NULL;
+    }
+    ~tape_context()
+    {
+        free(rd_buf);
+        free(stdio_buf);
     }
     void perform_flush();
     static void perform_flush(UNIT* uptr);
     t_bool has_request() { return io_top != TOP_DONE; }
     void perform_request();
+    void rd_invalidate() { rd_len = 0; }
 
 public:
     int                 io_top;
@@ -154,6 +191,14 @@ public:
     uint32              bpi;
     uint32              *objupdate;
     TAPE_PCALLBACK      callback;
+
+    uint8               *rd_buf;                        /* read-ahead window */
+    t_addr              rd_base;                        /* tape position of window start */
+    uint32              rd_len;                         /* valid bytes in window */
+    t_addr              rd_data;                        /* data of record located by rdlntf/rdlntr */
+    t_addr              wr_pos;                         /* stream position after last write */
+    t_bool              wr_valid;                       /* wr_pos is valid */
+    char                *stdio_buf;                     /* stdio buffer for the tape file */
 };
 
 #define tape_ctx up8                        /* Field in Unit structure which points to the tape_context */
@@ -382,7 +427,6 @@ return sim_tape_attach_ex (uptr, cptr, 0);
 t_stat sim_tape_attach_ex (UNIT *uptr, char *cptr, uint32 dbit)
 {
 tape_context* ctx;
-uint32 objc;
 DEVICE *dptr;
 char gbuf[CBUFSIZE];
 t_stat r;
@@ -399,31 +443,32 @@ if (sim_switches & SWMASK ('F')) {                      /* format spec? */
 r = attach_unit (uptr, cptr);                           /* attach unit */
 if (r != SCPE_OK)                                       /* error? */
     return r;
+
+uptr->tape_ctx = ctx = new tape_context(uptr);
+ctx->dptr = dptr;                                       /* save DEVICE pointer */
+ctx->dbit = dbit;                                       /* save debug bit */
+ctx->rd_buf = (uint8 *) malloc (TAPE_RDAHEAD_SIZE);     /* read-ahead window, optional */
+ctx->stdio_buf = (char *) malloc (TAPE_STDIO_BUFSIZE);  /* write coalescing, optional */
+if (ctx->stdio_buf &&
+    setvbuf (uptr->fileref, ctx->stdio_buf, _IOFBF, TAPE_STDIO_BUFSIZE)) {
+    free (ctx->stdio_buf);
+    ctx->stdio_buf = NULL;
+    }
+
 switch (MT_GET_FMT (uptr)) {                            /* case on format */
 
     case MTUF_F_TPC:                                    /* TPC */
-        objc = sim_tape_tpc_map (uptr, NULL);           /* get # objects */
-        if (objc == 0) {                                /* tape empty? */
+        /* record map is only needed for reverse motion, build it on first use */
+        if (sim_fsize_ex (uptr->fileref) < sizeof (t_tpclnt)) { /* tape empty? */
             sim_tape_detach (uptr);
             return SCPE_FMT;                            /* yes, complain */
             }
-        uptr->filebuf = calloc (objc + 1, sizeof (t_addr));
-        if (uptr->filebuf == NULL) {                    /* map allocated? */
-            sim_tape_detach (uptr);
-            return SCPE_MEM;                            /* no, complain */
-            }
-        uptr->hwmark = objc + 1;                        /* save map size */
-        sim_tape_tpc_map (uptr, (t_addr *) uptr->filebuf);      /* fill map */
         break;
 
     default:
         break;
         }
 
-uptr->tape_ctx = ctx = new tape_context(uptr);
-ctx->dptr = dptr;                                       /* save DEVICE pointer */
-ctx->dbit = dbit;                                       /* save debug bit */
-
 sim_tape_rewind (uptr);
 
 sim_tape_set_async (uptr, 0);
@@ -504,6 +549,88 @@ if (ctx->dptr->dctrl & reason) {
     }
 }
 
+/* Read from tape image through read-ahead window (internal routine)
+
+   Inputs:
+        uptr    =       pointer to tape unit
+        pos     =       tape position to read from
+        bptr    =       pointer to buffer
+        size    =       item size, as in sim_fread
+        count   =       item count
+        rev     =       TRUE if tape is moving in reverse direction
+   Outputs:
+        count of items read, short count at end of file or on error;
+        host I/O error is indicated by ferror (uptr->fileref) as after sim_fread
+
+   Transfers larger than the window bypass it.
+*/
+
+static size_t sim_tape_rdbuf (UNIT *uptr, t_addr pos, void *bptr, size_t size, size_t count, t_bool rev)
+{
+tape_context* ctx = (tape_context*) uptr->tape_ctx;
+size_t len = size * count;
+size_t avail;
+t_addr base;
+
+if (len == 0)
+    return 0;
+if (pos >= ctx->rd_base && pos + len <= ctx->rd_base + ctx->rd_len) {    /* in window? */
+    memcpy (bptr, ctx->rd_buf + (size_t) (pos - ctx->rd_base), len);
+    sim_buf_swap_data (bptr, size, count);
+    return count;
+    }
+ctx->wr_valid = FALSE;                                  /* stream is being read */
+if (ctx->rd_buf == NULL || len > TAPE_RDAHEAD_SIZE) {   /* no window or too large? */
+    sim_fseek (uptr->fileref, pos, SEEK_SET);
+    return sim_fread (bptr, size, count, uptr->fileref);
+    }
+if (rev)                                                /* window ends at request */
+    base = (pos + len > TAPE_RDAHEAD_SIZE)? pos + len - TAPE_RDAHEAD_SIZE: 0;
+else base = pos;                                        /* window starts at request */
+ctx->rd_invalidate ();
+sim_fseek (uptr->fileref, base, SEEK_SET);
+avail = sim_fread (ctx->rd_buf, sizeof (uint8), TAPE_RDAHEAD_SIZE, uptr->fileref);
+if (ferror (uptr->fileref))                             /* error? */
+    return 0;
+ctx->rd_base = base;
+ctx->rd_len = (uint32) avail;
+if (pos >= base + avail)                                /* past end of image? */
+    return 0;
+avail = (size_t) (base + avail - pos);
+if (avail < len)                                        /* partial items at eof */
+    count = avail / size;
+memcpy (bptr, ctx->rd_buf + (size_t) (pos - base), count * size);
+sim_buf_swap_data (bptr, size, count);
+return count;
+}
+
+/* Position tape image for write (internal routine)
+
+   Invalidates read-ahead window and seeks stream to the current tape
+   position, unless stream is already there after preceding write, which
+   lets consecutive writes coalesce in stdio buffer.
+*/
+
+static void sim_tape_wrpos (UNIT *uptr)
+{
+tape_context* ctx = (tape_context*) uptr->tape_ctx;
+
+ctx->rd_invalidate ();
+if (!ctx->wr_valid || ctx->wr_pos != uptr->pos)
+    sim_fseek (uptr->fileref, uptr->pos, SEEK_SET);
+ctx->wr_valid = FALSE;
+}
+
+/* Record completion of write at current tape position (internal routine) */
+
+static void sim_tape_wrdone (UNIT *uptr)
+{
+tape_context* ctx = (tape_context*) uptr->tape_ctx;
+
+ctx->wr_pos = uptr->pos;
+ctx->wr_valid = TRUE;
+}
+
 /* Read record length forward (internal routine)
 
    Inputs:
@@ -518,44 +645,44 @@ if (ctx->dptr->dctrl & reason) {
    read error           unchanged, PNU set
    end of file/medium   unchanged, PNU set
    tape mark            updated
-   data record          updated, sim_fread will read record forward
+   data record          updated, record data position saved in tape context
 
    See notes at "sim_tape_wrgap" regarding erase gap implementation.
 */
 
 t_stat sim_tape_rdlntf (UNIT *uptr, t_mtrlnt *bc)
 {
+tape_context* ctx = (tape_context*) uptr->tape_ctx;
 uint8 c;
 t_bool all_eof;
 uint32 f = MT_GET_FMT (uptr);
 t_mtrlnt sbc;
 t_tpclnt tpcbc;
+size_t i;
 
 MT_CLR_PNU (uptr);
 if ((uptr->flags & UNIT_ATT) == 0)                      /* not attached? */
     return MTSE_UNATT;
-sim_fseek (uptr->fileref, uptr->pos, SEEK_SET);         /* set tape pos */
 switch (f) {                                            /* switch on fmt */
 
     case MTUF_F_STD: case MTUF_F_E11:
         do {
-            sim_fread (bc, sizeof (t_mtrlnt), 1, uptr->fileref);    /* read rec lnt */
+            i = sim_tape_rdbuf (uptr, uptr->pos, bc, sizeof (t_mtrlnt), 1, FALSE);  /* read rec lnt */
             sbc = MTR_L (*bc);                          /* save rec lnt */
             if (ferror (uptr->fileref)) {               /* error? */
                 MT_SET_PNU (uptr);                      /* pos not upd */
                 return sim_tape_ioerr (uptr);
                 }
-            if (feof (uptr->fileref) || (*bc == MTR_EOM)) {     /* eof or eom? */
+            if ((i == 0) || (*bc == MTR_EOM)) {         /* eof or eom? */
                 MT_SET_PNU (uptr);                      /* pos not upd */
                 return MTSE_EOM;
                 }
             uptr->pos = uptr->pos + sizeof (t_mtrlnt);  /* spc over rec lnt */
+            ctx->rd_data = uptr->pos;                   /* record data follows */
             if (*bc == MTR_TMK)                         /* tape mark? */
                 return MTSE_TMK;
-            if (*bc == MTR_FHGAP) {                     /* half gap? */
+            if (*bc == MTR_FHGAP)                       /* half gap? */
                 uptr->pos = uptr->pos + sizeof (t_mtrlnt) / 2;  /* half space fwd */
-                sim_fseek (uptr->fileref, uptr->pos, SEEK_SET); /* resync */
-                }
             else if (*bc != MTR_GAP)
                 uptr->pos = uptr->pos + sizeof (t_mtrlnt) +     /* spc over record */
                     ((f == MTUF_F_STD)? ((sbc + 1) & ~1): sbc);
@@ -564,17 +691,18 @@ switch (f) {                                            /* switch on fmt */
         break;
 
     case MTUF_F_TPC:
-        sim_fread (&tpcbc, sizeof (t_tpclnt), 1, uptr->fileref);
+        i = sim_tape_rdbuf (uptr, uptr->pos, &tpcbc, sizeof (t_tpclnt), 1, FALSE);
         *bc = tpcbc;                                    /* save rec lnt */
         if (ferror (uptr->fileref)) {                   /* error? */
             MT_SET_PNU (uptr);                          /* pos not upd */
             return sim_tape_ioerr (uptr);
             }
-        if (feof (uptr->fileref)) {                     /* eof? */
+        if (i == 0) {                                   /* eof? */
             MT_SET_PNU (uptr);                          /* pos not upd */
             return MTSE_EOM;
             }
         uptr->pos = uptr->pos + sizeof (t_tpclnt);      /* spc over reclnt */
+        ctx->rd_data = uptr->pos;                       /* record data follows */
         if (tpcbc == TPC_TMK)                           /* tape mark? */
             return MTSE_TMK;
         uptr->pos = uptr->pos + ((tpcbc + 1) & ~1);     /* spc over record */
@@ -582,12 +710,12 @@ switch (f) {                                            /* switch on fmt */
 
     case MTUF_F_P7B:
         for (sbc = 0, all_eof = 1; ; sbc++) {           /* loop thru record */
-            sim_fread (&c, sizeof (uint8), 1, uptr->fileref);
+            i = sim_tape_rdbuf (uptr, uptr->pos + sbc, &c, sizeof (uint8), 1, FALSE);
             if (ferror (uptr->fileref)) {               /* error? */
                 MT_SET_PNU (uptr);                      /* pos not upd */
                 return sim_tape_ioerr (uptr);
                 }
-            if (feof (uptr->fileref)) {                 /* eof? */
+            if (i == 0) {                               /* eof? */
                 if (sbc == 0)                           /* no data? eom */
                     return MTSE_EOM;
                 break;                                  /* treat like eor */
@@ -598,7 +726,7 @@ switch (f) {                                            /* switch on fmt */
                 all_eof = 0;
             }
         *bc = sbc;                                      /* save rec lnt */
-        sim_fseek (uptr->fileref, uptr->pos, SEEK_SET); /* for read */
+        ctx->rd_data = uptr->pos;                       /* for read */
         uptr->pos = uptr->pos + sbc;                    /* spc over record */
         if (all_eof)                                    /* tape mark? */
             return MTSE_TMK;
@@ -627,19 +755,21 @@ return MTSE_OK;
    end of file          unchanged
    end of medium        updated
    tape mark            updated
-   data record          updated, sim_fread will read record forward
+   data record          updated, record data position saved in tape context
 
    See notes at "sim_tape_wrgap" regarding erase gap implementation.
 */
 
 t_stat sim_tape_rdlntr (UNIT *uptr, t_mtrlnt *bc)
 {
+tape_context* ctx = (tape_context*) uptr->tape_ctx;
 uint8 c;
 t_bool all_eof;
 uint32 f = MT_GET_FMT (uptr);
 t_addr ppos;
 t_mtrlnt sbc;
 t_tpclnt tpcbc;
+size_t i;
 
 MT_CLR_PNU (uptr);
 if ((uptr->flags & UNIT_ATT) == 0)                      /* not attached? */
@@ -650,26 +780,23 @@ switch (f) {                                            /* switch on fmt */
 
     case MTUF_F_STD: case MTUF_F_E11:
         do {
-            sim_fseek (uptr->fileref, uptr->pos - sizeof (t_mtrlnt), SEEK_SET);
-            sim_fread (bc, sizeof (t_mtrlnt), 1, uptr->fileref);    /* read rec lnt */
+            i = sim_tape_rdbuf (uptr, uptr->pos - sizeof (t_mtrlnt), bc, sizeof (t_mtrlnt), 1, TRUE);  /* read rec lnt */
             sbc = MTR_L (*bc);
             if (ferror (uptr->fileref))                 /* error? */
                 return sim_tape_ioerr (uptr);
-            if (feof (uptr->fileref))                   /* eof? */
+            if (i == 0)                                 /* eof? */
                 return MTSE_EOM;
             uptr->pos = uptr->pos - sizeof (t_mtrlnt);  /* spc over rec lnt */
             if (*bc == MTR_EOM)                         /* eom? */
                 return MTSE_EOM;
             if (*bc == MTR_TMK)                         /* tape mark? */
                 return MTSE_TMK;
-            if ((*bc & MTR_M_RHGAP) == MTR_RHGAP) {     /* half gap? */
+            if ((*bc & MTR_M_RHGAP) == MTR_RHGAP)       /* half gap? */
                 uptr->pos = uptr->pos + sizeof (t_mtrlnt) / 2;  /* half space rev */
-                sim_fseek (uptr->fileref, uptr->pos, SEEK_SET); /* resync */
-                }
             else if (*bc != MTR_GAP) {
                 uptr->pos = uptr->pos - sizeof (t_mtrlnt) - /* spc over record */
                     ((f == MTUF_F_STD)? ((sbc + 1) & ~1): sbc);
-                sim_fseek (uptr->fileref, uptr->pos + sizeof (t_mtrlnt), SEEK_SET);
+                ctx->rd_data = uptr->pos + sizeof (t_mtrlnt);
                 }
             else if (sim_tape_bot (uptr))               /* backed into BOT? */
                 return MTSE_BOT;
@@ -678,27 +805,28 @@ switch (f) {                                            /* switch on fmt */
         break;
 
     case MTUF_F_TPC:
+        if ((uptr->filebuf == NULL) &&                  /* record map not built yet? */
+            (sim_tape_tpc_build (uptr) != SCPE_OK))
+            return sim_tape_ioerr (uptr);
         ppos = sim_tape_tpc_fnd (uptr, (t_addr *) uptr->filebuf); /* find prev rec */
-        sim_fseek (uptr->fileref, ppos, SEEK_SET);      /* position */
-        sim_fread (&tpcbc, sizeof (t_tpclnt), 1, uptr->fileref);
+        i = sim_tape_rdbuf (uptr, ppos, &tpcbc, sizeof (t_tpclnt), 1, TRUE);
         *bc = tpcbc;                                    /* save rec lnt */
         if (ferror (uptr->fileref))                     /* error? */
             return sim_tape_ioerr (uptr);
-        if (feof (uptr->fileref))                       /* eof? */
+        if (i == 0)                                     /* eof? */
             return MTSE_EOM;
         uptr->pos = ppos;                               /* spc over record */
         if (*bc == MTR_TMK)                             /* tape mark? */
             return MTSE_TMK;
-        sim_fseek (uptr->fileref, uptr->pos + sizeof (t_tpclnt), SEEK_SET);
+        ctx->rd_data = uptr->pos + sizeof (t_tpclnt);
         break;
 
     case MTUF_F_P7B:
         for (sbc = 1, all_eof = 1; (t_addr) sbc <= uptr->pos ; sbc++) {
-            sim_fseek (uptr->fileref, uptr->pos - sbc, SEEK_SET);
-            sim_fread (&c, sizeof (uint8), 1, uptr->fileref);
+            i = sim_tape_rdbuf (uptr, uptr->pos - sbc, &c, sizeof (uint8), 1, TRUE);
             if (ferror (uptr->fileref))                 /* error? */
                 return sim_tape_ioerr (uptr);
-            if (feof (uptr->fileref))                   /* eof? */
+            if (i == 0)                                 /* eof? */
                 return MTSE_EOM;
             if ((c & P7B_DPAR) != P7B_EOF)
                 all_eof = 0;
@@ -707,7 +835,7 @@ switch (f) {                                            /* switch on fmt */
             }
         uptr->pos = uptr->pos - sbc;                    /* update position */
         *bc = sbc;                                      /* save rec lnt */
-        sim_fseek (uptr->fileref, uptr->pos, SEEK_SET); /* for read */
+        ctx->rd_data = uptr->pos;                       /* for read */
         if (all_eof)                                    /* tape mark? */
             return MTSE_TMK;
         break;
@@ -759,7 +887,7 @@ if (rbc > max) {                                        /* rec out of range? */
     uptr->pos = opos;
     return MTSE_INVRL;
     }
-i = (t_mtrlnt) sim_fread (buf, sizeof (uint8), rbc, uptr->fileref);/* read record */
+i = (t_mtrlnt) sim_tape_rdbuf (uptr, ctx->rd_data, buf, sizeof (uint8), rbc, FALSE);/* read record */
 if (ferror (uptr->fileref)) {                           /* error? */
     MT_SET_PNU (uptr);
     uptr->pos = opos;
@@ -818,7 +946,7 @@ if (st = sim_tape_rdlntr (uptr, &tbc))                  /* read rec lnt */
 *bc = rbc = MTR_L (tbc);                                /* strip error flag */
 if (rbc > max)                                          /* rec out of range? */
     return MTSE_INVRL;
-i = (t_mtrlnt) sim_fread (buf, sizeof (uint8), rbc, uptr->fileref);/* read record */
+i = (t_mtrlnt) sim_tape_rdbuf (uptr, ctx->rd_data, buf, sizeof (uint8), rbc, TRUE);/* read record */
 if (ferror (uptr->fileref))                             /* error? */
     return sim_tape_ioerr (uptr);
 for ( ; i < rbc; i++)                                   /* fill with 0's */
@@ -870,7 +998,7 @@ if (sim_tape_wrp (uptr))                                /* write prot? */
     return MTSE_WRP;
 if (sbc == 0)                                           /* nothing to do? */
     return MTSE_OK;
-sim_fseek (uptr->fileref, uptr->pos, SEEK_SET);         /* set pos */
+sim_tape_wrpos (uptr);                                  /* set pos */
 switch (f) {                                            /* case on format */
 
     case MTUF_F_STD:                                    /* standard */
@@ -884,6 +1012,7 @@ switch (f) {                                            /* case on format */
             return sim_tape_ioerr (uptr);
             }
         uptr->pos = uptr->pos + sbc + (2 * sizeof (t_mtrlnt));  /* move tape */
+        sim_tape_wrdone (uptr);
         break;
 
     case MTUF_F_P7B:                                    /* Pierce 7B */
@@ -919,13 +1048,14 @@ if ((uptr->flags & UNIT_ATT) == 0)                      /* not attached? */
     return MTSE_UNATT;
 if (sim_tape_wrp (uptr))                                /* write prot? */
     return MTSE_WRP;
-sim_fseek (uptr->fileref, uptr->pos, SEEK_SET);         /* set pos */
+sim_tape_wrpos (uptr);                                  /* set pos */
 sim_fwrite (&dat, sizeof (t_mtrlnt), 1, uptr->fileref);
 if (ferror (uptr->fileref)) {                           /* error? */
     MT_SET_PNU (uptr);
     return sim_tape_ioerr (uptr);
     }
 uptr->pos = uptr->pos + sizeof (t_mtrlnt);              /* move tape */
+sim_tape_wrdone (uptr);
 return MTSE_OK;
 }
 
@@ -1111,6 +1241,8 @@ if (format != MTUF_F_STD)                               /* not SIMH fmt? */
 if (sim_tape_wrp (uptr))                                /* write protected? */
     return MTSE_WRP;
 
+ctx->rd_invalidate ();                                  /* stream is read and written */
+ctx->wr_valid = FALSE;                                  /*   directly below */
 file_size = sim_fsize (uptr->fileref);                  /* get file size */
 sim_fseek (uptr->fileref, uptr->pos, SEEK_SET);         /* position tape */
 
@@ -1816,8 +1948,14 @@ return (uptr->flags & MTUF_WRP)? TRUE: FALSE;
 
 t_stat sim_tape_ioerr (UNIT *uptr)
 {
+tape_context* ctx = (tape_context*) uptr->tape_ctx;
+
 smp_perror ("Magtape library I/O error");
 clearerr (uptr->fileref);
+if (ctx) {                                              /* stream state unknown */
+    ctx->rd_invalidate ();
+    ctx->wr_valid = FALSE;
+    }
 return MTSE_IOERR;
 }
 
@@ -1865,8 +2003,7 @@ uint32 objc;
 if ((uptr == NULL) || (uptr->fileref == NULL))
     return 0;
 for (objc = 0, tpos = 0;; ) {
-    sim_fseek (uptr->fileref, tpos, SEEK_SET);
-    i = sim_fread (&bc, sizeof (t_tpclnt), 1, uptr->fileref);
+    i = sim_tape_rdbuf (uptr, tpos, &bc, sizeof (t_tpclnt), 1, FALSE);
     if (i == 0)
         break;
     if (map)
@@ -1878,6 +2015,29 @@ if (map) map[objc] = tpos;
 return objc;
 }
 
+/* Build record map of a TPC format tape image
+
+   The map is only needed to space or read in reverse, so it is built on
+   first reverse motion rather than at attach time.
+*/
+
+static t_stat sim_tape_tpc_build (UNIT *uptr)
+{
+uint32 objc;
+t_addr *map;
+
+objc = sim_tape_tpc_map (uptr, NULL);                   /* get # objects */
+if (ferror (uptr->fileref))
+    return SCPE_IOERR;
+map = (t_addr *) calloc (objc + 1, sizeof (t_addr));
+if (map == NULL)                                        /* map allocated? */
+    return SCPE_MEM;
+sim_tape_tpc_map (uptr, map);                           /* fill map */
+uptr->filebuf = map;
+uptr->hwmark = objc + 1;                                /* save map size */
+return SCPE_OK;
+}
+
 /* Find the preceding record in a TPC file */
 
 t_addr sim_tape_tpc_fnd (UNIT *uptr, t_addr *map)
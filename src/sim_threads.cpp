@@ -23,6 +23,9 @@
 
 #if defined(__linux)
 #  include <sys/prctl.h>
+#  include <sys/eventfd.h>
+#  include <linux/futex.h>
+#  include <dirent.h>
 #endif
 
 #if defined(__APPLE__)
@@ -46,6 +49,7 @@ static int smp_get_smt_per_core();
 
 #if defined(__linux) || defined(__APPLE__)
 static void smp_set_thread_priority_init();
+static void smp_register_housekeeping_thread();
 #endif
 
 #if defined(__linux)
@@ -864,6 +868,24 @@ t_bool InterruptRegister::examine_int(uint32 ipl, uint32 dev)
     return 0 != (weak_read(irqs[ipl - lo_ipl]) & (1 << dev));
 }
 
+/* pending interrupt mask at "ipl", used by SAVE while VCPUs are paused */
+uint32 InterruptRegister::get_level(uint32 ipl)
+{
+    if (ipl < lo_ipl || ipl > hi_ipl)
+        return 0;
+    return weak_read(irqs[ipl - lo_ipl]);
+}
+
+/* replace pending interrupt mask at "ipl", used by RESTORE while VCPUs are paused */
+void InterruptRegister::set_level(uint32 ipl, uint32 mask)
+{
+    if (ipl < lo_ipl || ipl > hi_ipl)
+        return;
+    irqs[ipl - lo_ipl] = mask;
+    local_irqs[ipl - lo_ipl] = mask;
+    smp_var(changed) = TRUE;
+}
+
 /*
  * Check if there is any interrupt pending at exact "ipl" level using previously read
  * local_irqs.
@@ -1345,20 +1367,21 @@ void smp_set_thread_name(const char* name)
 
 /**********************  Windows -- TLS  **********************/
 
-t_bool smp_tls_alloc(smp_tls_key* key)
+/* fiber-local storage is used, as unlike TlsAlloc it can call a destructor on thread exit */
+t_bool smp_tls_alloc(smp_tls_key* key, smp_tls_dtor_t dtor)
 {
-    uint32 /*DWORD*/ dw = TlsAlloc();
-    return (*key = dw) != 0xFFFFFFFF;
+    uint32 /*DWORD*/ dw = FlsAlloc((PFLS_CALLBACK_FUNCTION) dtor);
+    return (*key = dw) != FLS_OUT_OF_INDEXES;
 }
 
 void tls_set_value(const smp_tls_key& key, void* value)
 {
-    TlsSetValue(key, value);
+    FlsSetValue(key, value);
 }
 
 void* tls_get_value(const smp_tls_key& key)
 {
-    return TlsGetValue(key);
+    return FlsGetValue(key);
 }
 
 /************************  Windows -- smp_lock  ************************/
@@ -2070,7 +2093,21 @@ t_bool smp_can_alloc_per_core(int nthreads)
     return smp_core_cpu_mask && smp_ncores >= nthreads;
 }
 
-void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how)
+t_bool smp_can_alloc_topology(int nvcpus)
+{
+    return FALSE;
+}
+
+void smp_set_housekeeping_affinity(smp_affinity_kind_t how)
+{
+}
+
+void smp_show_affinity(SMP_FILE* st, t_bool show_plan)
+{
+    fprintf(st, "Host processor topology is not available\n");
+}
+
+void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how, int vcpu)
 {
     if (how == SMP_AFFINITY_PER_CORE)
     {
@@ -2399,6 +2436,97 @@ t_bool smp_wait_thread(smp_thread_t thread_handle, t_value* exitcode, t_bool dot
 
 /**********************  Linux/OSX -- smp_semaphore  **********************/
 
+#if defined(__linux)
+/*
+ * On Linux pollable semaphore is an eventfd in semaphore mode: each read takes one unit and a write adds
+ * any number of units, so release(count) is a single system call regardless of count. The descriptor is
+ * non-blocking: trywait and clear do not need to toggle descriptor flags, and wait sleeps in poll.
+ */
+
+smp_semaphore_impl::smp_semaphore_impl()
+{
+    efd = -1;
+}
+
+smp_semaphore_impl::~smp_semaphore_impl()
+{
+    DECL_RESTARTABLE(rc);
+    if (efd != -1)  DO_RESTARTABLE(rc, close(efd));
+}
+
+t_bool smp_semaphore_impl::init(int initial_open_count, t_bool dothrow)
+{
+    efd = eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd != -1)
+    {
+        smp_wmb();
+        if (initial_open_count)
+            release(initial_open_count);
+        return TRUE;
+    }
+    else if (dothrow)
+    {
+        panic("Unable to initialize semaphore");
+        never_returns_bool_t;
+    }
+    else
+    {
+        return FALSE;
+    }
+}
+
+smp_pollable_handle_t smp_semaphore_impl::pollable_handle()
+{
+    return efd;
+}
+
+const char* smp_semaphore_impl::pollable_handle_op()
+{
+    return "R";
+}
+
+void smp_semaphore_impl::release(int count)
+{
+    DECL_RESTARTABLE(rc);
+    if (count <= 0)  return;
+    uint64_t v = (uint64_t) count;
+    DO_RESTARTABLE(rc, write(efd, &v, sizeof(v)));
+    if (rc != sizeof(v))
+        panic("Unable to release semaphore");
+}
+
+void smp_semaphore_impl::clear()
+{
+    while (trywait()) ;
+}
+
+void smp_semaphore_impl::wait()
+{
+    DECL_RESTARTABLE(rc);
+    while (! trywait())
+    {
+        struct pollfd pfd;
+        pfd.fd = efd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        DO_RESTARTABLE(rc, poll(&pfd, 1, -1));
+        if (rc == -1)
+            panic("Unable to acquire semaphore");
+    }
+}
+
+t_bool smp_semaphore_impl::trywait()
+{
+    DECL_RESTARTABLE(rc);
+    uint64_t v;
+    DO_RESTARTABLE(rc, read(efd, &v, sizeof(v)));
+    if (rc == sizeof(v))  return TRUE;
+    if (rc == -1 && errno == EAGAIN)  return FALSE;
+    panic("Unable to acquire semaphore");
+    never_returns_bool_t;
+}
+
+#else
 smp_semaphore_impl::smp_semaphore_impl()
 {
     fd[0] = fd[1] = -1;
@@ -2505,6 +2633,7 @@ t_bool smp_semaphore_impl::trywait()
     panic("Unimplemented: semaphore.trywait");
     never_returns_bool_t;
 }
+#endif
 
 /******************  Linux/OSX -- smp_simple_semaphore  ******************/
 
@@ -2519,6 +2648,112 @@ smp_simple_semaphore* smp_simple_semaphore::create(int initial_open_count, t_boo
     return sem;
 }
 
+#if defined(__linux)
+/*
+ * On Linux simple (non-pollable) semaphore is a futex word holding the count of available units.
+ * Units are taken and released with interlocked operations, the kernel is entered only to sleep when
+ * the count is zero, or to wake sleepers when there are any: release(count) wakes up to count waiters
+ * with one call. Before sleeping, waiter spins briefly in case the semaphore is about to be released,
+ * as it typically is on VCPU run gates.
+ */
+
+#define SMP_SEMAPHORE_SPIN  200         /* spin-wait loop cycles before sleeping */
+
+#define smp_sem_futex_wait(var, val)  syscall(SYS_futex, (int*) & (var), FUTEX_WAIT_PRIVATE, (val), NULL, NULL, 0)
+#define smp_sem_futex_wake(var, n)    syscall(SYS_futex, (int*) & (var), FUTEX_WAKE_PRIVATE, (n), NULL, NULL, 0)
+
+smp_simple_semaphore_impl::smp_simple_semaphore_impl()
+{
+    inited = FALSE;
+    count = 0;
+    nwaiters = 0;
+}
+
+smp_simple_semaphore_impl::~smp_simple_semaphore_impl()
+{
+}
+
+t_bool smp_simple_semaphore_impl::init(int initial_open_count, t_bool dothrow)
+{
+    if (! inited)
+    {
+        count = initial_open_count;
+        nwaiters = 0;
+        smp_wmb();
+        inited = TRUE;
+    }
+    return inited;
+}
+
+void smp_simple_semaphore_impl::clear()
+{
+    for (;;)
+    {
+        int32 c = count;
+        if (c <= 0 || smp_interlocked_cas(&count, c, 0) == c)
+            break;
+    }
+}
+
+void smp_simple_semaphore_impl::wait()
+{
+    if (trywait())
+        return;
+
+    if (smp_ncpus > 1)
+    {
+        for (int k = 0;  k < SMP_SEMAPHORE_SPIN;  k++)
+        {
+            smp_cpu_relax();
+            if (count > 0 && trywait())
+                return;
+        }
+    }
+
+    /*
+     * Register as a waiter before the final check of the count: release either sees the waiter
+     * and issues wake-up, or has already updated the count that futex wait compares against.
+     */
+    smp_interlocked_increment(&nwaiters);
+    while (! trywait())
+    {
+        if (smp_sem_futex_wait(count, 0) == -1 && errno != EAGAIN && errno != EINTR)
+            panic("Semaphore error");
+    }
+    smp_interlocked_decrement(&nwaiters);
+}
+
+t_bool smp_simple_semaphore_impl::trywait()
+{
+    for (;;)
+    {
+        int32 c = count;
+        if (c <= 0)
+            return FALSE;
+        if (smp_interlocked_cas(&count, c, c - 1) == c)
+            return TRUE;
+    }
+}
+
+void smp_simple_semaphore_impl::release(int n)
+{
+    if (n <= 0)  return;
+
+    for (;;)
+    {
+        int32 c = count;
+        if (smp_interlocked_cas(&count, c, c + n) == c)
+            break;
+    }
+
+    if (nwaiters != 0)
+    {
+        if (smp_sem_futex_wake(count, n) == -1)
+            panic("Semaphore error");
+    }
+}
+
+#else
 smp_simple_semaphore_impl::smp_simple_semaphore_impl()
 {
     inited = FALSE;
@@ -2580,6 +2815,7 @@ void smp_simple_semaphore_impl::release(int count)
         if (rc != 0)  panic("Semaphore error");
     }
 }
+#endif
 
 /**********************  Linux/OSX -- smp_barrier  **********************/
 
@@ -2919,6 +3155,11 @@ smp_event_impl::~smp_event_impl()
     }
 }
 
+#if defined(HAVE_POSIX_CLOCK_ID)
+static t_bool event_have_clock_id = FALSE;     /* clock the event condition variables actually time out on */
+static clockid_t event_clock_id;
+#endif
+
 t_bool smp_event_impl::init(t_bool dothrow)
 {
     t_bool inited_mutex = FALSE;
@@ -2931,6 +3172,13 @@ t_bool smp_event_impl::init(t_bool dothrow)
         inited_mutex = TRUE;
 
 #if defined(HAVE_POSIX_CLOCK_ID)
+    /*
+     * Condition variable timeouts are measured against the clock bound to the condition variable,
+     * not against sim_posix_clock_id.  Some clocks (e.g. CLOCK_MONOTONIC_RAW on Linux) are rejected
+     * by pthread_condattr_setclock, in which case the condition variable stays on CLOCK_REALTIME
+     * and timed_wait must compute its deadline on CLOCK_REALTIME too, otherwise the deadline lies
+     * in the past and every timed wait expires immediately.
+     */
     if (sim_posix_have_clock_id)
     {
         if (pthread_condattr_init(& cond_attr))
@@ -2940,7 +3188,13 @@ t_bool smp_event_impl::init(t_bool dothrow)
         {
             pthread_condattr_destroy(p_cond_attr);
             p_cond_attr = NULL;
+            event_clock_id = CLOCK_REALTIME;
+        }
+        else
+        {
+            event_clock_id = sim_posix_clock_id;
         }
+        event_have_clock_id = TRUE;
     }
 #endif
 
@@ -3094,7 +3348,14 @@ t_bool smp_event_impl::timed_wait(uint32 usec, uint32* p_actual_usec)
     get_now(& start);
 
     /* calculate wait end absolute time */
+#if defined(HAVE_POSIX_CLOCK_ID)
+    if (event_have_clock_id)
+        clock_gettime(event_clock_id, & target);
+    else
+        target = start;
+#else
     target = start;
+#endif
     target.tv_sec += usec / million;
     target.tv_nsec += (usec % million) * 1000;
     target.tv_sec += target.tv_nsec / billion;
@@ -3180,6 +3441,10 @@ void smp_event_impl::wait_and_clear()
 void run_scope_context::set_current()
 {
     pthread_setspecific(run_scope_key, this);
+
+    /* IOP and clock threads are placed on housekeeping processors, see smp_set_housekeeping_affinity */
+    if (thread_type == SIM_THREAD_TYPE_IOP || thread_type == SIM_THREAD_TYPE_CLOCK)
+        smp_register_housekeeping_thread();
 }
 
 void run_scope_context::set_current(run_scope_context* rscx)
@@ -3840,71 +4105,412 @@ t_bool smp_can_alloc_per_core(int nthreads)
     return smp_ncores >= nthreads;
 }
 
-void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how)
+/*
+ * Topology-aware placement (SET AFFINITY TOPOLOGY).
+ *
+ * Host topology is read from /sys/devices/system/cpu: every host core (the set of its SMT siblings)
+ * is tagged with its NUMA node and last-level cache domain.  Each VCPU is then pinned to the sibling
+ * set of a core of its own, so no two VCPUs share a core and VCPU spin-waits (syncw, interlocked
+ * instructions) do not compete with a sibling thread.  VCPU cores are taken from one LLC domain if
+ * it has enough cores, otherwise from one NUMA node, and only then spill across nodes.
+ *
+ * IOP, clock and other auxiliary threads (housekeeping threads) are confined to the cores left
+ * over after VCPU placement.  Domains and cores are taken from the top down, leaving the
+ * lowest-numbered cores (where the host tends to steer device interrupts) to housekeeping.
+ */
+typedef struct
+{
+    int cpu;                           /* lowest logical processor of the core, identifies the core */
+    int node;                          /* NUMA node */
+    int llc;                           /* lowest logical processor sharing the last-level cache */
+    int node_cores;                    /* cores in the node */
+    int llc_cores;                     /* cores in the LLC domain */
+    t_bool preferred;                  /* LLC domain that alone can hold all VCPUs */
+    cpu_set_t cpus;                    /* SMT siblings */
+}
+smp_topo_core_t;
+
+static int smp_topo_ncores = 0;        /* cores usable by the process */
+static int smp_topo_nvcpus = 0;        /* VCPUs in current placement plan */
+static smp_topo_core_t* smp_topo_cores = NULL;   /* sorted in placement order */
+static cpu_set_t smp_topo_hk_cpu_set;  /* processors for housekeeping threads */
+static t_bool smp_topo_hk_shared;      /* no spare cores, housekeeping shares VCPU cores */
+
+static t_bool smp_read_sysfs_line(int cpu, const char* leaf, char* buf, size_t bufsize)
+{
+    char path[256];
+    sprintf(path, "/sys/devices/system/cpu/cpu%d/%s", cpu, leaf);
+    FILE* fd = fopen(path, "r");
+    if (fd == NULL)
+        return FALSE;
+    t_bool ok = NULL != fgets(buf, (int) bufsize, fd);
+    fclose(fd);
+    return ok;
+}
+
+/* parse list like "0-3,8,10-11", return lowest listed processor or -1 */
+static int smp_parse_cpulist(const char* list, cpu_set_t* set)
 {
-    if (how == SMP_AFFINITY_PER_CORE)
-    {
-        pthread_setaffinity_np(thread_th, sizeof smp_core_cpu_set, & smp_core_cpu_set);
-    }
-    else
+    int lo, hi, low = -1;
+    char* xp;
+
+    CPU_ZERO(set);
+    while (*list)
     {
-        pthread_setaffinity_np(thread_th, sizeof smp_all_cpu_set, & smp_all_cpu_set);
+        lo = (int) strtol(list, &xp, 10);
+        if (xp == list)
+            break;
+        hi = lo;
+        list = xp;
+        if (*list == '-')
+        {
+            hi = (int) strtol(list + 1, &xp, 10);
+            list = xp;
+        }
+        for (int k = lo;  k <= hi && k < CPU_SETSIZE;  k++)
+            CPU_SET(k, set);
+        if (low < 0 || lo < low)
+            low = lo;
+        if (*list == ',')
+            list++;
     }
+    return low;
 }
-#endif
 
-/* ===========================================  OSX all architectures  =========================================== */
+static int smp_topo_node(int cpu)
+{
+    char path[64];
+    struct dirent* de;
+    int node = 0;
 
-#if defined(__APPLE__)
+    sprintf(path, "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = opendir(path);
+    if (dir == NULL)
+        return 0;
+    while (de = readdir(dir))
+    {
+        if (0 == strncmp(de->d_name, "node", 4) && 1 == sscanf(de->d_name + 4, "%d", & node))
+            break;
+    }
+    closedir(dir);
+    return node;
+}
 
-/**********************  OSX -- set thread priority **********************/
+static int smp_topo_llc(int cpu)
+{
+    char leaf[64];
+    char buf[1024];
+    cpu_set_t set;
+    int level, hi_level = -1, llc = cpu;
 
-static int cpu_calibration_priority = -1;
-static int cpu_kernel_critical_vm_priority = -1;
-static int cpu_kernel_critical_os_hi_priority = -1;
-static int cpu_kernel_critical_os_priority = -1;
-static int cpu_clock_hi_priority = -1;
-static int cpu_clock_lo_priority = -1;
-static int cpu_run_priority = -1;
-static int console_paused_priority = -1;
-static int console_run_priority = -1;
+    for (int index = 0;  ;  index++)
+    {
+        sprintf(leaf, "cache/index%d/level", index);
+        if (! smp_read_sysfs_line(cpu, leaf, buf, sizeof buf))
+            break;
+        if (1 != sscanf(buf, "%d", & level) || level <= hi_level)
+            continue;
+        sprintf(leaf, "cache/index%d/shared_cpu_list", index);
+        if (smp_read_sysfs_line(cpu, leaf, buf, sizeof buf))
+        {
+            int low = smp_parse_cpulist(buf, & set);
+            if (low >= 0)
+            {
+                hi_level = level;
+                llc = low;
+            }
+        }
+    }
 
-t_bool smp_set_thread_priority(sim_thread_priority_t prio)
-{
-    run_scope_context::get_current()->setting_priority(prio);
-    return smp_set_thread_priority(pthread_self(), prio);
+    return llc;
 }
 
-int smp_get_thread_os_priority(smp_thread_t thread_th)
+static int smp_topo_compare(const void* pa, const void* pb)
 {
-    int policy = SCHED_OTHER;
-    struct sched_param sc_param;
-    if (0 != rest_pthread_getschedparam(thread_th, & policy, & sc_param))
-        return -1;
-    return sc_param.sched_priority;
+    const smp_topo_core_t* a = (const smp_topo_core_t*) pa;
+    const smp_topo_core_t* b = (const smp_topo_core_t*) pb;
+
+    if (a->preferred != b->preferred)
+        return a->preferred ? -1 : 1;
+    if (a->node_cores != b->node_cores)
+        return b->node_cores - a->node_cores;
+    if (a->node != b->node)
+        return b->node - a->node;
+    if (a->llc_cores != b->llc_cores)
+        return b->llc_cores - a->llc_cores;
+    if (a->llc != b->llc)
+        return b->llc - a->llc;
+    return b->cpu - a->cpu;
 }
 
-t_bool smp_set_thread_priority(smp_thread_t thread_th, sim_thread_priority_t prio)
+/*
+ * Build placement plan for "nvcpus" VCPUs.
+ * Return FALSE if host topology is unknown or there are fewer usable cores than VCPUs.
+ */
+t_bool smp_can_alloc_topology(int nvcpus)
 {
-    int priority = -1;
-    int policy;
+    cpu_set_t allowed;
+    cpu_set_t seen;
+    char buf[1024];
+    int cpu, k, j;
+    smp_topo_core_t* cores = NULL;
+    int ncores = 0;
+    t_bool done = FALSE;
 
-    switch (prio)
-    {
-    /* CPU thread -- regular instruction stream execution */
-    case SIMH_THREAD_PRIORITY_CPU_RUN:
-        policy = SCHED_OTHER;
-        priority = cpu_run_priority;
-        break;
+    CHECK(nvcpus > 0);
+    CHECK(0 == sched_getaffinity(0, sizeof allowed, & allowed));
+    CPU_AND(& allowed, & allowed, & smp_all_cpu_set);
+    CPU_ZERO(& seen);
 
-    /* console thread -- while CPUs are paused */
-    case SIMH_THREAD_PRIORITY_CONSOLE_PAUSED:
-        policy = SCHED_OTHER;
-        priority = console_paused_priority;
-        break;
+    cores = (smp_topo_core_t*) calloc(CPU_COUNT(& allowed), sizeof(smp_topo_core_t));
+    CHECK(cores);
 
-    /* console thread -- while CPUs are running */
-    case SIMH_THREAD_PRIORITY_CONSOLE_RUN:
+    for (cpu = 0;  cpu < CPU_SETSIZE;  cpu++)
+    {
+        if (! CPU_ISSET(cpu, & allowed) || CPU_ISSET(cpu, & seen))
+            continue;
+
+        smp_topo_core_t* cp = & cores[ncores++];
+        CHECK(smp_read_sysfs_line(cpu, "topology/thread_siblings_list", buf, sizeof buf));
+        CHECK(smp_parse_cpulist(buf, & cp->cpus) >= 0);
+        CPU_OR(& seen, & seen, & cp->cpus);
+        CPU_AND(& cp->cpus, & cp->cpus, & allowed);
+        cp->cpu = cpu;
+        cp->node = smp_topo_node(cpu);
+        cp->llc = smp_topo_llc(cpu);
+    }
+
+    CHECK(ncores >= nvcpus);
+
+    for (k = 0;  k < ncores;  k++)
+    {
+        for (j = 0;  j < ncores;  j++)
+        {
+            if (cores[j].node == cores[k].node)
+                cores[k].node_cores++;
+            if (cores[j].llc == cores[k].llc)
+                cores[k].llc_cores++;
+        }
+    }
+
+    /* largest LLC domain is preferred if it alone can hold all VCPUs */
+    for (k = 0, j = -1;  k < ncores;  k++)
+    {
+        if (cores[k].llc_cores >= nvcpus && (j < 0 || cores[k].llc_cores >= cores[j].llc_cores))
+            j = k;
+    }
+    for (k = 0;  j >= 0 && k < ncores;  k++)
+        cores[k].preferred = (cores[k].llc == cores[j].llc);
+
+    qsort(cores, ncores, sizeof(smp_topo_core_t), smp_topo_compare);
+
+    CPU_ZERO(& smp_topo_hk_cpu_set);
+    for (k = nvcpus;  k < ncores;  k++)
+        CPU_OR(& smp_topo_hk_cpu_set, & smp_topo_hk_cpu_set, & cores[k].cpus);
+    smp_topo_hk_shared = (CPU_COUNT(& smp_topo_hk_cpu_set) == 0);
+    if (smp_topo_hk_shared)
+        smp_topo_hk_cpu_set = allowed;
+
+    if (smp_topo_cores)
+        free(smp_topo_cores);
+    smp_topo_cores = cores;
+    smp_topo_ncores = ncores;
+    smp_topo_nvcpus = nvcpus;
+    cores = NULL;
+    done = TRUE;
+
+cleanup:
+
+    if (cores)
+        free(cores);
+
+    return done;
+}
+
+void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how, int vcpu)
+{
+    if (how == SMP_AFFINITY_TOPOLOGY && vcpu >= 0 && vcpu < smp_topo_nvcpus)
+    {
+        pthread_setaffinity_np(thread_th, sizeof(cpu_set_t), & smp_topo_cores[vcpu].cpus);
+    }
+    else if (how == SMP_AFFINITY_PER_CORE)
+    {
+        pthread_setaffinity_np(thread_th, sizeof smp_core_cpu_set, & smp_core_cpu_set);
+    }
+    else
+    {
+        pthread_setaffinity_np(thread_th, sizeof smp_all_cpu_set, & smp_all_cpu_set);
+    }
+}
+
+/*
+ * Housekeeping threads register themselves on start (see run_scope_context::set_current)
+ * and are tracked by kernel thread id, so their affinity can be changed from the console
+ * thread when placement policy changes.  Thread-exit destructor of smp_hk_key removes the entry.
+ */
+#define SMP_MAX_HOUSEKEEPING_THREADS 256
+static pthread_mutex_t smp_hk_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t smp_hk_once = PTHREAD_ONCE_INIT;
+static pthread_key_t smp_hk_key;
+static pid_t smp_hk_tids[SMP_MAX_HOUSEKEEPING_THREADS];
+static int smp_hk_count = 0;
+static smp_affinity_kind_t smp_hk_affinity = SMP_AFFINITY_ALL;
+
+static const cpu_set_t* smp_hk_cpu_set()
+{
+    return (smp_hk_affinity == SMP_AFFINITY_TOPOLOGY && smp_topo_nvcpus) ? & smp_topo_hk_cpu_set : & smp_all_cpu_set;
+}
+
+static void smp_unregister_housekeeping_thread(void* arg)
+{
+    pid_t tid = (pid_t) (intptr_t) arg;
+
+    pthread_mutex_lock(& smp_hk_lock);
+    for (int k = 0;  k < smp_hk_count;  k++)
+    {
+        if (smp_hk_tids[k] == tid)
+        {
+            smp_hk_tids[k] = smp_hk_tids[--smp_hk_count];
+            break;
+        }
+    }
+    pthread_mutex_unlock(& smp_hk_lock);
+}
+
+static void smp_hk_key_init()
+{
+    if (pthread_key_create(& smp_hk_key, smp_unregister_housekeeping_thread))
+        panic("Unable to initialize thread-local storage");
+}
+
+static void smp_register_housekeeping_thread()
+{
+    pthread_once(& smp_hk_once, smp_hk_key_init);
+    if (pthread_getspecific(smp_hk_key))
+        return;
+
+    pid_t tid = gettid();
+
+    pthread_mutex_lock(& smp_hk_lock);
+    if (smp_hk_count < SMP_MAX_HOUSEKEEPING_THREADS)
+    {
+        smp_hk_tids[smp_hk_count++] = tid;
+        pthread_setspecific(smp_hk_key, (void*) (intptr_t) tid);
+    }
+    sched_setaffinity(tid, sizeof(cpu_set_t), smp_hk_cpu_set());
+    pthread_mutex_unlock(& smp_hk_lock);
+}
+
+void smp_set_housekeeping_affinity(smp_affinity_kind_t how)
+{
+    pthread_mutex_lock(& smp_hk_lock);
+    if (how != smp_hk_affinity || how == SMP_AFFINITY_TOPOLOGY)
+    {
+        smp_hk_affinity = how;
+        for (int k = 0;  k < smp_hk_count;  k++)
+            sched_setaffinity(smp_hk_tids[k], sizeof(cpu_set_t), smp_hk_cpu_set());
+    }
+    pthread_mutex_unlock(& smp_hk_lock);
+}
+
+static void smp_show_cpu_set(SMP_FILE* st, const cpu_set_t* set, const char* suffix)
+{
+    int lo, hi;
+    t_bool any = FALSE;
+
+    for (lo = 0;  lo < CPU_SETSIZE;  lo = hi + 1)
+    {
+        hi = lo;
+        if (! CPU_ISSET(lo, set))
+            continue;
+        while (hi + 1 < CPU_SETSIZE && CPU_ISSET(hi + 1, set))
+            hi++;
+        if (any)
+            fprintf(st, ",");
+        if (hi == lo)
+            fprintf(st, "%d", lo);
+        else
+            fprintf(st, "%d-%d", lo, hi);
+        any = TRUE;
+    }
+
+    fprintf(st, "%s%s\n", any ? "" : "none", suffix);
+}
+
+void smp_show_affinity(SMP_FILE* st, t_bool show_plan)
+{
+    fprintf(st, "Host processors: %d, cores: %d, SMT units per core: %d\n", smp_ncpus, smp_ncores, smp_smt_per_core);
+
+    if (! show_plan || smp_topo_nvcpus == 0)
+        return;
+
+    for (int k = 0;  k < smp_topo_nvcpus;  k++)
+    {
+        fprintf(st, "  CPU%02d on host processors ", k);
+        smp_show_cpu_set(st, & smp_topo_cores[k].cpus, "");
+    }
+
+    fprintf(st, "  IOP and CLOCK threads on host processors ");
+    smp_show_cpu_set(st, & smp_topo_hk_cpu_set, smp_topo_hk_shared ? " (shared with VCPUs)" : "");
+
+    fprintf(st, "  VCPU cores span %s\n", 
+            smp_topo_cores[0].llc == smp_topo_cores[smp_topo_nvcpus - 1].llc ? "one last-level cache domain" :
+            smp_topo_cores[0].node == smp_topo_cores[smp_topo_nvcpus - 1].node ? "one NUMA node" : "multiple NUMA nodes");
+}
+#endif
+
+/* ===========================================  OSX all architectures  =========================================== */
+
+#if defined(__APPLE__)
+
+/**********************  OSX -- set thread priority **********************/
+
+static int cpu_calibration_priority = -1;
+static int cpu_kernel_critical_vm_priority = -1;
+static int cpu_kernel_critical_os_hi_priority = -1;
+static int cpu_kernel_critical_os_priority = -1;
+static int cpu_clock_hi_priority = -1;
+static int cpu_clock_lo_priority = -1;
+static int cpu_run_priority = -1;
+static int console_paused_priority = -1;
+static int console_run_priority = -1;
+
+t_bool smp_set_thread_priority(sim_thread_priority_t prio)
+{
+    run_scope_context::get_current()->setting_priority(prio);
+    return smp_set_thread_priority(pthread_self(), prio);
+}
+
+int smp_get_thread_os_priority(smp_thread_t thread_th)
+{
+    int policy = SCHED_OTHER;
+    struct sched_param sc_param;
+    if (0 != rest_pthread_getschedparam(thread_th, & policy, & sc_param))
+        return -1;
+    return sc_param.sched_priority;
+}
+
+t_bool smp_set_thread_priority(smp_thread_t thread_th, sim_thread_priority_t prio)
+{
+    int priority = -1;
+    int policy;
+
+    switch (prio)
+    {
+    /* CPU thread -- regular instruction stream execution */
+    case SIMH_THREAD_PRIORITY_CPU_RUN:
+        policy = SCHED_OTHER;
+        priority = cpu_run_priority;
+        break;
+
+    /* console thread -- while CPUs are paused */
+    case SIMH_THREAD_PRIORITY_CONSOLE_PAUSED:
+        policy = SCHED_OTHER;
+        priority = console_paused_priority;
+        break;
+
+    /* console thread -- while CPUs are running */
+    case SIMH_THREAD_PRIORITY_CONSOLE_RUN:
         policy = SCHED_RR;
         priority = console_run_priority;
         break;
@@ -4154,7 +4760,25 @@ t_bool smp_can_alloc_per_core(int nthreads)
     return FALSE;
 }
 
-void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how)
+t_bool smp_can_alloc_topology(int nvcpus)
+{
+    return FALSE;
+}
+
+void smp_set_housekeeping_affinity(smp_affinity_kind_t how)
+{
+}
+
+static void smp_register_housekeeping_thread()
+{
+}
+
+void smp_show_affinity(SMP_FILE* st, t_bool show_plan)
+{
+    fprintf(st, "Host processor topology is not available\n");
+}
+
+void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how, int vcpu)
 {
     panic("smp_set_affinity: not implemented");
 }
@@ -4170,6 +4794,7 @@ void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how)
 #  define interlocked_incl_is_eq(var)  (interlocked_incl(var) == 0)
 #  define interlocked_decl_is_geq(var)  (interlocked_decl(var) >= 0)
 #  define interlocked_cas(var, oldvalue, newvalue)  __sync_val_compare_and_swap(& (var), (oldvalue), (newvalue))
+#  define interlocked_xchg(var, newvalue)  __sync_lock_test_and_set(& (var), (newvalue))
 #elif defined(_WIN32)
 #  define interlocked_incl(var)  smp_interlocked_increment(& (var))
 #  define interlocked_decl(var)  smp_interlocked_decrement(& (var))
@@ -4178,11 +4803,20 @@ void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how)
 #  define interlocked_cas(var, oldvalue, newvalue)  smp_interlocked_cas(& (var), (oldvalue), (newvalue))
 #endif
 
+#if defined(SMP_LOCK_USE_FUTEX)
+#  define smp_lock_futex_wait(var, val)  syscall(SYS_futex, & (var), FUTEX_WAIT_PRIVATE, (val), NULL, NULL, 0)
+#  define smp_lock_futex_wake(var, n)    syscall(SYS_futex, & (var), FUTEX_WAKE_PRIVATE, (n), NULL, NULL, 0)
+#endif
+
+/* adaptive spin-wait limit: SMP_LOCK_SPIN_ADAPT_FACTOR * spin_adapt + SMP_LOCK_SPIN_ADAPT_MIN, but no more than spin_count */
+#define SMP_LOCK_SPIN_ADAPT_FACTOR  2
+#define SMP_LOCK_SPIN_ADAPT_MIN     100
+
 smp_lock_impl::smp_lock_impl()
 {
     criticality = SIM_LOCK_CRITICALITY_NONE;
     inited = FALSE;
-#if !defined(_WIN32)
+#if !defined(_WIN32) && !defined(SMP_LOCK_USE_FUTEX)
     os_sem_decl_init(semaphore);
 #endif
     calibrating_spinloop = FALSE;
@@ -4194,21 +4828,30 @@ t_bool smp_lock_impl::init(uint32 cycles, t_bool dothrow)
     {
         if (! check_aligned(this, SMP_MAXCACHELINESIZE, dothrow))
             goto cleanup;
+#if defined(SMP_LOCK_USE_FUTEX)
+        if (! smp_check_aligned(& lock_state, dothrow))
+            goto cleanup;
+#else
         if (! smp_check_aligned(& lock_count, dothrow))
             goto cleanup;
+#endif
 
         /* gcc builtin __sync_add_and_fetch uses xaddl unavailable before i486 */
         /*             __sync_val_compare_and_swap uses cmpxchgl unavailable before i486 */
         if (!have_x86_xaddl || !have_x86_cmpxchgl)
             goto cleanup;
+#if defined(SMP_LOCK_USE_FUTEX)
+        smp_var(lock_state) = 0;
+#else
         smp_var(lock_count) = -1;
+#endif
         recursion_count = 0;
         owning_thread = 0;
-        spin_count = (smp_ncpus > 1) ? cycles : 0;
+        set_spin_count(cycles);
 #if defined(_WIN32)
         semaphore = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
         if (semaphore == NULL)  goto cleanup;
-#else
+#elif !defined(SMP_LOCK_USE_FUTEX)
         DECL_RESTARTABLE(rc);
         DO_RESTARTABLE(rc, os_sem_init(os_sem_ptr(semaphore), 0));
         if (rc == -1)  goto cleanup;
@@ -4238,7 +4881,7 @@ smp_lock_impl::~smp_lock_impl()
 #if defined(_WIN32)
     if (inited)
         CloseHandle(semaphore);
-#else
+#elif !defined(SMP_LOCK_USE_FUTEX)
     if (inited)
        os_sem_destroy(os_sem_ptr(semaphore));
 #endif
@@ -4247,6 +4890,7 @@ smp_lock_impl::~smp_lock_impl()
 void smp_lock_impl::set_spin_count(uint32 cycles)
 {
     spin_count = (smp_ncpus > 1) ? cycles : 0;
+    spin_adapt = spin_count / 4;
 }
 
 void smp_lock_impl::set_spin_count(uint32 us, uint32 min_cycles, uint32 max_cycles)
@@ -4269,10 +4913,12 @@ void smp_lock_impl::set_spin_count(uint32 us, uint32 min_cycles, uint32 max_cycl
     }
 
     spin_count = cycles;
+    spin_adapt = spin_count / 4;
 }
 
 void smp_lock_impl::set_perf_collect(t_bool collect)
 {
+    perf_hold_start = 0;
     perf_collect = collect;
 }
 
@@ -4282,6 +4928,41 @@ void smp_lock_impl::perf_reset()
     UINT64_SET_ZERO(perf_nowait_count);
     UINT64_SET_ZERO(perf_syswait_count);
     perf_avg_spinwait = 0;
+    perf_hold_start = 0;
+    memset(perf_wait_hist, 0, sizeof(perf_wait_hist));
+    memset(perf_hold_hist, 0, sizeof(perf_hold_hist));
+}
+
+static uint32 smp_lock_hist_bucket(t_uint64 ns)
+{
+    uint32 k = 0;
+    while (ns >>= 1)
+        k++;
+    return (k < SMP_LOCK_HIST_BUCKETS) ? k : SMP_LOCK_HIST_BUCKETS - 1;
+}
+
+static void smp_lock_hist_show(SMP_FILE* fp, const char* title, const uint32* hist)
+{
+    double total = 0;
+    int k, kmin = -1, kmax = -1;
+
+    for (k = 0;  k < SMP_LOCK_HIST_BUCKETS;  k++)
+    {
+        if (hist[k] == 0)  continue;
+        if (kmin < 0)  kmin = k;
+        kmax = k;
+        total += hist[k];
+    }
+
+    if (kmin < 0)
+        return;
+
+    fprintf(fp, "    %s (ns):\n", title);
+    for (k = kmin;  k <= kmax;  k++)
+    {
+        fprintf(fp, "        %10.0f - %-10.0f %10u  %5.1f%%\n",
+                k ? ldexp(1.0, k) : 0.0, ldexp(1.0, k + 1) - 1, hist[k], 100.0 * hist[k] / total);
+    }
 }
 
 void smp_lock_impl::perf_show(SMP_FILE* fp, const char* name)
@@ -4307,6 +4988,10 @@ void smp_lock_impl::perf_show(SMP_FILE* fp, const char* name)
     fprintf(fp, "    immediately: %g%%\n", 100.0 * UINT64_TO_DOUBLE(perf_nowait_count) / UINT64_TO_DOUBLE(perf_lock_count));
     fprintf(fp, "    blocking wait: %g%%\n", 100.0 * UINT64_TO_DOUBLE(perf_syswait_count) / UINT64_TO_DOUBLE(perf_lock_count));
     fprintf(fp, "    average spinwait (loop cycles): %.1f\n", perf_avg_spinwait);
+    fprintf(fp, "    spinwait limit (loop cycles): %u adaptive, %u max\n",
+            spin_count ? imin(spin_count, SMP_LOCK_SPIN_ADAPT_FACTOR * spin_adapt + SMP_LOCK_SPIN_ADAPT_MIN) : 0, spin_count);
+    smp_lock_hist_show(fp, "wait time when contended", perf_wait_hist);
+    smp_lock_hist_show(fp, "hold time", perf_hold_hist);
 }
 
 /*
@@ -4465,9 +5150,121 @@ void smp_lock_impl::lock()
     if (criticality != SIM_LOCK_CRITICALITY_NONE)
         critical_lock(criticality);
 
-    uint32 cycles = spin_count;
+    t_uint64 wait_start = 0;
+    if (unlikely(perf_collect))
+        wait_start = sim_os_nsec();
 
-    if (likely(spin_count != 0))
+    /* start of contention, for lock wait time accounting (SHOW CPU STATISTICS) */
+    t_uint64 contend_start = 0;
+
+    /*
+     * Spin-wait limit adapts to how long spinning took to succeed recently, as a proxy for the holding
+     * time of the lock and for whether lock holders tend to keep running while holding it. If spinning
+     * tends to fail (holder is preempted, or the section is long), the limit shrinks and contenders
+     * fall through to blocking wait quickly instead of burning host CPU. spin_count is the upper bound.
+     */
+    uint32 limit = spin_count;
+    uint32 cycles = 0;
+
+#if defined(SMP_LOCK_USE_FUTEX)
+    if (thread_eq(owning_thread, this_thread))
+    {
+        recursion_count++;
+        return;
+    }
+
+    if (likely(limit != 0))
+    {
+        if (likely(! calibrating_spinloop))
+            limit = imin(limit, SMP_LOCK_SPIN_ADAPT_FACTOR * spin_adapt + SMP_LOCK_SPIN_ADAPT_MIN);
+
+        for (;;)
+        {
+            if (smp_var(lock_state) == 0 && interlocked_cas(smp_var(lock_state), 0, 1) == 0)
+            {
+                smp_post_interlocked_mb();
+
+                owning_thread = this_thread;
+                recursion_count = 1;
+
+                if (cycles != 0)
+                {
+                    spin_adapt_update(cycles, TRUE);
+                    sim_lock_waited(contend_start);
+                }
+
+                /* record performance counters */
+                if (unlikely(perf_collect))
+                    perf_acquired(cycles, FALSE, wait_start);
+                return;
+            }
+
+            if (smp_var(lock_state) == 2)
+            {
+                // the lock is locked, and at least one more thread is already blocked waiting for it
+                // give up on spin-waiting
+                break;
+            }
+
+            smp_cpu_relax();
+
+            if (cycles++ == 0)
+                contend_start = sim_os_nsec();
+
+            if (cycles >= limit)
+            {
+                // make one last attempt at checking
+                if (smp_var(lock_state) != 0)
+                    // give up on spin-waiting
+                    break;
+            }
+        }
+
+        /* comes here for OS blocking wait */
+        if (unlikely(calibrating_spinloop))
+            return;
+
+        if (cycles >= limit)
+            spin_adapt_update(limit, FALSE);
+    }
+    else
+    {
+        if (interlocked_cas(smp_var(lock_state), 0, 1) == 0)
+        {
+            smp_post_interlocked_mb();
+            owning_thread = this_thread;
+            recursion_count = 1;
+
+            /* record performance counters */
+            if (unlikely(perf_collect))
+                perf_acquired(0, FALSE, wait_start);
+            return;
+        }
+    }
+
+    /*
+     * Mark the lock contended and sleep until it is released. Released lock is not handed off to a specific
+     * waiter: unlock frees it and wakes up one waiter that then competes for it on equal terms with running
+     * threads, so the lock is never left idle while the wakened thread is being scheduled.
+     * A thread that acquired the lock after sleeping keeps it marked contended, since more waiters may remain.
+     */
+    if (contend_start == 0)
+        contend_start = sim_os_nsec();
+
+    while (interlocked_xchg(smp_var(lock_state), 2) != 0)
+        smp_lock_futex_wait(smp_var(lock_state), 2);
+
+    smp_post_interlocked_mb();
+    owning_thread = this_thread;
+    recursion_count = 1;
+    sim_lock_waited(contend_start);
+
+    /* record performance counters */
+    if (unlikely(perf_collect))
+        perf_acquired(cycles, TRUE, wait_start);
+
+#else
+    if (likely(limit != 0))
     {
         if (thread_eq(owning_thread, this_thread))
         {
@@ -4476,6 +5273,9 @@ void smp_lock_impl::lock()
             return;
         }
 
+        if (likely(! calibrating_spinloop))
+            limit = imin(limit, SMP_LOCK_SPIN_ADAPT_FACTOR * spin_adapt + SMP_LOCK_SPIN_ADAPT_MIN);
+
         for (;;)
         {
             if (smp_var(lock_count) == -1 && interlocked_cas(smp_var(lock_count), -1, 0) == -1)
@@ -4485,9 +5285,15 @@ void smp_lock_impl::lock()
                 owning_thread = this_thread;
                 recursion_count = 1;
 
+                if (cycles != 0)
+                {
+                    spin_adapt_update(cycles, TRUE);
+                    sim_lock_waited(contend_start);
+                }
+
                 /* record performance counters */
                 if (unlikely(perf_collect))
-                    perf_acquired(cycles);
+                    perf_acquired(cycles, FALSE, wait_start);
                 return;
             }
 
@@ -4508,7 +5314,10 @@ void smp_lock_impl::lock()
              */
             smp_cpu_relax();
 
-            if (cycles == 0 || --cycles == 0)
+            if (cycles++ == 0)
+                contend_start = sim_os_nsec();
+
+            if (cycles >= limit)
             {
                 // make one last attempt at checking
                 if (smp_var(lock_count) != -1)
@@ -4516,21 +5325,26 @@ void smp_lock_impl::lock()
                     break;
             }
         }
-    }
 
-    /* comes here for OS blocking wait */
-    if (unlikely(calibrating_spinloop))
-        return;
+        /* comes here for OS blocking wait */
+        if (unlikely(calibrating_spinloop))
+            return;
+
+        if (cycles >= limit)
+            spin_adapt_update(limit, FALSE);
+    }
 
     if (interlocked_incl_is_eq(smp_var(lock_count)))
     {
         smp_post_interlocked_mb();
         owning_thread = this_thread;
         recursion_count = 1;
+        if (contend_start)
+            sim_lock_waited(contend_start);
 
         /* record performance counters */
         if (unlikely(perf_collect))
-            perf_acquired(cycles);
+            perf_acquired(cycles, FALSE, wait_start);
     }
     else if (thread_eq(owning_thread, this_thread))
     {
@@ -4538,6 +5352,9 @@ void smp_lock_impl::lock()
     }
     else
     {
+        if (contend_start == 0)
+            contend_start = sim_os_nsec();
+
 #if defined(_WIN32)
         switch (WaitForSingleObject(semaphore, INFINITE))
         {
@@ -4557,34 +5374,61 @@ void smp_lock_impl::lock()
 
         owning_thread = this_thread;
         recursion_count = 1;
+        sim_lock_waited(contend_start);
 
         /* record performance counters */
         if (unlikely(perf_collect))
-        {
-            UINT64_INC(perf_lock_count);
-            if (UINT64_ISMAX(perf_lock_count))
-                perf_collect = FALSE;
-            UINT64_INC(perf_syswait_count);
-        }
+            perf_acquired(cycles, TRUE, wait_start);
     }
+#endif
 }
 
 void smp_lock_impl::calibrate_spinloop()
 {
+#if defined(SMP_LOCK_USE_FUTEX)
+    smp_var(lock_state) = 1;
+    calibrating_spinloop = TRUE;
+    lock();
+    calibrating_spinloop = FALSE;
+    smp_var(lock_state) = 0;
+#else
     smp_var(lock_count) = 0;
     calibrating_spinloop = TRUE;
     lock();
     calibrating_spinloop = FALSE;
     smp_var(lock_count) = -1;
+#endif
 }
 
-void smp_lock_impl::perf_acquired(uint32 cycles)
+/*
+ * Running average of spin-wait length. Successful spins pull it towards the observed length,
+ * failed spins decay it towards zero, i.e. the limit towards SMP_LOCK_SPIN_ADAPT_MIN, so while
+ * holders keep getting preempted contenders stop burning host CPU and block almost at once.
+ * Updated without interlocking by contenders: it is merely a hint.
+ */
+void smp_lock_impl::spin_adapt_update(uint32 spun, t_bool acquired)
 {
+    int32 adapt = (int32) spin_adapt;
+    if (acquired)
+        adapt += ((int32) spun - adapt) / 8;
+    else
+        adapt -= adapt / 8;
+    spin_adapt = (uint32) ((adapt < 0) ? 0 : adapt);
+}
+
+void smp_lock_impl::perf_acquired(uint32 spun, t_bool syswait, t_uint64 wait_start)
+{
+    t_uint64 now = sim_os_nsec();
+
     UINT64_INC(perf_lock_count);
     if (UINT64_ISMAX(perf_lock_count))
         perf_collect = FALSE;
 
-    if (cycles == spin_count)
+    if (syswait)
+    {
+        UINT64_INC(perf_syswait_count);
+    }
+    else if (spun == 0)
     {
         /* no-wait case */
         UINT64_INC(perf_nowait_count);
@@ -4593,20 +5437,39 @@ void smp_lock_impl::perf_acquired(uint32 cycles)
     {
         /* number of previous wait cases */
         double prev_spinwait_count = (UINT64_TO_DOUBLE(perf_lock_count) - 1.0) - UINT64_TO_DOUBLE(perf_nowait_count) - UINT64_TO_DOUBLE(perf_syswait_count);
-        perf_avg_spinwait = (prev_spinwait_count * perf_avg_spinwait + (double) (spin_count - cycles)) / (prev_spinwait_count + 1.0);
+        perf_avg_spinwait = (prev_spinwait_count * perf_avg_spinwait + (double) spun) / (prev_spinwait_count + 1.0);
     }
+
+    if ((syswait || spun != 0) && wait_start != 0 && now >= wait_start)
+        perf_wait_hist[smp_lock_hist_bucket(now - wait_start)]++;
+
+    perf_hold_start = now;
 }
 
 void smp_lock_impl::unlock()
 {
     if (0 != --recursion_count)
     {
+#if !defined(SMP_LOCK_USE_FUTEX)
         interlocked_decl(smp_var(lock_count));
+#endif
     }
     else
     {
+        if (unlikely(perf_collect) && perf_hold_start != 0)
+        {
+            t_uint64 now = sim_os_nsec();
+            if (now >= perf_hold_start)
+                perf_hold_hist[smp_lock_hist_bucket(now - perf_hold_start)]++;
+            perf_hold_start = 0;
+        }
+
         owning_thread = 0;
         smp_pre_interlocked_mb();
+#if defined(SMP_LOCK_USE_FUTEX)
+        if (interlocked_xchg(smp_var(lock_state), 0) == 2)
+            smp_lock_futex_wake(smp_var(lock_state), 1);
+#else
         if (interlocked_decl_is_geq(smp_var(lock_count)))
         {
 #if defined(_WIN32)
@@ -4618,6 +5481,7 @@ void smp_lock_impl::unlock()
             if (rc != 0)  panic("Semaphore error");
 #endif
         }
+#endif
     }
 
     if (criticality != SIM_LOCK_CRITICALITY_NONE)
@@ -5175,3 +6039,196 @@ void sim_prefault_memory()
 {
     cpu_prefault_memory();
 }
+
+/* ====================================  sim_alloc_memory -- all platforms  ==================================== */
+
+/*
+ * Guest memory is mapped directly from the host rather than taken from the heap, so it comes
+ * zero-filled by the host without a pass over every page on the console thread.  Pages are
+ * faulted in later by sim_prefault_range, or eagerly by the host in PREFAULT POPULATE mode.
+ */
+#if defined(__linux) || defined(__APPLE__)
+#  include <sys/mman.h>
+#  if !defined(MAP_ANONYMOUS)
+#    define MAP_ANONYMOUS MAP_ANON
+#  endif
+#endif
+
+void* sim_alloc_memory(size_t size)
+{
+#if defined(_WIN32)
+    return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(__linux) || defined(__APPLE__)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#  if defined(MAP_POPULATE)
+    if (sim_ws_prefault == SIM_PREFAULT_POPULATE)
+        flags |= MAP_POPULATE;
+#  endif
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return (p == MAP_FAILED) ? NULL : p;
+#else
+    return calloc_aligned(size, 1, /*SMP_MAXCACHELINESIZE*/ 512);
+#endif
+}
+
+void sim_free_memory(void* p, size_t size)
+{
+    if (p == NULL)
+        return;
+#if defined(_WIN32)
+    VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(__linux) || defined(__APPLE__)
+    munmap(p, size);
+#else
+    free_aligned(p);
+#endif
+}
+
+/* ====================================  sim_prefault_range -- all platforms  ==================================== */
+
+/*
+ * Fault in a range of guest memory ahead of execution, so VCPU threads do not take first-touch
+ * page faults after boot.  The range is split into one stripe per VCPU, and each stripe is faulted
+ * in by a separate thread.  Under SET AFFINITY TOPOLOGY the thread for a stripe runs on the core
+ * of the corresponding VCPU, so first-touch placement puts the stripe on that VCPU's NUMA node.
+ *
+ * Pages are faulted in for write (merely reading an untouched anonymous page maps the shared
+ * zero page and defers the real fault to the first store).  Memory contents are preserved:
+ * where the host has no populate-for-write request, each page is touched with an interlocked
+ * no-op store, so a concurrent DMA write from an IOP thread cannot be lost.
+ *
+ * Progress is reported on the console when the pass takes longer than PREFAULT_REPORT_MSEC.
+ */
+#define PREFAULT_PAGE           4096                    /* smallest host page size */
+#define PREFAULT_CHUNK          (4 * 1024 * 1024)       /* unit of work and of progress accounting */
+#define PREFAULT_MIN_STRIPE     (32 * 1024 * 1024)      /* do not spin up a thread for less than this */
+#define PREFAULT_MAXTHREADS     64
+#define PREFAULT_POLL_MSEC      100
+#define PREFAULT_REPORT_MSEC    1000
+
+typedef struct
+{
+    t_byte* base;                                       /* stripe start */
+    size_t size;                                        /* stripe size */
+    int vcpu;                                           /* VCPU the stripe is placed near */
+    smp_thread_t thread;
+    smp_interlocked_uint32* done;                       /* chunks completed, all stripes */
+}
+prefault_worker;
+
+static void prefault_pages(t_byte* base, size_t size)
+{
+#if defined(__linux) && defined(MADV_POPULATE_WRITE)
+    if (madvise(base, size, MADV_POPULATE_WRITE) == 0)
+        return;
+#endif
+    for (size_t off = 0;  off < size;  off += PREFAULT_PAGE)
+    {
+        smp_interlocked_uint32* p = (smp_interlocked_uint32*) (base + off);
+        uint32 v = *p;
+        smp_interlocked_cas(p, v, v);
+    }
+}
+
+static void prefault_stripe(prefault_worker* w)
+{
+    for (size_t off = 0;  off < w->size;  off += PREFAULT_CHUNK)
+    {
+        size_t len = w->size - off;
+        if (len > PREFAULT_CHUNK)
+            len = PREFAULT_CHUNK;
+        prefault_pages(w->base + off, len);
+        smp_interlocked_increment(w->done);
+    }
+}
+
+static SMP_THREAD_ROUTINE_DECL prefault_thread(void* arg)
+{
+    prefault_worker* w = (prefault_worker*) arg;
+
+    smp_thread_init();
+    smp_set_thread_name("PREFAULT");
+    if (sim_vcpu_affinity == SMP_AFFINITY_TOPOLOGY)
+        smp_set_affinity(w->thread, SMP_AFFINITY_TOPOLOGY, w->vcpu);
+    prefault_stripe(w);
+
+    SMP_THREAD_ROUTINE_END;
+}
+
+static void prefault_report(const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    char buf[128];
+    vsprintf(buf, fmt, va);
+    va_end(va);
+
+    smp_printf("%s", buf);
+    if (sim_log)
+        fprintf(sim_log, "%s", buf);
+}
+
+void sim_prefault_range(void* base, size_t size)
+{
+    prefault_worker workers[PREFAULT_MAXTHREADS];
+    smp_interlocked_uint32 done = 0;
+    uint32 nthreads, ix;
+    uint32 nchunks = 0;
+    uint32 start = sim_os_msec();
+    uint32 last_report = 0;
+    size_t stripe;
+
+    if (base == NULL || size == 0)
+        return;
+
+#if defined(__linux) || defined(__APPLE__)
+    if (sim_ws_prefault == SIM_PREFAULT_ADVISE)
+    {
+        madvise(base, size, MADV_WILLNEED);
+        return;
+    }
+#endif
+
+    nthreads = imax(1, imin(imin((int) sim_ncpus, smp_ncpus), PREFAULT_MAXTHREADS));
+    while (nthreads > 1 && size / nthreads < PREFAULT_MIN_STRIPE)
+        nthreads--;
+
+    stripe = (size / nthreads + PREFAULT_CHUNK - 1) & ~((size_t) PREFAULT_CHUNK - 1);
+    for (ix = 0;  ix < nthreads;  ix++)
+    {
+        size_t off = stripe * ix;
+        workers[ix].base = (t_byte*) base + off;
+        workers[ix].size = (off >= size) ? 0 : (size - off < stripe) ? size - off : stripe;
+        workers[ix].vcpu = ix;
+        workers[ix].done = & done;
+        nchunks += (uint32) ((workers[ix].size + PREFAULT_CHUNK - 1) / PREFAULT_CHUNK);
+    }
+
+    if (nthreads == 1)
+    {
+        prefault_stripe(& workers[0]);
+        return;
+    }
+
+    for (ix = 0;  ix < nthreads;  ix++)
+        smp_create_thread(prefault_thread, & workers[ix], & workers[ix].thread);
+
+    while (done != nchunks)
+    {
+        sim_os_ms_sleep(PREFAULT_POLL_MSEC);
+        uint32 elapsed = sim_os_msec() - start;
+        if (elapsed >= last_report + PREFAULT_REPORT_MSEC && done != nchunks)
+        {
+            if (last_report == 0)
+                prefault_report("Prefaulting %u MB of memory on %u threads ...\n", (uint32) (size >> 20), nthreads);
+            prefault_report("  %u%% done\n", (uint32) ((t_uint64) done * 100 / nchunks));
+            last_report = elapsed;
+        }
+    }
+
+    for (ix = 0;  ix < nthreads;  ix++)
+        smp_wait_thread(workers[ix].thread);
+
+    if (last_report)
+        prefault_report("  completed in %.1f sec\n", (sim_os_msec() - start) / 1000.0);
+}
@@ -773,6 +773,7 @@ extern uint32 smp_spinwait_min_us;
 /* Helpers for locking/unlocking VM-critical objects */
 void critical_lock(sim_lock_criticality_t criticality);
 void critical_unlock(sim_lock_criticality_t criticality);
+void sim_lock_waited(t_uint64 wait_start);
 #define vm_critical_lock()     critical_lock(SIM_LOCK_CRITICALITY_VM)
 #define vm_critical_unlock()   critical_unlock(SIM_LOCK_CRITICALITY_VM)
 #define os_hi_critical_lock()     critical_lock(SIM_LOCK_CRITICALITY_OS_HI)
@@ -836,6 +837,8 @@ public:
     t_bool check_int_atipl_clr(RUN_DECL, uint32 ipl, uint32* int_dev);
     t_bool query_syncw_sys();
     t_bool examine_int(uint32 ipl, uint32 dev);
+    uint32 get_level(uint32 ipl);
+    void set_level(uint32 ipl, uint32 mask);
     // t_bool examine_int(uint32 ipl);
     // t_bool check_int(uint32 ipl, uint32* int_ipl);
     // t_bool check_int(uint32 ipl, uint32* int_ipl, uint32* int_dev);
@@ -847,17 +850,22 @@ protected:
     void show_aux_2(SMP_FILE* st, const char* intr, t_bool& none);
 };
 
+/* optional destructor is called on thread exit with the thread's non-NULL value */
 #if defined(_WIN32)
 typedef uint32 /*DWORD*/ smp_tls_key;
-t_bool smp_tls_alloc(smp_tls_key* key);
+#  define SMP_TLS_DTOR_DECL void __stdcall
+typedef void (__stdcall *smp_tls_dtor_t)(void*);
+t_bool smp_tls_alloc(smp_tls_key* key, smp_tls_dtor_t dtor = NULL);
 void tls_set_value(const smp_tls_key& key, void* value);
 void* tls_get_value(const smp_tls_key& key);
 #elif defined(__linux) || defined(__APPLE__)
 #  include <pthread.h>
 typedef pthread_key_t smp_tls_key;
-SIM_INLINE static t_bool smp_tls_alloc(smp_tls_key* key)
+#  define SMP_TLS_DTOR_DECL void
+typedef void (*smp_tls_dtor_t)(void*);
+SIM_INLINE static t_bool smp_tls_alloc(smp_tls_key* key, smp_tls_dtor_t dtor = NULL)
 {
-    return 0 == pthread_key_create(key, NULL);
+    return 0 == pthread_key_create(key, dtor);
 }
 SIM_INLINE static void tls_set_value(smp_tls_key& key, void* value)
 {
@@ -907,8 +915,9 @@ typedef int smp_pollable_handle_t;
 
 typedef enum
 {
-    SMP_AFFINITY_ALL = 0,
-    SMP_AFFINITY_PER_CORE = 1
+    SMP_AFFINITY_ALL = 0,              /* any host processor */
+    SMP_AFFINITY_PER_CORE = 1,         /* one logical processor per host core */
+    SMP_AFFINITY_TOPOLOGY = 2          /* VCPU: own host core, housekeeping threads: remaining cores */
 }
 smp_affinity_kind_t;
 
@@ -920,7 +929,10 @@ t_bool smp_set_thread_priority(smp_thread_t thread_th, sim_thread_priority_t pri
 void smp_set_thread_name(const char* name);
 int smp_get_thread_os_priority(smp_thread_t thread_th);
 t_bool smp_can_alloc_per_core(int nthreads);
-void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how);
+t_bool smp_can_alloc_topology(int nvcpus);
+void smp_set_affinity(smp_thread_t thread_th, smp_affinity_kind_t how, int vcpu = -1);
+void smp_set_housekeeping_affinity(smp_affinity_kind_t how);
+void smp_show_affinity(SMP_FILE* st, t_bool show_plan);
 
 class smp_synch_object
 {
@@ -1085,6 +1097,13 @@ void smp_show_thread_priority_info(SMP_FILE* st);
 #  define USE_SIMH_SMP_LOCK
 #endif
 
+/* on Linux smp_lock blocks on its lock word with futex rather than on a separate semaphore */
+#if defined(__linux) && defined(USE_SIMH_SMP_LOCK)
+#  define SMP_LOCK_USE_FUTEX
+#endif
+
+#define SMP_LOCK_HIST_BUCKETS  32       /* log2 ns buckets for lock hold/wait time histograms */
+
 class SIM_ALIGN_CACHELINE smp_lock_impl : public smp_lock
 {
 public:
@@ -1119,15 +1138,23 @@ public:
     void perf_show(SMP_FILE* fp, const char* name);
 
 protected:
-    void perf_acquired(uint32 cycles);
+    void perf_acquired(uint32 spun, t_bool syswait, t_uint64 wait_start);
+    void spin_adapt_update(uint32 spun, t_bool acquired);
 
 protected:
-    smp_interlocked_int32_var lock_count;
+#if defined(SMP_LOCK_USE_FUTEX)
+    smp_interlocked_int32_var lock_state;       /* futex word: 0 = free, 1 = held, 2 = held and contended */
+#else
+    smp_interlocked_int32_var lock_count;       /* -1 = free, 0 = held, n > 0 = held with n waiters */
+#endif
     volatile int32 recursion_count;
-    volatile uint32 spin_count;
+    volatile uint32 spin_count;                 /* spin-wait limit (loop cycles) */
+    volatile uint32 spin_adapt;                 /* recent spin-wait length to acquire (loop cycles) */
 #if defined(_WIN32)
     volatile DWORD owning_thread;
     HANDLE semaphore;
+#elif defined(SMP_LOCK_USE_FUTEX)
+    volatile pthread_t owning_thread;
 #else
     volatile pthread_t owning_thread;
     os_sem_declare(semaphore);
@@ -1144,6 +1171,9 @@ protected:
     UINT64 perf_nowait_count;
     UINT64 perf_syswait_count;
     double perf_avg_spinwait;
+    t_uint64 perf_hold_start;
+    uint32 perf_wait_hist[SMP_LOCK_HIST_BUCKETS];
+    uint32 perf_hold_hist[SMP_LOCK_HIST_BUCKETS];
 #endif
 
     /* dummy padding to prevent other data falling into the same cache line as lock data */
@@ -1253,7 +1283,11 @@ public:
 class smp_semaphore_impl : public smp_semaphore
 {
 private:
+#if defined(__linux)
+    int efd;                                    /* eventfd in semaphore mode */
+#else
     int fd[2];
+#endif
 
 public:
     smp_semaphore_impl();
@@ -1271,7 +1305,12 @@ class smp_simple_semaphore_impl : public smp_simple_semaphore
 {
 private:
     t_bool inited;
+#if defined(__linux)
+    smp_interlocked_int32 count;                /* futex word: available units */
+    smp_interlocked_uint32 nwaiters;            /* threads blocked or about to block */
+#else
     os_sem_declare(semaphore);
+#endif
 
 public:
     smp_simple_semaphore_impl();
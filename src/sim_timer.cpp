@@ -42,6 +42,9 @@
    sim_os_msec  -       return elapsed time in msec
    sim_os_sleep -       sleep specified number of seconds
    sim_os_ms_sleep -    sleep specified number of milliseconds
+   sim_os_thread_cpu_nsec - return host CPU time used by calling thread
+   sim_os_nsec -        return monotonic host time in nsec
+   sim_os_ns_sleep -    sleep specified number of nanoseconds
 
    The calibration, idle, and throttle routines are OS-independent; the _os_
    routines are not.
@@ -54,9 +57,10 @@
 #include "sim_defs.h"
 #include <ctype.h>
 
-#if defined(VM_VAX_MP)
-#  define SIM_NO_THROTTLING
-#endif
+/*
+ * sim_throt_unit is queued and serviced by every VCPU separately, hence throttle pacing state is kept per VCPU
+ * (see sim_throt_svc). Define SIM_NO_THROTTLING to build without throttling support.
+ */
 
 t_bool sim_idle_enab = FALSE;                           /* global flag */
 
@@ -68,12 +72,8 @@ clockid_t sim_posix_clock_id;
 
 static uint32 sim_idle_rate_us = 0;
 uint32 sim_idle_stable = SIM_IDLE_STDFLT;
-static uint32 sim_throt_ms_start = 0;
-static uint32 sim_throt_ms_stop = 0;
 static uint32 sim_throt_type = SIM_THROT_NONE;
 static uint32 sim_throt_val = 0;
-static uint32 sim_throt_state = 0;
-static int32 sim_throt_wait = 0;
 extern int32 sim_switches;
 extern SMP_FILE *sim_log;
 
@@ -890,6 +890,73 @@ void sim_os_gettime_vms(uint32* p_vms_time)
 
 #endif
 
+/* Host CPU time consumed by the calling thread, in nanoseconds (0 if not available) */
+
+t_uint64 sim_os_thread_cpu_nsec (void)
+{
+#if defined (_WIN32)
+    FILETIME ct, et, kt, ut;
+    if (! GetThreadTimes (GetCurrentThread (), &ct, &et, &kt, &ut))
+        return 0;
+    t_uint64 t = (((t_uint64) kt.dwHighDateTime << 32) | kt.dwLowDateTime) +
+                 (((t_uint64) ut.dwHighDateTime << 32) | ut.dwLowDateTime);
+    return t * 100;
+#elif defined(HAVE_POSIX_CLOCK_ID) && defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts))
+        return 0;
+    return (t_uint64) ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * Monotonic host time in nanoseconds, for fine-grained pacing.
+ *
+ * On Linux CLOCK_MONOTONIC is read through the vDSO and is backed by TSC when the kernel found it invariant
+ * and synchronized across processors (falling back to HPET/ACPI PM timer otherwise), so this is as cheap and
+ * precise as reading TSC directly, without the need to calibrate TSC frequency or to cope with unsynchronized
+ * TSCs on multi-socket hosts. Same holds for QueryPerformanceCounter on Windows.
+ */
+
+t_uint64 sim_os_nsec (void)
+{
+#if defined (_WIN32)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER pc;
+    if (freq.QuadPart == 0 && !QueryPerformanceFrequency (&freq))
+        freq.QuadPart = -1;
+    if (freq.QuadPart > 0 && QueryPerformanceCounter (&pc))
+        return (t_uint64) pc.QuadPart / freq.QuadPart * 1000000000 +
+               (t_uint64) pc.QuadPart % freq.QuadPart * 1000000000 / freq.QuadPart;
+    return (t_uint64) GetTickCount64 () * 1000 * 1000;
+#elif defined(HAVE_POSIX_CLOCK_ID) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    if (0 == clock_gettime (CLOCK_MONOTONIC, &ts))
+        return (t_uint64) ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+    return (t_uint64) sim_os_msec () * 1000 * 1000;
+#else
+    return (t_uint64) sim_os_msec () * 1000 * 1000;
+#endif
+}
+
+/* Sleep for the specified number of nanoseconds, rounded as host allows */
+
+void sim_os_ns_sleep (t_uint64 ns)
+{
+#if defined (_WIN32)
+    Sleep ((DWORD) ((ns + 500000) / 1000000));
+#elif defined(HAVE_POSIX_CLOCK_ID)
+    struct timespec treq;
+    treq.tv_sec = (time_t) (ns / 1000000000);
+    treq.tv_nsec = (long) (ns % 1000000000);
+    (void) nanosleep (&treq, NULL);
+#else
+    sim_os_ms_sleep ((unsigned int) ((ns + 999999) / 1000000));
+#endif
+}
+
 /* OS independent clock calibration package */
 
 // int32 rtc_ticks[SIM_NTIMERS] = { 0 };            /* ticks */
@@ -1026,7 +1093,9 @@ void sim_rtcn_init_secondary_cpu (CPU_UNIT* cpu_unit, CPU_UNIT* src, int32 tmr,
             cpu_unit->cpu_last_second_tick_cycles = CPU_CURRENT_CYCLES;
         }
 
-        rtc_currd[tmr] = weak_read_var(cpu_cycles_per_second) / rtc_hz[tmr];
+        /* source VCPU may not have taken its first clock tick yet, leave rate uncalibrated then */
+        if (rtc_hz[tmr])
+            rtc_currd[tmr] = weak_read_var(cpu_cycles_per_second) / rtc_hz[tmr];
 
         if (rtc_currd[tmr] <= 0)
             rtc_currd[tmr] = 1;
@@ -1646,6 +1715,7 @@ t_stat sim_idle(RUN_DECL, uint32 tmr, t_bool sin_cyc, uint32 maxticks)
 
     if (act_us != UINT32_MAX)
     {
+        cpu_stats.idle_us += act_us;
         cps2 = cpu_get_cycles_per_second(RUN_PASS);
         UINT64_FROM_UINT32(act_cyc64, (cps1 + cps2) / 2);
         UINT64_MUL_UINT32(act_cyc64, act_us);
@@ -1866,7 +1936,22 @@ t_stat sim_show_throt (SMP_FILE *st, DEVICE *dnotused, UNIT *unotused, int32 fla
         {
             fprintf (st, "Wait rate = %d us\n", sim_idle_rate_us);
             if (sim_throt_type != 0)
-                fprintf (st, "Throttle interval = %d cycles\n", sim_throt_wait);
+            {
+                for (uint32 cpu_ix = 0;  cpu_ix < sim_ncpus;  cpu_ix++)
+                {
+                    CPU_UNIT* xcpu = cpu_units[cpu_ix];
+                    t_uint64 elapsed_ns = xcpu->cpu_throt_ns - xcpu->cpu_throt_start_ns;
+                    if (xcpu->cpu_throt_start_ns == 0 || elapsed_ns == 0)
+                        continue;
+                    fprintf (st, "CPU%d: interval = %d cycles, rate = %.3f Mcps, unthrottled = %.3f Mcps, "
+                                 "slept %.1f%% in %u sleeps\n",
+                             cpu_ix, xcpu->cpu_throt_wait,
+                             (double) xcpu->cpu_throt_total_cycles * 1000.0 / (double) elapsed_ns,
+                             xcpu->cpu_throt_acps / 1000000.0,
+                             (double) xcpu->cpu_throt_slept_ns * 100.0 / (double) elapsed_ns,
+                             xcpu->cpu_throt_sleeps);
+                }
+            }
         }
     }
 #endif
@@ -1876,7 +1961,16 @@ t_stat sim_show_throt (SMP_FILE *st, DEVICE *dnotused, UNIT *unotused, int32 fla
 void sim_throt_sched (void)
 {
 #if !defined(SIM_NO_THROTTLING)
-    sim_throt_state = 0;
+    RUN_SCOPE;
+    /* unthrottled rate is a property of the host and is kept across pauses, pacing restarts afresh */
+    cpu_unit->cpu_throt_state = (cpu_unit->cpu_throt_acps != 0 || sim_throt_type != SIM_THROT_PCT) ? 1 : 0;
+    cpu_unit->cpu_throt_start_ns = 0;
+    cpu_unit->cpu_throt_debt_ns = 0;
+    cpu_unit->cpu_throt_calib_ns = 0;
+    cpu_unit->cpu_throt_calib_cycles = 0;
+    cpu_unit->cpu_throt_total_cycles = 0;
+    cpu_unit->cpu_throt_slept_ns = 0;
+    cpu_unit->cpu_throt_sleeps = 0;
     if (sim_throt_type)
         sim_activate (&sim_throt_unit, SIM_THROT_WINIT);
 #endif
@@ -1891,70 +1985,111 @@ void sim_throt_cancel (void)
 
 /* Throttle service
 
-   Throttle service has three distinct states
+   Throttling is a closed loop executed by each VCPU independently, on its own thread.
+
+   Every cpu_throt_wait cycles the VCPU compares host time its cycles should have taken at the target
+   rate against host time they actually took, and accumulates the difference in cpu_throt_debt_ns.
+   When the VCPU gets ahead of schedule by SIM_THROT_MINSLEEP_US or more, it sleeps the debt off.
+   Oversleep and host preemption turn the debt negative, and it is repaid by running subsequent
+   slices without sleeping; however no more than SIM_THROT_MAXLAG_MS of lag is carried, so a long
+   host stall does not turn into a burst of catch-up execution.
 
-   0        take initial measurement
-   1        take final measurement, calculate wait values
-   2        periodic waits to slow down the CPU
+   The check interval is sized to cover SIM_THROT_SLICE_US of host time at the target rate, so VCPU
+   progress is paced in sub-millisecond steps rather than alternating between running flat out and
+   sleeping for a whole host timer tick.
+
+   Throttle service has two states
+
+   0        measure unthrottled execution rate (only for percentage throttling)
+   1        pace execution, keep refining the unthrottled rate estimate
 */
 
 t_stat sim_throt_svc (RUN_SVC_DECL, UNIT *uptr)
 {
 #if !defined(SIM_NO_THROTTLING)
     // RUN_SVC_CHECK_CANCELLED(uptr);    // not required for per-CPU devices
-    uint32 delta_ms;
-    double a_cps, d_cps;
+    t_uint64 now = sim_os_nsec ();
+    uint32 cycles = CPU_CURRENT_CYCLES;
+    uint32 executed = cycles - cpu_unit->cpu_throt_cycles;
+    t_uint64 busy_ns;
+    double d_cps, wait;
 
-    switch (sim_throt_state)
+    if (cpu_unit->cpu_throt_start_ns == 0)              /* take initial reading */
     {
-    case 0:                                             /* take initial reading */
-        sim_throt_ms_start = sim_os_msec ();
-        sim_throt_wait = SIM_THROT_WST;
-        sim_throt_state++;                              /* next state */
-        break;                                          /* reschedule */
-
-    case 1:                                             /* take final reading */
-        sim_throt_ms_stop = sim_os_msec ();
-        delta_ms = sim_throt_ms_stop - sim_throt_ms_start;
-        if (delta_ms < SIM_THROT_MSMIN) {               /* not enough time? */
-            if (sim_throt_wait >= 100000000)            /* too many inst? */
-            {
-                sim_throt_state = 0;                    /* fails in 32b! */
-                return SCPE_OK;
-            }
-            sim_throt_wait = sim_throt_wait * SIM_THROT_WMUL;
-            sim_throt_ms_start = sim_throt_ms_stop;
-        }
-        else                                            /* long enough */
+        cpu_unit->cpu_throt_start_ns = now;
+        cpu_unit->cpu_throt_ns = now;
+        cpu_unit->cpu_throt_cycles = cycles;
+        if (cpu_unit->cpu_throt_state == 0 || cpu_unit->cpu_throt_wait <= 0)
+            cpu_unit->cpu_throt_wait = SIM_THROT_WST;
+        sim_activate (uptr, cpu_unit->cpu_throt_wait);
+        return SCPE_OK;
+    }
+
+    /* interval since the last check contains no throttle sleep */
+    busy_ns = (now > cpu_unit->cpu_throt_ns) ? now - cpu_unit->cpu_throt_ns : 0;
+    cpu_unit->cpu_throt_total_cycles += executed;
+
+    if (cpu_unit->cpu_throt_state == 0)                 /* measuring */
+    {
+        cpu_unit->cpu_throt_calib_ns += busy_ns;
+        cpu_unit->cpu_throt_calib_cycles += executed;
+        if (cpu_unit->cpu_throt_calib_ns < (t_uint64) SIM_THROT_MSMIN * 1000 * 1000)
         {
-            a_cps = ((double) sim_throt_wait) * 1000.0 / (double) delta_ms;
-            if (sim_throt_type == SIM_THROT_MCYC)       /* calc desired cps */
-                d_cps = (double) sim_throt_val * 1000000.0;
-            else if (sim_throt_type == SIM_THROT_KCYC)
-                d_cps = (double) sim_throt_val * 1000.0;
-            else d_cps = (a_cps * ((double) sim_throt_val)) / 100.0;
-            if (d_cps >= a_cps) {
-                sim_throt_state = 0;
-                return SCPE_OK;
-                }
-            sim_throt_wait = (int32)                    /* time between waits */
-                ((a_cps * d_cps * (double) sim_idle_rate_us) / (a_cps - d_cps));
-            if (sim_throt_wait < SIM_THROT_WMIN) {      /* not long enough? */
-                sim_throt_state = 0;
-                return SCPE_OK;
-                }
-            sim_throt_state++;
-//            fprintf (smp_stderr, "Throttle values a_cps = %f, d_cps = %f, wait = %d\n",
-//                a_cps, d_cps, sim_throt_wait);
+            if (cpu_unit->cpu_throt_wait < 100000000 / SIM_THROT_WMUL)
+                cpu_unit->cpu_throt_wait *= SIM_THROT_WMUL;
+            cpu_unit->cpu_throt_ns = now;
+            cpu_unit->cpu_throt_cycles = cycles;
+            sim_activate (uptr, cpu_unit->cpu_throt_wait);
+            return SCPE_OK;
         }
-        break;
+        cpu_unit->cpu_throt_acps = (double) cpu_unit->cpu_throt_calib_cycles * 1.0e9 / (double) cpu_unit->cpu_throt_calib_ns;
+        cpu_unit->cpu_throt_state++;
+        busy_ns = 0;                                    /* measured interval ran unpaced, do not charge it */
+        executed = 0;
+    }
+    else if (busy_ns != 0)                              /* refine unthrottled rate estimate */
+    {
+        double a_cps = (double) executed * 1.0e9 / (double) busy_ns;
+        if (cpu_unit->cpu_throt_acps == 0)
+            cpu_unit->cpu_throt_acps = a_cps;
+        else
+            cpu_unit->cpu_throt_acps += (a_cps - cpu_unit->cpu_throt_acps) / 16;
+    }
 
-    case 2:                                             /* throttling */
-        sim_os_ms_sleep (1);
-        break;
+    if (sim_throt_type == SIM_THROT_MCYC)               /* calc desired cps */
+        d_cps = (double) sim_throt_val * 1000000.0;
+    else if (sim_throt_type == SIM_THROT_KCYC)
+        d_cps = (double) sim_throt_val * 1000.0;
+    else
+        d_cps = (cpu_unit->cpu_throt_acps * (double) sim_throt_val) / 100.0;
+    if (d_cps < 1000.0)
+        d_cps = 1000.0;
+
+    /* host time the slice should have taken minus time it took */
+    cpu_unit->cpu_throt_debt_ns += (double) executed * 1.0e9 / d_cps - (double) busy_ns;
+    if (cpu_unit->cpu_throt_debt_ns < -(double) SIM_THROT_MAXLAG_MS * 1000.0 * 1000.0)
+        cpu_unit->cpu_throt_debt_ns = -(double) SIM_THROT_MAXLAG_MS * 1000.0 * 1000.0;
+
+    if (cpu_unit->cpu_throt_debt_ns >= (double) SIM_THROT_MINSLEEP_US * 1000.0)
+    {
+        t_uint64 t0 = now;
+        sim_os_ns_sleep ((t_uint64) cpu_unit->cpu_throt_debt_ns);
+        now = sim_os_nsec ();
+        cpu_unit->cpu_throt_debt_ns -= (double) (now - t0);
+        cpu_unit->cpu_throt_slept_ns += now - t0;
+        cpu_unit->cpu_throt_sleeps++;
     }
 
-    sim_activate (uptr, sim_throt_wait);                /* reschedule */
+    wait = d_cps * (double) SIM_THROT_SLICE_US / 1000000.0;
+    if (wait < SIM_THROT_WMIN)
+        wait = SIM_THROT_WMIN;
+    else if (wait > 100000000)
+        wait = 100000000;
+    cpu_unit->cpu_throt_wait = (int32) wait;
+
+    cpu_unit->cpu_throt_ns = now;
+    cpu_unit->cpu_throt_cycles = cycles;
+    sim_activate (uptr, cpu_unit->cpu_throt_wait);      /* reschedule */
 #endif
 
     return SCPE_OK;
@@ -45,6 +45,9 @@
 #define SIM_THROT_WMUL  4                               /* multiplier */
 #define SIM_THROT_WMIN  100                             /* min wait */
 #define SIM_THROT_MSMIN 10                              /* min for measurement */
+#define SIM_THROT_SLICE_US 250                          /* host time between pacing checks */
+#define SIM_THROT_MINSLEEP_US 50                        /* min pacing sleep */
+#define SIM_THROT_MAXLAG_MS 20                          /* max lag carried over */
 #define SIM_THROT_NONE  0                               /* throttle parameters */
 #define SIM_THROT_MCYC  1
 #define SIM_THROT_KCYC  2
@@ -68,6 +71,9 @@ t_stat sim_show_idle (SMP_FILE *st, UNIT *uptr, int32 val, void *desc);
 void sim_throt_sched (void);
 void sim_throt_cancel (void);
 uint32 sim_os_msec (void);
+t_uint64 sim_os_thread_cpu_nsec (void);
+t_uint64 sim_os_nsec (void);
+void sim_os_ns_sleep (t_uint64 ns);
 void sim_os_sleep (unsigned int sec);
 uint32 sim_os_ms_sleep (unsigned int msec);
 uint32 sim_os_us_sleep_init (void);
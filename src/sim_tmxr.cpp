@@ -62,6 +62,7 @@
    tmxr_getc_ln -       get character for line
    tmxr_poll_rx -       poll receive
    tmxr_putc_ln -       put character for line
+   tmxr_putblk_ln -     put block of characters for line
    tmxr_poll_tx -       poll transmit
    tmxr_open_master -   open master connection
    tmxr_close_master -  close master connection
@@ -87,6 +88,10 @@
 #include "sim_tmxr.h"
 #include "scp.h"
 #include <ctype.h>
+#if defined(__linux)
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#endif
 
 /* Telnet protocol constants - negatives are for init'ing signed char data */
 
@@ -132,6 +137,13 @@
 void tmxr_rmvrc (TMLN *lp, int32 p);
 int32 tmxr_send_buffered_data (TMLN *lp);
 TMLN *tmxr_find_ldsc (UNIT *uptr, int32 val, TMXR *mp);
+static void tmxr_poll_rx_ln (TMLN *lp);
+static void tmxr_evt_start (TMXR *mp);
+static void tmxr_evt_stop (TMXR *mp);
+static t_bool tmxr_evt_conn_ready (TMXR *mp);
+static void tmxr_evt_arm_master (TMXR *mp);
+static void tmxr_evt_add_line (TMXR *mp, TMLN *lp);
+static void tmxr_evt_poll_rx (TMXR *mp);
 
 extern int32 sim_switches;
 extern char sim_name[];
@@ -181,7 +193,11 @@ int32 tmxr_poll_conn (TMXR *mp)
 #endif
     };
 
+    if (mp->evt && !tmxr_evt_conn_ready (mp))               /* nothing pending? */
+        return -1;
     newsock = sim_accept_conn (mp->master, &ipaddr);        /* poll connect */
+    if (mp->evt)                                            /* re-arm master */
+        tmxr_evt_arm_master (mp);
     if (newsock != INVALID_SOCKET) {                        /* got a live one? */
         op = mp->lnorder;                                   /* get line connection order list pointer */
         i = mp->lines;                                      /* play it safe in case lines == 0 */
@@ -206,6 +222,8 @@ int32 tmxr_poll_conn (TMXR *mp)
             lp->conn = newsock;                             /* record connection */
             lp->ipad = ipaddr;                              /* ip address */
             lp->mp = mp;                                    /* save mux */
+            if (mp->evt)                                    /* watch for input */
+                tmxr_evt_add_line (mp, lp);
             sim_write_sock (newsock, mantra, sizeof(mantra));
             tmxr_debug (TMXR_DBG_XMT, lp, "Sending", mantra, sizeof(mantra));
             sprintf (cmsg, "\n\r\nConnected to the %s simulator ", sim_name);
@@ -298,140 +316,152 @@ int32 tmxr_getc_ln (TMLN *lp)
 
 void tmxr_poll_rx (TMXR *mp)
 {
-    int32 i, nbytes, j;
+    int32 i;
     TMLN *lp;
 
+    if (mp->evt) {                                          /* readiness-based? */
+        tmxr_evt_poll_rx (mp);                              /* only ready lines */
+        return;
+        }
     for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
         lp = mp->ldsc + i;                                  /* get line desc */
         if (!lp->conn || !lp->rcve)                         /* skip if !conn */
             continue;
+        tmxr_poll_rx_ln (lp);
+        }                                                   /* end for lines */
+    for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
+        lp = mp->ldsc + i;                                  /* get line desc */
+        if (lp->rxbpi == lp->rxbpr)                         /* if buf empty, */
+            lp->rxbpi = lp->rxbpr = 0;                      /* reset pointers */
+        }                                                   /* end for */
+}
 
-        nbytes = 0;
-        if (lp->rxbpi == 0)                                 /* need input? */
-            nbytes = sim_read_sock (lp->conn,               /* yes, read */
-                &(lp->rxb[lp->rxbpi]),                      /* leave spc for */
-                TMXR_MAXBUF - TMXR_GUARD);                  /* Telnet cruft */
-        else if (lp->tsta)                                  /* in Telnet seq? */
-            nbytes = sim_read_sock (lp->conn,               /* yes, read to end */
-                &(lp->rxb[lp->rxbpi]),
-                TMXR_MAXBUF - lp->rxbpi);
-        if (nbytes < 0)                                     /* closed? reset ln */
-            tmxr_reset_ln (lp);
-        else if (nbytes > 0) {                              /* if data rcvd */
+/* Poll for input on connected and enabled line */
 
-            tmxr_debug (TMXR_DBG_RCV, lp, "Received", &(lp->rxb[lp->rxbpi]), nbytes);
+static void tmxr_poll_rx_ln (TMLN *lp)
+{
+    int32 nbytes, j;
+
+    nbytes = 0;
+    if (lp->rxbpi == 0)                                     /* need input? */
+        nbytes = sim_read_sock (lp->conn,                   /* yes, read */
+            &(lp->rxb[lp->rxbpi]),                          /* leave spc for */
+            TMXR_MAXBUF - TMXR_GUARD);                      /* Telnet cruft */
+    else if (lp->tsta)                                      /* in Telnet seq? */
+        nbytes = sim_read_sock (lp->conn,                   /* yes, read to end */
+            &(lp->rxb[lp->rxbpi]),
+            TMXR_MAXBUF - lp->rxbpi);
+    if (nbytes < 0)                                         /* closed? reset ln */
+        tmxr_reset_ln (lp);
+    else if (nbytes > 0) {                                  /* if data rcvd */
 
-            j = lp->rxbpi;                                  /* start of data */
-            memset (&lp->rbr[j], 0, nbytes);                /* clear status */
-            lp->rxbpi = lp->rxbpi + nbytes;                 /* adv pointers */
-            lp->rxcnt = lp->rxcnt + nbytes;
+        tmxr_debug (TMXR_DBG_RCV, lp, "Received", &(lp->rxb[lp->rxbpi]), nbytes);
 
-    /* Examine new data, remove TELNET cruft before making input available */
+        j = lp->rxbpi;                                      /* start of data */
+        memset (&lp->rbr[j], 0, nbytes);                    /* clear status */
+        lp->rxbpi = lp->rxbpi + nbytes;                     /* adv pointers */
+        lp->rxcnt = lp->rxcnt + nbytes;
 
-            for (; j < lp->rxbpi; ) {                       /* loop thru char */
-                signed char tmp = lp->rxb[j];               /* get char */
-                switch (lp->tsta) {                         /* case tlnt state */
+/* Examine new data, remove TELNET cruft before making input available */
 
-                case TNS_NORM:                              /* normal */
-                    if (tmp == TN_IAC) {                    /* IAC? */
-                        lp->tsta = TNS_IAC;                 /* change state */
-                        tmxr_rmvrc (lp, j);                 /* remove char */
-                        break;
-                        }
-                    if ((tmp == TN_CR) && lp->dstb)         /* CR, no bin */
-                        lp->tsta = TNS_CRPAD;               /* skip pad char */
-                    j = j + 1;                              /* advance j */
-                    break;
+        for (; j < lp->rxbpi; ) {                           /* loop thru char */
+            signed char tmp = lp->rxb[j];                   /* get char */
+            switch (lp->tsta) {                             /* case tlnt state */
 
-                case TNS_IAC:                               /* IAC prev */
-                    if (tmp == TN_IAC) {                    /* IAC + IAC */
-                        lp->tsta = TNS_NORM;                /* treat as normal */
-                        j = j + 1;                          /* advance j */
-                        break;                              /* keep IAC */
-                        }
-                    if (tmp == TN_BRK) {                    /* IAC + BRK? */
-                        lp->tsta = TNS_NORM;                /* treat as normal */
-                        lp->rxb[j] = 0;                     /* char is null */
-                        lp->rbr[j] = 1;                     /* flag break */
-                        j = j + 1;                          /* advance j */
-                        break;
-                        }
-                    switch (tmp) {
-                    case TN_WILL:                           /* IAC + WILL? */
-                        lp->tsta = TNS_WILL;
-                        break;
-                    case TN_WONT:                           /* IAC + WONT? */
-                        lp->tsta = TNS_WONT;
-                        break;
-                    case TN_DO:                             /* IAC + DO? */
-                        lp->tsta = TNS_DO;
-                        break;
-                    case TN_DONT:                           /* IAC + DONT? */
-                        lp->tsta = TNS_DONT;
-                        break;
-                    case TN_GA: case TN_EL:                 /* IAC + other 2 byte types */
-                    case TN_EC: case TN_AYT:                
-                    case TN_AO: case TN_IP:
-                    case TN_NOP: 
-                        lp->tsta = TNS_NORM;                /* ignore */
-                        break;
-                    case TN_SB:                             /* IAC + SB sub-opt negotiation */
-                    case TN_DATAMK:                         /* IAC + data mark */
-                    case TN_SE:                             /* IAC + SE sub-opt end */
-                        lp->tsta = TNS_NORM;                /* ignore */
-                        break;
-                        }
+            case TNS_NORM:                                  /* normal */
+                if (tmp == TN_IAC) {                        /* IAC? */
+                    lp->tsta = TNS_IAC;                     /* change state */
                     tmxr_rmvrc (lp, j);                     /* remove char */
                     break;
-
-                case TNS_WILL: case TNS_WONT:               /* IAC+WILL/WONT prev */
-                    if (tmp == TN_BIN) {                    /* BIN? */
-                        if (lp->tsta == TNS_WILL)
-                            lp->dstb = 0;
-                        else lp->dstb = 1;
-                        }
-                    tmxr_rmvrc (lp, j);                     /* remove it */
-                    lp->tsta = TNS_NORM;                    /* next normal */
+                    }
+                if ((tmp == TN_CR) && lp->dstb)             /* CR, no bin */
+                    lp->tsta = TNS_CRPAD;                   /* skip pad char */
+                j = j + 1;                                  /* advance j */
+                break;
+
+            case TNS_IAC:                                   /* IAC prev */
+                if (tmp == TN_IAC) {                        /* IAC + IAC */
+                    lp->tsta = TNS_NORM;                    /* treat as normal */
+                    j = j + 1;                              /* advance j */
+                    break;                                  /* keep IAC */
+                    }
+                if (tmp == TN_BRK) {                        /* IAC + BRK? */
+                    lp->tsta = TNS_NORM;                    /* treat as normal */
+                    lp->rxb[j] = 0;                         /* char is null */
+                    lp->rbr[j] = 1;                         /* flag break */
+                    j = j + 1;                              /* advance j */
                     break;
-
-                /* Negotiation with the HP terminal emulator "QCTerm" is not working.
-                   QCTerm says "WONT BIN" but sends bare CRs.  RFC 854 says:
-
-                     Note that "CR LF" or "CR NUL" is required in both directions
-                     (in the default ASCII mode), to preserve the symmetry of the
-                     NVT model.  ...The protocol requires that a NUL be inserted
-                     following a CR not followed by a LF in the data stream.
-
-                   Until full negotiation is implemented, we work around the problem
-                   by checking the character following the CR in non-BIN mode and
-                   strip it only if it is LF or NUL.  This should not affect
-                   conforming clients.
-                */
-
-                case TNS_CRPAD:                             /* only LF or NUL should follow CR */
-                    lp->tsta = TNS_NORM;                    /* next normal */
-                    if ((tmp == TN_LF) ||                   /* CR + LF ? */
-                        (tmp == TN_NUL))                    /* CR + NUL? */
-                        tmxr_rmvrc (lp, j);                 /* remove it */
+                    }
+                switch (tmp) {
+                case TN_WILL:                               /* IAC + WILL? */
+                    lp->tsta = TNS_WILL;
                     break;
-
-                case TNS_DO:                                /* pending DO request */
-                case TNS_DONT:                              /* pending DONT request */
-                case TNS_SKIP: default:                     /* skip char */
-                    tmxr_rmvrc (lp, j);                     /* remove char */
-                    lp->tsta = TNS_NORM;                    /* next normal */
+                case TN_WONT:                               /* IAC + WONT? */
+                    lp->tsta = TNS_WONT;
                     break;
-                    }                                       /* end case state */
-                }                                           /* end for char */
-                if (nbytes != (lp->rxbpi-lp->rxbpr))
-                    tmxr_debug (TMXR_DBG_RCV, lp, "Remaining", &(lp->rxb[lp->rxbpi]), lp->rxbpi-lp->rxbpr);
-            }                                               /* end else nbytes */
-        }                                                   /* end for lines */
-    for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
-        lp = mp->ldsc + i;                                  /* get line desc */
-        if (lp->rxbpi == lp->rxbpr)                         /* if buf empty, */
-            lp->rxbpi = lp->rxbpr = 0;                      /* reset pointers */
-        }                                                   /* end for */
+                case TN_DO:                                 /* IAC + DO? */
+                    lp->tsta = TNS_DO;
+                    break;
+                case TN_DONT:                               /* IAC + DONT? */
+                    lp->tsta = TNS_DONT;
+                    break;
+                case TN_GA: case TN_EL:                     /* IAC + other 2 byte types */
+                case TN_EC: case TN_AYT:                
+                case TN_AO: case TN_IP:
+                case TN_NOP: 
+                    lp->tsta = TNS_NORM;                    /* ignore */
+                    break;
+                case TN_SB:                                 /* IAC + SB sub-opt negotiation */
+                case TN_DATAMK:                             /* IAC + data mark */
+                case TN_SE:                                 /* IAC + SE sub-opt end */
+                    lp->tsta = TNS_NORM;                    /* ignore */
+                    break;
+                    }
+                tmxr_rmvrc (lp, j);                         /* remove char */
+                break;
+
+            case TNS_WILL: case TNS_WONT:                   /* IAC+WILL/WONT prev */
+                if (tmp == TN_BIN) {                        /* BIN? */
+                    if (lp->tsta == TNS_WILL)
+                        lp->dstb = 0;
+                    else lp->dstb = 1;
+                    }
+                tmxr_rmvrc (lp, j);                         /* remove it */
+                lp->tsta = TNS_NORM;                        /* next normal */
+                break;
+
+            /* Negotiation with the HP terminal emulator "QCTerm" is not working.
+               QCTerm says "WONT BIN" but sends bare CRs.  RFC 854 says:
+
+                 Note that "CR LF" or "CR NUL" is required in both directions
+                 (in the default ASCII mode), to preserve the symmetry of the
+                 NVT model.  ...The protocol requires that a NUL be inserted
+                 following a CR not followed by a LF in the data stream.
+
+               Until full negotiation is implemented, we work around the problem
+               by checking the character following the CR in non-BIN mode and
+               strip it only if it is LF or NUL.  This should not affect
+               conforming clients.
+            */
+
+            case TNS_CRPAD:                                 /* only LF or NUL should follow CR */
+                lp->tsta = TNS_NORM;                        /* next normal */
+                if ((tmp == TN_LF) ||                       /* CR + LF ? */
+                    (tmp == TN_NUL))                        /* CR + NUL? */
+                    tmxr_rmvrc (lp, j);                     /* remove it */
+                break;
+
+            case TNS_DO:                                    /* pending DO request */
+            case TNS_DONT:                                  /* pending DONT request */
+            case TNS_SKIP: default:                         /* skip char */
+                tmxr_rmvrc (lp, j);                         /* remove char */
+                lp->tsta = TNS_NORM;                        /* next normal */
+                break;
+                }                                           /* end case state */
+            }                                               /* end for char */
+            if (nbytes != (lp->rxbpi-lp->rxbpr))
+                tmxr_debug (TMXR_DBG_RCV, lp, "Remaining", &(lp->rxb[lp->rxbpi]), lp->rxbpi-lp->rxbpr);
+        }                                                   /* end else nbytes */
 }
 
 /* Return count of available characters for line */
@@ -491,6 +521,73 @@ t_stat tmxr_putc_ln (TMLN *lp, int32 chr)
     return SCPE_STALL;                                      /* char not sent */
 }
 
+/* Store block of characters in line buffer
+
+   Equivalent to calling tmxr_putc_ln for each character until it fails, but
+   moves runs of characters that need no Telnet escaping with a single copy.
+
+   Inputs:
+        *lp     =       pointer to line descriptor
+        *buf    =       characters
+        len     =       number of characters
+   Outputs:
+        count   =       number of characters stored, or
+                        -1 if connection lost
+*/
+
+int32 tmxr_putblk_ln (TMLN *lp, const char *buf, int32 len)
+{
+    int32 n, k, avail;
+    const char *p;
+
+    if ((lp->conn == 0) && (!lp->txbfd)) {                  /* no conn & not buffered? */
+        if (lp->txlog) {                                    /* if it was logged, we got it */
+            fwrite (buf, 1, len, lp->txlog);
+            return len;
+            }
+        ++lp->txdrp;                                        /* lost */
+        return -1;
+        }
+    if (lp->txbfd) {                                        /* buffered? never stalls */
+        for (n = 0; n < len; n++)
+            tmxr_putc_ln (lp, buf[n]);
+        return len;
+        }
+    avail = TXBUF_AVAIL (lp);
+    for (n = 0; n < len; ) {
+        if ((char) TN_IAC == buf[n]) {                      /* IAC needs room for two */
+            if (avail <= 2)
+                break;
+            TXBUF_CHAR (lp, TN_IAC);
+            TXBUF_CHAR (lp, TN_IAC);
+            avail -= 2;
+            n++;
+            continue;
+            }
+        k = len - n;                                        /* run up to next IAC, */
+        if (k > avail - 1)                                  /* what fits, */
+            k = avail - 1;
+        if (k > lp->txbsz - lp->txbpi)                      /* and end of ring */
+            k = lp->txbsz - lp->txbpi;
+        if (k <= 0)
+            break;
+        p = (const char *) memchr (buf + n, TN_IAC, k);
+        if (p)
+            k = (int32) (p - (buf + n));
+        memcpy (&lp->txb[lp->txbpi], buf + n, k);
+        lp->txbpi = (lp->txbpi + k) % lp->txbsz;
+        avail -= k;
+        n += k;
+        }
+    if (lp->txlog && n)                                     /* log what was stored */
+        fwrite (buf, 1, n, lp->txlog);
+    if (n < len)                                            /* no room, dsbl line */
+        ++lp->txdrp, lp->xmte = 0;
+    else if (avail <= TMXR_GUARD)                           /* near full? */
+        lp->xmte = 0;                                       /* disable line */
+    return n;
+}
+
 /* Poll for output
 
    Inputs:
@@ -525,34 +622,31 @@ void tmxr_poll_tx (TMXR *mp)
 
 int32 tmxr_send_buffered_data (TMLN *lp)
 {
-    int32 nbytes, sbytes;
+    int32 nbytes, sbytes, nbytes1;
 
     nbytes = tmxr_tqln(lp);                                 /* avail bytes */
     if (nbytes) {                                           /* >0? write */
         if (lp->txbpr < lp->txbpi)                          /* no wrap? */
             sbytes = sim_write_sock (lp->conn,              /* write all data */
                 &(lp->txb[lp->txbpr]), nbytes);
-        else sbytes = sim_write_sock (lp->conn,             /* write to end buf */
-                &(lp->txb[lp->txbpr]), lp->txbsz - lp->txbpr);
+        else {                                              /* wrapped: both parts */
+            nbytes1 = lp->txbsz - lp->txbpr;                /* at once */
+            sbytes = sim_writev_sock (lp->conn,
+                &(lp->txb[lp->txbpr]), nbytes1, lp->txb, nbytes - nbytes1);
+            }
         if (sbytes != SOCKET_ERROR) {                       /* ok? */
-            tmxr_debug (TMXR_DBG_XMT, lp, "Sent", &(lp->txb[lp->txbpr]), sbytes);
+            if (lp->txbpr + sbytes <= lp->txbsz)            /* debug sent data */
+                tmxr_debug (TMXR_DBG_XMT, lp, "Sent", &(lp->txb[lp->txbpr]), sbytes);
+            else {
+                tmxr_debug (TMXR_DBG_XMT, lp, "Sent", &(lp->txb[lp->txbpr]), lp->txbsz - lp->txbpr);
+                tmxr_debug (TMXR_DBG_XMT, lp, "Sent", lp->txb, sbytes - (lp->txbsz - lp->txbpr));
+                }
             lp->txbpr = (lp->txbpr + sbytes);               /* update remove ptr */
             if (lp->txbpr >= lp->txbsz)                     /* wrap? */
-                lp->txbpr = 0;
+                lp->txbpr -= lp->txbsz;
             lp->txcnt = lp->txcnt + sbytes;                 /* update counts */
             nbytes = nbytes - sbytes;
             }
-        if (nbytes && (lp->txbpr == 0))     {               /* more data and wrap? */
-            sbytes = sim_write_sock (lp->conn, lp->txb, nbytes);
-            if (sbytes != SOCKET_ERROR) {                   /* ok */
-                tmxr_debug (TMXR_DBG_XMT, lp, "Sent", lp->txb, sbytes);
-                lp->txbpr = (lp->txbpr + sbytes);           /* update remove ptr */
-                if (lp->txbpr >= lp->txbsz)                 /* wrap? */
-                    lp->txbpr = 0;
-                lp->txcnt = lp->txcnt + sbytes;             /* update counts */
-                nbytes = nbytes - sbytes;
-                }
-            }
         }                                                   /* end if nbytes */
     return nbytes;
 }
@@ -564,6 +658,238 @@ int32 tmxr_tqln (TMLN *lp)
     return (lp->txbpi - lp->txbpr + ((lp->txbpi < lp->txbpr)? lp->txbsz: 0));
 }
 
+/* Readiness-based polling
+
+   Polling every connected line with a read on every poll tick costs a system
+   call per line per tick, even when all lines are idle.  On Linux, each open
+   multiplexer instead keeps its master socket and connected line sockets in
+   an epoll set watched by an event thread.  Sockets are registered one-shot:
+   when a socket becomes readable, the event thread marks it ready (rxrdy for
+   lines, connpend for the master socket), flags the multiplexer as having
+   pending input, and optionally activates the multiplexer's wakeup unit, so
+   that input is picked up without waiting for the next poll tick.
+
+   tmxr_poll_rx and tmxr_poll_conn then look only at ready sockets.  After a
+   line is read, its socket is re-armed; if data remains, the event thread
+   marks it ready again.  A ready line that cannot accept input yet (previous
+   input not consumed) stays marked until it can.
+
+   Each socket is armed at most once, so rxrdy for a line is written either by
+   the event thread (after the line's socket has fired) or by the polling
+   thread (before the socket is re-armed), but never concurrently.
+
+   Sockets of disconnected lines are closed by tmxr_reset_ln, which drops them
+   from the epoll set.  A stale ready mark left for such a line is discarded.
+*/
+
+#if defined(__linux)
+
+#define TMXR_EVT_STOP    0                              /* event tag: stop request */
+#define TMXR_EVT_MASTER  1                              /* event tag: master socket */
+#define TMXR_EVT_LINE    2                              /* event tag: line 0 */
+#define TMXR_EVT_MAXEV   64                             /* events per epoll_wait */
+
+struct tmxr_evt
+{
+    int                         epfd;                   /* epoll set */
+    int                         stopfd;                 /* eventfd for stop request */
+    smp_thread_t                thread;                 /* event thread */
+    smp_interlocked_uint32_var  rxpend;                 /* some line may be ready */
+    smp_interlocked_uint32_var  connpend;               /* master socket ready */
+
+    static void* operator new(size_t size)    { return operator_new_aligned(size, SMP_MAXCACHELINESIZE); }
+    static void  operator delete(void* p)     { operator_delete_aligned(p); }
+};
+
+static t_bool tmxr_evt_ctl (TMXR *mp, int op, SOCKET sock, t_uint64 tag, uint32 events)
+{
+    struct epoll_event ev;
+
+    memset (&ev, 0, sizeof (ev));
+    ev.events = events;
+    ev.data.u64 = tag;
+    return epoll_ctl (mp->evt->epfd, op, sock, &ev) == 0;
+}
+
+static void tmxr_evt_loop (TMXR *mp)
+{
+    tmxr_evt *evt = mp->evt;
+    struct epoll_event evs[TMXR_EVT_MAXEV];
+    int k, nev;
+    t_uint64 tag;
+
+    for (;;) {
+        nev = epoll_wait (evt->epfd, evs, TMXR_EVT_MAXEV, -1);
+        if (nev < 0) {
+            if (errno == EINTR)
+                continue;
+            panic ("Terminal multiplexor event wait failed");
+            }
+        for (k = 0; k < nev; k++) {
+            tag = evs[k].data.u64;
+            if (tag == TMXR_EVT_STOP)
+                return;
+            if (tag == TMXR_EVT_MASTER) {
+                smp_wmb ();
+                smp_var (evt->connpend) = 1;
+                }
+            else {
+                mp->ldsc[tag - TMXR_EVT_LINE].rxrdy = 1;
+                smp_wmb ();
+                smp_var (evt->rxpend) = 1;
+                }
+            }
+        if (nev && mp->wakeup)                          /* kick poll unit */
+            sim_asynch_activate_abs (mp->wakeup, 0);
+        }
+}
+
+static SMP_THREAD_ROUTINE_DECL tmxr_evt_main (void* arg)
+{
+    TMXR* mp = (TMXR*) arg;
+    char tname[16];
+
+    sim_try
+    {
+        smp_thread_init ();
+
+        run_scope_context* rscx = new run_scope_context (NULL, SIM_THREAD_TYPE_IOP, mp->evt->thread);
+        rscx->set_current ();
+
+        smp_set_thread_priority (SIMH_THREAD_PRIORITY_IOP);
+        sprintf (tname, "IOP_%s_MX", mp->dptr ? mp->dptr->name : "CON");
+        smp_set_thread_name (tname);
+
+        tmxr_evt_loop (mp);
+    }
+    sim_catch (sim_exception_SimError, exc)
+    {
+        fprintf (smp_stderr, "\nFatal error in %s simulator, unexpected exception while executing terminal multiplexor thread\n", sim_name);
+        fprintf (smp_stderr, "Exception cause: %s\n", exc->get_message ());
+        fprintf (smp_stderr, "Terminating the simulator abnormally...\n");
+        exit (1);
+    }
+    sim_end_try
+
+    SMP_THREAD_ROUTINE_END;
+}
+
+/* Start readiness-based polling for just opened master socket,
+   multiplexor falls back to plain polling if it cannot be started */
+
+static void tmxr_evt_start (TMXR *mp)
+{
+    tmxr_evt *evt = new tmxr_evt ();
+
+    evt->epfd = epoll_create1 (EPOLL_CLOEXEC);
+    evt->stopfd = eventfd (0, EFD_CLOEXEC);
+    smp_var (evt->rxpend) = 0;
+    smp_var (evt->connpend) = 1;                        /* poll master once anyway */
+    mp->evt = evt;
+    if (evt->epfd < 0 || evt->stopfd < 0 ||
+        !tmxr_evt_ctl (mp, EPOLL_CTL_ADD, evt->stopfd, TMXR_EVT_STOP, EPOLLIN) ||
+        !tmxr_evt_ctl (mp, EPOLL_CTL_ADD, mp->master, TMXR_EVT_MASTER, EPOLLIN | EPOLLONESHOT) ||
+        !smp_create_thread (tmxr_evt_main, (void*) mp, &evt->thread, FALSE)) {
+        if (evt->epfd >= 0)  close (evt->epfd);
+        if (evt->stopfd >= 0)  close (evt->stopfd);
+        mp->evt = NULL;
+        delete evt;
+        }
+}
+
+static void tmxr_evt_stop (TMXR *mp)
+{
+    tmxr_evt *evt = mp->evt;
+    t_uint64 one = 1;
+
+    if (evt == NULL)
+        return;
+    if (write (evt->stopfd, &one, sizeof (one)) != sizeof (one))
+        panic ("Unable to stop terminal multiplexor thread");
+    smp_wait_thread (evt->thread);
+    close (evt->epfd);
+    close (evt->stopfd);
+    mp->evt = NULL;
+    delete evt;
+}
+
+static t_bool tmxr_evt_conn_ready (TMXR *mp)
+{
+    tmxr_evt *evt = mp->evt;
+
+    if (smp_var (evt->connpend) == 0)
+        return FALSE;
+    smp_var (evt->connpend) = 0;
+    smp_rmb ();
+    return TRUE;
+}
+
+static void tmxr_evt_arm_master (TMXR *mp)
+{
+    tmxr_evt_ctl (mp, EPOLL_CTL_MOD, mp->master, TMXR_EVT_MASTER, EPOLLIN | EPOLLONESHOT);
+}
+
+static void tmxr_evt_arm_line (TMXR *mp, TMLN *lp, int op)
+{
+    t_uint64 tag = TMXR_EVT_LINE + (t_uint64) (lp - mp->ldsc);
+
+    if (!tmxr_evt_ctl (mp, op, lp->conn, tag, EPOLLIN | EPOLLRDHUP | EPOLLONESHOT)) {
+        lp->rxrdy = 1;                                  /* cannot watch, poll it */
+        smp_var (mp->evt->rxpend) = 1;
+        }
+}
+
+static void tmxr_evt_add_line (TMXR *mp, TMLN *lp)
+{
+    lp->rxrdy = 0;
+    tmxr_evt_arm_line (mp, lp, EPOLL_CTL_ADD);
+}
+
+static void tmxr_evt_poll_rx (TMXR *mp)
+{
+    tmxr_evt *evt = mp->evt;
+    t_bool pending = FALSE;
+    int32 i;
+    TMLN *lp;
+
+    if (smp_var (evt->rxpend) == 0)                     /* nothing ready? */
+        return;
+    smp_var (evt->rxpend) = 0;
+    smp_mb ();
+    for (i = 0; i < mp->lines; i++) {                   /* loop thru lines */
+        lp = mp->ldsc + i;                              /* get line desc */
+        if (!lp->rxrdy)                                 /* skip if not ready */
+            continue;
+        if (!lp->conn) {                                /* stale mark? */
+            lp->rxrdy = 0;
+            continue;
+            }
+        if (!lp->rcve || (lp->rxbpi && !lp->tsta)) {    /* can't take input now? */
+            pending = TRUE;                             /* retry on next poll */
+            continue;
+            }
+        lp->rxrdy = 0;
+        tmxr_poll_rx_ln (lp);
+        if (lp->conn)                                   /* still connected? */
+            tmxr_evt_arm_line (mp, lp, EPOLL_CTL_MOD);  /* re-arm */
+        if (lp->rxbpi == lp->rxbpr)                     /* if buf empty, */
+            lp->rxbpi = lp->rxbpr = 0;                  /* reset pointers */
+        }
+    if (pending)
+        smp_var (evt->rxpend) = 1;
+}
+
+#else
+
+static void tmxr_evt_start (TMXR *mp) {}
+static void tmxr_evt_stop (TMXR *mp) {}
+static t_bool tmxr_evt_conn_ready (TMXR *mp) { return TRUE; }
+static void tmxr_evt_arm_master (TMXR *mp) {}
+static void tmxr_evt_add_line (TMXR *mp, TMLN *lp) {}
+static void tmxr_evt_poll_rx (TMXR *mp) {}
+
+#endif
+
 /* Open master socket */
 
 t_stat tmxr_open_master (TMXR *mp, char *cptr)
@@ -659,6 +985,7 @@ t_stat tmxr_open_master (TMXR *mp, char *cptr)
         fprintf (sim_log, "Listening on port %d (socket %d)\n", port, sock);
     mp->port = port;                                        /* save port */
     mp->master = sock;                                      /* save master socket */
+    tmxr_evt_start (mp);                                    /* readiness-based polling */
     for (i = 0; i < mp->lines; i++) {                       /* initialize lines */
         lp = mp->ldsc + i;
         lp->conn = lp->tsta = 0;
@@ -725,6 +1052,7 @@ t_stat tmxr_close_master (TMXR *mp)
             tmxr_reset_ln (lp);
             }                                               /* end if conn */
         }                                                   /* end for */
+    tmxr_evt_stop (mp);                                     /* stop readiness polling */
     sim_close_sock (mp->master, 1);                         /* close master socket */
     mp->master = 0;
     return SCPE_OK;
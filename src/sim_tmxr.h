@@ -79,8 +79,11 @@ struct tmln {
     char                rbr[TMXR_MAXBUF];               /* rcv break */
     char                *txb;                           /* xmt buffer */
     TMXR                *mp;                            /* back pointer to mux */
+    smp_interlocked_uint32 rxrdy;                       /* input ready (set by event thread) */
     };
 
+struct tmxr_evt;
+
 struct tmxr {
     int32               lines;                          /* # lines */
     int32               port;                           /* listening port */
@@ -90,6 +93,8 @@ struct tmxr {
     DEVICE              *dptr;                          /* multiplexer device */
     char                logfiletmpl[FILENAME_MAX];      /* template logfile name */
     int32               buffered;                       /* Buffered Line Behavior and Buffer Size Flag */
+    UNIT                *wakeup;                        /* unit to activate on input or connection, or NULL */
+    tmxr_evt            *evt;                           /* readiness-based polling state, or NULL */
     };
 
 int32 tmxr_poll_conn (TMXR *mp);
@@ -97,6 +102,7 @@ void tmxr_reset_ln (TMLN *lp);
 int32 tmxr_getc_ln (TMLN *lp);
 void tmxr_poll_rx (TMXR *mp);
 t_stat tmxr_putc_ln (TMLN *lp, int32 chr);
+int32 tmxr_putblk_ln (TMLN *lp, const char *buf, int32 len);
 void tmxr_poll_tx (TMXR *mp);
 t_stat tmxr_open_master (TMXR *mp, char *cptr);
 t_stat tmxr_close_master (TMXR *mp);